@@ -0,0 +1,97 @@
+/* dual_fisheye.h
+ * デュアル魚眼カメラの入力モデル
+ *
+ * 前後2つの魚眼レンズの画像を並べたフレームを、正距円筒画像に
+ * 貼り合わせずに直接サンプリングするためのキャリブレーション。
+ *
+ * レンズ座標系: X: 右, Y: 下, Z: 光軸方向
+ *   X_lens = R_lens × X  （R_lens = R_pr(pitch, roll) × R(Y)(yaw)）
+ *
+ * 歪みモデル（光軸からの角度 α → 像高 r）:
+ *   r(α) = f * (α + k1 α^3 + k2 α^5 + k3 α^7 + k4 α^9)
+ *   f は r(α_max) = radius となるように決める（α_max = fov/2）
+ *
+ * 継ぎ目では各レンズの重み
+ *   w = clamp((α_max - α) / blend, 0, 1)
+ * で2つのサンプルを混合する。
+ */
+
+#ifndef DUAL_FISHEYE_H
+#define DUAL_FISHEYE_H
+
+#include "vector_math.h"
+
+/* 1つのレンズのキャリブレーション */
+typedef struct {
+    double cx, cy;      /* 像円の中心（画素） */
+    double radius;      /* 像円の半径（画素、画角の端に対応） */
+    double fov_deg;     /* 画角（度数法） */
+    double k[4];        /* 歪み多項式の係数 k1〜k4 */
+    double yaw_deg;     /* レンズの向き（度数法） */
+    double pitch_deg;
+    double roll_deg;
+
+    /* dual_fisheye_prepare() で計算する値 */
+    Matrix3x3 R;        /* 世界座標 → レンズ座標 */
+    double focal;       /* f */
+    double alpha_max;   /* 画角の半分（ラジアン） */
+} FisheyeLens;
+
+/* デュアル魚眼のキャリブレーション */
+typedef struct DualFisheyeCalib {
+    FisheyeLens lens[2];
+    double blend_deg;   /* 継ぎ目の混合幅（度数法） */
+    double blend_rad;   /* 同（ラジアン、dual_fisheye_prepare() で計算） */
+} DualFisheyeCalib;
+
+
+/* ===========================
+ * キャリブレーションの設定
+ * =========================== */
+
+/* 左右に並んだ標準的なデュアル魚眼のキャリブレーション
+ *
+ * 入力:
+ *   width, height - フレームサイズ（左半分が前方、右半分が後方のレンズ）
+ *   fov_deg       - 各レンズの画角（度数法）
+ *
+ * 出力:
+ *   calib - 歪みなし（等距離射影）、後方レンズはヨー180°
+ */
+void dual_fisheye_default(int width, int height, double fov_deg,
+                          DualFisheyeCalib *calib);
+
+/* キャリブレーションファイルを読み込む
+ *
+ * 書式（1行に1項目、# 以降はコメント、未指定の項目は標準値）:
+ *   lens0.cx 1440
+ *   lens0.cy 1440
+ *   lens0.radius 1420
+ *   lens0.fov 190
+ *   lens0.k 0.0 0.0 0.0 0.0
+ *   lens0.yaw 0
+ *   lens0.pitch 0
+ *   lens0.roll 0
+ *   lens1.cx 4320
+ *   ...
+ *   blend 4
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int dual_fisheye_load(const char *filename, int width, int height,
+                      DualFisheyeCalib *calib);
+
+/* 派生値（回転行列、焦点距離など）を計算
+ *
+ * キャリブレーションの値を変更した後に呼ぶこと
+ */
+void dual_fisheye_prepare(DualFisheyeCalib *calib);
+
+/* 像高の多項式 r(α) / f */
+double fisheye_lens_poly(const FisheyeLens *lens, double alpha);
+
+/* キャリブレーションを表示 */
+void dual_fisheye_info(const DualFisheyeCalib *calib);
+
+#endif /* DUAL_FISHEYE_H */
@@ -0,0 +1,57 @@
+/* fft.h
+ * 高速フーリエ変換（外部ライブラリなし）
+ *
+ * 基数2の Cooley-Tukey 法。長さは2のべき乗に限る。
+ * 実数信号は2本を1回の複素FFTにまとめて変換する。
+ *
+ * 定義:
+ *   順変換 X(k) = Σ x(n) exp(-2πi kn/N)
+ *   逆変換 x(n) = (1/N) Σ X(k) exp(+2πi kn/N)
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+/* 複素数 */
+typedef struct {
+    double re;
+    double im;
+} Complex;
+
+
+/* n 以上の最小の2のべき乗 */
+int fft_size_pow2(int n);
+
+/* 複素FFT（その場で変換）
+ *
+ * 入力:
+ *   data    - 長さ n の複素数列
+ *   n       - 長さ（2のべき乗）
+ *   inverse - 0: 順変換, 1: 逆変換（1/n 倍を含む）
+ *
+ * 戻り値:
+ *   1: 成功, 0: n が2のべき乗でない
+ */
+int fft_complex(Complex *data, int n, int inverse);
+
+/* 2本の実数信号の順変換
+ *
+ * z = a + i b を1回変換し、対称性
+ *   A(k) = (Z(k) + conj(Z(n-k))) / 2
+ *   B(k) = (Z(k) - conj(Z(n-k))) / 2i
+ * で分離する。
+ *
+ * 入力:
+ *   a, b - 長さ n の実数列
+ *   work - 長さ n の作業領域
+ *
+ * 出力:
+ *   A, B - それぞれのスペクトル（長さ n）
+ *
+ * 戻り値:
+ *   1: 成功, 0: n が2のべき乗でない
+ */
+int fft_real_pair(const double *a, const double *b, int n,
+                  Complex *work, Complex *A, Complex *B);
+
+#endif /* FFT_H */
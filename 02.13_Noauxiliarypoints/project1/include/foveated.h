@@ -0,0 +1,138 @@
+/* foveated.h
+ * 中心窩（foveated）描画
+ *
+ * 注視画像の利用者は注視点G（光軸 ez）付近の細部を重視し、
+ * 周辺部はそれほど必要としない。そこで光軸からの角度で
+ * 出力画素をレベル分けし、周辺ほど粗い格子でサンプリングして
+ * バイリニア補間で拡大する。
+ *
+ *   レベル0        : 角度 <= inner_radius          → 全画素サンプリング
+ *   レベルL (L>=1) : inner_radius + (L-1)*ring_width 〜 + ring_width
+ *                   → 間隔 2^L の格子点だけサンプリング
+ *
+ * 出力カメラ座標の光軸は Z軸（正距円筒の出力では画像中心）。
+ *
+ * 各画素のレベルと必要な格子点は出力の投影とパラメータだけで決まるので、
+ * FoveationPlan として1回だけ求め、同じ出力で注視点（回転）を替えて描画
+ * するときは使い回す。サンプリングは投影の組み合わせごとに特殊化した
+ * 行の一部のカーネル（projection_span_kernel()）で、必要な格子点と
+ * レベル0の画素の連続した区間ごとに行う。
+ */
+
+#ifndef FOVEATED_H
+#define FOVEATED_H
+
+#include "projection.h"
+
+/* レベル数の上限 */
+#define FOVEATION_MAX_LEVELS 6
+
+/* レベル分けのブロックの大きさ（画素） */
+#define FOVEATION_BLOCK 16
+
+/* 中心窩描画のパラメータ */
+typedef struct {
+    double inner_radius_deg;  /* 全密度で描画する光軸からの角度半径（度数法） */
+    double ring_width_deg;    /* 各リングの幅（度数法） */
+    int max_level;            /* 最も粗いレベル（格子間隔 2^max_level） */
+} FoveationParams;
+
+/* 描画の計画（出力の投影とパラメータごとのレベル分け） */
+typedef struct {
+    int width, height;                           /* 出力のサイズ */
+    FoveationParams params;
+    uint8_t *level;                              /* 各画素のレベル (width * height) */
+    int gw[FOVEATION_MAX_LEVELS];                /* レベルごとの格子点の数 */
+    int gh[FOVEATION_MAX_LEVELS];
+    uint8_t *need[FOVEATION_MAX_LEVELS];         /* 補間に使う格子点なら1 (gw * gh) */
+    long pixels_per_level[FOVEATION_MAX_LEVELS]; /* 各レベルの出力画素数 */
+    long samples_per_level[FOVEATION_MAX_LEVELS];/* 各レベルのサンプリング数 */
+    long projections;                            /* レベル分けで投影した点の数 */
+    double seconds;                              /* 計画にかかった時間 */
+} FoveationPlan;
+
+/* 描画の統計 */
+typedef struct {
+    long total_pixels;                           /* 出力画素数 */
+    long samples;                                /* 入力をサンプリングした回数 */
+    double saved_ratio;                          /* サンプリングの削減率
+                                                    1 - samples / total */
+    long plan_projections;                       /* この描画のレベル分けで投影した
+                                                    点の数（計画を使い回した場合は0） */
+    double plan_seconds;                         /* 計画（レベル分け）の時間 */
+    double render_seconds;                       /* サンプリングと補間の時間 */
+    long pixels_per_level[FOVEATION_MAX_LEVELS]; /* 各レベルの出力画素数 */
+    long samples_per_level[FOVEATION_MAX_LEVELS];
+} FoveationStats;
+
+
+/* 標準のパラメータ（半径 inner_radius_deg、リング幅15°、最大レベル3） */
+FoveationParams foveation_default(double inner_radius_deg);
+
+/* 描画の計画を作る
+ *
+ * 各出力画素の光軸からの角度でレベルを決め、各レベルの格子で補間に
+ * 使う格子点に印を付ける。FOVEATION_BLOCK 四方のブロックごとに中心と
+ * 4隅だけを投影し、ブロック全体が1つのレベルに収まればまとめて決める。
+ * レベルの境界にかかるブロックだけ画素ごとに投影し、cos の閾値と
+ * 光軸方向の成分を比べて分類する。
+ *
+ * 入力:
+ *   out_p  - 出力画像の投影
+ *   params - 中心窩描画のパラメータ
+ *
+ * 戻り値:
+ *   計画（foveation_plan_free() で解放）、失敗時は NULL
+ */
+FoveationPlan* foveation_plan_create(const ProjectionParams *out_p,
+                                     const FoveationParams *params);
+
+/* 計画を解放 */
+void foveation_plan_free(FoveationPlan *plan);
+
+/* 計画を使って中心窩描画
+ *
+ * 入力:
+ *   input  - 入力画像
+ *   in_p   - 入力画像の投影
+ *   out_p  - 出力画像の投影（計画を作ったときと同じもの）
+ *   R_T    - 出力カメラ座標 → 入力カメラ座標の回転
+ *   plan   - foveation_plan_create() の計画
+ *
+ * 出力:
+ *   output - 出力画像（サイズは out_p、チャンネル数は入力と一致すること）
+ *   stats  - サンプリング数の統計（NULL 可、plan_projections は 0）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int foveated_render_plan(Image *input, const ProjectionParams *in_p,
+                         Image *output, const ProjectionParams *out_p,
+                         Matrix3x3 R_T, const FoveationPlan *plan,
+                         FoveationStats *stats);
+
+/* 中心窩描画（計画を作って描画し、解放する）
+ *
+ * 入力:
+ *   input  - 入力画像
+ *   in_p   - 入力画像の投影
+ *   out_p  - 出力画像の投影
+ *   R_T    - 出力カメラ座標 → 入力カメラ座標の回転
+ *   params - 中心窩描画のパラメータ
+ *
+ * 出力:
+ *   output - 出力画像（サイズは out_p、チャンネル数は入力と一致すること）
+ *   stats  - サンプリング数の統計（NULL 可、レベル分けの投影の数と時間を含む）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int foveated_render(Image *input, const ProjectionParams *in_p,
+                    Image *output, const ProjectionParams *out_p,
+                    Matrix3x3 R_T, const FoveationParams *params,
+                    FoveationStats *stats);
+
+/* 統計を表示 */
+void foveation_stats_print(const FoveationStats *stats);
+
+#endif /* FOVEATED_H */
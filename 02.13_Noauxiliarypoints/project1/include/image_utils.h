@@ -15,6 +15,17 @@ typedef struct {
     uint8_t *data;
 } Image;
 
+/* グレースケール画像
+ *
+ * 輝度 (R + G + B) / 3 を double で保持する。
+ * 目的関数の計算で画素ごとにRGBから変換し直さないために使う。
+ */
+typedef struct {
+    int width;
+    int height;
+    double *data;
+} GrayImage;
+
 /* 関数宣言 */
 Image* image_load(const char *filename);
 int image_save_jpg(const char *filename, Image *img, int quality);
@@ -25,6 +36,17 @@ Image* image_create_like(Image *src);
 void get_pixel(Image *img, int u, int v, uint8_t *rgb);
 void set_pixel(Image *img, int u, int v, const uint8_t *rgb);
 void get_pixel_bilinear(Image *img, double u, double v, uint8_t *rgb);
+double get_gray_bilinear(Image *img, double u, double v);
+double get_gray_bilinear_gradient(Image *img, double u, double v,
+                                  double *dS_du, double *dS_dv);
 void image_info(Image *img);
 
+GrayImage* gray_image_create(int width, int height);
+GrayImage* gray_image_from_image(Image *img);
+void gray_image_free(GrayImage *gray);
+double gray_get(const GrayImage *gray, int u, int v);
+double gray_get_bilinear(const GrayImage *gray, double u, double v);
+double gray_get_bilinear_gradient(const GrayImage *gray, double u, double v,
+                                  double *dS_du, double *dS_dv);
+
 #endif /* IMAGE_UTILS_H */
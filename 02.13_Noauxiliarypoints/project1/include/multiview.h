@@ -0,0 +1,94 @@
+/* multiview.h
+ * 複数ビューの一括描画
+ *
+ * 1枚の全方位画像から K 個の注視方向のビューを生成する場合、
+ * projection_render() を K 回呼ぶと出力画素の方向（出力の投影の逆変換）を
+ * ビューごとに同じだけ計算し直し、入力画像の同じ範囲を K 回読み直すことになる。
+ * ここでは出力の投影が同じビューをまとめ、次のどちらかの順で描画する。
+ *
+ *   MULTIVIEW_ROWS  - projection_render_views(): 出力の1行の各画素の方向を
+ *                     1回だけ求め、その行を全ビューで続けて描画する
+ *   MULTIVIEW_TILES - projection_render_views_binned(): さらに全ビューの
+ *                     数行分の出力画素を入力の MULTIVIEW_TILE_SIZE 四方の
+ *                     タイルごとに並べ替え、タイル順に補間する
+ *
+ * ビューが重なる場合、MULTIVIEW_TILES では各入力タイルをバッチごとに1回だけ
+ * 読む。どちらも結果は projection_render() を個別に呼んだ場合と画素単位で一致する。
+ */
+
+#ifndef MULTIVIEW_H
+#define MULTIVIEW_H
+
+#include "projection.h"
+
+/* 入力タイルの一辺 [画素]（3チャンネルで 12 KiB、L1/L2 に収まる大きさ） */
+#define MULTIVIEW_TILE_SIZE 64
+
+/* MULTIVIEW_TILES の1バッチの出力画素数の目安（作業領域は約 32 MiB） */
+#define MULTIVIEW_BATCH_SAMPLES (1L << 20)
+
+/* 描画の順序 */
+typedef enum {
+    MULTIVIEW_ROWS,          /* 出力の行順（全ビューの同じ行を続けて） */
+    MULTIVIEW_TILES          /* 入力タイル順（全ビューの数行分をまとめて） */
+} MultiViewOrder;
+
+/* 1つのビュー */
+typedef struct {
+    ProjectionParams out_p;  /* 出力画像の投影 */
+    Matrix3x3 R_T;           /* 出力カメラ座標 → 入力カメラ座標の回転 */
+    Image *output;           /* 出力画像（サイズは out_p、チャンネル数は入力と一致） */
+} ViewSpec;
+
+/* 描画の統計 */
+typedef struct {
+    long samples;            /* 描画した出力画素数 */
+    int groups;              /* 出力の投影が同じビューのまとまりの数 */
+    long tile_visits;        /* 読んだ入力タイルの数（MULTIVIEW_TILES のみ） */
+    int batches;             /* バッチの数（MULTIVIEW_TILES のみ） */
+} MultiViewStats;
+
+
+/* 注視点 (u_g, v_g) を向くビューを設定
+ *
+ * 入力:
+ *   out_p    - 出力画像の投影
+ *   u_g, v_g - 注視点（W × H の正距円筒画像上の座標）
+ *   W, H     - 注視点の座標系の画像サイズ
+ *   channels - 出力画像のチャンネル数
+ *
+ * 出力:
+ *   view - 出力画像を確保したビュー
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int view_spec_init(ViewSpec *view, const ProjectionParams *out_p,
+                   int u_g, int v_g, int W, int H, int channels);
+
+/* ビューの出力画像を解放 */
+void view_spec_free(ViewSpec *view);
+
+/* K 個のビューを一括で描画
+ *
+ * 入力:
+ *   input  - 入力画像
+ *   in_p   - 入力画像の投影
+ *   views  - ビューの配列（K 個）
+ *   interp - 補間方法
+ *   order  - 描画の順序
+ *
+ * 出力:
+ *   views[k].output - 各ビューの画像
+ *   stats           - 統計（NULL 可）
+ *
+ * 出力の投影（種類、サイズ、画角、面）が同じビューをまとめて描画する。
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int multiview_render(Image *input, const ProjectionParams *in_p,
+                     ViewSpec *views, int K, Interpolation interp,
+                     MultiViewOrder order, MultiViewStats *stats);
+
+#endif /* MULTIVIEW_H */
@@ -0,0 +1,115 @@
+/* mutual_info.h
+ * 相互情報量による目的関数（Y軸回り専用）
+ *
+ * 別のセンサーの画像や昼夜の画像の組では輝度の関係が1次式でないので、
+ * 差の2乗も ZNCC（zncc.h）も最小点が正しくならない。相互情報量
+ *
+ *   MI(ψ) = Σ p(i, j) log(p(i, j) / (pb(i) pr(j)))
+ *
+ * は輝度の対応が一意であれば大きくなる。最小化するので E_mi = -MI とする。
+ *
+ * 同時ヒストグラム p(i, j) は bins × bins（32〜64）:
+ *   i - 基準画像の輝度の階級（切り捨て、角度によらない）
+ *   j - 参照画像の補間した輝度 t = Sr (bins - 3)/255 + 1 を3次の B スプラインの
+ *       Parzen 窓で floor(t) - 1 〜 floor(t) + 2 の4つの階級に分ける
+ *       （ψ について滑らかで、両端の1階級は窓がはみ出さないための余白）
+ *       1次の B スプライン（2つの階級）では区間の中で p が ψ の1次式になり、
+ *       E_mi の最小点が角のような形になってガウス・ニュートン法が進まない。
+ * 参照画像の補間は zncc.h と同じく同じ行の u 方向の切り捨てのない線形補間。
+ *
+ * ヒストグラムへの加算は、続く画素が同じ階級に加算すると前の加算の
+ * 書き込みを待つことになるので、sub_histograms 個の部分ヒストグラムに
+ * 画素を順に振り分けて加算し、最後に合計する。3次の B スプラインの重みの
+ * 計算が画素ごとの手間の大半なので、比較領域 380 × 190 画素の実画像では
+ * 部分ヒストグラムの数による速さの差は測定の誤差程度（bench_mutual_info）。
+ * 標準は1個。
+ *
+ * 微分は Parzen 窓の微分から同時ヒストグラムの微分 dp(i, j)/dψ を同じ走査で
+ * 求め、
+ *   dMI/dψ = Σ dp(i, j) log(p(i, j) / pr(j))
+ *   H ≈ Σ dp(i, j)²/p(i, j) - Σ dpr(j)²/pr(j)
+ * （H は d²p の項を除いた近似で、差の2乗の H = (1/N) Σ (dSr/dψ)² にあたる
+ *   フィッシャー情報量型の量。負にならない）。
+ *
+ * E_mi の谷は差の2乗より狭い（比較領域 380 × 190 画素の実画像で ±0.05° 程度）
+ * ので、初期値は角度の掃引などで最小点の近くに置くこと。
+ */
+
+#ifndef MUTUAL_INFO_H
+#define MUTUAL_INFO_H
+
+#include "y_rotation.h"
+
+/* 階級の数と部分ヒストグラムの数の上限 */
+#define MI_MAX_BINS 64
+#define MI_MAX_SUB_HISTOGRAMS 8
+
+/* 設定 */
+typedef struct {
+    int bins;               /* 階級の数（2〜MI_MAX_BINS） */
+    int sub_histograms;     /* 部分ヒストグラムの数（1〜MI_MAX_SUB_HISTOGRAMS） */
+} MiOptions;
+
+/* 基準画像・参照画像の事前計算と作業領域 */
+typedef struct {
+    int width, height;      /* 画像のサイズ */
+    Region region;          /* 比較領域 */
+    int region_width;       /* 比較領域の幅 w */
+    int rows;               /* 比較領域の行数 */
+    int count;              /* 画素数 N */
+    int bins;
+    int sub_histograms;
+
+    unsigned char *base_bin;    /* 基準画像の階級（rows × w） */
+    double *base_marginal;      /* pb(i) */
+
+    /* 参照画像の比較領域の行（u 方向に周期的に延長、rows × (W + w + 1)） */
+    int ext_width;
+    double *ref_ext;
+
+    /* 作業領域（sub_histograms × bins × bins、mi_* の呼び出しで上書き） */
+    double *joint;
+    double *joint_d;
+} MiContext;
+
+
+/* 標準の設定（32 階級、部分ヒストグラム1個） */
+MiOptions mi_default_options(void);
+
+/* 事前計算
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   region    - 比較領域（行は画像の内側、幅は W 以下）
+ *   options   - 設定（NULL で標準）
+ *
+ * 出力:
+ *   事前計算の結果（mi_context_free() で解放）、失敗時は NULL
+ *   作業領域を持つので、1つの MiContext を複数のスレッドで使わないこと。
+ */
+MiContext* mi_context_create(Image *base, Image *ref, Region region,
+                             const MiOptions *options);
+
+/* メモリ解放 */
+void mi_context_free(MiContext *ctx);
+
+/* 角度 ψ での同時ヒストグラム（画素数で割らない重みの和）
+ *
+ * 出力:
+ *   joint   - bins × bins（joint[i * bins + j]）
+ *   joint_d - d joint/dψ（ラジアン当たり、NULL なら求めない）
+ */
+void mi_joint_histogram(MiContext *ctx, double psi_deg, double *joint, double *joint_d);
+
+/* 目的関数 E_mi(ψ) = -MI(ψ) */
+double mi_objective(MiContext *ctx, double psi_deg);
+
+/* 目的関数とその微分
+ *
+ * 出力:
+ *   terms - E = -MI, gradient = dE/dψ, hessian（フィッシャー情報量型の近似）、
+ *           いずれもラジアン当たり
+ */
+void mi_objective_terms(MiContext *ctx, double psi_deg, ObjectiveTerms *terms);
+
+#endif /* MUTUAL_INFO_H */
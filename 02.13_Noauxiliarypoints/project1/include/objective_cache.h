@@ -0,0 +1,103 @@
+/* objective_cache.h
+ * 目的関数の値のキャッシュ（メモ化）
+ *
+ * 角度の掃引と数値微分では同じ ψ の E(ψ) を何度も求めることになる
+ * （E(ψ + Δψ) は次の角度の E(ψ) と同じ）。
+ * (画像の組の番号, 比較領域, ψ) をキーに E を覚えておき、2回目以降は
+ * 比較領域を走査せずに返す。
+ *
+ * ψ は OBJECTIVE_CACHE_QUANTUM_DEG 単位に丸めてキーにするので、
+ * 刻みの足し算で生じる小さな誤差では別の角度にならない。
+ */
+
+#ifndef OBJECTIVE_CACHE_H
+#define OBJECTIVE_CACHE_H
+
+#include <stddef.h>
+#include "y_rotation.h"
+
+/* ψ をキーにするときの丸めの単位（度数法） */
+#define OBJECTIVE_CACHE_QUANTUM_DEG 1e-6
+
+/* 目的関数を計算する画像の組
+ *
+ * id は呼び出し側で画像の組ごとに別の値を付ける
+ * （同じ id で別の画像を渡すと古い値が返る）。
+ * context に base と region の region_context_create() の結果を入れておくと、
+ * キャッシュにない角度の計算に使う（NULL なら compute_objective_function()）。
+ */
+typedef struct {
+    int id;             /* 画像の組の番号 */
+    Image *base;        /* 基準画像 I_b */
+    Image *ref;         /* 参照画像 I_r */
+    Region region;      /* 比較領域 */
+    const RegionContext *context;   /* 事前計算（NULL 可） */
+} ObjectivePair;
+
+/* キャッシュの1項目 */
+typedef struct {
+    int used;
+    int pair_id;
+    Region region;
+    long long psi_key;  /* round(ψ / OBJECTIVE_CACHE_QUANTUM_DEG) */
+    double E;
+} ObjectiveCacheEntry;
+
+/* キャッシュ（開番地法のハッシュ表） */
+typedef struct {
+    ObjectiveCacheEntry *entries;
+    size_t capacity;    /* 2のべき乗 */
+    size_t size;        /* 使用中の項目数 */
+    long hits;          /* キャッシュから返した回数 */
+    long misses;        /* 比較領域を走査した回数 */
+} ObjectiveCache;
+
+
+/* キャッシュを作成
+ *
+ * 入力:
+ *   capacity - 最初の容量（0 で標準、足りなければ自動で拡張）
+ *
+ * 出力:
+ *   キャッシュ（objective_cache_free() で解放）、失敗時は NULL
+ */
+ObjectiveCache* objective_cache_create(size_t capacity);
+
+/* メモリ解放 */
+void objective_cache_free(ObjectiveCache *cache);
+
+/* E(ψ) を探す
+ *
+ * 戻り値:
+ *   1: 見つかった（*E に値）, 0: 未計算
+ */
+int objective_cache_lookup(ObjectiveCache *cache, const ObjectivePair *pair,
+                           double psi_deg, double *E);
+
+/* 計算済みの E(ψ) を登録（compute_objective_terms() などで求めた値）
+ *
+ * 戻り値:
+ *   1: 成功, 0: メモリ不足
+ */
+int objective_cache_store(ObjectiveCache *cache, const ObjectivePair *pair,
+                          double psi_deg, double E);
+
+/* E(ψ)（未計算なら compute_objective_function() で求めて登録） */
+double cached_objective(ObjectiveCache *cache, const ObjectivePair *pair,
+                        double psi_deg);
+
+/* 前進差分 (E(ψ + Δψ) - E(ψ)) / Δψ（ラジアン当たり）
+ *
+ * compute_numerical_derivative() と同じ値を、キャッシュの E で求める。
+ */
+double cached_forward_derivative(ObjectiveCache *cache, const ObjectivePair *pair,
+                                 double psi_deg, double delta_psi_deg);
+
+/* 中心差分 (E(ψ + Δψ) - E(ψ - Δψ)) / 2Δψ（ラジアン当たり）
+ *
+ * 刻み Δψ の掃引の後なら、両隣の角度の E をそのまま使う。
+ */
+double cached_central_derivative(ObjectiveCache *cache, const ObjectivePair *pair,
+                                 double psi_deg, double delta_psi_deg);
+
+#endif /* OBJECTIVE_CACHE_H */
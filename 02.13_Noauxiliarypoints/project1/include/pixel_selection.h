@@ -0,0 +1,60 @@
+/* pixel_selection.h
+ * 目的関数に使う画素の選択（間引き）
+ *
+ * 輝度が平坦な画素は dE/dψ にほとんど寄与しないが、走査の手間は同じ。
+ * 比較領域の画素を最急降下画像 SD = dSb/dψ の大きさ（ヤコビアンの寄与、
+ * ヘッセ行列 H = (1/N) Σ SD² への寄与）で順位付けし、一部だけを使う。
+ *
+ *   PIXEL_SELECT_TOP_K      - 領域全体で |SD| の大きい順（テクスチャに偏る）
+ *   PIXEL_SELECT_STRATIFIED - 領域を cell_size 四方のセルに分け、
+ *                             セルごとに Σ|SD| に比例した個数（セルの画素数まで）
+ *                             を |SD| の大きい順。平坦なセルには枠を割かず、
+ *                             模様のあるセルが多くても全体には広げる
+ *   PIXEL_SELECT_RANDOM     - セルごとに画素数に比例した個数を無作為に（比較用）
+ *
+ * 結果は YawTemplate なので compute_objective_terms_ic() や
+ * estimate_y_rotation_ic() にそのまま渡せる。
+ */
+
+#ifndef PIXEL_SELECTION_H
+#define PIXEL_SELECTION_H
+
+#include "y_rotation.h"
+
+/* 選び方 */
+typedef enum {
+    PIXEL_SELECT_TOP_K,
+    PIXEL_SELECT_STRATIFIED,
+    PIXEL_SELECT_RANDOM
+} PixelSelectMode;
+
+/* 選択の設定 */
+typedef struct {
+    PixelSelectMode mode;
+    double fraction;    /* 残す画素の割合（0 < fraction <= 1） */
+    int count;          /* 残す画素数（正なら fraction より優先） */
+    int cell_size;      /* 層別のセルの大きさ（画素） */
+    unsigned int seed;  /* PIXEL_SELECT_RANDOM の乱数の種 */
+} PixelSelectOptions;
+
+
+/* 標準の設定（層別の |SD| 上位 10%、16 × 16 画素のセル） */
+PixelSelectOptions pixel_select_default_options(void);
+
+/* 選び方の名前 */
+const char* pixel_select_mode_name(PixelSelectMode mode);
+
+/* 画素を選んだ YawTemplate を作成
+ *
+ * 入力:
+ *   tmpl    - yaw_template_create() の結果（比較領域の全画素、ラスター順）
+ *   options - 設定（NULL で標準）
+ *
+ * 出力:
+ *   選んだ画素だけの YawTemplate（元のラスター順、hessian は選んだ画素で
+ *   計算し直す。yaw_template_free() で解放）、失敗時は NULL
+ */
+YawTemplate* yaw_template_select(const YawTemplate *tmpl,
+                                 const PixelSelectOptions *options);
+
+#endif /* PIXEL_SELECTION_H */
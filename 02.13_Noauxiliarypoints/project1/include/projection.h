@@ -0,0 +1,264 @@
+/* projection.h
+ * 投影モデルと特殊化された描画カーネル
+ *
+ * 投影モデルの種類:
+ *   - equirect      : 正距円筒図法（全方位画像）
+ *   - rectilinear   : 透視投影（通常のカメラ画像）
+ *   - cylindrical   : 円筒投影
+ *   - stereographic : 立体射影
+ *   - fisheye       : 等距離射影魚眼
+ *   - cube_face     : キューブマップの1面
+ *   - dual_fisheye  : デュアル魚眼カメラのフレーム（入力専用）
+ *
+ * カメラ座標系は世界座標系と同じく X: 右, Y: 下, Z: 光軸方向。
+ *
+ * 描画カーネルは (入力投影, 出力投影, 補間方法, チャンネル数) の
+ * 組み合わせごとに X-マクロで個別に生成される。
+ * 組み合わせの選択は描画開始時の1回だけで、画素ごとの分岐はない。
+ */
+
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include "vector_math.h"
+#include "image_utils.h"
+#include "dual_fisheye.h"
+
+/* 投影モデルの一覧（X-マクロ）
+ *
+ * X(列挙名, 関数名の接頭辞)
+ * 新しい投影を追加する場合はここに1行加え、projection.c に
+ * <接頭辞>_to_world / <接頭辞>_from_world / <接頭辞>_WRAP_U を定義して
+ * 出力側の一覧 OUTPUT_LIST にも加える
+ */
+#define PROJECTION_LIST(X) \
+    X(EQUIRECT,      equirect)      \
+    X(RECTILINEAR,   rectilinear)   \
+    X(CYLINDRICAL,   cylindrical)   \
+    X(STEREOGRAPHIC, stereographic) \
+    X(FISHEYE,       fisheye)       \
+    X(CUBE_FACE,     cube_face)     \
+    X(DUAL_FISHEYE,  dual_fisheye)
+
+/* 投影モデルの種類 */
+typedef enum {
+#define X(E, name) PROJ_##E,
+    PROJECTION_LIST(X)
+#undef X
+    PROJ_COUNT
+} ProjectionType;
+
+/* 補間方法 */
+typedef enum {
+    INTERP_NEAREST,
+    INTERP_BILINEAR,
+    INTERP_COUNT
+} Interpolation;
+
+/* キューブマップの面（光軸方向） */
+typedef enum {
+    CUBE_POS_X, CUBE_NEG_X,
+    CUBE_POS_Y, CUBE_NEG_Y,
+    CUBE_POS_Z, CUBE_NEG_Z
+} CubeFace;
+
+/* 投影パラメータ */
+typedef struct {
+    ProjectionType type;
+    int width;          /* 画像サイズ */
+    int height;
+    double fov_deg;     /* 水平画角（度数法、equirect と cube_face では未使用） */
+    CubeFace face;      /* cube_face の面 */
+    double focal;       /* 焦点距離など（projection_init で計算） */
+    const DualFisheyeCalib *fisheye;  /* dual_fisheye のキャリブレーション */
+} ProjectionParams;
+
+
+/* ===========================
+ * パラメータの設定
+ * =========================== */
+
+/* 投影パラメータを初期化
+ *
+ * 入力:
+ *   type     - 投影モデル
+ *   width, height - 画像サイズ
+ *   fov_deg  - 水平画角（度数法）
+ *
+ * 出力:
+ *   焦点距離を計算済みのパラメータ（cube_face の面は +Z）
+ */
+ProjectionParams projection_init(ProjectionType type, int width, int height,
+                                 double fov_deg);
+
+/* デュアル魚眼フレームの投影パラメータを初期化
+ *
+ * calib は描画が終わるまで呼び出し側で保持すること
+ */
+ProjectionParams projection_init_dual_fisheye(int width, int height,
+                                              const DualFisheyeCalib *calib);
+
+/* 投影モデルの名前 */
+const char* projection_name(ProjectionType type);
+
+/* 名前から投影モデルを取得（1: 成功, 0: 不明な名前） */
+int projection_parse(const char *name, ProjectionType *type);
+
+
+/* ===========================
+ * 座標変換（汎用版）
+ * =========================== */
+
+/* 画像座標 → カメラ座標（単位ベクトル）
+ *
+ * 戻り値:
+ *   1: 有効, 0: 投影範囲外（魚眼の円外など）
+ */
+int projection_to_world(const ProjectionParams *p, double u, double v,
+                        Vector3D *X);
+
+/* カメラ座標 → 画像座標
+ *
+ * 戻り値:
+ *   1: 有効, 0: 投影範囲外
+ */
+int projection_from_world(const ProjectionParams *p, Vector3D X,
+                          double *u, double *v);
+
+/* 世界座標 X の方向の画素値を入力画像から取得
+ *
+ * 描画カーネルと同じサンプラーを汎用的に呼び出す（画素ごとに分岐あり）。
+ * 疎なサンプリング（中心窩描画など）で使う。
+ *
+ * 出力:
+ *   px - 画素値（input->channels 個）
+ *
+ * 戻り値:
+ *   1: 有効, 0: 投影範囲外
+ */
+int projection_sample(const Image *input, const ProjectionParams *in_p,
+                      Vector3D X, uint8_t *px, Interpolation interp);
+
+/* 入力画像の画像座標 (u, v) の画素値を取得
+ *
+ * projection_from_world() で求めた座標を後から補間する場合に使う。
+ * 周期的な投影（equirect）では u を折り返し、それ以外は画像外を範囲外とする。
+ * dual_fisheye はレンズの混合が必要なため対象外（常に 0 を返す）。
+ *
+ * 戻り値:
+ *   1: 有効, 0: 範囲外
+ */
+int projection_sample_at(const Image *input, const ProjectionParams *in_p,
+                         double u, double v, uint8_t *px, Interpolation interp);
+
+
+/* ===========================
+ * 描画
+ * =========================== */
+
+/* 入力画像を別の投影で描画
+ *
+ * 出力画素ごとに
+ *   X' = 出力投影の to_world(u_out, v_out)
+ *   X  = R_T × X'
+ *   (u_in, v_in) = 入力投影の from_world(X)
+ * として入力画像を補間する。
+ *
+ * 入力:
+ *   input  - 入力画像（1, 3, 4チャンネル）
+ *            dual_fisheye では継ぎ目で2つのレンズのサンプルを混合する
+ *   in_p   - 入力画像の投影
+ *   out_p  - 出力画像の投影
+ *   R_T    - 出力カメラ座標 → 入力カメラ座標の回転
+ *   interp - 補間方法
+ *
+ * 出力:
+ *   output - 出力画像（サイズは out_p、チャンネル数は入力と一致すること）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 対応していない組み合わせ（dual_fisheye の出力など）
+ */
+int projection_render(Image *input, const ProjectionParams *in_p,
+                      Image *output, const ProjectionParams *out_p,
+                      Matrix3x3 R_T, Interpolation interp);
+
+/* 出力の投影が同じ K 個のビューをまとめて描画
+ *
+ * 出力画素の方向（出力の投影の逆変換）は行ごとに1回だけ求めて全ビューで
+ * 使い回し、同じ行を全ビューで続けて描画する。各ビューの結果は
+ * projection_render() と画素単位で一致する。
+ *
+ * 入力:
+ *   input  - 入力画像
+ *   in_p   - 入力画像の投影
+ *   out_p  - 全ビューに共通の出力画像の投影
+ *   R_T    - 各ビューの出力カメラ座標 → 入力カメラ座標の回転（K 個）
+ *   K      - ビューの数
+ *   interp - 補間方法
+ *
+ * 出力:
+ *   outputs - 各ビューの画像（K 個、サイズは out_p、チャンネル数は入力と一致）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int projection_render_views(Image *input, const ProjectionParams *in_p,
+                            Image **outputs, const ProjectionParams *out_p,
+                            const Matrix3x3 *R_T, int K, Interpolation interp);
+
+/* projection_render_views_binned() の統計 */
+typedef struct {
+    long tile_visits;        /* バッチごとに読んだ入力タイルの数の合計 */
+    int batches;             /* バッチの数 */
+} ProjectionBinStats;
+
+/* 出力の投影が同じ K 個のビューを入力タイル順にまとめて描画
+ *
+ * 全ビューの同じ範囲の行を1つのバッチとし、バッチ内の出力画素を
+ *   1. 行ごとに1回求めた方向から入力の座標 (u, v) に写し
+ *   2. 入力の tile_size × tile_size のタイルごとに数え上げソートし
+ *   3. タイル順に補間する
+ * ビューが重なる場合、各タイルはバッチごとに1回だけ読まれる。
+ * 各ビューの結果は projection_render() と画素単位で一致する。
+ * dual_fisheye の入力は2つのレンズを混合するため projection_render_views() で
+ * 描画する（stats は0）。
+ *
+ * 入力:
+ *   input, in_p, out_p, R_T, K, interp - projection_render_views() と同じ
+ *   tile_size     - 入力タイルの一辺 [画素]
+ *   batch_samples - 1つのバッチの出力画素数の目安（少なくとも全ビューの1行）
+ *                   1画素あたり約 32 バイトの作業領域を使う
+ *
+ * 出力:
+ *   outputs - 各ビューの画像
+ *   stats   - 統計（NULL 可）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int projection_render_views_binned(Image *input, const ProjectionParams *in_p,
+                                   Image **outputs, const ProjectionParams *out_p,
+                                   const Matrix3x3 *R_T, int K, Interpolation interp,
+                                   int tile_size, long batch_samples,
+                                   ProjectionBinStats *stats);
+
+/* 出力画像の1行の一部を描画するカーネル
+ *
+ * 出力画素 (min(u0 + k step, W - 1), v)（k = 0 .. n-1）を描画カーネルと
+ * 同じ計算で求め、dst の k 番目の画素（channels バイト）に書き込む。
+ * 範囲外は0。疎なサンプリング（中心窩描画など）で、画素ごとの分岐なしに
+ * 間隔 step の格子点や行の一部だけを描画する場合に使う。
+ */
+typedef void (*ProjectionSpanKernel)(const Image *in, const ProjectionParams *ip,
+                                     const ProjectionParams *op, const Matrix3x3 *M,
+                                     int u0, int v, int step, int n, uint8_t *dst);
+
+/* (入力投影, 出力投影, 補間方法, チャンネル数) の行の一部のカーネルを取得
+ *
+ * 戻り値:
+ *   カーネル、対応していない組み合わせでは NULL
+ */
+ProjectionSpanKernel projection_span_kernel(const Image *input, const ProjectionParams *in_p,
+                                            const ProjectionParams *out_p, Interpolation interp);
+
+#endif /* PROJECTION_H */
@@ -0,0 +1,46 @@
+/* pyramid.h
+ * 全方位画像のピラミッド（粗密探索用）
+ *
+ * レベル0が元画像で、レベルが1つ上がるごとに幅・高さを1/2にする。
+ * 縮小は2×2画素の平均で、u 方向は周期的に扱う（右端と左端がつながる）。
+ * 正距円筒画像のままなので、各レベルで image_to_world() などが
+ * そのまま使える（角度の分解能が 2^level 倍粗くなる）。
+ */
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include "image_utils.h"
+#include "y_rotation.h"
+
+/* レベル数の上限 */
+#define PYRAMID_MAX_LEVELS 8
+
+/* グレースケール画像のピラミッド */
+typedef struct {
+    int levels;                             /* レベル数（1以上） */
+    GrayImage *level[PYRAMID_MAX_LEVELS];   /* level[0] は元画像（所有しない） */
+} GrayPyramid;
+
+
+/* ピラミッドを作成
+ *
+ * 入力:
+ *   image  - 元画像（level[0] として参照するだけで複製しない）
+ *   levels - レベル数（幅・高さが小さくなりすぎる場合は減らす）
+ *
+ * 出力:
+ *   pyramid - ピラミッド（gray_pyramid_free() で解放）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int gray_pyramid_build(GrayImage *image, int levels, GrayPyramid *pyramid);
+
+/* メモリ解放（level[0] は解放しない） */
+void gray_pyramid_free(GrayPyramid *pyramid);
+
+/* レベル level での比較領域（座標を 1/2^level にする） */
+Region region_at_level(Region region, int level);
+
+#endif /* PYRAMID_H */
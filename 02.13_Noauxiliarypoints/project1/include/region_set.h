@@ -0,0 +1,137 @@
+/* region_set.h
+ * 複数の比較領域の目的関数を1回の走査で求める（Y軸回り専用）
+ *
+ * 比較領域を複数使うと、領域ごとに compute_objective_terms_gray() などを
+ * 呼ぶ場合は領域の数だけ参照画像を走査し、重なった画素は何度も計算する。
+ * ここでは領域の集合をまとめて事前計算し、角度ごとに
+ *   - 使う行（どれかの領域に入る行）を1回ずつ
+ *   - 各行を「同じ領域の組に入る区間」（セグメント）に分け、
+ *     区間の画素の差 Sr - Sb と dSr/dψ を1回だけ計算
+ *   - 区間の和を、その区間を含む全ての領域に加える
+ * として、全ての領域の E, dE/dψ, H を1回の走査で求める。
+ * 参照画像は使う行だけを u 方向に周期的に延長して持ち（行は全ての領域で共有）、
+ * 基準画像の輝度は区間ごとに1回だけ持つ。
+ *
+ * 補間と微分は compute_objective_terms_gray() と同じ（同じ行の u 方向の
+ * 線形補間、dSr/dψ = -(∂S/∂u) W/2π）。
+ *
+ * 全体の目的関数は全ての領域の差の2乗の和を画素数の和 Σ N_r で割ったもの
+ * （重なった画素は領域の数だけ数える）で、
+ *   E = Σ N_r E_r / Σ N_r
+ * 各領域の E_r と同じ形なので、全体の推定にはガウス・ニュートン法
+ * （estimate_y_rotation_regions）をそのまま使える。
+ *
+ * 画像の継ぎ目（u = 0 と W の境）をまたぐ領域は u_max < u_min と書く
+ * （u_min から右へ W - 1 を越えて u_max まで）。
+ *
+ * 領域のファイルは1行に1つの領域
+ *   u_min v_min u_max v_max
+ * で、# から行末まではコメント、空行は読み飛ばす。
+ */
+
+#ifndef REGION_SET_H
+#define REGION_SET_H
+
+#include <stddef.h>
+#include "y_rotation.h"
+
+/* 領域の数の上限 */
+#define REGION_SET_MAX_REGIONS 64
+
+/* 比較領域の集合 */
+typedef struct {
+    int count;
+    Region *regions;
+} RegionSet;
+
+/* 同じ領域の組に入る行の区間（画像の継ぎ目をまたがない） */
+typedef struct {
+    int row;                /* RegionSetContext の行の番号 */
+    int u0;                 /* 区間の左端（0 <= u0 < W） */
+    int length;             /* 区間の画素数 */
+    int member_start;       /* members の中の位置 */
+    int member_count;       /* 区間を含む領域の数 */
+    size_t base_offset;     /* base_gray の中の位置 */
+} RegionSegment;
+
+/* 事前計算 */
+typedef struct {
+    int width, height;      /* 画像のサイズ */
+    int region_count;
+    Region *regions;        /* 継ぎ目をまたぐ領域は u_max を W だけ大きくしたもの */
+    int *region_pixels;     /* 各領域の画素数 N_r */
+    long total_pixels;      /* Σ N_r */
+    long unique_pixels;     /* どれかの領域に入る画素の数（1回の走査の画素数） */
+
+    int rows;               /* 使う行の数 */
+    int *row_v;             /* 各行の v */
+
+    int segment_count;
+    RegionSegment *segments;
+    int *members;           /* 区間を含む領域の番号 */
+    double *base_gray;      /* 区間の基準画像の輝度 */
+
+    int ext_width;          /* 2W + 1 */
+    double *ref_ext;        /* 参照画像の行（rows × ext_width） */
+} RegionSetContext;
+
+
+/* 領域の集合を作る（regions は複製する、count は 1〜REGION_SET_MAX_REGIONS）
+ *
+ * 戻り値:
+ *   領域の集合（region_set_free() で解放）、失敗時は NULL
+ */
+RegionSet* region_set_create(const Region *regions, int count);
+
+/* 領域の集合をファイルから読む
+ *
+ * 戻り値:
+ *   領域の集合（region_set_free() で解放）、失敗時は NULL
+ *   （読めない行があればその行番号をエラーに出す）
+ */
+RegionSet* region_set_load(const char *filename);
+
+/* メモリ解放 */
+void region_set_free(RegionSet *set);
+
+/* 事前計算
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   set       - 比較領域の集合（行は画像の内側、幅は W 以下）
+ *
+ * 出力:
+ *   事前計算の結果（region_set_context_free() で解放）、失敗時は NULL
+ */
+RegionSetContext* region_set_context_create(Image *base, Image *ref, const RegionSet *set);
+
+/* メモリ解放 */
+void region_set_context_free(RegionSetContext *ctx);
+
+/* 角度 ψ での全ての領域の目的関数とその微分（1回の走査）
+ *
+ * 出力:
+ *   per_region - 領域ごとの E, dE/dψ, H（region_count 個、NULL なら求めない）
+ *   combined   - 全体の E, dE/dψ, H（NULL なら求めない、count は Σ N_r）
+ */
+void region_set_terms(const RegionSetContext *ctx, double psi_deg,
+                      ObjectiveTerms *per_region, ObjectiveTerms *combined);
+
+/* 全体の目的関数 E(ψ) */
+double region_set_objective(const RegionSetContext *ctx, double psi_deg);
+
+/* 角度の列での領域ごとの曲線と全体の曲線
+ *
+ * 入力:
+ *   psis - 角度の列（度数法）
+ *   K    - 角度の数
+ *
+ * 出力:
+ *   curves   - 領域 r の角度 k の値を curves[r * K + k] に
+ *              （region_count × K 個、NULL なら求めない）
+ *   combined - 全体の値（K 個、NULL なら求めない）
+ */
+void region_set_sweep(const RegionSetContext *ctx, const double *psis, int K,
+                      ObjectiveTerms *curves, ObjectiveTerms *combined);
+
+#endif /* REGION_SET_H */
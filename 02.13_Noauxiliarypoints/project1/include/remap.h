@@ -0,0 +1,101 @@
+/* remap.h
+ * 注視画像生成用のリマップテーブル
+ *
+ * 回転行列を R = R_pr(pitch, roll) × R(Y)(yaw) と分解すると、
+ * 逆変換 X = R^T X' = R(Y)(-yaw) × (R_pr^T X') のヨー成分は
+ * 入力全方位画像上で u 方向の平行移動になる:
+ *
+ *   u_in = u_0 + yaw * W/(2π)  (mod W)
+ *   v_in = v_0
+ *
+ * そこでテーブルは (W, H, pitch, roll, 出力サイズ) だけをキーとして
+ * ヨー0での (u_0, v_0) を保持し、ヨーは適用時に加算する。
+ * 同じ水平線上のパン操作や一括処理では1つのテーブルを使い回せる。
+ */
+
+#ifndef REMAP_H
+#define REMAP_H
+
+#include "vector_math.h"
+#include "image_utils.h"
+
+/* キャッシュに保持するテーブル数 */
+#define REMAP_CACHE_SIZE 8
+
+/* リマップテーブル */
+typedef struct {
+    int in_width;       /* 入力画像サイズ */
+    int in_height;
+    int out_width;      /* 出力画像サイズ */
+    int out_height;
+    double pitch_deg;   /* キーとなる回転角度 */
+    double roll_deg;
+    float *u;           /* ヨー0での入力画像座標（出力画素ごと） */
+    float *v;
+} RemapTable;
+
+/* リマップテーブルのキャッシュ */
+typedef struct {
+    RemapTable *tables[REMAP_CACHE_SIZE];
+    int next;           /* 次に置き換える位置 */
+    int hits;
+    int misses;
+} RemapCache;
+
+
+/* ===========================
+ * テーブルの作成・適用
+ * =========================== */
+
+/* リマップテーブルを作成
+ *
+ * 入力:
+ *   in_W, in_H   - 入力全方位画像のサイズ
+ *   out_W, out_H - 出力画像のサイズ
+ *   pitch_deg, roll_deg - 回転のピッチ・ロール成分（度数法）
+ *
+ * 注意:
+ *   呼び出し側で remap_table_free() が必要
+ */
+RemapTable* remap_table_create(int in_W, int in_H, int out_W, int out_H,
+                               double pitch_deg, double roll_deg);
+
+/* テーブルがキーと一致するか（1: 一致, 0: 不一致） */
+int remap_table_matches(const RemapTable *table,
+                        int in_W, int in_H, int out_W, int out_H,
+                        double pitch_deg, double roll_deg);
+
+/* テーブルを適用して出力画像を生成
+ *
+ * 入力:
+ *   table   - リマップテーブル
+ *   input   - 入力全方位画像（サイズはテーブルと一致すること）
+ *   yaw_deg - 回転のヨー成分（度数法）
+ *
+ * 出力:
+ *   output  - 出力画像（サイズはテーブルと一致すること）
+ */
+void remap_table_apply(const RemapTable *table, Image *input,
+                       double yaw_deg, Image *output);
+
+/* メモリ解放 */
+void remap_table_free(RemapTable *table);
+
+
+/* ===========================
+ * キャッシュ
+ * =========================== */
+
+RemapCache* remap_cache_create(void);
+
+/* キーに一致するテーブルを取得（なければ作成して登録）
+ *
+ * 返したテーブルはキャッシュが所有する（解放しないこと）
+ */
+RemapTable* remap_cache_get(RemapCache *cache,
+                            int in_W, int in_H, int out_W, int out_H,
+                            double pitch_deg, double roll_deg);
+
+void remap_cache_free(RemapCache *cache);
+
+#endif /* REMAP_H */
@@ -55,6 +55,55 @@ Vector3D compute_ex(Vector3D ez);
  */
 Vector3D compute_ey(Vector3D ez, Vector3D ex);
 
+/* ===========================
+ * 回転の分解
+ * =========================== */
+
+/* ピッチ・ロール回転行列を生成
+ * 
+ * 入力:
+ *   pitch_deg - X軸回りの回転角度（度数法）
+ *   roll_deg  - Z軸回りの回転角度（度数法）
+ * 
+ * 出力:
+ *   R_pr = R(Z)(roll) × R(X)(pitch)
+ * 
+ *   R(X)(α) = [ 1    0       0    ]    R(Z)(γ) = [ cos(γ) -sin(γ)  0 ]
+ *             [ 0  cos(α) -sin(α) ]              [ sin(γ)  cos(γ)  0 ]
+ *             [ 0  sin(α)  cos(α) ]              [   0       0     1 ]
+ */
+Matrix3x3 create_pitch_roll_matrix(double pitch_deg, double roll_deg);
+
+/* 回転行列をヨーとピッチ・ロールに分解
+ * 
+ * R = R_pr(pitch, roll) × R(Y)(yaw)
+ * 
+ * ヨーは光軸 ez の経度 θ = atan2(ez.x, ez.z) とする。
+ * このとき R × R(Y)(yaw)^T の第3行のx成分が0になり、
+ * 残りをピッチ・ロールで表せる。
+ * 
+ * 出力:
+ *   yaw_deg, pitch_deg, roll_deg - 各回転角度（度数法）
+ */
+void rotation_decompose_yaw(Matrix3x3 R, double *yaw_deg,
+                            double *pitch_deg, double *roll_deg);
+
+/* ===========================
+ * 軸・角度表現
+ * =========================== */
+
+/* 回転ベクトルから回転行列を生成（ロドリゲスの公式）
+ * 
+ * 入力:
+ *   omega - 回転ベクトル（向きが回転軸、長さが回転角度[ラジアン]）
+ * 
+ * 出力:
+ *   exp([ω]×) = I + sin(|ω|)/|ω| [ω]× + (1 - cos(|ω|))/|ω|² [ω]×²
+ * 
+ *   exp([ω]×) X ≈ X + ω × X （|ω| が小さいとき）
+ */
+Matrix3x3 create_axis_angle_matrix(Vector3D omega);
+
 /* ===========================
  * 検証・デバッグ用
  * =========================== */
@@ -0,0 +1,128 @@
+/* rotation_registration.h
+ * 3自由度の回転の位置合わせ
+ *
+ * Y軸回りの1パラメータ（y_rotation.h）を一般の回転 R に拡張する。
+ *
+ *   E(R) = (1/2N) Σ (Sr(X') - Sb(X))²,  X' = R X
+ *
+ * 回転は SO(3) 上で左から微小回転を掛けて更新する:
+ *   R ← exp([ω]×) R,   X' ← X' + ω × X'
+ *
+ * 画素ごとのヤコビアン（1×3）は
+ *   ∂Sr/∂ω = ∇S(X') · (ω × X') の係数 = X' × ∇S(X')
+ * ∇S は式15と同じく ∂S/∂θ, ∂S/∂φ と ∂θ/∂X', ∂φ/∂X' の連鎖律で求める
+ * （Y軸回りの dX'/dψ = (-Z', 0, X') は ω = -ψ ey の場合にあたる）。
+ *
+ *   g = (1/N) Σ (Sr - Sb) J,  H = (1/N) Σ J Jᵀ
+ *   (H + λ diag(H)) ω = -g
+ *
+ * 粗いレベルから順にガウス・ニュートン法を行い（pyramid.h）、
+ * 求めた回転を次のレベルの初期値にする。
+ *
+ * 比較領域の画素の代わりに球面上の点の集合（sphere_sampling.h）で
+ * 同じ E, g, H を求めることもできる。点の世界座標は画像のサイズによらないので、
+ * ピラミッドのどのレベルでも同じ点を使い、粗いレベルでは 4^l 個に1点に間引く。
+ * 等面積の点なら、各点の重みが等しいまま極の近くに標本が集まらない。
+ */
+
+#ifndef ROTATION_REGISTRATION_H
+#define ROTATION_REGISTRATION_H
+
+#include "pyramid.h"
+#include "sphere_sampling.h"
+
+/* 位置合わせの設定 */
+typedef struct {
+    int levels;             /* ピラミッドのレベル数 */
+    int max_iterations;     /* 各レベルの最大反復回数 */
+    double tolerance_deg;   /* 更新量 |ω| がこれ未満で収束（度数法） */
+    double lambda_init;     /* λ の初期値 */
+    double lambda_max;      /* λ がこれを超えたらそのレベルを打ち切る */
+} RegistrationOptions;
+
+/* 位置合わせの結果 */
+typedef struct {
+    Matrix3x3 R;                            /* 推定した回転（X' = R X） */
+    double yaw_deg, pitch_deg, roll_deg;    /* R = R_pr(pitch, roll) × R(Y)(yaw) */
+    double E;                               /* レベル0での目的関数 */
+    int iterations;                         /* 全レベルの反復回数の合計 */
+    int passes;                             /* 比較領域を走査した回数（全レベル） */
+    int converged;                          /* 1: レベル0で収束 */
+    int levels;                             /* 実際に使ったレベル数 */
+    int level_iterations[PYRAMID_MAX_LEVELS];
+    double level_seconds[PYRAMID_MAX_LEVELS];
+} RegistrationResult;
+
+
+/* 標準の設定 */
+RegistrationOptions registration_default_options(void);
+
+/* 回転 R での目的関数 E(R)
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   region    - 比較領域（base の座標）
+ *   R         - 回転（X' = R X）
+ */
+double rotation_objective(const GrayImage *base, const GrayImage *ref,
+                          Region region, Matrix3x3 R);
+
+/* 回転を推定（ピラミッドによる粗密探索 + ガウス・ニュートン法）
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像
+ *   region    - 比較領域（レベル0の座標）
+ *   R_init    - 初期値（ヨーが大きい場合は yaw_search_fft() の結果など）
+ *   options   - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int register_rotation(GrayImage *base, GrayImage *ref, Region region,
+                      Matrix3x3 R_init, const RegistrationOptions *options,
+                      RegistrationResult *result);
+
+/* 標本点での目的関数 E(R) = (1/2N) Σ (Sr(R X_k) - Sb(X_k))²
+ *
+ * 入力:
+ *   samples - 標本点と基準画像の輝度（sphere_samples_create()）
+ *   ref     - 参照画像（samples を作った基準画像と同じサイズ）
+ *   R       - 回転（X' = R X）
+ */
+double rotation_objective_samples(const SphereSamples *samples, const GrayImage *ref,
+                                  Matrix3x3 R);
+
+/* 標本点で回転を推定（register_rotation() の比較領域を点の集合に置き換えたもの）
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像
+ *   points    - 球面上の点の集合（sphere_points_fibonacci() など）
+ *   R_init    - 初期値
+ *   options   - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果（passes は点の集合を走査した回数）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int register_rotation_samples(GrayImage *base, GrayImage *ref, const SpherePoints *points,
+                              Matrix3x3 R_init, const RegistrationOptions *options,
+                              RegistrationResult *result);
+
+/* 比較用: ヨー・ピッチ・ロールの3次元格子の全探索（レベル0）
+ *
+ * 中心 (yaw0, pitch0, roll0) の ± half_range_deg を step_deg 刻みで調べる。
+ *
+ * 出力:
+ *   result - 最小の格子点（iterations は評価点数）
+ */
+int register_rotation_grid(const GrayImage *base, const GrayImage *ref,
+                           Region region, double yaw0_deg, double pitch0_deg,
+                           double roll0_deg, double half_range_deg,
+                           double step_deg, RegistrationResult *result);
+
+#endif /* ROTATION_REGISTRATION_H */
@@ -0,0 +1,93 @@
+/* sphere_sampling.h
+ * 球面上の等面積の標本点
+ *
+ * 正距円筒画像の画素は同じ大きさでも、受け持つ立体角は
+ *   ΔΩ = (2π/W)(π/H) sin φ
+ * で極に近いほど小さい。比較領域の全画素を同じ重みで足す目的関数では、
+ * 高緯度の領域ほど同じ立体角に多くの画素（標本）を使うことになる。
+ *
+ * ここでは球面全体または球冠（中心 c、角半径 α）の中にフィボナッチ格子
+ *   z_i = 1 - (1 - cos α)(i + 1/2)/n   （c からの角度の余弦、面積が等間隔）
+ *   a_i = i × 黄金角
+ * の n 点を作る。各点の受け持つ立体角は 2π(1 - cos α)/n で等しい。
+ * 点の世界座標（単位ベクトル）は1回だけ計算し、基準画像の輝度とともに
+ * SphereSamples に持つ。目的関数とヤコビアンは rotation_registration.h の
+ * rotation_objective_samples(), register_rotation_samples() で求める。
+ *
+ * 比較用に、球冠の中心が入る正距円筒画像の全画素の点の集合も作れる。
+ */
+
+#ifndef SPHERE_SAMPLING_H
+#define SPHERE_SAMPLING_H
+
+#include "vector_math.h"
+#include "image_utils.h"
+
+/* 球面上の点の集合 */
+typedef struct {
+    int count;
+    Vector3D *X;        /* 世界座標（単位ベクトル） */
+    double *area;       /* 各点が受け持つ立体角（ステラジアン） */
+} SpherePoints;
+
+/* 点の集合と基準画像の輝度 */
+typedef struct {
+    int count;
+    Vector3D *X;        /* 世界座標（単位ベクトル） */
+    double *Sb;         /* 基準画像の輝度（バイリニア補間） */
+} SphereSamples;
+
+
+/* 球冠の立体角 2π(1 - cos α)（α = 180° で球面全体の 4π） */
+double sphere_cap_solid_angle(double cap_radius_deg);
+
+/* 赤道の画素と同じ密度（1画素 (2π/W)(π/H) ステラジアンに1点）で
+ * 球冠を覆う点の数 */
+int sphere_cap_equator_density_count(double cap_radius_deg, int W, int H);
+
+/* フィボナッチ格子（等面積）
+ *
+ * 入力:
+ *   n              - 点の数
+ *   center         - 球冠の中心（単位ベクトルでなくてもよい）
+ *   cap_radius_deg - 球冠の角半径（度数法、180 で球面全体）
+ *
+ * 出力:
+ *   点の集合（sphere_points_free() で解放）、失敗時は NULL
+ */
+SpherePoints* sphere_points_fibonacci(int n, Vector3D center, double cap_radius_deg);
+
+/* 比較用: 球冠に入る正距円筒画像の画素（image_to_world() の点、
+ * 立体角は (2π/W)(π/H) sin φ）
+ *
+ * 入力:
+ *   W, H           - 画像のサイズ
+ *   center, cap_radius_deg - 球冠
+ */
+SpherePoints* sphere_points_equirect(int W, int H, Vector3D center, double cap_radius_deg);
+
+/* メモリ解放 */
+void sphere_points_free(SpherePoints *points);
+
+/* 立体角で重みを付けた場合の実効的な点の数 (Σ ΔΩ)² / Σ ΔΩ²
+ * （等面積なら点の数と同じ、重みが偏るほど小さい）
+ */
+double sphere_points_effective_count(const SpherePoints *points);
+
+/* 点の集合の基準画像の輝度を求める（世界座標は複製する）
+ *
+ * 入力:
+ *   base   - 基準画像
+ *   points - 点の集合
+ *   stride - stride 個ごとに1点を使う（ピラミッドの粗いレベル用、1 で全点）
+ *
+ * 出力:
+ *   標本（sphere_samples_free() で解放）、失敗時は NULL
+ */
+SphereSamples* sphere_samples_create(const GrayImage *base, const SpherePoints *points,
+                                     int stride);
+
+/* メモリ解放 */
+void sphere_samples_free(SphereSamples *samples);
+
+#endif /* SPHERE_SAMPLING_H */
@@ -0,0 +1,114 @@
+/* sweep.h
+ * 角度の掃引の並列実行
+ *
+ * 角度ごとの目的関数・微分（compute_objective_terms_ref）は互いに独立なので、
+ * スレッドプールで並列に計算する。
+ *
+ *   - 角度単位: 1つの作業 = 1つの角度
+ *   - 行単位（split_rows）: 1つの作業 = 1つの角度の SWEEP_ROW_BLOCK 行
+ *     （角度の数がスレッド数より少ない場合や、比較領域が大きい場合）
+ *
+ * 基準画像の比較領域の世界座標と輝度（RegionContext）は掃引の前に1回だけ
+ * 求め、全ての角度・スレッドで共有する。
+ *
+ * どちらの場合も、各角度の値は比較領域を SWEEP_ROW_BLOCK 行ずつに分けた
+ * 部分和を上の行から順に足して求める。分け方と足す順序がスレッド数や
+ * 実行順によらないので、結果はスレッド数によらずビット単位で一致する。
+ *
+ * 曲線が不要で最小の角度だけを求める場合は sweep_objective_argmin() を使う。
+ * それまでの最小値を上限に compute_objective_function_yaw_bounded() で
+ * 計算し、上限を超えた角度は途中で打ち切る。
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "y_rotation.h"
+
+/* 部分和を求める行の単位（スレッド数によらない固定値） */
+#define SWEEP_ROW_BLOCK 16
+
+/* 掃引の設定 */
+typedef struct {
+    int threads;        /* スレッド数（0 で CPU のコア数） */
+    int split_rows;     /* 1: 角度をさらに行単位に分けて並列化 */
+} SweepOptions;
+
+
+/* 最小値だけの探索の結果 */
+typedef struct {
+    int index;          /* 最小の角度の番号（psis[index]） */
+    double E;           /* その目的関数の値 */
+    int completed;      /* 最後まで計算した角度の数 */
+    int pruned;         /* 途中で打ち切った角度の数 */
+    long rows;          /* 足した行の総数（全て計算すると n × 行数） */
+} SweepMinimum;
+
+
+/* 標準の設定（コア数のスレッド、角度単位） */
+SweepOptions sweep_default_options(void);
+
+/* 実際に使うスレッド数（threads = 0 のときは CPU のコア数） */
+int sweep_thread_count(const SweepOptions *options);
+
+/* 複数の角度で目的関数・理論微分・ヘッセ行列を並列に計算
+ *
+ * 入力:
+ *   base    - 基準画像 I_b
+ *   ref     - 参照画像 I_r（base と同じサイズ）
+ *   region  - 比較領域
+ *   psis    - 角度の列（度数法）
+ *   n       - 角度の数
+ *   options - 設定（NULL で標準）
+ *
+ * 出力:
+ *   terms - 角度 psis[i] の E, dE/dψ, d²E/dψ²（terms[i]、入力と同じ順）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int sweep_objective_terms(Image *base, Image *ref, Region region,
+                          const double *psis, int n, const SweepOptions *options,
+                          ObjectiveTerms *terms);
+
+/* sweep_objective_terms() の RegionContext 版（値はビット単位で一致）
+ *
+ * 同じ基準画像・比較領域で参照画像を替えて何度も掃引する場合に、
+ * region_context_create() を1回だけにする。
+ *
+ * 入力:
+ *   ctx - region_context_create() の結果
+ *   ref - 参照画像 I_r
+ *   その他は sweep_objective_terms() と同じ
+ */
+int sweep_objective_terms_ctx(const RegionContext *ctx, Image *ref,
+                              const double *psis, int n, const SweepOptions *options,
+                              ObjectiveTerms *terms);
+
+/* 複数の角度の目的関数の最小値だけを求める（打ち切り付き、Y軸回り専用）
+ *
+ * 角度は間隔を半分ずつ細かくする順（n 以下の最大の2のべき乗の間隔から）に
+ * 調べ、早い段階で小さな上限を得る。各角度は1つのスレッドで
+ * objective_row_order() の順に行を足すので、最後まで計算した角度の E は
+ * スレッド数によらない。打ち切った角度の E は最小値より真に大きいので、
+ * 最小の角度（同じ値なら番号の小さい方）もスレッド数によらない。
+ * options->split_rows は使わない。
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   region    - 比較領域
+ *   psis      - 角度の列（度数法）
+ *   n         - 角度の数
+ *   options   - 設定（NULL で標準）
+ *
+ * 出力:
+ *   minimum - 最小の角度と計算量
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int sweep_objective_argmin(Image *base, Image *ref, Region region,
+                           const double *psis, int n, const SweepOptions *options,
+                           SweepMinimum *minimum);
+
+#endif /* SWEEP_H */
@@ -0,0 +1,227 @@
+/* tracking.h
+ * 全方位動画のフレーム列の回転の追跡
+ *
+ * フレーム列を順に読み、各フレームの回転を直前のフレームまたは
+ * キーフレームに対して推定し、最初のフレームに対する回転（軌跡）を求める。
+ *
+ * フレーム k の回転 R_k は最初のフレームの X をフレーム k の X' = R_k X に移す
+ * （Sr(R X) = Sb(X) の R と同じ向き）。基準のフレーム（直前またはキーフレーム）
+ * の回転を R_key、推定した相対回転を R_rel とすると
+ *   R_k = R_rel R_key
+ *
+ * 毎回 ±10° の探索から始める代わりに、等速の予測
+ *   R_pred = (R_{k-1} R_{k-2}^T) R_{k-1}
+ * （ヨーだけのモデルでは ψ_pred = 2ψ_{k-1} - ψ_{k-2}）から相対回転の初期値
+ * R_pred R_key^T を作り、微分を使う反復で推定する。
+ *   - TRACK_YAW:      逆合成法 estimate_y_rotation_ic()。最急降下画像は
+ *                     基準のフレームが替わるときに1回だけ作る
+ *   - TRACK_ROTATION: register_rotation()（ヨー・ピッチ・ロール）。初期値が
+ *                     近いのでピラミッドのレベルを少なくしてよい
+ *
+ * 予測の誤差が比較領域の模様の周期の半分を超えると反復は別の極小に収束する。
+ * 動きの分からない2フレーム目と、直前のフレームで収束しなかった場合は
+ * 予測を使わず、estimate_y_rotation_pyramid()（最上位レベルでの全周探索）で
+ * ヨー角を捕捉してから推定する。
+ *
+ * キーフレームに対して推定すると、直前のフレームに対する推定の誤差が
+ * 積み重ならない。キーフレームからの回転が大きくなるか一定のフレーム数が
+ * 経つと、収束したフレームを新しいキーフレームにする。収束しなかった
+ * フレームは基準にせず（回転は予測のまま）、次のフレームは最後の良い
+ * 基準のフレームに対して捕捉する。
+ *
+ * フレームは画像ファイルのリスト（1行に1つのパス、# から行末はコメント）
+ * または幅・高さを指定した生の RGB（1画素3バイト）の連続から読む。
+ * 画像のデコードは別のスレッドで先読みし（FramePipeline）、推定と並行に行う。
+ */
+
+#ifndef TRACKING_H
+#define TRACKING_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "y_rotation.h"
+#include "yaw_estimator.h"
+#include "rotation_registration.h"
+
+/* 先読みするフレーム数の上限 */
+#define FRAME_PIPELINE_MAX_DEPTH 16
+
+/* フレームの入力の種類 */
+typedef enum {
+    FRAME_SOURCE_LIST,      /* 画像ファイルのリスト */
+    FRAME_SOURCE_RAW        /* 生の RGB の連続 */
+} FrameSourceType;
+
+/* フレームの入力 */
+typedef struct {
+    FrameSourceType type;
+    FILE *fp;               /* リストまたは生のフレームのファイル */
+    int close_fp;           /* 1: frame_source_close() で閉じる（標準入力は 0） */
+    int width, height;      /* 生のフレームのサイズ */
+    int frames;             /* ここまでに読んだフレーム数 */
+    int error;              /* 1: 読み込みに失敗した（入力の終わりではない） */
+} FrameSource;
+
+/* フレームの先読み（デコード用のスレッドと有限の待ち行列） */
+typedef struct {
+    FrameSource *source;    /* 所有しない */
+    int depth;              /* 待ち行列の長さ（0: 先読みしない） */
+    Image *queue[FRAME_PIPELINE_MAX_DEPTH];
+    int head, size;
+    int finished;           /* 1: 入力の終わりに達したか読み込みに失敗した */
+    int error;              /* 1: 読み込みに失敗して止まった（source->error） */
+    int stop;               /* 1: デコードを止める */
+    double decode_seconds;  /* デコードにかかった時間の合計 */
+    int started;            /* 1: スレッドを起動した */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} FramePipeline;
+
+/* 推定する回転のモデル */
+typedef enum {
+    TRACK_YAW,              /* ヨー角だけ（逆合成法） */
+    TRACK_ROTATION          /* ヨー・ピッチ・ロール */
+} TrackModel;
+
+/* 相対回転の基準 */
+typedef enum {
+    TRACK_PREVIOUS,         /* 直前のフレーム */
+    TRACK_KEYFRAME          /* キーフレーム */
+} TrackReference;
+
+/* 追跡の設定 */
+typedef struct {
+    TrackModel model;
+    TrackReference reference;
+    Region region;                  /* 比較領域（基準のフレームの座標） */
+    int predict;                    /* 1: 等速の予測を初期値に, 0: 直前の回転 */
+    int acquire_levels;             /* 捕捉のピラミッドのレベル数（0: 捕捉しない） */
+    int keyframe_interval;          /* キーフレームを替えるフレーム数（0: 替えない） */
+    double keyframe_max_deg;        /* キーフレームからの回転がこれを超えたら替える */
+    YawEstimatorOptions yaw;        /* TRACK_YAW の設定 */
+    RegistrationOptions rotation;   /* TRACK_ROTATION の設定 */
+} TrackerOptions;
+
+/* 1フレームの推定結果 */
+typedef struct {
+    int frame;                      /* フレームの番号（0 から） */
+    Matrix3x3 R;                    /* 最初のフレームに対する回転 */
+    double yaw_deg, pitch_deg, roll_deg;    /* R = R_pr(pitch, roll) × R(Y)(yaw) */
+    double predicted_yaw_deg;       /* 初期値にした予測のヨー角 */
+    double E;                       /* 目的関数の値（残差） */
+    int passes;                     /* 比較領域を走査した回数 */
+    int converged;                  /* 1: 反復が収束した */
+    int acquired;                   /* 1: 予測を使わず全周探索から求めた */
+    int keyframe;                   /* 1: このフレームを基準のフレームにした */
+    double seconds;                 /* 推定にかかった時間 */
+} TrackPose;
+
+/* 追跡の状態 */
+typedef struct {
+    TrackerOptions opt;
+    int frames;                     /* 処理したフレーム数 */
+    Image *key;                     /* 基準のフレーム */
+    Matrix3x3 R_key;                /* 基準のフレームの回転 */
+    double yaw_key;                 /* TRACK_YAW: 基準のフレームのヨー角 */
+    int key_frame;                  /* 基準のフレームの番号 */
+    YawTemplate *key_template;      /* TRACK_YAW: 基準のフレームの事前計算 */
+    GrayImage *key_gray;            /* TRACK_ROTATION: 基準のフレームの輝度 */
+    Matrix3x3 R_prev, R_prev2;      /* 直前と2つ前のフレームの回転 */
+    double yaw_prev, yaw_prev2;     /* TRACK_YAW: 直前と2つ前のヨー角 */
+    int lost;                       /* 1: 直前のフレームで収束しなかった */
+} Tracker;
+
+
+/* 画像ファイルのリストを開く
+ *
+ * 戻り値:
+ *   フレームの入力（frame_source_close() で閉じる）、失敗時は NULL
+ */
+FrameSource* frame_source_open_list(const char *filename);
+
+/* 生の RGB のフレームの連続を開く
+ *
+ * 入力:
+ *   filename      - ファイル名（"-" で標準入力）
+ *   width, height - フレームのサイズ
+ */
+FrameSource* frame_source_open_raw(const char *filename, int width, int height);
+
+/* 次のフレームを読む
+ *
+ * 画像が読めない、生のフレームが途中で終わっている場合は source->error = 1
+ * とし、以後は NULL を返す（入力の終わりでは error = 0 のまま）。
+ *
+ * 戻り値:
+ *   フレーム（image_free() で解放）、終わりまたは失敗時は NULL
+ */
+Image* frame_source_next(FrameSource *source);
+
+/* 閉じる */
+void frame_source_close(FrameSource *source);
+
+/* 先読みを始める
+ *
+ * 入力:
+ *   source - フレームの入力
+ *   depth  - 先読みするフレーム数（0 で先読みせず frame_pipeline_next() の
+ *            中で読む、上限は FRAME_PIPELINE_MAX_DEPTH）
+ *
+ * 戻り値:
+ *   先読みの状態（frame_pipeline_stop() で解放）、失敗時は NULL
+ */
+FramePipeline* frame_pipeline_start(FrameSource *source, int depth);
+
+/* 次のフレームを取り出す（デコードが終わるまで待つ）
+ *
+ * 戻り値:
+ *   フレーム（image_free() で解放）、終わりまたは失敗時は NULL
+ *   （失敗は pipeline->error = 1 で区別する）
+ */
+Image* frame_pipeline_next(FramePipeline *pipeline);
+
+/* 先読みを止めて解放（残ったフレームも解放する） */
+void frame_pipeline_stop(FramePipeline *pipeline);
+
+/* 標準の設定（TRACK_YAW、キーフレーム、等速の予測）
+ *
+ * 入力:
+ *   region - 比較領域
+ */
+TrackerOptions tracker_default_options(Region region);
+
+/* 追跡を始める
+ *
+ * 戻り値:
+ *   追跡の状態（tracker_free() で解放）、失敗時は NULL
+ */
+Tracker* tracker_create(const TrackerOptions *options);
+
+/* 次のフレームの回転を推定
+ *
+ * 最初のフレームは回転なし（単位行列）で基準のフレームにする。
+ * 推定に失敗した場合は予測の回転を pose に入れて converged = 0 とする。
+ * このフレームは基準にせず、次のフレームは今の基準のフレームに対して
+ * 捕捉から始める。
+ *
+ * 入力:
+ *   tracker - 追跡の状態
+ *   frame   - フレーム（所有権を移す。基準のフレームにしない場合は解放する）
+ *
+ * 出力:
+ *   pose - 推定結果
+ *
+ * 戻り値:
+ *   1: pose を求めた, 0: 失敗（サイズが違う、メモリ確保失敗）
+ */
+int tracker_add_frame(Tracker *tracker, Image *frame, TrackPose *pose);
+
+/* メモリ解放 */
+void tracker_free(Tracker *tracker);
+
+/* 軌跡のファイル（CSV）の見出しと1行 */
+void trajectory_write_header(FILE *fp);
+void trajectory_write_pose(FILE *fp, const TrackPose *pose);
+
+#endif /* TRACKING_H */
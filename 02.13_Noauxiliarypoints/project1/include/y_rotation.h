@@ -10,6 +10,64 @@
 #include "vector_math.h"
 #include "image_utils.h"
 
+/* 比較領域（両端を含む） */
+typedef struct {
+  int u_min, v_min;   /* 左上 */
+  int u_max, v_max;   /* 右下 */
+} Region;
+
+/* 目的関数とその微分（1回の走査で計算） */
+typedef struct {
+  double E;           /* 目的関数 E(ψ) */
+  double gradient;    /* dE/dψ（ラジアン当たり） */
+  double hessian;     /* ガウス・ニュートン近似の d²E/dψ² = (1/N) Σ (dSr/dψ)² */
+  int count;          /* 画素数 N */
+} ObjectiveTerms;
+
+/* compute_objective_batch() で1回に受け持つ角度の数
+ * （角度ごとの回転行列と加算器を小さな配列に収めるため）
+ */
+#define OBJECTIVE_BATCH_ANGLES 32
+
+/* 逆合成法（inverse compositional）用に事前計算した基準画像
+ *
+ * 基準画像の側に微小回転 R(Δ) を掛けて
+ *   E(Δ) = (1/2N) Σ (Sb(R(Δ) X) - Sr(R(ψ) X))²
+ * を最小化し、ψ ← ψ - Δ と更新する（Y軸回りの回転は可換）。
+ * 最急降下画像 SD = dSb(R(Δ) X)/dΔ |Δ=0 とヘッセ行列 H = (1/N) Σ SD² は
+ * ψ によらないので最初に1回だけ計算する。
+ */
+typedef struct {
+  int width, height;      /* 基準画像のサイズ */
+  Region region;          /* 比較領域 */
+  int count;              /* 画素数 N */
+  Vector3D *X;            /* 各画素の世界座標 */
+  double *Sb;             /* 各画素の輝度 */
+  double *SD;             /* 最急降下画像 */
+  double hessian;         /* H（ラジアン当たり） */
+} YawTemplate;
+
+/* 基準画像の比較領域の事前計算（角度によらない量）
+ *
+ * compute_objective_function() などは角度ごとに全画素の
+ * image_to_world(u, v) と基準画像の輝度を求め直すが、どちらも ψ によらない。
+ * 比較領域ごとに1回だけ求め、成分ごとの配列（SoA）に持つ。
+ * 作るのに1回の走査と 4N 個の double が要るので、同じ比較領域で何度も
+ * 評価する場合（掃引、反復）に使い、1回だけの評価は元の関数で直接計算する。
+ * 画素 i = (v - v_min) w + (u - u_min) の順（w は比較領域の幅）。
+ * *_ctx の関数の角度ごとの処理は、回転・投影・参照画像の補間だけになる。
+ */
+typedef struct {
+  int width, height;      /* 基準画像のサイズ */
+  Region region;          /* 比較領域 */
+  int region_width;       /* w */
+  int rows;               /* 比較領域の行数 */
+  int count;              /* 画素数 N */
+  double *X, *Y, *Z;      /* 各画素の世界座標 */
+  double *Sb;             /* 各画素の輝度 */
+} RegionContext;
+
+
 /* ===========================
  * Y軸回りの回転行列
  * =========================== */
@@ -74,6 +132,34 @@ double compute_objective_function(
     int u_max, int v_max
 );
 
+/* 複数の角度の目的関数をまとめて計算
+ * 
+ * 比較領域の基準画像の画素（世界座標と輝度）を1回だけ読み込み、
+ * 画素ごとに K 個の角度で参照画像を補間して K 個の和に加える。
+ * 角度は OBJECTIVE_BATCH_ANGLES 個ずつ処理する（基準画像の読み込みは1回）。
+ * 各角度の値は compute_objective_function() とビット単位で一致する。
+ * 
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r
+ *   psis - 回転角度の列（度数法）
+ *   K    - 角度の数
+ *   比較領域の座標
+ * 
+ * 出力:
+ *   E - E(psis[k]) を E[k] に（K 個）
+ * 
+ * 戻り値:
+ *   1: 成功, 0: メモリ不足
+ */
+int compute_objective_batch(
+    Image *base, Image *ref,
+    const double *psis, int K,
+    int u_min, int v_min,
+    int u_max, int v_max,
+    double *E
+);
+
 
 /* ===========================
  * 微分の計算
@@ -90,7 +176,7 @@ double compute_objective_function(
  *   比較領域の座標
  * 
  * 出力:
- *   理論微分の値
+ *   理論微分の値（compute_objective_terms() の gradient と同じ）
  */
 double compute_analytical_derivative(
     Image *base, Image *ref,
@@ -121,4 +207,243 @@ double compute_numerical_derivative(
     int u_max, int v_max
 );
 
+/* 目的関数・理論微分・ガウス・ニュートンのヘッセ行列を同時に計算
+ * 
+ * 画素ごとの dSr/dψ（式15の連鎖律）を1回だけ求めて
+ *   E   = (1/2N) Σ (Sr - Sb)²
+ *   g   = (1/N)  Σ (Sr - Sb) dSr/dψ
+ *   H   = (1/N)  Σ (dSr/dψ)²
+ * を1回の走査で計算する。
+ * E は compute_objective_function() と同じ順序で加算するので値も一致する。
+ * 角度を掃引する場合、刻みと同じ Δψ の数値微分は隣の角度の E から求まる。
+ *
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r
+ *   psi_deg - 回転角度（度数法）
+ *   比較領域の座標
+ * 
+ * 出力:
+ *   terms - E, dE/dψ, d²E/dψ²（微分はラジアン当たり）
+ */
+void compute_objective_terms(
+    Image *base, Image *ref,
+    double psi_deg,
+    int u_min, int v_min,
+    int u_max, int v_max,
+    ObjectiveTerms *terms
+);
+
+
+/* ===========================
+ * 基準画像の比較領域（事前計算）
+ * =========================== */
+
+/* 基準画像の比較領域の世界座標と輝度を求める
+ * 
+ * 入力:
+ *   base   - 基準画像 I_b
+ *   region - 比較領域
+ * 
+ * 出力:
+ *   事前計算の結果（region_context_free() で解放）、失敗時は NULL
+ */
+RegionContext* region_context_create(Image *base, Region region);
+
+/* メモリ解放 */
+void region_context_free(RegionContext *ctx);
+
+/* compute_objective_function() の RegionContext 版（値はビット単位で一致） */
+double compute_objective_function_ctx(const RegionContext *ctx, Image *ref,
+                                      double psi_deg);
+
+/* compute_objective_batch() の RegionContext 版（値はビット単位で一致）
+ * 
+ * 戻り値:
+ *   1（メモリを確保しないので失敗しない）
+ */
+int compute_objective_batch_ctx(const RegionContext *ctx, Image *ref,
+                                const double *psis, int K, double *E);
+
+/* compute_analytical_derivative() の RegionContext 版 */
+double compute_analytical_derivative_ctx(const RegionContext *ctx, Image *ref,
+                                         double psi_deg);
+
+/* compute_objective_terms() の RegionContext 版（値はビット単位で一致） */
+void compute_objective_terms_ctx(const RegionContext *ctx, Image *ref,
+                                 double psi_deg, ObjectiveTerms *terms);
+
+/* compute_objective_terms_ctx() の比較領域の一部の行（掃引の行ブロック用）
+ * 
+ * 入力:
+ *   row0, row1 - 比較領域の行の番号（0 〜 rows - 1、両端を含む）
+ */
+void compute_objective_terms_ctx_rows(const RegionContext *ctx, Image *ref,
+                                      double psi_deg, int row0, int row1,
+                                      ObjectiveTerms *terms);
+
+
+/* ===========================
+ * Y軸回り専用の閉じた形（球面座標を経由しない）
+ * =========================== */
+
+/* compute_objective_function() の Y軸回り専用版
+ * 
+ * Y軸回りの回転では θ' = θ - ψ, φ' = φ なので
+ *   u_ref = u - ψ W/360（度数法）,  v_ref = v
+ * となり、各行は同じ行の u 方向にずらした1次元の補間になる。
+ * image_to_world(), 回転行列, world_to_image()（atan2, acos）を使わない。
+ * 補間は get_gray_bilinear() の dv = 0 の場合と同じ（切り捨てなし）
+ * なので、一般の経路との差は u_ref, v_ref の丸め誤差の分だけ。
+ * Y軸以外の回転には一般の経路を使うこと。
+ * 
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r（base と同じサイズ）
+ *   psi_deg - 回転角度（度数法）
+ *   比較領域の座標
+ * 
+ * 出力:
+ *   目的関数の値
+ */
+double compute_objective_function_yaw(
+    Image *base, Image *ref,
+    double psi_deg,
+    int u_min, int v_min,
+    int u_max, int v_max
+);
+
+/* compute_objective_terms() の Y軸回り専用版
+ * 
+ * 式15の連鎖律は dSr/dψ = -∂S/∂θ = -(∂S/∂u) W/2π になり、
+ * 三角関数を使わずに
+ *   g = (1/N) Σ (Sr - Sb) (-(∂S/∂u) W/2π),  H = (1/N) Σ ((∂S/∂u) W/2π)²
+ * を求める（∂S/∂u は Sr の補間に使った同じ行の2画素の線形補間の傾き）。
+ * 
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r（base と同じサイズ）
+ *   psi_deg - 回転角度（度数法）
+ *   比較領域の座標
+ * 
+ * 出力:
+ *   terms - E, dE/dψ, d²E/dψ²（微分はラジアン当たり）
+ */
+void compute_objective_terms_yaw(
+    Image *base, Image *ref,
+    double psi_deg,
+    int u_min, int v_min,
+    int u_max, int v_max,
+    ObjectiveTerms *terms
+);
+
+
+/* 打ち切り付きの目的関数で行を足す順序
+ * 
+ * 比較領域の各行の基準画像の輝度の分散が大きい順（同じ値は v の昇順）。
+ * 分散の大きい行ほど角度がずれたときの差が大きいので、先に足すと
+ * 部分和が早く上限を超える。
+ * 
+ * 出力:
+ *   行 v の列（v_max - v_min + 1 個、free() で解放）、失敗時は NULL
+ */
+int* objective_row_order(Image *base, int u_min, int v_min, int u_max, int v_max);
+
+/* compute_objective_function_yaw() の打ち切り付き版（最小値の探索用）
+ * 
+ * 行ごとに差の2乗を足し、E の部分和が bound を超えた時点でやめる。
+ * 差の2乗は負でないので、打ち切った場合（rows_done が行数未満）の戻り値
+ * （部分和から求めた E）は bound より大きく、本当の E 以下。
+ * 最後まで足した場合は E そのもの（行の順序が違うので
+ * compute_objective_function_yaw() と下位の桁が異なることがある）。
+ * 
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   psi_deg   - 回転角度（度数法）
+ *   比較領域の座標
+ *   row_order - 行を足す順序（objective_row_order()、NULL で上から順）
+ *   bound     - E の上限（これを超えたら打ち切り、HUGE_VAL で打ち切りなし）
+ * 
+ * 出力:
+ *   rows_done - 足した行の数（行数と等しければ最後まで計算した、NULL 可）
+ * 
+ * 戻り値:
+ *   E（打ち切った場合は bound より大きい部分和）
+ */
+double compute_objective_function_yaw_bounded(
+    Image *base, Image *ref,
+    double psi_deg,
+    int u_min, int v_min,
+    int u_max, int v_max,
+    const int *row_order,
+    double bound,
+    int *rows_done
+);
+
+
+/* ===========================
+ * グレースケール画像（ピラミッド用）
+ * =========================== */
+
+/* グレースケール画像での目的関数・理論微分・ヘッセ行列
+ * 
+ * compute_objective_terms_yaw() と同じ閉じた形の E, g, H を GrayImage で
+ * 計算する（ピラミッドの各レベルの画像に使う）。
+ * 
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r（base と同じサイズ）
+ *   psi_deg - 回転角度（度数法）
+ *   比較領域の座標
+ * 
+ * 出力:
+ *   terms - E, dE/dψ, d²E/dψ²（微分はラジアン当たり）
+ */
+void compute_objective_terms_gray(
+    const GrayImage *base, const GrayImage *ref,
+    double psi_deg,
+    int u_min, int v_min,
+    int u_max, int v_max,
+    ObjectiveTerms *terms
+);
+
+
+/* ===========================
+ * 逆合成法
+ * =========================== */
+
+/* 基準画像の比較領域から逆合成法の事前計算を行う
+ * 
+ * 入力:
+ *   base   - 基準画像 I_b
+ *   region - 比較領域
+ * 
+ * 出力:
+ *   事前計算の結果（yaw_template_free() で解放）、失敗時は NULL
+ */
+YawTemplate* yaw_template_create(Image *base, Region region);
+
+/* メモリ解放 */
+void yaw_template_free(YawTemplate *tmpl);
+
+/* 逆合成法での目的関数とその微分
+ * 
+ * 画素ごとの処理は参照画像の1回のバイリニア補間だけで
+ *   E = (1/2N) Σ (Sr(R(ψ) X) - Sb)²
+ *   g = (1/N)  Σ SD (Sr(R(ψ) X) - Sb)
+ *   H = tmpl->hessian
+ * を求める。g は dE/dψ の近似で、最小点の近くで一致する。
+ * E は compute_objective_function() と同じ値。
+ * 
+ * 入力:
+ *   tmpl - yaw_template_create() の結果
+ *   ref  - 参照画像 I_r
+ *   psi_deg - 回転角度（度数法）
+ * 
+ * 出力:
+ *   terms - E, g, H（微分はラジアン当たり）
+ */
+void compute_objective_terms_ic(const YawTemplate *tmpl, Image *ref,
+                                double psi_deg, ObjectiveTerms *terms);
+
 #endif /* Y_ROTATION_H */
\ No newline at end of file
@@ -0,0 +1,225 @@
+/* yaw_estimator.h
+ * ヨー角の推定（ガウス・ニュートン / レーベンバーグ・マーカート法）
+ *
+ * 目的関数 E(ψ) = (1/2N) Σ (Sr - Sb)² を初期値 ψ0 から反復で最小化する。
+ *
+ *   g = dE/dψ,  H = (1/N) Σ (dSr/dψ)²  （compute_objective_terms() で1回の走査）
+ *   Δψ = -g / (H (1 + λ))
+ *
+ * E が減れば更新して λ を小さく、増えれば λ を大きくしてやり直す。
+ * 1反復は比較領域の1回の走査。
+ *
+ * 逆合成法（estimate_y_rotation_ic）では g と H を基準画像側の微分で
+ * 近似し、H は反復によらない定数になる。
+ *
+ * 収束は減衰なしの更新量 |g / H| が tolerance_deg 未満になったときとする。
+ * 勾配が当てにならない場合（H <= 0、λ が上限を超えた、減衰した更新量が
+ * tolerance_deg 未満でも E が減らない、反復が収束しない）は
+ * 初期値の周りの区間で目的関数だけを使うブレント法に切り替える。
+ *
+ * 露出の異なる画像の組には、同じ反復を ZNCC の目的関数 1 - ρ（zncc.h）で
+ * 行う estimate_y_rotation_zncc() を、輝度の関係が1次式でない組には
+ * 相互情報量 -MI（mutual_info.h）で行う estimate_y_rotation_mi() を使う。
+ * 複数の比較領域をまとめて使う場合は、全体の目的関数（region_set.h）で
+ * 行う estimate_y_rotation_regions() を使う。
+ *
+ * 粗密探索（estimate_y_rotation_pyramid）では、ピラミッドの最上位で
+ * 全周を探索し（yaw_search_fft）、その結果を初期値として各レベルで
+ * ガウス・ニュートン法を行う。初期値が分からない大きな回転にも使える。
+ */
+
+#ifndef YAW_ESTIMATOR_H
+#define YAW_ESTIMATOR_H
+
+#include "y_rotation.h"
+#include "pyramid.h"
+#include "zncc.h"
+#include "mutual_info.h"
+#include "region_set.h"
+
+/* 推定の結果の状態 */
+typedef enum {
+    YAW_CONVERGED,          /* ガウス・ニュートン法で収束 */
+    YAW_BRENT_FALLBACK,     /* ブレント法で求めた */
+    YAW_MAX_ITERATIONS,     /* 反復回数の上限に達した（フォールバックなし） */
+    YAW_FAILED              /* 失敗（勾配が使えずフォールバックもなし） */
+} YawStatus;
+
+/* 推定の設定 */
+typedef struct {
+    int max_iterations;         /* ガウス・ニュートン法の最大反復回数 */
+    double tolerance_deg;       /* 減衰なしの更新量がこれ未満で収束（度数法） */
+    double lambda_init;         /* λ の初期値 */
+    double lambda_max;          /* λ がこれを超えたら失敗とみなす */
+    int use_brent_fallback;     /* 1: 失敗時にブレント法を使う */
+    double brent_half_range_deg;/* ブレント法の探索区間 ψ0 ± この値（度数法） */
+    double brent_tolerance_deg; /* ブレント法の収束判定（度数法） */
+} YawEstimatorOptions;
+
+/* 推定の結果 */
+typedef struct {
+    double psi_deg;     /* 推定した角度（度数法） */
+    double E;           /* 最終的な目的関数の値（残差） */
+    double gradient;    /* 最終的な dE/dψ（ブレント法では未計算で 0） */
+    int iterations;     /* ガウス・ニュートン法の反復回数 */
+    int passes;         /* 比較領域を走査した回数（ブレント法を含む） */
+    YawStatus status;
+} YawEstimate;
+
+/* 粗密探索の結果 */
+typedef struct {
+    YawEstimate estimate;       /* レベル0での推定結果 */
+    int levels;                 /* 実際に使ったレベル数 */
+    double build_seconds;       /* ピラミッドの作成時間 */
+    double search_psi_deg;      /* 最上位レベルの全周探索の結果（度数法） */
+    double search_seconds;      /* 全周探索の時間 */
+    double level_psi_deg[PYRAMID_MAX_LEVELS];   /* 各レベルで推定した角度 */
+    int level_passes[PYRAMID_MAX_LEVELS];       /* 各レベルの走査回数 */
+    double level_seconds[PYRAMID_MAX_LEVELS];   /* 各レベルの時間（全周探索を除く） */
+} YawPyramidEstimate;
+
+
+/* 標準の設定 */
+YawEstimatorOptions yaw_estimator_default_options(void);
+
+/* ヨー角を推定
+ *
+ * 入力:
+ *   base     - 基準画像 I_b
+ *   ref      - 参照画像 I_r
+ *   region   - 比較領域
+ *   init_deg - 初期値（度数法、yaw_search_fft() の結果など）
+ *   options  - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation(Image *base, Image *ref, Region region,
+                        double init_deg, const YawEstimatorOptions *options,
+                        YawEstimate *result);
+
+/* estimate_y_rotation() の RegionContext 版（結果は同じ）
+ *
+ * 同じ基準画像・比較領域で参照画像を替えて何度も推定する場合に使う。
+ *
+ * 入力:
+ *   ctx - region_context_create() の結果
+ *   ref - 参照画像 I_r
+ *   その他は estimate_y_rotation() と同じ
+ */
+int estimate_y_rotation_ctx(const RegionContext *ctx, Image *ref, double init_deg,
+                            const YawEstimatorOptions *options, YawEstimate *result);
+
+/* ヨー角を推定（逆合成法）
+ *
+ * estimate_y_rotation() と同じ反復だが、dSr/dψ の代わりに基準画像側の
+ * 最急降下画像（yaw_template_create() で1回だけ計算）を使い、
+ * ヘッセ行列も定数になる。1反復は参照画像の1回のバイリニア補間だけ。
+ * 同じ基準画像に対して多数の参照画像（フレーム）を推定する場合に向く。
+ *
+ * 入力:
+ *   tmpl     - 基準画像の事前計算（比較領域を含む）
+ *   ref      - 参照画像 I_r
+ *   init_deg - 初期値（度数法）
+ *   options  - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果（gradient は逆合成法の g）
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation_ic(const YawTemplate *tmpl, Image *ref, double init_deg,
+                           const YawEstimatorOptions *options, YawEstimate *result);
+
+/* ヨー角を推定（ZNCC）
+ *
+ * estimate_y_rotation() と同じ反復で E_zncc = 1 - ρ を最小化する。
+ * 基準画像と参照画像の明るさ・コントラストが異なっても最小点がずれない。
+ * H には区間内の厳密な2階微分を使う（最小点の近くで正）。
+ *
+ * 入力:
+ *   ctx      - zncc_context_create() の結果（比較領域を含む）
+ *   init_deg - 初期値（度数法）
+ *   options  - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果（E は 1 - ρ）
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation_zncc(const ZnccContext *ctx, double init_deg,
+                             const YawEstimatorOptions *options, YawEstimate *result);
+
+/* ヨー角を推定（相互情報量）
+ *
+ * estimate_y_rotation() と同じ反復で E_mi = -MI を最小化する。
+ * 輝度の対応が1次式でない画像の組（別のセンサー、昼夜など）に使う。
+ *
+ * 入力:
+ *   ctx      - mi_context_create() の結果（比較領域を含む、作業領域を使う）
+ *   init_deg - 初期値（度数法）
+ *   options  - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果（E は -MI）
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation_mi(MiContext *ctx, double init_deg,
+                           const YawEstimatorOptions *options, YawEstimate *result);
+
+/* ヨー角を推定（複数の比較領域）
+ *
+ * estimate_y_rotation() と同じ反復で、全ての領域の全体の目的関数
+ * E = Σ N_r E_r / Σ N_r を最小化する。1反復は全ての領域の1回の走査。
+ *
+ * 入力:
+ *   ctx      - region_set_context_create() の結果
+ *   init_deg - 初期値（度数法）
+ *   options  - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果（E は全体の目的関数）
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation_regions(const RegionSetContext *ctx, double init_deg,
+                                const YawEstimatorOptions *options, YawEstimate *result);
+
+/* ヨー角を推定（ピラミッドによる粗密探索）
+ *
+ * 基準画像・参照画像のピラミッド（u 方向は周期的）を作り、
+ *   1. 最上位レベルで全ての整数シフトの目的関数を求め（yaw_search_fft）、
+ *      最小点を初期値にする（初期値は不要）
+ *   2. 粗いレベルから順に compute_objective_terms_gray() による
+ *      ガウス・ニュートン法で求め、次のレベルの初期値にする
+ * 各レベルの収束判定は tolerance_deg × 2^level（画素の角度に比例）。
+ * ブレント法への切り替えはレベル0でだけ行う。
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   region    - 比較領域（レベル0の座標）
+ *   levels    - ピラミッドのレベル数（画像が小さい場合は減らす）
+ *   options   - 設定（NULL で標準）
+ *
+ * 出力:
+ *   result - 推定結果と各レベルの時間
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+int estimate_y_rotation_pyramid(GrayImage *base, GrayImage *ref, Region region,
+                                int levels, const YawEstimatorOptions *options,
+                                YawPyramidEstimate *result);
+
+/* 状態の名前 */
+const char* yaw_status_name(YawStatus status);
+
+#endif /* YAW_ESTIMATOR_H */
@@ -0,0 +1,64 @@
+/* yaw_search.h
+ * FFTによるヨー角の全探索
+ *
+ * Y軸回りの回転 R(Y)(ψ) は θ' = θ - ψ なので、正距円筒画像上では
+ * u 方向の循環シフト u_ref = u - ψ W/(2π) になる（v は変わらない）。
+ * 整数シフト s（ψ = 360 s / W 度）に対する目的関数（式14）は
+ *
+ *   2N E(s) = Σ Sb² + Σ Sr(u - s)² - 2 Σ Sb(u) Sr(u - s)
+ *
+ * と展開でき、第3項は行ごとの循環相互相関なので、
+ * 全ての s について FFT でまとめて計算できる。
+ * 第2項は Sr² の行方向の累積和から求める。
+ *
+ * 最小となるシフトの前後3点に放物線を当てはめて
+ * サブピクセル精度の角度を求める。
+ */
+
+#ifndef YAW_SEARCH_H
+#define YAW_SEARCH_H
+
+#include "image_utils.h"
+
+/* 目的関数の全周の曲線 */
+typedef struct {
+    int width;              /* 画像の幅 W（= シフトの数） */
+    double *E;              /* E[s] : シフト s 画素（ψ = 360 s / W 度）の目的関数 */
+    int best_shift;         /* E が最小のシフト */
+    double best_psi_deg;    /* サブピクセル補正後の角度（-180° 〜 180°） */
+    double best_E;          /* 最小値 E[best_shift] */
+} YawCurve;
+
+
+/* 全ての整数シフトについて目的関数を計算
+ *
+ * 入力:
+ *   base - 基準画像 I_b
+ *   ref  - 参照画像 I_r（base と同じサイズ）
+ *   u_min, v_min - 比較領域の左上
+ *   u_max, v_max - 比較領域の右下
+ *
+ * 出力:
+ *   curve - 全周の目的関数と最小値（yaw_curve_free() で解放）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int yaw_search_fft(const GrayImage *base, const GrayImage *ref,
+                   int u_min, int v_min, int u_max, int v_max,
+                   YawCurve *curve);
+
+/* シフト s を角度（-180° 〜 180°、度数法）に変換 */
+double yaw_shift_to_deg(int shift, int width);
+
+/* 曲線をCSVに保存（角度の昇順、列: angle_deg,objective_function）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 失敗
+ */
+int yaw_curve_save_csv(const YawCurve *curve, const char *filename);
+
+/* メモリ解放 */
+void yaw_curve_free(YawCurve *curve);
+
+#endif /* YAW_SEARCH_H */
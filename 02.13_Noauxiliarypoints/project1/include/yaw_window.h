@@ -0,0 +1,53 @@
+/* yaw_window.h
+ * Y軸回りの回転での参照画像の窓と画素の輝度（共通の小さな関数）
+ *
+ * Y軸回りの回転 ψ では θ' = θ - ψ なので u_ref = u - ψ W/360（度数法）、
+ * v_ref = v となり、比較領域の各行は参照画像の同じ行の u 方向の窓に移る。
+ * y_rotation.c, zncc.c, mutual_info.c, region_set.c はこの窓の位置と
+ * 画素の輝度をここの関数で求める。
+ */
+
+#ifndef YAW_WINDOW_H
+#define YAW_WINDOW_H
+
+#include <math.h>
+#include "image_utils.h"
+
+/* u の周期境界（0 <= u < W） */
+static inline int wrap_u(int u, int W) {
+    u %= W;
+    return (u < 0) ? u + W : u;
+}
+
+/* Y軸回りの回転 ψ での参照画像の u 方向のずれ
+ *
+ * 整数の u に対して u_ref = (u + k) + f（k は整数、0 <= f < 1）と分け、
+ * k と f は画素によらない。
+ */
+static inline void yaw_shift_split(double psi_deg, int W, int *k, double *f) {
+    double shift = -psi_deg * (double)W / 360.0;
+    double k_floor = floor(shift);
+    *k = (int)k_floor;
+    *f = shift - k_floor;
+}
+
+/* Y軸回りの回転 ψ での参照画像の窓の左端の列 x0（0 <= x0 < W）と補間の重み f
+ *
+ * 比較領域の u_min の列は参照画像の x0 + f に移る。
+ */
+static inline void yaw_window(double psi_deg, int W, int u_min, int *x0, double *f) {
+    int k;
+    yaw_shift_split(psi_deg, W, &k, f);
+    *x0 = wrap_u(u_min + k, W);
+}
+
+/* 画素 (u, v) の輝度 (R + G + B) / 3（get_pixel() と同じく u は周期的、
+ * v の範囲外は0）
+ */
+static inline double pixel_gray(Image *img, int u, int v) {
+    uint8_t rgb[3];
+    get_pixel(img, u, v, rgb);
+    return (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+}
+
+#endif /* YAW_WINDOW_H */
@@ -0,0 +1,88 @@
+/* zncc.h
+ * 零平均正規化相互相関（ZNCC）による目的関数（Y軸回り専用）
+ *
+ * 基準画像と参照画像の露出（明るさ・コントラスト）が異なると、
+ * 差の2乗の目的関数 E = (1/2N) Σ (Sr - Sb)² の最小点がずれる。
+ * ZNCC は輝度の1次変換 Sr → a Sr + b で変わらない:
+ *
+ *   ρ(ψ) = Σ (Sb - mb)(Sr - mr) / √(Σ (Sb - mb)² Σ (Sr - mr)²)
+ *   E_zncc(ψ) = 1 - ρ(ψ)   （0 で完全一致、最大 2）
+ *
+ * Y軸回りの回転では参照画像の比較領域は同じ行を u 方向に
+ *   s = -ψ W/360 = k + f （k は整数、0 <= f < 1）
+ * だけずらした窓になり、Sr = (1 - f) A + f B（A, B は同じ行の隣り合う
+ * 2画素 S(u + k), S(u + k + 1)）。窓は常に同じ行を覆うので、参照画像の
+ * S, S², S(u) S(u + 1) の列ごとの和の累積和（u 方向に周期的に延長した
+ * 積分画像）から
+ *   Σ Sr  = (1 - f) ΣA + f ΣB
+ *   Σ Sr² = (1 - f)² ΣA² + 2 f (1 - f) ΣAB + f² ΣB²
+ * が角度によらず O(1) で求まる。基準画像の平均と分散は1回だけ計算し、
+ * 角度ごとに走査するのは相互相関の項 Σ (Sb - mb) A, Σ (Sb - mb) B だけ。
+ *
+ * 補間は切り捨てのない輝度の線形補間（積分画像の和と正確に一致させるため、
+ * compute_objective_function_yaw() と同じ補間面）。Y軸以外の回転には使えない。
+ */
+
+#ifndef ZNCC_H
+#define ZNCC_H
+
+#include "y_rotation.h"
+
+/* 基準画像・参照画像の事前計算 */
+typedef struct {
+    int width, height;      /* 画像のサイズ */
+    Region region;          /* 比較領域 */
+    int region_width;       /* 比較領域の幅 w */
+    int rows;               /* 比較領域の行数 */
+    int count;              /* 画素数 N = w × rows */
+
+    double *base_zm;        /* 基準画像の Sb - mb（rows × w、行ごと） */
+    double base_var;        /* Σ (Sb - mb)² */
+
+    /* 参照画像の比較領域の行（u 方向に周期的に延長、rows × (W + w + 1)） */
+    int ext_width;          /* W + w + 1 */
+    double *ref_ext;
+
+    /* 延長した列 x について x より左の列の和の累積（ext_width + 1 個） */
+    double *sum_S;          /* Σ S */
+    double *sum_S2;         /* Σ S² */
+    double *sum_SS;         /* Σ S(x) S(x + 1) */
+} ZnccContext;
+
+
+/* 事前計算
+ *
+ * 入力:
+ *   base, ref - 基準画像・参照画像（同じサイズ）
+ *   region    - 比較領域（行は画像の内側、幅は W 以下）
+ *
+ * 出力:
+ *   事前計算の結果（zncc_context_free() で解放）、失敗時は NULL
+ */
+ZnccContext* zncc_context_create(Image *base, Image *ref, Region region);
+
+/* メモリ解放 */
+void zncc_context_free(ZnccContext *ctx);
+
+/* 目的関数 E_zncc(ψ) = 1 - ρ(ψ)
+ *
+ * 分散が 0 の場合（平坦な領域）は ρ = 0 とする。
+ */
+double zncc_objective(const ZnccContext *ctx, double psi_deg);
+
+/* 目的関数とその微分（理論値）
+ *
+ * f の区間の中では ρ は f の有理式なので、
+ *   dρ/ds  = C'/D - ρ V'/(2V)
+ *   d²ρ/ds² = -C' V'/(2 V D) - (dρ/ds) V'/(2V) - ρ (V''/(2V) - V'²/(2V²))
+ * （C = Σ (Sb - mb) Sr, V = Σ (Sr - mr)², D = √(Σ (Sb - mb)² V)、
+ *   ' は s での微分、ds/dψ = -W/2π）を積分画像と相互相関の2つの和から求める。
+ *
+ * 出力:
+ *   terms - E = 1 - ρ, gradient = dE/dψ, hessian = d²E/dψ²（いずれもラジアン
+ *           当たり、hessian はガウス・ニュートン近似でなく区間内の厳密な値）
+ */
+void zncc_objective_terms(const ZnccContext *ctx, double psi_deg,
+                          ObjectiveTerms *terms);
+
+#endif /* ZNCC_H */
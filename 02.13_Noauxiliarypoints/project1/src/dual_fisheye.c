@@ -0,0 +1,160 @@
+/* dual_fisheye.c
+ * デュアル魚眼カメラの入力モデルの実装
+ */
+
+#include "dual_fisheye.h"
+#include "rotation.h"
+#include "y_rotation.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法からラジアンへの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+
+/* 標準の混合幅（度） */
+#define DEFAULT_BLEND_DEG 4.0
+
+/* ===========================
+ * キャリブレーションの設定
+ * =========================== */
+
+void dual_fisheye_default(int width, int height, double fov_deg,
+                          DualFisheyeCalib *calib) {
+    memset(calib, 0, sizeof(*calib));
+
+    double radius = fmin(width / 4.0, height / 2.0);
+    for (int i = 0; i < 2; i++) {
+        FisheyeLens *lens = &calib->lens[i];
+        lens->cx = width / 4.0 + i * width / 2.0;
+        lens->cy = height / 2.0;
+        lens->radius = radius;
+        lens->fov_deg = fov_deg;
+        lens->yaw_deg = (i == 0) ? 0.0 : 180.0;
+    }
+    calib->blend_deg = DEFAULT_BLEND_DEG;
+
+    dual_fisheye_prepare(calib);
+}
+
+/* "lens0.cx" などの項目を設定（1: 成功, 0: 不明な項目） */
+static int set_lens_value(FisheyeLens *lens, const char *key, const double *vals,
+                          int n) {
+    if (strcmp(key, "cx") == 0 && n >= 1) {
+        lens->cx = vals[0];
+    } else if (strcmp(key, "cy") == 0 && n >= 1) {
+        lens->cy = vals[0];
+    } else if (strcmp(key, "radius") == 0 && n >= 1) {
+        lens->radius = vals[0];
+    } else if (strcmp(key, "fov") == 0 && n >= 1) {
+        lens->fov_deg = vals[0];
+    } else if (strcmp(key, "yaw") == 0 && n >= 1) {
+        lens->yaw_deg = vals[0];
+    } else if (strcmp(key, "pitch") == 0 && n >= 1) {
+        lens->pitch_deg = vals[0];
+    } else if (strcmp(key, "roll") == 0 && n >= 1) {
+        lens->roll_deg = vals[0];
+    } else if (strcmp(key, "k") == 0 && n >= 1) {
+        for (int j = 0; j < 4; j++) {
+            lens->k[j] = (j < n) ? vals[j] : 0.0;
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int dual_fisheye_load(const char *filename, int width, int height,
+                      DualFisheyeCalib *calib) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        fprintf(stderr, "エラー: キャリブレーションファイルが開けません: %s\n", filename);
+        return 0;
+    }
+
+    dual_fisheye_default(width, height, 190.0, calib);
+
+    char line[256];
+    int line_no = 0;
+    int ok = 1;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char key[64];
+        int consumed = 0;
+        if (sscanf(line, "%63s%n", key, &consumed) != 1) {
+            continue;  /* 空行 */
+        }
+
+        double vals[4];
+        int n = 0;
+        const char *p = line + consumed;
+        int len;
+        while (n < 4 && sscanf(p, "%lf%n", &vals[n], &len) == 1) {
+            p += len;
+            n++;
+        }
+
+        int known = 0;
+        if (strcmp(key, "blend") == 0 && n >= 1) {
+            calib->blend_deg = vals[0];
+            known = 1;
+        } else if (strncmp(key, "lens0.", 6) == 0) {
+            known = set_lens_value(&calib->lens[0], key + 6, vals, n);
+        } else if (strncmp(key, "lens1.", 6) == 0) {
+            known = set_lens_value(&calib->lens[1], key + 6, vals, n);
+        }
+
+        if (!known) {
+            fprintf(stderr, "エラー: %s:%d 不明な項目: %s\n", filename, line_no, key);
+            ok = 0;
+        }
+    }
+    fclose(fp);
+
+    dual_fisheye_prepare(calib);
+    return ok;
+}
+
+void dual_fisheye_prepare(DualFisheyeCalib *calib) {
+    for (int i = 0; i < 2; i++) {
+        FisheyeLens *lens = &calib->lens[i];
+        lens->R = matrix_multiply(
+            create_pitch_roll_matrix(lens->pitch_deg, lens->roll_deg),
+            create_y_rotation_matrix(lens->yaw_deg));
+        lens->alpha_max = DEG_TO_RAD(lens->fov_deg) / 2.0;
+        lens->focal = lens->radius / fisheye_lens_poly(lens, lens->alpha_max);
+    }
+    calib->blend_rad = DEG_TO_RAD(calib->blend_deg);
+    if (calib->blend_rad < 1e-9) {
+        calib->blend_rad = 1e-9;
+    }
+}
+
+/* r(α)/f = α + k1 α^3 + k2 α^5 + k3 α^7 + k4 α^9 */
+double fisheye_lens_poly(const FisheyeLens *lens, double alpha) {
+    double a2 = alpha * alpha;
+    return alpha * (1.0 + a2 * (lens->k[0] + a2 * (lens->k[1]
+                  + a2 * (lens->k[2] + a2 * lens->k[3]))));
+}
+
+void dual_fisheye_info(const DualFisheyeCalib *calib) {
+    printf("デュアル魚眼キャリブレーション:\n");
+    for (int i = 0; i < 2; i++) {
+        const FisheyeLens *lens = &calib->lens[i];
+        printf("  レンズ%d: 中心 (%.1f, %.1f), 半径 %.1f, 画角 %.1f°\n",
+               i, lens->cx, lens->cy, lens->radius, lens->fov_deg);
+        printf("          k = (%.4f, %.4f, %.4f, %.4f)\n",
+               lens->k[0], lens->k[1], lens->k[2], lens->k[3]);
+        printf("          向き: ヨー %.2f°, ピッチ %.2f°, ロール %.2f°\n",
+               lens->yaw_deg, lens->pitch_deg, lens->roll_deg);
+    }
+    printf("  継ぎ目の混合幅: %.2f°\n", calib->blend_deg);
+}
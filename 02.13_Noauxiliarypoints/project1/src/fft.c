@@ -0,0 +1,96 @@
+/* fft.c
+ * 高速フーリエ変換の実装
+ */
+
+#include "fft.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int fft_size_pow2(int n) {
+    int size = 1;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+int fft_complex(Complex *data, int n, int inverse) {
+    if (n <= 0 || (n & (n - 1)) != 0) {
+        return 0;
+    }
+
+    /* ビット反転の並べ替え */
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            Complex tmp = data[i];
+            data[i] = data[j];
+            data[j] = tmp;
+        }
+    }
+
+    /* バタフライ演算 */
+    double sign = inverse ? 1.0 : -1.0;
+    for (int len = 2; len <= n; len <<= 1) {
+        double angle = sign * 2.0 * M_PI / len;
+        double w_re = cos(angle);
+        double w_im = sin(angle);
+        int half = len >> 1;
+
+        for (int i = 0; i < n; i += len) {
+            double t_re = 1.0;
+            double t_im = 0.0;
+            for (int k = 0; k < half; k++) {
+                Complex *a = &data[i + k];
+                Complex *b = &data[i + k + half];
+                double x_re = b->re * t_re - b->im * t_im;
+                double x_im = b->re * t_im + b->im * t_re;
+                b->re = a->re - x_re;
+                b->im = a->im - x_im;
+                a->re += x_re;
+                a->im += x_im;
+
+                /* 回転因子を更新 */
+                double next_re = t_re * w_re - t_im * w_im;
+                t_im = t_re * w_im + t_im * w_re;
+                t_re = next_re;
+            }
+        }
+    }
+
+    if (inverse) {
+        for (int i = 0; i < n; i++) {
+            data[i].re /= n;
+            data[i].im /= n;
+        }
+    }
+    return 1;
+}
+
+int fft_real_pair(const double *a, const double *b, int n,
+                  Complex *work, Complex *A, Complex *B) {
+    for (int i = 0; i < n; i++) {
+        work[i].re = a[i];
+        work[i].im = b[i];
+    }
+    if (!fft_complex(work, n, 0)) {
+        return 0;
+    }
+
+    for (int k = 0; k < n; k++) {
+        const Complex *z = &work[k];
+        const Complex *zc = &work[(n - k) & (n - 1)];  /* Z(n-k)、k=0 では Z(0) */
+        A[k].re = 0.5 * (z->re + zc->re);
+        A[k].im = 0.5 * (z->im - zc->im);
+        B[k].re = 0.5 * (z->im + zc->im);
+        B[k].im = -0.5 * (z->re - zc->re);
+    }
+    return 1;
+}
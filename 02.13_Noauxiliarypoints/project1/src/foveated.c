@@ -0,0 +1,348 @@
+/* foveated.c
+ * 中心窩（foveated）描画の実装
+ */
+
+#include "foveated.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法からラジアンへの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+FoveationParams foveation_default(double inner_radius_deg) {
+    FoveationParams p;
+    p.inner_radius_deg = inner_radius_deg;
+    p.ring_width_deg = 15.0;
+    p.max_level = 3;
+    return p;
+}
+
+/* 角度 angle_deg を超えると z = cos(角度) がこれを下回る（180°以上は該当なし） */
+static double cos_threshold(double angle_deg) {
+    return (angle_deg >= 180.0) ? -2.0 : cos(DEG_TO_RAD(angle_deg));
+}
+
+/* 光軸方向の成分 z の方向のレベル
+ *   L = 1: 角度 > inner_radius（z < z_limit[1]）
+ *   L > 1: 角度 >= inner_radius + (L-1) ring_width（z <= z_limit[L]） */
+static int level_of(double z, const double *z_limit, int max_level) {
+    int L = 0;
+    while (L < max_level && (L == 0 ? z < z_limit[1] : z <= z_limit[L + 1])) {
+        L++;
+    }
+    return L;
+}
+
+/* 2つの単位ベクトルのなす角（ラジアン） */
+static double angle_between(Vector3D a, Vector3D b) {
+    double c = a.x * b.x + a.y * b.y + a.z * b.z;
+    if (c > 1.0) c = 1.0;
+    if (c < -1.0) c = -1.0;
+    return acos(c);
+}
+
+/* ブロックの全画素が同じレベルならそのレベル、分からなければ -1
+ *
+ * 中心と4隅の方向だけを投影し、中心から4隅までの角度の最大 ρ に余裕を
+ * 持たせた範囲 [α - 1.5ρ, α + 1.5ρ]（α は中心の光軸からの角度）が1つの
+ * レベルに収まるかで判定する。レベルは角度について単調なので、収まれば
+ * ブロック内の全画素がそのレベルになる。
+ */
+static int block_level(const ProjectionParams *out_p, int u0, int v0, int u1, int v1,
+                       const double *z_limit, int max_level) {
+    Vector3D c, corner[4];
+    if (!projection_to_world(out_p, 0.5 * (u0 + u1), 0.5 * (v0 + v1), &c) ||
+        !projection_to_world(out_p, (double)u0, (double)v0, &corner[0]) ||
+        !projection_to_world(out_p, (double)u1, (double)v0, &corner[1]) ||
+        !projection_to_world(out_p, (double)u0, (double)v1, &corner[2]) ||
+        !projection_to_world(out_p, (double)u1, (double)v1, &corner[3])) {
+        return -1;
+    }
+    double rho = 0.0;
+    for (int k = 0; k < 4; k++) {
+        rho = fmax(rho, angle_between(c, corner[k]));
+    }
+    double z = c.z;
+    if (z > 1.0) z = 1.0;
+    if (z < -1.0) z = -1.0;
+    double alpha = acos(z);
+    double lo = fmax(alpha - 1.5 * rho, 0.0);
+    double hi = fmin(alpha + 1.5 * rho, M_PI);
+    int L = level_of(cos(lo), z_limit, max_level);
+    return (L == level_of(cos(hi), z_limit, max_level)) ? L : -1;
+}
+
+/* 補間に使う格子点に印を付ける（画素 u0〜u1, v0〜v1 が全てレベル L） */
+static void mark_needed(FoveationPlan *plan, int L, int u0, int v0, int u1, int v1) {
+    int s = 1 << L;
+    int gw = plan->gw[L], gh = plan->gh[L];
+    int i0 = u0 / s, i1 = u1 / s + 1;
+    int j0 = v0 / s, j1 = v1 / s + 1;
+    if (i1 > gw - 1) i1 = gw - 1;
+    if (j1 > gh - 1) j1 = gh - 1;
+    for (int j = j0; j <= j1; j++) {
+        memset(plan->need[L] + (size_t)j * gw + i0, 1, (size_t)(i1 - i0 + 1));
+    }
+}
+
+FoveationPlan* foveation_plan_create(const ProjectionParams *out_p,
+                                     const FoveationParams *params) {
+    if (params->max_level < 0 || params->max_level >= FOVEATION_MAX_LEVELS ||
+        params->ring_width_deg <= 0.0) {
+        fprintf(stderr, "エラー: 中心窩描画のパラメータが不正です\n");
+        return NULL;
+    }
+
+    double start = now_seconds();
+    int W = out_p->width;
+    int H = out_p->height;
+    int max_level = params->max_level;
+
+    FoveationPlan *plan = (FoveationPlan*)calloc(1, sizeof(FoveationPlan));
+    if (!plan) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    plan->width = W;
+    plan->height = H;
+    plan->params = *params;
+    plan->level = (uint8_t*)malloc((size_t)W * H);
+    int ok = (plan->level != NULL);
+    for (int L = 1; ok && L <= max_level; L++) {
+        int step = 1 << L;
+        plan->gw[L] = (W - 1 + step - 1) / step + 1;
+        plan->gh[L] = (H - 1 + step - 1) / step + 1;
+        plan->need[L] = (uint8_t*)calloc((size_t)plan->gw[L] * plan->gh[L], 1);
+        ok = (plan->need[L] != NULL);
+    }
+    if (!ok) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        foveation_plan_free(plan);
+        return NULL;
+    }
+
+    /* レベル L 以上になる z の閾値 */
+    double z_limit[FOVEATION_MAX_LEVELS];
+    for (int L = 1; L <= max_level; L++) {
+        z_limit[L] = cos_threshold(params->inner_radius_deg + (L - 1) * params->ring_width_deg);
+    }
+
+    /* FOVEATION_BLOCK 四方のブロックごとに分類し、レベルの境界にかかる
+     * ブロックだけ画素ごとに投影する */
+    long projections = 0;
+    for (int bv = 0; bv < H; bv += FOVEATION_BLOCK) {
+        int v1 = (bv + FOVEATION_BLOCK < H) ? bv + FOVEATION_BLOCK - 1 : H - 1;
+        for (int bu = 0; bu < W; bu += FOVEATION_BLOCK) {
+            int u1 = (bu + FOVEATION_BLOCK < W) ? bu + FOVEATION_BLOCK - 1 : W - 1;
+            int L = block_level(out_p, bu, bv, u1, v1, z_limit, max_level);
+            projections += 5;
+            if (L >= 0) {
+                for (int v = bv; v <= v1; v++) {
+                    memset(plan->level + (size_t)v * W + bu, L, (size_t)(u1 - bu + 1));
+                }
+                plan->pixels_per_level[L] += (long)(u1 - bu + 1) * (v1 - bv + 1);
+                if (L > 0) mark_needed(plan, L, bu, bv, u1, v1);
+                continue;
+            }
+
+            for (int v = bv; v <= v1; v++) {
+                for (int u = bu; u <= u1; u++) {
+                    int Lp = max_level;
+                    Vector3D Xp;
+                    if (projection_to_world(out_p, (double)u, (double)v, &Xp)) {
+                        Lp = level_of(Xp.z, z_limit, max_level);
+                    }
+                    projections++;
+                    plan->level[(size_t)v * W + u] = (uint8_t)Lp;
+                    plan->pixels_per_level[Lp]++;
+                    if (Lp > 0) mark_needed(plan, Lp, u, v, u, v);
+                }
+            }
+        }
+    }
+
+    plan->samples_per_level[0] = plan->pixels_per_level[0];
+    for (int L = 1; L <= max_level; L++) {
+        size_t n = (size_t)plan->gw[L] * plan->gh[L];
+        for (size_t k = 0; k < n; k++) {
+            plan->samples_per_level[L] += plan->need[L][k];
+        }
+    }
+    plan->projections = projections;
+    plan->seconds = now_seconds() - start;
+    return plan;
+}
+
+void foveation_plan_free(FoveationPlan *plan) {
+    if (!plan) return;
+    free(plan->level);
+    for (int L = 0; L < FOVEATION_MAX_LEVELS; L++) {
+        free(plan->need[L]);
+    }
+    free(plan);
+}
+
+int foveated_render_plan(Image *input, const ProjectionParams *in_p,
+                         Image *output, const ProjectionParams *out_p,
+                         Matrix3x3 R_T, const FoveationPlan *plan,
+                         FoveationStats *stats) {
+    int W = out_p->width;
+    int H = out_p->height;
+    int C = input->channels;
+
+    if (output->width != W || output->height != H || output->channels != C || C > 4) {
+        fprintf(stderr, "エラー: 出力画像のサイズまたはチャンネル数が一致しません\n");
+        return 0;
+    }
+    if (plan->width != W || plan->height != H) {
+        fprintf(stderr, "エラー: 中心窩描画の計画と出力のサイズが一致しません\n");
+        return 0;
+    }
+    ProjectionSpanKernel span = projection_span_kernel(input, in_p, out_p, INTERP_BILINEAR);
+    if (!span) {
+        return 0;
+    }
+
+    double start = now_seconds();
+    int max_level = plan->params.max_level;
+
+    /* 必要な格子点を、格子の行ごとに連続した区間でまとめてサンプリング */
+    uint8_t *grids[FOVEATION_MAX_LEVELS] = {NULL};
+    int ok = 1;
+    for (int L = 1; ok && L <= max_level; L++) {
+        int s = 1 << L;
+        int gw = plan->gw[L], gh = plan->gh[L];
+        grids[L] = (uint8_t*)malloc((size_t)gw * gh * C);
+        if (!grids[L]) {
+            fprintf(stderr, "エラー: メモリ確保失敗\n");
+            ok = 0;
+            break;
+        }
+        for (int j = 0; j < gh; j++) {
+            const uint8_t *need = plan->need[L] + (size_t)j * gw;
+            uint8_t *row = grids[L] + (size_t)j * gw * C;
+            int v = (j * s > H - 1) ? H - 1 : j * s;
+            for (int i = 0; i < gw; ) {
+                if (!need[i]) { i++; continue; }
+                int i_end = i + 1;
+                while (i_end < gw && need[i_end]) i_end++;
+                span(input, in_p, out_p, &R_T, i * s, v, s, i_end - i, row + (size_t)i * C);
+                i = i_end;
+            }
+        }
+    }
+
+    for (int v = 0; ok && v < H; v++) {
+        const uint8_t *level = plan->level + (size_t)v * W;
+        uint8_t *out_row = output->data + (size_t)v * W * C;
+        for (int u = 0; u < W; ) {
+            int L = level[u];
+            if (L == 0) {
+                /* 全密度: レベル0の区間をそのまま描画 */
+                int u_end = u + 1;
+                while (u_end < W && level[u_end] == 0) u_end++;
+                span(input, in_p, out_p, &R_T, u, v, 1, u_end - u, out_row + (size_t)u * C);
+                u = u_end;
+                continue;
+            }
+
+            /* 粗い格子からバイリニア補間で拡大 */
+            int s = 1 << L;
+            int gw = plan->gw[L], gh = plan->gh[L];
+            int i0 = u / s;
+            int j0 = v / s;
+            int i1 = (i0 + 1 < gw) ? i0 + 1 : i0;
+            int j1 = (j0 + 1 < gh) ? j0 + 1 : j0;
+
+            int x0 = i0 * s, x1 = i1 * s;
+            int y0 = j0 * s, y1 = j1 * s;
+            if (x1 > W - 1) x1 = W - 1;
+            if (y1 > H - 1) y1 = H - 1;
+            double tx = (x1 > x0) ? (double)(u - x0) / (x1 - x0) : 0.0;
+            double ty = (y1 > y0) ? (double)(v - y0) / (y1 - y0) : 0.0;
+
+            const uint8_t *g = grids[L];
+            const uint8_t *p00 = g + ((size_t)j0 * gw + i0) * C;
+            const uint8_t *p10 = g + ((size_t)j0 * gw + i1) * C;
+            const uint8_t *p01 = g + ((size_t)j1 * gw + i0) * C;
+            const uint8_t *p11 = g + ((size_t)j1 * gw + i1) * C;
+
+            uint8_t *px = out_row + (size_t)u * C;
+            for (int c = 0; c < C; c++) {
+                float val = (float)((1.0 - tx) * (1.0 - ty) * p00[c]
+                                  + tx         * (1.0 - ty) * p10[c]
+                                  + (1.0 - tx) * ty         * p01[c]
+                                  + tx         * ty         * p11[c]);
+                px[c] = (uint8_t)(val + 0.5f);
+            }
+            u++;
+        }
+    }
+
+    for (int L = 0; L <= max_level; L++) {
+        free(grids[L]);
+    }
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->total_pixels = (long)W * H;
+        for (int L = 0; L <= max_level; L++) {
+            stats->pixels_per_level[L] = plan->pixels_per_level[L];
+            stats->samples_per_level[L] = plan->samples_per_level[L];
+            stats->samples += plan->samples_per_level[L];
+        }
+        /* サンプリングの削減（入力のサンプリング数 / 出力画素数）。
+         * レベル分けの費用は plan_projections, plan_seconds に別に入れる */
+        stats->saved_ratio = 1.0 - (double)stats->samples / (double)stats->total_pixels;
+        stats->render_seconds = now_seconds() - start;
+    }
+    return ok;
+}
+
+int foveated_render(Image *input, const ProjectionParams *in_p,
+                    Image *output, const ProjectionParams *out_p,
+                    Matrix3x3 R_T, const FoveationParams *params,
+                    FoveationStats *stats) {
+    FoveationPlan *plan = foveation_plan_create(out_p, params);
+    if (!plan) {
+        return 0;
+    }
+    int ok = foveated_render_plan(input, in_p, output, out_p, R_T, plan, stats);
+    if (ok && stats) {
+        stats->plan_projections = plan->projections;
+        stats->plan_seconds = plan->seconds;
+    }
+    foveation_plan_free(plan);
+    return ok;
+}
+
+void foveation_stats_print(const FoveationStats *stats) {
+    printf("中心窩描画の統計:\n");
+    printf("  出力画素数: %ld\n", stats->total_pixels);
+    printf("  サンプリング数: %ld (%.1f%% 削減)\n",
+           stats->samples, 100.0 * stats->saved_ratio);
+    printf("  レベル分けの投影: %ld 回 (出力画素の %.1f%%)\n", stats->plan_projections,
+           stats->total_pixels > 0
+               ? 100.0 * stats->plan_projections / stats->total_pixels : 0.0);
+    printf("  時間: レベル分け %.3f 秒, 描画 %.3f 秒\n",
+           stats->plan_seconds, stats->render_seconds);
+    for (int L = 0; L < FOVEATION_MAX_LEVELS; L++) {
+        if (stats->pixels_per_level[L] == 0) continue;
+        printf("  レベル%d (間隔%d): 画素 %ld, サンプリング %ld\n",
+               L, 1 << L, stats->pixels_per_level[L], stats->samples_per_level[L]);
+    }
+}
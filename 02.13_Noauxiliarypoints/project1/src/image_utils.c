@@ -213,6 +213,176 @@ void get_pixel_bilinear(Image *img, double u, double v, uint8_t *rgb) {
     }
 }
 
+/* 輝度のバイリニア補間
+ *
+ * 輝度はチャンネルごとの補間値を切り捨てずに (R + G + B) / 3 で平均したもの
+ * （4画素の輝度 (R + G + B) / 3 の双線形補間と同じ）。目的関数の Sr は
+ * すべてこの補間面の値を使う。
+ */
+double get_gray_bilinear(Image *img, double u, double v) {
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    double du = u - u0;
+    double dv = v - v0;
+
+    uint8_t p00[3], p01[3], p10[3], p11[3];
+    get_pixel(img, u0, v0, p00);
+    get_pixel(img, u0, v0 + 1, p01);
+    get_pixel(img, u0 + 1, v0, p10);
+    get_pixel(img, u0 + 1, v0 + 1, p11);
+
+    double sum = 0.0;
+    for (int c = 0; c < 3; c++) {
+        sum += (1.0 - du) * (1.0 - dv) * p00[c]
+             + (1.0 - du) * dv         * p01[c]
+             + du         * (1.0 - dv) * p10[c]
+             + du         * dv         * p11[c];
+    }
+    return sum / 3.0;
+}
+
+/* 輝度のバイリニア補間とその偏微分（同じ4画素から）
+ *
+ * 値は get_gray_bilinear() と同じ（切り捨てなし）。偏微分はその補間面
+ * （区分的な双線形関数）を u, v で微分したもの:
+ *   ∂S/∂u = (1 - dv)(p10 - p00) + dv (p11 - p01)
+ *   ∂S/∂v = (1 - du)(p01 - p00) + du (p11 - p10)
+ * 画素の境界（du = 0 など）では右側の区間の値になる。
+ */
+double get_gray_bilinear_gradient(Image *img, double u, double v,
+                                  double *dS_du, double *dS_dv) {
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    double du = u - u0;
+    double dv = v - v0;
+
+    uint8_t p00[3], p01[3], p10[3], p11[3];
+    get_pixel(img, u0, v0, p00);
+    get_pixel(img, u0, v0 + 1, p01);
+    get_pixel(img, u0 + 1, v0, p10);
+    get_pixel(img, u0 + 1, v0 + 1, p11);
+
+    double sum = 0.0;
+    int d10_00 = 0, d11_01 = 0, d01_00 = 0, d11_10 = 0;
+    for (int c = 0; c < 3; c++) {
+        sum += (1.0 - du) * (1.0 - dv) * p00[c]
+             + (1.0 - du) * dv         * p01[c]
+             + du         * (1.0 - dv) * p10[c]
+             + du         * dv         * p11[c];
+
+        d10_00 += p10[c] - p00[c];
+        d11_01 += p11[c] - p01[c];
+        d01_00 += p01[c] - p00[c];
+        d11_10 += p11[c] - p10[c];
+    }
+
+    *dS_du = ((1.0 - dv) * d10_00 + dv * d11_01) / 3.0;
+    *dS_dv = ((1.0 - du) * d01_00 + du * d11_10) / 3.0;
+    return sum / 3.0;
+}
+
+
+/* ===========================
+ * グレースケール画像
+ * =========================== */
+
+/* 空のグレースケール画像を作成（0で初期化） */
+GrayImage* gray_image_create(int width, int height) {
+    GrayImage *gray = (GrayImage*)malloc(sizeof(GrayImage));
+    if (!gray) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    
+    gray->width = width;
+    gray->height = height;
+    gray->data = (double*)calloc((size_t)width * height, sizeof(double));
+    
+    if (!gray->data) {
+        fprintf(stderr, "エラー: 画像データのメモリ確保失敗\n");
+        free(gray);
+        return NULL;
+    }
+    
+    return gray;
+}
+
+/* カラー画像をグレースケールに変換 */
+GrayImage* gray_image_from_image(Image *img) {
+    if (!img || !img->data) return NULL;
+    
+    GrayImage *gray = gray_image_create(img->width, img->height);
+    if (!gray) return NULL;
+    
+    for (int v = 0; v < img->height; v++) {
+        for (int u = 0; u < img->width; u++) {
+            uint8_t rgb[3];
+            get_pixel(img, u, v, rgb);
+            gray->data[(size_t)v * img->width + u] = (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+        }
+    }
+    
+    return gray;
+}
+
+/* メモリ解放 */
+void gray_image_free(GrayImage *gray) {
+    if (gray) {
+        free(gray->data);
+        free(gray);
+    }
+}
+
+/* 輝度を取得（get_pixel と同じく u は周期的、v の範囲外は0） */
+double gray_get(const GrayImage *gray, int u, int v) {
+    if (v < 0 || v >= gray->height) {
+        return 0.0;
+    }
+    
+    u %= gray->width;
+    if (u < 0) u += gray->width;
+    
+    return gray->data[(size_t)v * gray->width + u];
+}
+
+/* バイリニア補間で輝度を取得（get_pixel_bilinear と違い小数のまま返す） */
+double gray_get_bilinear(const GrayImage *gray, double u, double v) {
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    double du = u - u0;
+    double dv = v - v0;
+    
+    return (1.0 - du) * (1.0 - dv) * gray_get(gray, u0, v0)
+         + (1.0 - du) * dv         * gray_get(gray, u0, v0 + 1)
+         + du         * (1.0 - dv) * gray_get(gray, u0 + 1, v0)
+         + du         * dv         * gray_get(gray, u0 + 1, v0 + 1);
+}
+
+/* バイリニア補間で輝度とその偏微分を取得（同じ4画素から）
+ *
+ * 値は gray_get_bilinear() と同じ。偏微分は補間面を u, v で微分したもの
+ * （get_gray_bilinear_gradient() と同じ式）。
+ */
+double gray_get_bilinear_gradient(const GrayImage *gray, double u, double v,
+                                  double *dS_du, double *dS_dv) {
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    double du = u - u0;
+    double dv = v - v0;
+
+    double p00 = gray_get(gray, u0, v0);
+    double p01 = gray_get(gray, u0, v0 + 1);
+    double p10 = gray_get(gray, u0 + 1, v0);
+    double p11 = gray_get(gray, u0 + 1, v0 + 1);
+
+    *dS_du = (1.0 - dv) * (p10 - p00) + dv * (p11 - p01);
+    *dS_dv = (1.0 - du) * (p01 - p00) + du * (p11 - p10);
+    return (1.0 - du) * (1.0 - dv) * p00
+         + (1.0 - du) * dv         * p01
+         + du         * (1.0 - dv) * p10
+         + du         * dv         * p11;
+}
+
 
 /* ===========================
  * デバッグ用
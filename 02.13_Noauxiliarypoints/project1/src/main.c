@@ -7,30 +7,63 @@
  *   X = R^T X' （出力側 X' から入力側 X を求める）
  * 
  * 使い方:
- *   ./main input.jpg output.jpg u_g v_g
+ *   ./main input.jpg output.jpg u_g v_g [投影 [画角 [幅 高さ]]] [--fisheye calib.txt]
+ *          [--foveate 半径]
+ *   ./main input.jpg --batch 注視点リスト
  * 
  * 例:
  *   ./main input.jpg output.jpg 1000 500
+ *   ./main input.jpg output.jpg 1000 500 rectilinear 90 1920 1080
+ *   ./main dual.jpg output.jpg 1000 500 --fisheye calib.txt
+ *   ./main input.jpg output.jpg 1000 500 --foveate 30
+ *   ./main input.jpg --batch gazes.txt
+ * 
+ * --fisheye を指定すると入力をデュアル魚眼のフレームとして扱い、
+ * 正距円筒画像への貼り合わせを経由せずに直接サンプリングする。
+ * 注視点 (u_g, v_g) は入力と同じサイズの正距円筒画像上の座標とみなす。
+ *
+ * --foveate を指定すると光軸から指定角度（度数法）の範囲だけを
+ * 全密度で描画し、周辺は粗い格子から補間する（foveated.h 参照）。
+ *
+ * --batch を指定するとリストの各行 "u_g v_g 出力画像" の注視画像を
+ * まとめて生成する（# から行末はコメント）。リマップテーブルは
+ * (pitch, roll) をキーとするキャッシュ（remap.h）で使い回すので、
+ * 同じ v_g の注視点（水平方向のパン）はテーブルを1回だけ作る。
  */
 
 #include "coord_transform.h"
 #include "rotation.h"
 #include "vector_math.h"
 #include "image_utils.h"
+#include "remap.h"
+#include "projection.h"
+#include "foveated.h"
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include <string.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 
-/* 注視画像を生成する関数 */
-Image* generate_gaze_image(Image *input, int u_g, int v_g) {
+/* 注視画像を生成する関数
+ * 
+ * 回転 R を R = R_pr × R(Y)(yaw) に分解し、
+ * (pitch, roll) をキーとするリマップテーブルにヨーを u 方向の
+ * 平行移動として加えて出力画像を生成する。
+ * 
+ * cache に NULL を渡した場合はその場でテーブルを作成・解放する。
+ * 入力が正距円筒画像でない場合（デュアル魚眼など）は
+ * 投影カーネルで入力を直接サンプリングする。
+ * 出力サイズは in_p の幅・高さ。
+ */
+Image* generate_gaze_image(Image *input, const ProjectionParams *in_p,
+                           int u_g, int v_g, RemapCache *cache) {
     printf("\n===== 注視画像生成開始 =====\n\n");
     
-    int W = input->width;
-    int H = input->height;
+    int W = in_p->width;
+    int H = in_p->height;
     
     printf("【ステップ1】注視点の設定\n");
     printf("  注視点: (%d, %d)\n", u_g, v_g);
@@ -46,86 +79,244 @@ Image* generate_gaze_image(Image *input, int u_g, int v_g) {
     Matrix3x3 R = compute_rotation_matrix(G);
     matrix_print("  回転行列R", R);
     
-    /* 回転行列の転置（逆変換用） */
-    Matrix3x3 R_T = matrix_transpose(R); 
+    /* 回転の分解: R = R_pr(pitch, roll) × R(Y)(yaw) */
+    double yaw_deg, pitch_deg, roll_deg;
+    rotation_decompose_yaw(R, &yaw_deg, &pitch_deg, &roll_deg);
+    printf("  ヨー: %.6f°, ピッチ: %.6f°, ロール: %.6f°\n",
+           yaw_deg, pitch_deg, roll_deg);
     
     /* 出力画像を作成 */
     printf("\n【ステップ4】注視画像の生成\n");
-    Image *output = image_create_like(input);
+    Image *output = image_create(W, H, input->channels);
     if (!output) {
         fprintf(stderr, "エラー: 出力画像の作成失敗\n");
         return NULL;
     }
     
-    printf("  処理中");
-    fflush(stdout);
+    /* 正距円筒以外の入力は投影カーネルで直接サンプリング */
+    if (in_p->type != PROJ_EQUIRECT) {
+        ProjectionParams out_p = projection_init(PROJ_EQUIRECT, W, H, 360.0);
+        if (!projection_render(input, in_p, output, &out_p,
+                               matrix_transpose(R), INTERP_BILINEAR)) {
+            image_free(output);
+            return NULL;
+        }
+        printf("  完了！\n");
+        printf("\n===== 注視画像生成完了 =====\n");
+        return output;
+    }
     
-    int progress_step = H / 10;  /* 進捗表示用 */
+    /* リマップテーブルを取得（ヨーに依存しない）
+     *   逆変換（理論）：X = R^T X' = R(Y)(-yaw) × (R_pr^T X')
+     *   テーブルは R_pr^T X' を入力画像座標にしたもの
+     */
+    RemapTable *table;
+    if (cache) {
+        table = remap_cache_get(cache, W, H, W, H, pitch_deg, roll_deg);
+    } else {
+        table = remap_table_create(W, H, W, H, pitch_deg, roll_deg);
+    }
+    if (!table) {
+        fprintf(stderr, "エラー: リマップテーブルの作成失敗\n");
+        image_free(output);
+        return NULL;
+    }
     
-    /* 出力画像の全画素について処理 */
-    for (int v_out = 0; v_out < H; v_out++) {
-        /* 進捗表示 */
-        if (v_out % progress_step == 0) {
-            printf(".");
-            fflush(stdout);
-        }
-        
-        for (int u_out = 0; u_out < W; u_out++) {
-            /* 1. 出力画素を世界座標に変換 */
-            Vector3D X_prime = image_to_world(u_out, v_out, W, H);
+    /* ヨーを u 方向の平行移動として適用 */
+    remap_table_apply(table, input, yaw_deg, output);
+    
+    if (!cache) {
+        remap_table_free(table);
+    }
+    
+    printf("  完了！\n");
+    printf("\n===== 注視画像生成完了 =====\n");
+    
+    return output;
+}
 
-            /* 2. 逆変換: X = R^T × X'
-             *   逆変換（理論）：世界方向 X を求めて入力画像をサンプルする
-             *  定義：X' = R X   （R: 世界 -> 回転後カメラ）
-             *  よって：X = R^T X'
-             * 「X′は回転後カメラ座標系」「Xは世界（=入力側の球面方向）」
-             */
-            Vector3D X = matrix_vector_multiply(R_T, X_prime); 
-            
-            /* 3. 世界座標を画像座標に変換 */
-            double u_in, v_in;
-            world_to_image(X, W, H, &u_in, &v_in);
-            
-            /* 4. バイリニア補間で画素値を取得 */
-            uint8_t rgb[3];
-            get_pixel_bilinear(input, u_in, v_in, rgb);
-            
-            /* 5. 出力画像に設定 */
-            set_pixel(output, u_out, v_out, rgb);
+/* 注視方向のビューを任意の投影で生成する関数
+ * 
+ * 出力投影の光軸（カメラ座標のZ軸）が注視点Gを向く。
+ * 注視点は in_p の幅・高さの正距円筒画像上の座標。
+ * foveation が NULL でなければ中心窩描画を行う。
+ */
+Image* generate_view_image(Image *input, const ProjectionParams *in_p,
+                           int u_g, int v_g, const ProjectionParams *out_p,
+                           const FoveationParams *foveation) {
+    printf("\n===== ビュー画像生成開始（%s → %s） =====\n\n",
+           projection_name(in_p->type), projection_name(out_p->type));
+    
+    int W = in_p->width;
+    int H = in_p->height;
+    
+    printf("【ステップ1】注視点の設定\n");
+    printf("  注視点: (%d, %d)\n", u_g, v_g);
+    
+    Vector3D G = image_to_world(u_g, v_g, W, H);
+    Matrix3x3 R = compute_rotation_matrix(G);
+    
+    printf("\n【ステップ2】ビュー画像の生成\n");
+    printf("  出力: %d × %d, 画角 %.1f°\n", out_p->width, out_p->height, out_p->fov_deg);
+    Image *output = image_create(out_p->width, out_p->height, input->channels);
+    if (!output) {
+        fprintf(stderr, "エラー: 出力画像の作成失敗\n");
+        return NULL;
+    }
+    
+    int ok;
+    if (foveation) {
+        FoveationStats stats;
+        ok = foveated_render(input, in_p, output, out_p, matrix_transpose(R),
+                             foveation, &stats);
+        if (ok) {
+            foveation_stats_print(&stats);
         }
+    } else {
+        ok = projection_render(input, in_p, output, out_p,
+                               matrix_transpose(R), INTERP_BILINEAR);
+    }
+    if (!ok) {
+        image_free(output);
+        return NULL;
     }
     
-    printf(" 完了！\n");
-    printf("\n===== 注視画像生成完了 =====\n");
+    printf("  完了！\n");
+    printf("\n===== ビュー画像生成完了 =====\n");
     
     return output;
 }
 
+/* 注視点のリストから注視画像をまとめて生成（リマップテーブルを使い回す）
+ *
+ * 戻り値:
+ *   1: 全て成功, 0: 失敗した行がある
+ */
+static int generate_gaze_batch(Image *input, const ProjectionParams *in_p,
+                               const char *list_filename) {
+    FILE *fp = fopen(list_filename, "r");
+    if (!fp) {
+        fprintf(stderr, "エラー: 注視点のリストが開けません: %s\n", list_filename);
+        return 0;
+    }
+    RemapCache *cache = remap_cache_create();
+    if (!cache) {
+        fclose(fp);
+        return 0;
+    }
+
+    char line[1024];
+    char output_filename[1024];
+    int line_no = 0, count = 0, ok = 1;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        int u_g, v_g;
+        int n = sscanf(line, "%d %d %1023s", &u_g, &v_g, output_filename);
+        if (n <= 0) continue;
+        if (n != 3 || u_g < 0 || u_g >= input->width || v_g < 0 || v_g >= input->height) {
+            fprintf(stderr, "エラー: %s の %d 行目が読めません\n", list_filename, line_no);
+            ok = 0;
+            continue;
+        }
+        Image *output = generate_gaze_image(input, in_p, u_g, v_g, cache);
+        if (!output || !image_save_jpg(output_filename, output, 95)) {
+            fprintf(stderr, "エラー: 注視画像の生成に失敗しました: %s\n", output_filename);
+            ok = 0;
+        } else {
+            count++;
+        }
+        image_free(output);
+    }
+    fclose(fp);
+
+    printf("\n【一括生成】%d 枚, リマップテーブル 作成 %d 回, 再利用 %d 回\n",
+           count, cache->misses, cache->hits);
+    remap_cache_free(cache);
+    return ok;
+}
+
 
 int main(int argc, char *argv[]) {
     printf("===== 全方位画像からの注視画像生成 =====\n\n");
     
-    /* コマンドライン引数のチェック */
-    if (argc != 5) {
-        fprintf(stderr, "使い方: %s <入力画像> <出力画像> <u_g> <v_g>\n", argv[0]);
+    /* オプションと位置引数を分ける */
+    const char *fisheye_filename = NULL;
+    int foveate = 0;
+    double foveate_deg = 0.0;
+    const char *batch_filename = NULL;
+    const char *args[8];
+    int n_args = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fisheye") == 0 && i + 1 < argc) {
+            fisheye_filename = argv[++i];
+        } else if (strcmp(argv[i], "--foveate") == 0 && i + 1 < argc) {
+            foveate = 1;
+            foveate_deg = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_filename = argv[++i];
+        } else if (n_args < 8) {
+            args[n_args++] = argv[i];
+        } else {
+            n_args = 9;  /* 引数が多すぎる */
+        }
+    }
+    
+    /* コマンドライン引数のチェック（半径と出力画像サイズは正） */
+    int usage_ok = batch_filename ? (n_args == 1 && !foveate)
+                                  : (n_args >= 4 && n_args <= 8 && n_args != 7);
+    if (foveate && !(foveate_deg > 0.0)) {
+        usage_ok = 0;
+    }
+    if (usage_ok && n_args == 8 && (atoi(args[6]) <= 0 || atoi(args[7]) <= 0)) {
+        usage_ok = 0;
+    }
+    if (!usage_ok) {
+        fprintf(stderr, "使い方: %s <入力画像> <出力画像> <u_g> <v_g> [投影 [画角 [幅 高さ]]] [--fisheye キャリブレーション] [--foveate 半径]\n", argv[0]);
+        fprintf(stderr, "        %s <入力画像> --batch <注視点リスト>\n", argv[0]);
         fprintf(stderr, "\n");
         fprintf(stderr, "引数:\n");
         fprintf(stderr, "  入力画像: 全方位画像のファイル名（例: input.jpg）\n");
         fprintf(stderr, "  出力画像: 注視画像のファイル名（例: output.jpg）\n");
         fprintf(stderr, "  u_g, v_g: 注視点の画像座標\n");
+        fprintf(stderr, "  投影: equirect（デフォルト）, rectilinear, cylindrical,\n");
+        fprintf(stderr, "        stereographic, fisheye, cube_face\n");
+        fprintf(stderr, "  画角: 水平画角（度数法、デフォルト: 90）\n");
+        fprintf(stderr, "  幅, 高さ: 出力画像サイズ（正の整数、デフォルト: 入力の W/4 × H/2）\n");
+        fprintf(stderr, "  --fisheye: 入力をデュアル魚眼フレームとして直接サンプリング\n");
+        fprintf(stderr, "             （\"default\" で左右に並んだ画角190°の標準配置）\n");
+        fprintf(stderr, "  --foveate: 光軸から指定角度（度数法、正）の外側を粗くサンプリング\n");
+        fprintf(stderr, "  --batch: 各行 \"u_g v_g 出力画像\" の注視画像をまとめて生成\n");
+        fprintf(stderr, "           （同じピッチ・ロールのリマップテーブルを使い回す）\n");
         fprintf(stderr, "例:\n");
         fprintf(stderr, "  %s input.jpg output.jpg 1000 500\n", argv[0]);
+        fprintf(stderr, "  %s input.jpg output.jpg 1000 500 rectilinear 90 1920 1080\n", argv[0]);
+        fprintf(stderr, "  %s dual.jpg output.jpg 1000 500 --fisheye calib.txt\n", argv[0]);
+        fprintf(stderr, "  %s input.jpg output.jpg 1000 500 --foveate 30\n", argv[0]);
+        fprintf(stderr, "  %s input.jpg --batch gazes.txt\n", argv[0]);
         return 1;
     }
     
     /* 引数の読み込み */
-    const char *input_filename = argv[1];
-    const char *output_filename = argv[2];
-    int u_g = atoi(argv[3]);
-    int v_g = atoi(argv[4]);
+    const char *input_filename = args[0];
+    const char *output_filename = batch_filename ? batch_filename : args[1];
+    int u_g = batch_filename ? 0 : atoi(args[2]);
+    int v_g = batch_filename ? 0 : atoi(args[3]);
+    
+    ProjectionType out_type = PROJ_EQUIRECT;
+    if (n_args >= 5 && !projection_parse(args[4], &out_type)) {
+        fprintf(stderr, "エラー: 不明な投影です: %s\n", args[4]);
+        return 1;
+    }
+    if (out_type == PROJ_DUAL_FISHEYE) {
+        fprintf(stderr, "エラー: dual_fisheye は入力専用です\n");
+        return 1;
+    }
+    double fov_deg = (n_args >= 6) ? atof(args[5]) : 90.0;
     
     printf("入力ファイル: %s\n", input_filename);
-    printf("出力ファイル: %s\n", output_filename);
+    printf("%s: %s\n", batch_filename ? "注視点リスト" : "出力ファイル", output_filename);
     printf("\n");
     
     /* 画像の読み込み */
@@ -136,6 +327,30 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    /* 入力の投影 */
+    ProjectionParams in_p = projection_init(PROJ_EQUIRECT, input->width, input->height, 360.0);
+    DualFisheyeCalib calib;
+    if (fisheye_filename) {
+        printf("\n【デュアル魚眼キャリブレーション】\n");
+        if (strcmp(fisheye_filename, "default") == 0) {
+            dual_fisheye_default(input->width, input->height, 190.0, &calib);
+        } else if (!dual_fisheye_load(fisheye_filename, input->width, input->height, &calib)) {
+            fprintf(stderr, "エラー: キャリブレーションの読み込みに失敗しました\n");
+            image_free(input);
+            return 1;
+        }
+        dual_fisheye_info(&calib);
+        in_p = projection_init_dual_fisheye(input->width, input->height, &calib);
+    }
+    
+    /* 一括生成 */
+    if (batch_filename) {
+        int ok = generate_gaze_batch(input, &in_p, batch_filename);
+        image_free(input);
+        printf("\n===== 処理完了 =====\n");
+        return ok ? 0 : 1;
+    }
+    
     /* 座標の妥当性チェック */
     if (u_g < 0 || u_g >= input->width || v_g < 0 || v_g >= input->height) {
         fprintf(stderr, "エラー: 注視点が画像範囲外です\n");
@@ -146,7 +361,27 @@ int main(int argc, char *argv[]) {
     }
     
     /* 注視画像を生成 */
-    Image *output = generate_gaze_image(input, u_g, v_g);
+    Image *output;
+    FoveationParams foveation = foveation_default(foveate_deg);
+    const FoveationParams *fov_params = foveate ? &foveation : NULL;
+    if (out_type == PROJ_EQUIRECT && !fov_params) {
+        output = generate_gaze_image(input, &in_p, u_g, v_g, NULL);
+    } else if (out_type == PROJ_EQUIRECT) {
+        /* 中心窩描画はリマップテーブルを使わず注視画像を直接描画 */
+        ProjectionParams out_p = projection_init(PROJ_EQUIRECT, input->width,
+                                                 input->height, 360.0);
+        output = generate_view_image(input, &in_p, u_g, v_g, &out_p, fov_params);
+    } else {
+        int out_W = (n_args >= 8) ? atoi(args[6]) : input->width / 4;
+        int out_H = (n_args >= 8) ? atoi(args[7]) : input->height / 2;
+        if (out_W <= 0 || out_H <= 0) {
+            fprintf(stderr, "エラー: 出力画像サイズが不正です（%d × %d）\n", out_W, out_H);
+            image_free(input);
+            return 1;
+        }
+        ProjectionParams out_p = projection_init(out_type, out_W, out_H, fov_deg);
+        output = generate_view_image(input, &in_p, u_g, v_g, &out_p, fov_params);
+    }
     
     if (!output) {
         fprintf(stderr, "エラー: 注視画像の生成に失敗しました\n");
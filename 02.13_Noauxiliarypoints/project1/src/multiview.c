@@ -0,0 +1,100 @@
+/* multiview.c
+ * 複数ビューの一括描画の実装
+ */
+
+#include "multiview.h"
+#include "coord_transform.h"
+#include "rotation.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+int view_spec_init(ViewSpec *view, const ProjectionParams *out_p,
+                   int u_g, int v_g, int W, int H, int channels) {
+    view->out_p = *out_p;
+    view->R_T = matrix_transpose(compute_rotation_matrix(image_to_world(u_g, v_g, W, H)));
+    view->output = image_create(out_p->width, out_p->height, channels);
+    if (!view->output) {
+        fprintf(stderr, "エラー: 出力画像の作成失敗\n");
+        return 0;
+    }
+    return 1;
+}
+
+void view_spec_free(ViewSpec *view) {
+    if (view->output) {
+        image_free(view->output);
+        view->output = NULL;
+    }
+}
+
+/* 出力の投影が同じか */
+static int same_output(const ProjectionParams *a, const ProjectionParams *b) {
+    return a->type == b->type && a->width == b->width && a->height == b->height &&
+           a->fov_deg == b->fov_deg && a->face == b->face && a->focal == b->focal;
+}
+
+int multiview_render(Image *input, const ProjectionParams *in_p,
+                     ViewSpec *views, int K, Interpolation interp,
+                     MultiViewOrder order, MultiViewStats *stats) {
+    int C = input->channels;
+    MultiViewStats st = {0, 0, 0, 0};
+
+    for (int k = 0; k < K; k++) {
+        const Image *out = views[k].output;
+        if (!out || out->channels != C || out->width != views[k].out_p.width ||
+            out->height != views[k].out_p.height) {
+            fprintf(stderr, "エラー: ビュー%d の出力画像が投影パラメータと一致しません\n", k);
+            return 0;
+        }
+    }
+    if (K <= 0) {
+        if (stats) *stats = st;
+        return 1;
+    }
+
+    Image **outputs = (Image**)malloc(K * sizeof(Image*));
+    Matrix3x3 *R_T = (Matrix3x3*)malloc(K * sizeof(Matrix3x3));
+    uint8_t *done = (uint8_t*)calloc(K, 1);
+    if (!outputs || !R_T || !done) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(outputs);
+        free(R_T);
+        free(done);
+        return 0;
+    }
+
+    /* 出力の投影が同じビューをまとめて描画 */
+    int ok = 1;
+    for (int i = 0; ok && i < K; i++) {
+        if (done[i]) continue;
+        const ProjectionParams *op = &views[i].out_p;
+        int n = 0;
+        for (int k = i; k < K; k++) {
+            if (done[k] || !same_output(op, &views[k].out_p)) continue;
+            outputs[n] = views[k].output;
+            R_T[n] = views[k].R_T;
+            done[k] = 1;
+            n++;
+        }
+        if (order == MULTIVIEW_TILES) {
+            ProjectionBinStats bin;
+            ok = projection_render_views_binned(input, in_p, outputs, op, R_T, n, interp,
+                                                MULTIVIEW_TILE_SIZE,
+                                                MULTIVIEW_BATCH_SAMPLES, &bin);
+            st.tile_visits += bin.tile_visits;
+            st.batches += bin.batches;
+        } else {
+            ok = projection_render_views(input, in_p, outputs, op, R_T, n, interp);
+        }
+        st.samples += (long)n * op->width * op->height;
+        st.groups++;
+    }
+
+    free(outputs);
+    free(R_T);
+    free(done);
+
+    if (ok && stats) *stats = st;
+    return ok;
+}
@@ -0,0 +1,228 @@
+/* mutual_info.c
+ * 相互情報量による目的関数の実装
+ */
+
+#include "mutual_info.h"
+#include "yaw_window.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+MiOptions mi_default_options(void) {
+    MiOptions opt;
+    opt.bins = 32;
+    opt.sub_histograms = 1;
+    return opt;
+}
+
+MiContext* mi_context_create(Image *base, Image *ref, Region region,
+                             const MiOptions *options) {
+    MiOptions opt = options ? *options : mi_default_options();
+    if (opt.bins < 2 || opt.bins > MI_MAX_BINS ||
+        opt.sub_histograms < 1 || opt.sub_histograms > MI_MAX_SUB_HISTOGRAMS) {
+        fprintf(stderr, "エラー: 相互情報量の設定が不正です（階級 %d, 部分ヒストグラム %d）\n",
+                opt.bins, opt.sub_histograms);
+        return NULL;
+    }
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return NULL;
+    }
+    int W = ref->width;
+    int w = region.u_max - region.u_min + 1;
+    int rows = region.v_max - region.v_min + 1;
+    if (w <= 0 || rows <= 0 || w > W || region.v_min < 0 || region.v_max >= ref->height) {
+        fprintf(stderr, "エラー: 相互情報量の比較領域が不正です\n");
+        return NULL;
+    }
+
+    MiContext *ctx = (MiContext*)calloc(1, sizeof(MiContext));
+    if (!ctx) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    ctx->width = W;
+    ctx->height = ref->height;
+    ctx->region = region;
+    ctx->region_width = w;
+    ctx->rows = rows;
+    ctx->count = w * rows;
+    ctx->bins = opt.bins;
+    ctx->sub_histograms = opt.sub_histograms;
+    ctx->ext_width = W + w + 1;
+
+    int L = ctx->ext_width;
+    size_t hist_size = (size_t)opt.sub_histograms * opt.bins * opt.bins;
+    ctx->base_bin = (unsigned char*)malloc((size_t)ctx->count);
+    ctx->base_marginal = (double*)calloc((size_t)opt.bins, sizeof(double));
+    ctx->ref_ext = (double*)malloc((size_t)rows * L * sizeof(double));
+    ctx->joint = (double*)malloc(hist_size * sizeof(double));
+    ctx->joint_d = (double*)malloc(hist_size * sizeof(double));
+    if (!ctx->base_bin || !ctx->base_marginal || !ctx->ref_ext ||
+        !ctx->joint || !ctx->joint_d) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        mi_context_free(ctx);
+        return NULL;
+    }
+
+    /* 基準画像の階級（切り捨て）と周辺分布 */
+    for (int r = 0; r < rows; r++) {
+        for (int j = 0; j < w; j++) {
+            double Sb = pixel_gray(base, region.u_min + j, region.v_min + r);
+            int i = (int)(Sb * opt.bins / 256.0);
+            ctx->base_bin[(size_t)r * w + j] = (unsigned char)i;
+            ctx->base_marginal[i] += 1.0 / ctx->count;
+        }
+    }
+
+    /* 参照画像の行を周期的に延長 */
+    for (int r = 0; r < rows; r++) {
+        double *ext = ctx->ref_ext + (size_t)r * L;
+        for (int x = 0; x < L; x++) {
+            ext[x] = pixel_gray(ref, x, region.v_min + r);
+        }
+    }
+
+    return ctx;
+}
+
+void mi_context_free(MiContext *ctx) {
+    if (ctx) {
+        free(ctx->base_bin);
+        free(ctx->base_marginal);
+        free(ctx->ref_ext);
+        free(ctx->joint);
+        free(ctx->joint_d);
+        free(ctx);
+    }
+}
+
+void mi_joint_histogram(MiContext *ctx, double psi_deg, double *joint, double *joint_d) {
+    int x0;
+    double f;
+    yaw_window(psi_deg, ctx->width, ctx->region.u_min, &x0, &f);
+
+    int bins = ctx->bins;
+    int bb = bins * bins;
+    int S = ctx->sub_histograms;
+    int w = ctx->region_width;
+    int L = ctx->ext_width;
+    int want_grad = (joint_d != NULL);
+    /* 3次の B スプラインが両端の外に出ないように1階級ずつ空ける */
+    const double scale = (bins - 3) / 255.0;
+
+    memset(ctx->joint, 0, (size_t)S * bb * sizeof(double));
+    if (want_grad) {
+        memset(ctx->joint_d, 0, (size_t)S * bb * sizeof(double));
+    }
+
+    /* 画素を部分ヒストグラムに順に振り分けて加算
+     * （続く画素の加算が前の画素の書き込みを待たないように）
+     */
+    int s = 0;
+    for (int r = 0; r < ctx->rows; r++) {
+        const unsigned char *ib = ctx->base_bin + (size_t)r * w;
+        const double *a = ctx->ref_ext + (size_t)r * L + x0;
+        for (int j = 0; j < w; j++) {
+            double slope = a[j + 1] - a[j];
+            double t = (a[j] + f * slope) * scale + 1.0;
+            int lo = (int)t;
+            if (lo > bins - 3) lo = bins - 3;
+            double x = t - lo;
+            double y = 1.0 - x;
+            double x2 = x * x;
+            double x3 = x2 * x;
+
+            double *h = ctx->joint + (size_t)s * bb + (size_t)ib[j] * bins + lo - 1;
+            h[0] += y * y * y / 6.0;
+            h[1] += (3.0 * x3 - 6.0 * x2 + 4.0) / 6.0;
+            h[2] += (-3.0 * x3 + 3.0 * x2 + 3.0 * x + 1.0) / 6.0;
+            h[3] += x3 / 6.0;
+            if (want_grad) {
+                /* Parzen 窓の微分（dt/ds = slope × scale） */
+                double dt = slope * scale;
+                double *d = ctx->joint_d + (size_t)s * bb + (size_t)ib[j] * bins + lo - 1;
+                d[0] -= 0.5 * y * y * dt;
+                d[1] += (1.5 * x2 - 2.0 * x) * dt;
+                d[2] += (-1.5 * x2 + x + 0.5) * dt;
+                d[3] += 0.5 * x2 * dt;
+            }
+            s = (s + 1 == S) ? 0 : s + 1;
+        }
+    }
+
+    /* 部分ヒストグラムの合計（joint が ctx->joint と同じでもよい） */
+    for (int b = 0; b < bb; b++) {
+        double sum = 0.0;
+        for (int k = 0; k < S; k++) sum += ctx->joint[(size_t)k * bb + b];
+        joint[b] = sum;
+    }
+    if (want_grad) {
+        /* ds/dψ = -W/2π（ラジアン当たり） */
+        double ds_dpsi = -(double)ctx->width / (2.0 * M_PI);
+        for (int b = 0; b < bb; b++) {
+            double sum = 0.0;
+            for (int k = 0; k < S; k++) sum += ctx->joint_d[(size_t)k * bb + b];
+            joint_d[b] = sum * ds_dpsi;
+        }
+    }
+}
+
+/* 同時ヒストグラムから MI（と微分） */
+static double mi_from_histogram(const MiContext *ctx, const double *joint,
+                                const double *joint_d, double *grad, double *hess) {
+    int bins = ctx->bins;
+    double inv_n = 1.0 / ctx->count;
+    double pr[MI_MAX_BINS] = {0};
+    double dpr[MI_MAX_BINS] = {0};
+    for (int i = 0; i < bins; i++) {
+        for (int j = 0; j < bins; j++) {
+            pr[j] += joint[i * bins + j] * inv_n;
+            if (joint_d) dpr[j] += joint_d[i * bins + j] * inv_n;
+        }
+    }
+
+    double mi = 0.0, g = 0.0, h = 0.0;
+    for (int i = 0; i < bins; i++) {
+        double pb = ctx->base_marginal[i];
+        for (int j = 0; j < bins; j++) {
+            double p = joint[i * bins + j] * inv_n;
+            if (p <= 0.0) continue;
+            mi += p * log(p / (pb * pr[j]));
+            if (joint_d) {
+                double dp = joint_d[i * bins + j] * inv_n;
+                g += dp * log(p / pr[j]);
+                h += dp * dp / p;
+            }
+        }
+    }
+    if (joint_d) {
+        for (int j = 0; j < bins; j++) {
+            if (pr[j] > 0.0) h -= dpr[j] * dpr[j] / pr[j];
+        }
+        *grad = g;
+        *hess = h;
+    }
+    return mi;
+}
+
+double mi_objective(MiContext *ctx, double psi_deg) {
+    /* 合計は作業領域の先頭の部分ヒストグラムに入れる */
+    mi_joint_histogram(ctx, psi_deg, ctx->joint, NULL);
+    return -mi_from_histogram(ctx, ctx->joint, NULL, NULL, NULL);
+}
+
+void mi_objective_terms(MiContext *ctx, double psi_deg, ObjectiveTerms *terms) {
+    double grad, hess;
+    mi_joint_histogram(ctx, psi_deg, ctx->joint, ctx->joint_d);
+    double mi = mi_from_histogram(ctx, ctx->joint, ctx->joint_d, &grad, &hess);
+    terms->E = -mi;
+    terms->gradient = -grad;
+    terms->hessian = hess;
+    terms->count = ctx->count;
+}
@@ -0,0 +1,168 @@
+/* objective_cache.c
+ * 目的関数の値のキャッシュの実装
+ */
+
+#include "objective_cache.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法からラジアンへの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+
+/* 標準の容量（2のべき乗） */
+#define OBJECTIVE_CACHE_DEFAULT_CAPACITY 1024
+
+static long long psi_to_key(double psi_deg) {
+    return llround(psi_deg / OBJECTIVE_CACHE_QUANTUM_DEG);
+}
+
+/* キーのハッシュ値（64ビットの混ぜ合わせ） */
+static size_t hash_key(int pair_id, const Region *r, long long psi_key) {
+    unsigned long long h = (unsigned long long)psi_key * 0x9E3779B97F4A7C15ULL;
+    int parts[5] = {pair_id, r->u_min, r->v_min, r->u_max, r->v_max};
+    for (int i = 0; i < 5; i++) {
+        h ^= (unsigned long long)(unsigned int)parts[i] + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+static int same_key(const ObjectiveCacheEntry *e, int pair_id, const Region *r,
+                    long long psi_key) {
+    return e->pair_id == pair_id && e->psi_key == psi_key &&
+           e->region.u_min == r->u_min && e->region.v_min == r->v_min &&
+           e->region.u_max == r->u_max && e->region.v_max == r->v_max;
+}
+
+/* キーの入る位置（見つからなければ空きの位置） */
+static ObjectiveCacheEntry* find_slot(ObjectiveCacheEntry *entries, size_t capacity,
+                                      int pair_id, const Region *r, long long psi_key) {
+    size_t mask = capacity - 1;
+    size_t i = hash_key(pair_id, r, psi_key) & mask;
+    while (entries[i].used && !same_key(&entries[i], pair_id, r, psi_key)) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+/* 容量を2倍にして入れ直す */
+static int grow(ObjectiveCache *cache) {
+    size_t capacity = cache->capacity * 2;
+    ObjectiveCacheEntry *entries = (ObjectiveCacheEntry*)calloc(capacity, sizeof(ObjectiveCacheEntry));
+    if (!entries) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 0;
+    }
+    for (size_t i = 0; i < cache->capacity; i++) {
+        const ObjectiveCacheEntry *e = &cache->entries[i];
+        if (e->used) {
+            *find_slot(entries, capacity, e->pair_id, &e->region, e->psi_key) = *e;
+        }
+    }
+    free(cache->entries);
+    cache->entries = entries;
+    cache->capacity = capacity;
+    return 1;
+}
+
+ObjectiveCache* objective_cache_create(size_t capacity) {
+    size_t c = OBJECTIVE_CACHE_DEFAULT_CAPACITY;
+    while (c < capacity) c *= 2;
+
+    ObjectiveCache *cache = (ObjectiveCache*)malloc(sizeof(ObjectiveCache));
+    if (!cache) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    cache->entries = (ObjectiveCacheEntry*)calloc(c, sizeof(ObjectiveCacheEntry));
+    if (!cache->entries) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(cache);
+        return NULL;
+    }
+    cache->capacity = c;
+    cache->size = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    return cache;
+}
+
+void objective_cache_free(ObjectiveCache *cache) {
+    if (cache) {
+        free(cache->entries);
+        free(cache);
+    }
+}
+
+int objective_cache_lookup(ObjectiveCache *cache, const ObjectivePair *pair,
+                           double psi_deg, double *E) {
+    const ObjectiveCacheEntry *e = find_slot(cache->entries, cache->capacity, pair->id,
+                                             &pair->region, psi_to_key(psi_deg));
+    if (!e->used) {
+        return 0;
+    }
+    *E = e->E;
+    return 1;
+}
+
+int objective_cache_store(ObjectiveCache *cache, const ObjectivePair *pair,
+                          double psi_deg, double E) {
+    /* 使用率が1/2を超えないように拡張 */
+    if (2 * (cache->size + 1) > cache->capacity && !grow(cache)) {
+        return 0;
+    }
+
+    long long key = psi_to_key(psi_deg);
+    ObjectiveCacheEntry *e = find_slot(cache->entries, cache->capacity, pair->id,
+                                       &pair->region, key);
+    if (!e->used) {
+        e->used = 1;
+        e->pair_id = pair->id;
+        e->region = pair->region;
+        e->psi_key = key;
+        cache->size++;
+    }
+    e->E = E;
+    return 1;
+}
+
+double cached_objective(ObjectiveCache *cache, const ObjectivePair *pair,
+                        double psi_deg) {
+    double E;
+    if (objective_cache_lookup(cache, pair, psi_deg, &E)) {
+        cache->hits++;
+        return E;
+    }
+
+    const Region *r = &pair->region;
+    if (pair->context) {
+        E = compute_objective_function_ctx(pair->context, pair->ref, psi_deg);
+    } else {
+        E = compute_objective_function(pair->base, pair->ref, psi_deg,
+                                       r->u_min, r->v_min, r->u_max, r->v_max);
+    }
+    cache->misses++;
+    objective_cache_store(cache, pair, psi_deg, E);
+    return E;
+}
+
+double cached_forward_derivative(ObjectiveCache *cache, const ObjectivePair *pair,
+                                 double psi_deg, double delta_psi_deg) {
+    double E0 = cached_objective(cache, pair, psi_deg);
+    double E1 = cached_objective(cache, pair, psi_deg + delta_psi_deg);
+    return (E1 - E0) / DEG_TO_RAD(delta_psi_deg);
+}
+
+double cached_central_derivative(ObjectiveCache *cache, const ObjectivePair *pair,
+                                 double psi_deg, double delta_psi_deg) {
+    double E_plus = cached_objective(cache, pair, psi_deg + delta_psi_deg);
+    double E_minus = cached_objective(cache, pair, psi_deg - delta_psi_deg);
+    return (E_plus - E_minus) / (2.0 * DEG_TO_RAD(delta_psi_deg));
+}
@@ -0,0 +1,244 @@
+/* pixel_selection.c
+ * 目的関数に使う画素の選択の実装
+ */
+
+#include "pixel_selection.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* 順位付けの項目 */
+typedef struct {
+    double score;   /* |SD| */
+    int index;      /* 元の YawTemplate での番号 */
+} RankedPixel;
+
+
+PixelSelectOptions pixel_select_default_options(void) {
+    PixelSelectOptions opt;
+    opt.mode = PIXEL_SELECT_STRATIFIED;
+    opt.fraction = 0.1;
+    opt.count = 0;
+    opt.cell_size = 16;
+    opt.seed = 1;
+    return opt;
+}
+
+const char* pixel_select_mode_name(PixelSelectMode mode) {
+    switch (mode) {
+    case PIXEL_SELECT_TOP_K:      return "上位k";
+    case PIXEL_SELECT_STRATIFIED: return "層別上位";
+    case PIXEL_SELECT_RANDOM:     return "層別無作為";
+    default:                      return "不明";
+    }
+}
+
+/* |SD| の大きい順（同じ値は番号の小さい順にして結果を一意に） */
+static int compare_score_desc(const void *a, const void *b) {
+    const RankedPixel *pa = (const RankedPixel*)a;
+    const RankedPixel *pb = (const RankedPixel*)b;
+    if (pa->score > pb->score) return -1;
+    if (pa->score < pb->score) return 1;
+    return pa->index - pb->index;
+}
+
+static int compare_int(const void *a, const void *b) {
+    int ia = *(const int*)a;
+    int ib = *(const int*)b;
+    return (ia > ib) - (ia < ib);
+}
+
+/* 再現性のある乱数（xorshift32） */
+static unsigned int next_random(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* セルごとの個数を weight に比例して配る（cap を超えない、合計 k まで）
+ *
+ * 比例配分で cap を超えるセルは cap にし、残りを他のセルで配り直す。
+ * 最後は累積で丸めて合計を合わせる。quota に加え、配った個数を返す。
+ */
+static int allocate_quotas(const double *weight, const int *cap, int cells, int k,
+                           int *quota) {
+    char *full = (char*)calloc((size_t)cells, 1);
+    if (!full) return 0;
+    int given = 0;
+    for (;;) {
+        double total = 0.0;
+        for (int c = 0; c < cells; c++) {
+            if (!full[c]) total += weight[c];
+        }
+        int rest = k - given;
+        if (rest <= 0 || total <= 0.0) break;
+
+        int capped = 0;
+        for (int c = 0; c < cells; c++) {
+            if (!full[c] && rest * weight[c] / total >= cap[c] - quota[c]) {
+                given += cap[c] - quota[c];
+                quota[c] = cap[c];
+                full[c] = 1;
+                capped = 1;
+            }
+        }
+        if (capped) continue;
+
+        double seen = 0.0;
+        long long before = 0;
+        for (int c = 0; c < cells; c++) {
+            if (full[c]) continue;
+            seen += weight[c];
+            long long upto = llround(rest * seen / total);
+            int q = (int)(upto - before);
+            if (q > cap[c] - quota[c]) q = cap[c] - quota[c];
+            quota[c] += q;
+            given += q;
+            before = upto;
+        }
+        break;
+    }
+    free(full);
+    return given;
+}
+
+YawTemplate* yaw_template_select(const YawTemplate *tmpl,
+                                 const PixelSelectOptions *options) {
+    PixelSelectOptions opt = options ? *options : pixel_select_default_options();
+    int n = tmpl->count;
+    int width = tmpl->region.u_max - tmpl->region.u_min + 1;
+    int height = tmpl->region.v_max - tmpl->region.v_min + 1;
+    if (n != width * height) {
+        fprintf(stderr, "エラー: 比較領域の全画素の YawTemplate が必要です\n");
+        return NULL;
+    }
+
+    int k = (opt.count > 0) ? opt.count : (int)llround(opt.fraction * n);
+    if (k < 1) k = 1;
+    if (k > n) k = n;
+    int cell = (opt.cell_size > 0) ? opt.cell_size : 1;
+
+    RankedPixel *ranked = (RankedPixel*)malloc((size_t)n * sizeof(RankedPixel));
+    int *chosen = (int*)malloc((size_t)k * sizeof(int));
+    YawTemplate *sub = (YawTemplate*)calloc(1, sizeof(YawTemplate));
+    if (!ranked || !chosen || !sub) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(ranked);
+        free(chosen);
+        free(sub);
+        return NULL;
+    }
+
+    int m = 0;
+    if (opt.mode == PIXEL_SELECT_TOP_K) {
+        for (int i = 0; i < n; i++) {
+            ranked[i].score = fabs(tmpl->SD[i]);
+            ranked[i].index = i;
+        }
+        qsort(ranked, n, sizeof(RankedPixel), compare_score_desc);
+        for (; m < k; m++) chosen[m] = ranked[m].index;
+    } else {
+        int cells_u = (width + cell - 1) / cell;
+        int cells = cells_u * ((height + cell - 1) / cell);
+        int *cap = (int*)calloc((size_t)cells, sizeof(int));
+        int *quota = (int*)calloc((size_t)cells, sizeof(int));
+        double *weight = (double*)calloc((size_t)cells, sizeof(double));
+        if (!cap || !quota || !weight) {
+            fprintf(stderr, "エラー: メモリ確保失敗\n");
+            free(cap);
+            free(quota);
+            free(weight);
+            free(ranked);
+            free(chosen);
+            free(sub);
+            return NULL;
+        }
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int c = (y / cell) * cells_u + x / cell;
+                cap[c]++;
+                weight[c] += fabs(tmpl->SD[y * width + x]);
+            }
+        }
+        if (opt.mode == PIXEL_SELECT_STRATIFIED) {
+            /* セルごとに Σ|SD| に比例した個数（平坦なセルに枠を割かない）。
+             * Σ|SD| のあるセルで足りない分は残りの画素数に比例して配る */
+            int given = allocate_quotas(weight, cap, cells, k, quota);
+            if (given < k) {
+                for (int c = 0; c < cells; c++) weight[c] = cap[c] - quota[c];
+                allocate_quotas(weight, cap, cells, k - given, quota);
+            }
+        } else {
+            /* セルごとに画素数に比例した個数 */
+            for (int c = 0; c < cells; c++) weight[c] = cap[c];
+            allocate_quotas(weight, cap, cells, k, quota);
+        }
+
+        unsigned int state = opt.seed ? opt.seed : 1;
+        for (int cv = 0; cv < height; cv += cell) {
+            for (int cu = 0; cu < width; cu += cell) {
+                int c = 0;
+                for (int y = cv; y < cv + cell && y < height; y++) {
+                    for (int x = cu; x < cu + cell && x < width; x++) {
+                        int i = y * width + x;
+                        ranked[c].score = fabs(tmpl->SD[i]);
+                        ranked[c].index = i;
+                        c++;
+                    }
+                }
+                int q = quota[(cv / cell) * cells_u + cu / cell];
+
+                if (opt.mode == PIXEL_SELECT_STRATIFIED) {
+                    qsort(ranked, c, sizeof(RankedPixel), compare_score_desc);
+                } else {
+                    /* 部分的なフィッシャー・イェーツのシャッフル */
+                    for (int j = 0; j < q; j++) {
+                        int r = j + (int)(next_random(&state) % (unsigned int)(c - j));
+                        RankedPixel tmp = ranked[j];
+                        ranked[j] = ranked[r];
+                        ranked[r] = tmp;
+                    }
+                }
+                for (int j = 0; j < q; j++) chosen[m++] = ranked[j].index;
+            }
+        }
+        free(cap);
+        free(quota);
+        free(weight);
+    }
+
+    /* 元のラスター順に戻す（参照画像の読み出しが連続するように） */
+    qsort(chosen, m, sizeof(int), compare_int);
+
+    sub->width = tmpl->width;
+    sub->height = tmpl->height;
+    sub->region = tmpl->region;
+    sub->count = m;
+    sub->X = (Vector3D*)malloc((size_t)m * sizeof(Vector3D));
+    sub->Sb = (double*)malloc((size_t)m * sizeof(double));
+    sub->SD = (double*)malloc((size_t)m * sizeof(double));
+    if (!sub->X || !sub->Sb || !sub->SD) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(ranked);
+        free(chosen);
+        yaw_template_free(sub);
+        return NULL;
+    }
+
+    double sum_hess = 0.0;
+    for (int j = 0; j < m; j++) {
+        int i = chosen[j];
+        sub->X[j] = tmpl->X[i];
+        sub->Sb[j] = tmpl->Sb[i];
+        sub->SD[j] = tmpl->SD[i];
+        sum_hess += tmpl->SD[i] * tmpl->SD[i];
+    }
+    sub->hessian = (m > 0) ? sum_hess / m : 0.0;
+
+    free(ranked);
+    free(chosen);
+    return sub;
+}
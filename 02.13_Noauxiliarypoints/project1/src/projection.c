@@ -0,0 +1,992 @@
+/* projection.c
+ * 投影モデルと特殊化された描画カーネルの実装
+ */
+
+#include "projection.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法からラジアンへの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+
+/* ===========================
+ * 各投影モデル（インライン展開用）
+ *
+ * <name>_to_world   : 画像座標 → カメラ座標
+ * <name>_from_world : カメラ座標 → 画像座標
+ * <name>_WRAP_U     : u方向が周期的なら1
+ * =========================== */
+
+static inline Vector3D make_dir(double x, double y, double z) {
+    double n = sqrt(x * x + y * y + z * z);
+    Vector3D d = {x / n, y / n, z / n};
+    return d;
+}
+
+/* 光軸からの角度 α と像面上の方向から単位ベクトルを作る */
+static inline Vector3D radial_dir(double dx, double dy, double r, double alpha) {
+    if (r < 1e-12) {
+        Vector3D d = {0.0, 0.0, 1.0};
+        return d;
+    }
+    double s = sin(alpha) / r;
+    Vector3D d = {dx * s, dy * s, cos(alpha)};
+    return d;
+}
+
+/* ----- equirect: 式(1)(3) と同じ ----- */
+#define equirect_WRAP_U 1
+
+static inline int equirect_to_world(const ProjectionParams *p, double u, double v,
+                                    Vector3D *X) {
+    double theta = (u - (double)p->width / 2.0) * (2.0 * M_PI) / (double)p->width;
+    double phi = -(v - (double)p->height) * M_PI / (double)p->height;
+    double sin_phi = sin(phi);
+    X->x = sin_phi * sin(theta);
+    X->y = cos(phi);
+    X->z = sin_phi * cos(theta);
+    return 1;
+}
+
+static inline int equirect_from_world(const ProjectionParams *p, Vector3D X,
+                                      double *u, double *v) {
+    double y = X.y;
+    if (y > 1.0) y = 1.0;
+    if (y < -1.0) y = -1.0;
+    double theta = atan2(X.x, X.z);
+    double phi = acos(y);
+    *u = (theta + M_PI) * (double)p->width / (2.0 * M_PI);
+    *v = -(phi - M_PI) * (double)p->height / M_PI;
+    return 1;
+}
+
+/* ----- rectilinear: f = (W/2) / tan(fov/2) ----- */
+#define rectilinear_WRAP_U 0
+
+static inline int rectilinear_to_world(const ProjectionParams *p, double u, double v,
+                                       Vector3D *X) {
+    *X = make_dir((u - (double)p->width / 2.0) / p->focal,
+                  (v - (double)p->height / 2.0) / p->focal, 1.0);
+    return 1;
+}
+
+static inline int rectilinear_from_world(const ProjectionParams *p, Vector3D X,
+                                         double *u, double *v) {
+    if (X.z <= 1e-12) return 0;
+    *u = p->focal * X.x / X.z + (double)p->width / 2.0;
+    *v = p->focal * X.y / X.z + (double)p->height / 2.0;
+    return 1;
+}
+
+/* ----- cylindrical: f = W / fov [画素/ラジアン] ----- */
+#define cylindrical_WRAP_U 0
+
+static inline int cylindrical_to_world(const ProjectionParams *p, double u, double v,
+                                       Vector3D *X) {
+    double theta = (u - (double)p->width / 2.0) / p->focal;
+    double h = (v - (double)p->height / 2.0) / p->focal;
+    *X = make_dir(sin(theta), h, cos(theta));
+    return 1;
+}
+
+static inline int cylindrical_from_world(const ProjectionParams *p, Vector3D X,
+                                         double *u, double *v) {
+    double rho = sqrt(X.x * X.x + X.z * X.z);
+    if (rho < 1e-12) return 0;
+    double theta = atan2(X.x, X.z);
+    if (fabs(theta) > DEG_TO_RAD(p->fov_deg) / 2.0) return 0;
+    *u = theta * p->focal + (double)p->width / 2.0;
+    *v = X.y / rho * p->focal + (double)p->height / 2.0;
+    return 1;
+}
+
+/* ----- stereographic: r = 2f tan(α/2) ----- */
+#define stereographic_WRAP_U 0
+
+static inline int stereographic_to_world(const ProjectionParams *p, double u, double v,
+                                         Vector3D *X) {
+    double dx = u - (double)p->width / 2.0;
+    double dy = v - (double)p->height / 2.0;
+    double r = sqrt(dx * dx + dy * dy);
+    *X = radial_dir(dx, dy, r, 2.0 * atan(r / (2.0 * p->focal)));
+    return 1;
+}
+
+static inline int stereographic_from_world(const ProjectionParams *p, Vector3D X,
+                                           double *u, double *v) {
+    double z = X.z;
+    if (z > 1.0) z = 1.0;
+    if (z <= -1.0 + 1e-12) return 0;
+    double alpha = acos(z);
+    double rho = sqrt(X.x * X.x + X.y * X.y);
+    double r = 2.0 * p->focal * tan(alpha / 2.0);
+    *u = (double)p->width / 2.0;
+    *v = (double)p->height / 2.0;
+    if (rho > 1e-12) {
+        *u += r * X.x / rho;
+        *v += r * X.y / rho;
+    }
+    return 1;
+}
+
+/* ----- fisheye（等距離射影）: r = f α ----- */
+#define fisheye_WRAP_U 0
+
+static inline int fisheye_to_world(const ProjectionParams *p, double u, double v,
+                                   Vector3D *X) {
+    double dx = u - (double)p->width / 2.0;
+    double dy = v - (double)p->height / 2.0;
+    double r = sqrt(dx * dx + dy * dy);
+    double alpha = r / p->focal;
+    if (alpha > DEG_TO_RAD(p->fov_deg) / 2.0 || alpha > M_PI) return 0;
+    *X = radial_dir(dx, dy, r, alpha);
+    return 1;
+}
+
+static inline int fisheye_from_world(const ProjectionParams *p, Vector3D X,
+                                     double *u, double *v) {
+    double z = X.z;
+    if (z > 1.0) z = 1.0;
+    if (z < -1.0) z = -1.0;
+    double alpha = acos(z);
+    if (alpha > DEG_TO_RAD(p->fov_deg) / 2.0) return 0;
+    double rho = sqrt(X.x * X.x + X.y * X.y);
+    double r = p->focal * alpha;
+    *u = (double)p->width / 2.0;
+    *v = (double)p->height / 2.0;
+    if (rho > 1e-12) {
+        *u += r * X.x / rho;
+        *v += r * X.y / rho;
+    }
+    return 1;
+}
+
+/* ----- cube_face: 画角90°の透視投影を6方向に向けたもの ----- */
+#define cube_face_WRAP_U 0
+
+/* 各面の基底 {光軸, 右, 下} */
+static const double CUBE_BASIS[6][3][3] = {
+    /* +X */ {{ 1, 0, 0}, { 0, 0, -1}, {0, 1, 0}},
+    /* -X */ {{-1, 0, 0}, { 0, 0,  1}, {0, 1, 0}},
+    /* +Y */ {{ 0, 1, 0}, { 1, 0,  0}, {0, 0, -1}},
+    /* -Y */ {{ 0, -1, 0}, { 1, 0, 0}, {0, 0, 1}},
+    /* +Z */ {{ 0, 0, 1}, { 1, 0,  0}, {0, 1, 0}},
+    /* -Z */ {{ 0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+};
+
+static inline int cube_face_to_world(const ProjectionParams *p, double u, double v,
+                                     Vector3D *X) {
+    const double (*b)[3] = CUBE_BASIS[p->face];
+    double x = (u - (double)p->width / 2.0) / ((double)p->width / 2.0);
+    double y = (v - (double)p->height / 2.0) / ((double)p->height / 2.0);
+    *X = make_dir(b[0][0] + x * b[1][0] + y * b[2][0],
+                  b[0][1] + x * b[1][1] + y * b[2][1],
+                  b[0][2] + x * b[1][2] + y * b[2][2]);
+    return 1;
+}
+
+static inline int cube_face_from_world(const ProjectionParams *p, Vector3D X,
+                                       double *u, double *v) {
+    const double (*b)[3] = CUBE_BASIS[p->face];
+    double f = X.x * b[0][0] + X.y * b[0][1] + X.z * b[0][2];
+    if (f <= 1e-12) return 0;
+    double x = (X.x * b[1][0] + X.y * b[1][1] + X.z * b[1][2]) / f;
+    double y = (X.x * b[2][0] + X.y * b[2][1] + X.z * b[2][2]) / f;
+    if (fabs(x) > 1.0 || fabs(y) > 1.0) return 0;
+    *u = x * (double)p->width / 2.0 + (double)p->width / 2.0;
+    *v = y * (double)p->height / 2.0 + (double)p->height / 2.0;
+    return 1;
+}
+
+/* ----- dual_fisheye: 2つの魚眼レンズ（dual_fisheye.h） ----- */
+#define dual_fisheye_WRAP_U 0
+
+/* レンズ座標 → 画像座標（r(α) = f * poly(α)） */
+static inline int lens_from_world(const FisheyeLens *lens, Vector3D X,
+                                  double *u, double *v, double *alpha) {
+    double xl = lens->R.m[0][0] * X.x + lens->R.m[0][1] * X.y + lens->R.m[0][2] * X.z;
+    double yl = lens->R.m[1][0] * X.x + lens->R.m[1][1] * X.y + lens->R.m[1][2] * X.z;
+    double zl = lens->R.m[2][0] * X.x + lens->R.m[2][1] * X.y + lens->R.m[2][2] * X.z;
+    if (zl > 1.0) zl = 1.0;
+    if (zl < -1.0) zl = -1.0;
+
+    *alpha = acos(zl);
+    if (*alpha > lens->alpha_max) return 0;
+
+    double a2 = *alpha * *alpha;
+    double r = lens->focal * *alpha * (1.0 + a2 * (lens->k[0] + a2 * (lens->k[1]
+                                      + a2 * (lens->k[2] + a2 * lens->k[3]))));
+    double rho = sqrt(xl * xl + yl * yl);
+    *u = lens->cx;
+    *v = lens->cy;
+    if (rho > 1e-12) {
+        *u += r * xl / rho;
+        *v += r * yl / rho;
+    }
+    return 1;
+}
+
+/* 画像座標 → 世界座標（どちらかの像円の内側のみ有効） */
+static inline int dual_fisheye_to_world(const ProjectionParams *p, double u, double v,
+                                        Vector3D *X) {
+    for (int i = 0; i < 2; i++) {
+        const FisheyeLens *lens = &p->fisheye->lens[i];
+        double dx = u - lens->cx;
+        double dy = v - lens->cy;
+        double r = sqrt(dx * dx + dy * dy);
+        if (r > lens->radius) continue;
+
+        /* poly(α) = r/f をニュートン法で解く */
+        double target = r / lens->focal;
+        double alpha = target;
+        for (int it = 0; it < 10; it++) {
+            double a2 = alpha * alpha;
+            double g = fisheye_lens_poly(lens, alpha) - target;
+            double dg = 1.0 + a2 * (3.0 * lens->k[0] + a2 * (5.0 * lens->k[1]
+                        + a2 * (7.0 * lens->k[2] + a2 * 9.0 * lens->k[3])));
+            alpha -= g / dg;
+        }
+
+        /* レンズ座標 → 世界座標: X = R^T X_lens */
+        Vector3D Xl = radial_dir(dx, dy, r, alpha);
+        *X = matrix_vector_multiply(matrix_transpose(lens->R), Xl);
+        return 1;
+    }
+    return 0;
+}
+
+/* 前方レンズの画像座標（継ぎ目の混合は dual_fisheye_sample_* で行う） */
+static inline int dual_fisheye_from_world(const ProjectionParams *p, Vector3D X,
+                                          double *u, double *v) {
+    double alpha;
+    for (int i = 0; i < 2; i++) {
+        if (lens_from_world(&p->fisheye->lens[i], X, u, v, &alpha)) return 1;
+    }
+    return 0;
+}
+
+
+/* ===========================
+ * 補間（チャンネル数は定数として展開される）
+ * =========================== */
+
+static inline int wrap_index(int i, int n) {
+    i %= n;
+    return i < 0 ? i + n : i;
+}
+
+static inline int clamp_index(int i, int n) {
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+static inline void sample_nearest(const Image *img, double u, double v,
+                                  uint8_t *px, const int C, const int wrap_u) {
+    int W = img->width;
+    int H = img->height;
+    int ui = (int)floor(u + 0.5);
+    int vi = clamp_index((int)floor(v + 0.5), H);
+    ui = wrap_u ? wrap_index(ui, W) : clamp_index(ui, W);
+
+    const uint8_t *p = img->data + ((size_t)vi * W + ui) * C;
+    for (int c = 0; c < C; c++) {
+        px[c] = p[c];
+    }
+}
+
+static inline void sample_bilinear(const Image *img, double u, double v,
+                                   uint8_t *px, const int C, const int wrap_u) {
+    int W = img->width;
+    int H = img->height;
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    double du = u - u0;
+    double dv = v - v0;
+
+    int u1 = u0 + 1;
+    int v1 = clamp_index(v0 + 1, H);
+    v0 = clamp_index(v0, H);
+    if (wrap_u) {
+        u0 = wrap_index(u0, W);
+        u1 = wrap_index(u1, W);
+    } else {
+        u0 = clamp_index(u0, W);
+        u1 = clamp_index(u1, W);
+    }
+
+    const uint8_t *p00 = img->data + ((size_t)v0 * W + u0) * C;
+    const uint8_t *p10 = img->data + ((size_t)v0 * W + u1) * C;
+    const uint8_t *p01 = img->data + ((size_t)v1 * W + u0) * C;
+    const uint8_t *p11 = img->data + ((size_t)v1 * W + u1) * C;
+
+    for (int c = 0; c < C; c++) {
+        double val = (1.0 - du) * (1.0 - dv) * p00[c]
+                   + (1.0 - du) * dv         * p01[c]
+                   + du         * (1.0 - dv) * p10[c]
+                   + du         * dv         * p11[c];
+        if (val < 0) val = 0;
+        if (val > 255) val = 255;
+        px[c] = (uint8_t)val;
+    }
+}
+
+
+/* ===========================
+ * 入力側のサンプラー
+ *
+ * <name>_sample_<interp>(in, ip, X, px, C)
+ *   世界座標 X の画素値を px に書き込む（0: 範囲外）
+ * =========================== */
+
+/* 非周期の入力では画像の外を範囲外として扱う */
+#define IN_RANGE(img, u, v) \
+    ((u) >= 0.0 && (u) <= (double)((img)->width - 1) && \
+     (v) >= 0.0 && (v) <= (double)((img)->height - 1))
+
+/* 単一の投影: from_world して補間するだけ */
+#define DEFINE_SAMPLER(name, interp)                                           \
+static inline int name##_sample_##interp(const Image *in,                      \
+        const ProjectionParams *ip, Vector3D X, uint8_t *px, const int C) {    \
+    double u, v;                                                               \
+    if (!name##_from_world(ip, X, &u, &v)) return 0;                           \
+    if (!name##_WRAP_U && !IN_RANGE(in, u, v)) return 0;                       \
+    sample_##interp(in, u, v, px, C, name##_WRAP_U);                           \
+    return 1;                                                                  \
+}
+#define GEN_SAMPLERS(unused, E, name) \
+    DEFINE_SAMPLER(name, nearest) DEFINE_SAMPLER(name, bilinear)
+
+/* デュアル魚眼: 各レンズを重み w = clamp((α_max - α)/blend, 0, 1) で混合 */
+#define DEFINE_DUAL_FISHEYE_SAMPLER(interp)                                    \
+static inline int dual_fisheye_sample_##interp(const Image *in,                \
+        const ProjectionParams *ip, Vector3D X, uint8_t *px, const int C) {    \
+    const DualFisheyeCalib *calib = ip->fisheye;                               \
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};                                      \
+    double w_sum = 0.0;                                                        \
+    for (int i = 0; i < 2; i++) {                                              \
+        const FisheyeLens *lens = &calib->lens[i];                             \
+        double u, v, alpha;                                                    \
+        if (!lens_from_world(lens, X, &u, &v, &alpha)) continue;               \
+        if (!IN_RANGE(in, u, v)) continue;                                     \
+        double w = (lens->alpha_max - alpha) / calib->blend_rad;               \
+        if (w <= 0.0) continue;                                                \
+        if (w > 1.0) w = 1.0;                                                  \
+        uint8_t s[4];                                                          \
+        sample_##interp(in, u, v, s, C, 0);                                    \
+        for (int c = 0; c < C; c++) acc[c] += w * s[c];                        \
+        w_sum += w;                                                            \
+    }                                                                          \
+    if (w_sum <= 0.0) return 0;                                                \
+    for (int c = 0; c < C; c++) px[c] = (uint8_t)(acc[c] / w_sum + 0.5);       \
+    return 1;                                                                  \
+}
+
+
+/* ===========================
+ * 描画カーネルの生成（X-マクロ）
+ * =========================== */
+
+typedef void (*RenderKernel)(const Image *in, const ProjectionParams *ip,
+                             Image *out, const ProjectionParams *op,
+                             const Matrix3x3 *M);
+
+/* 出力のカメラ座標 Xp を M で回転（全カーネルで同じ式を使う） */
+#define ROTATE_DIR(M, Xp, X_)                                                  \
+    do {                                                                       \
+        (X_).x = (M)->m[0][0] * (Xp).x + (M)->m[0][1] * (Xp).y + (M)->m[0][2] * (Xp).z; \
+        (X_).y = (M)->m[1][0] * (Xp).x + (M)->m[1][1] * (Xp).y + (M)->m[1][2] * (Xp).z; \
+        (X_).z = (M)->m[2][0] * (Xp).x + (M)->m[2][1] * (Xp).y + (M)->m[2][2] * (Xp).z; \
+    } while (0)
+
+/* 出力のカメラ座標 Xp を M で回転して入力を補間（範囲外は0） */
+#define SAMPLE_ROTATED(IN, INTERP, C, in, ip, M, Xp, px)                      \
+    do {                                                                       \
+        Vector3D X_;                                                           \
+        ROTATE_DIR(M, Xp, X_);                                                 \
+        if (!IN##_sample_##INTERP(in, ip, X_, px, C)) {                        \
+            for (int c = 0; c < C; c++) (px)[c] = 0;                           \
+        }                                                                      \
+    } while (0)
+
+#define DEFINE_KERNEL(IN, OUT, INTERP, C)                                      \
+static void kernel_##IN##_##OUT##_##INTERP##_##C(                             \
+        const Image *in, const ProjectionParams *ip,                           \
+        Image *out, const ProjectionParams *op, const Matrix3x3 *M) {          \
+    for (int v_out = 0; v_out < op->height; v_out++) {                         \
+        uint8_t *row = out->data + (size_t)v_out * op->width * C;             \
+        for (int u_out = 0; u_out < op->width; u_out++) {                      \
+            uint8_t *px = row + (size_t)u_out * C;                             \
+            Vector3D Xp;                                                       \
+            if (!OUT##_to_world(op, (double)u_out, (double)v_out, &Xp)) {      \
+                for (int c = 0; c < C; c++) px[c] = 0;                         \
+                continue;                                                      \
+            }                                                                  \
+            SAMPLE_ROTATED(IN, INTERP, C, in, ip, M, Xp, px);                  \
+        }                                                                      \
+    }                                                                          \
+}
+
+/* 行の一部のカーネル: 出力画素 (min(u0 + k step, W - 1), v_out) を dst[k] に */
+#define DEFINE_SPAN_KERNEL(IN, OUT, INTERP, C)                                 \
+static void span_##IN##_##OUT##_##INTERP##_##C(                               \
+        const Image *in, const ProjectionParams *ip,                           \
+        const ProjectionParams *op, const Matrix3x3 *M,                        \
+        int u0, int v_out, int step, int n, uint8_t *dst) {                    \
+    for (int k = 0; k < n; k++) {                                              \
+        int u_out = u0 + k * step;                                             \
+        if (u_out > op->width - 1) u_out = op->width - 1;                      \
+        uint8_t *px = dst + (size_t)k * C;                                     \
+        Vector3D Xp;                                                           \
+        if (!OUT##_to_world(op, (double)u_out, (double)v_out, &Xp)) {          \
+            for (int c = 0; c < C; c++) px[c] = 0;                             \
+            continue;                                                          \
+        }                                                                      \
+        SAMPLE_ROTATED(IN, INTERP, C, in, ip, M, Xp, px);                      \
+    }                                                                          \
+}
+
+/* 出力の投影が同じ K 個のビュー: 出力画素の方向は行ごとに1回だけ求め、
+ * 同じ行を全ビューで続けて描画する（重なったビューは入力の同じ範囲を読む） */
+typedef void (*ViewsKernel)(const Image *in, const ProjectionParams *ip,
+                            const ProjectionParams *op, const Matrix3x3 *M,
+                            uint8_t *const *out, int K,
+                            Vector3D *dirs, uint8_t *valid);
+
+#define DEFINE_VIEWS_KERNEL(IN, OUT, INTERP, C)                                \
+static void views_##IN##_##OUT##_##INTERP##_##C(                              \
+        const Image *in, const ProjectionParams *ip,                           \
+        const ProjectionParams *op, const Matrix3x3 *M,                        \
+        uint8_t *const *out, int K, Vector3D *dirs, uint8_t *valid) {          \
+    for (int v_out = 0; v_out < op->height; v_out++) {                         \
+        for (int u_out = 0; u_out < op->width; u_out++) {                      \
+            valid[u_out] = (uint8_t)OUT##_to_world(op, (double)u_out,          \
+                                                   (double)v_out, &dirs[u_out]); \
+        }                                                                      \
+        for (int k = 0; k < K; k++) {                                          \
+            uint8_t *row = out[k] + (size_t)v_out * op->width * C;             \
+            for (int u_out = 0; u_out < op->width; u_out++) {                  \
+                uint8_t *px = row + (size_t)u_out * C;                         \
+                if (!valid[u_out]) {                                           \
+                    for (int c = 0; c < C; c++) px[c] = 0;                     \
+                    continue;                                                  \
+                }                                                              \
+                SAMPLE_ROTATED(IN, INTERP, C, in, ip, M + k, dirs[u_out], px); \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+}
+
+/* 入力タイル順の描画（ビン分け）
+ *
+ * bin_row_<in>: 1行分の出力画素の方向 dirs を M で回転して入力の座標 (u, v) を
+ *   求め、範囲内の画素は座標、書き込み先、入力タイルの番号を並べる（範囲外は
+ *   その場で0）。戻り値は並べた画素数。
+ * gather_<interp>_<C>_<wrap>: 並べた画素を order の順（タイル順）に補間する。
+ * どちらも SAMPLE_ROTATED と同じ式なので結果は描画カーネルと一致する。
+ */
+typedef int (*BinRowKernel)(const Image *in, const ProjectionParams *ip,
+                            const Matrix3x3 *M, const Vector3D *dirs,
+                            const uint8_t *valid, int width, uint8_t *row, int C,
+                            int tile_size, int tiles_u, int tiles_v,
+                            double *uv, uint8_t **dst, int *tile);
+typedef void (*GatherKernel)(const Image *in, const double *uv,
+                             uint8_t *const *dst, const int *order, int n);
+
+#define DEFINE_BIN_ROW(unused, E, name)                                        \
+static int bin_row_##name(const Image *in, const ProjectionParams *ip,         \
+        const Matrix3x3 *M, const Vector3D *dirs, const uint8_t *valid,        \
+        int width, uint8_t *row, int C, int tile_size, int tiles_u,            \
+        int tiles_v, double *uv, uint8_t **dst, int *tile) {                   \
+    int n = 0;                                                                 \
+    for (int u_out = 0; u_out < width; u_out++) {                              \
+        uint8_t *px = row + (size_t)u_out * C;                                 \
+        if (valid[u_out]) {                                                    \
+            Vector3D X;                                                        \
+            double u, v;                                                       \
+            ROTATE_DIR(M, dirs[u_out], X);                                     \
+            if (name##_from_world(ip, X, &u, &v) &&                            \
+                (name##_WRAP_U || IN_RANGE(in, u, v))) {                       \
+                int tu = clamp_index((int)floor(u) / tile_size, tiles_u);      \
+                int tv = clamp_index((int)floor(v) / tile_size, tiles_v);      \
+                uv[2 * n] = u;                                                 \
+                uv[2 * n + 1] = v;                                             \
+                dst[n] = px;                                                   \
+                tile[n] = tv * tiles_u + tu;                                   \
+                n++;                                                           \
+                continue;                                                      \
+            }                                                                  \
+        }                                                                      \
+        for (int c = 0; c < C; c++) px[c] = 0;                                 \
+    }                                                                          \
+    return n;                                                                  \
+}
+
+#define DEFINE_GATHER(INTERP, C, WRAP)                                         \
+static void gather_##INTERP##_##C##_##WRAP(const Image *in, const double *uv,  \
+        uint8_t *const *dst, const int *order, int n) {                        \
+    for (int j = 0; j < n; j++) {                                              \
+        int i = order[j];                                                      \
+        sample_##INTERP(in, uv[2 * i], uv[2 * i + 1], dst[i], C, WRAP);        \
+    }                                                                          \
+}
+
+/* 組み合わせを展開するための一覧
+ *
+ * マクロは自分自身の展開中に再展開されないため、
+ * 入力側の PROJECTION_LIST とは別に出力側の一覧を持つ。
+ * 出力に使える投影を追加する場合はここにも加えること。
+ */
+#define OUTPUT_LIST(M, ...) \
+    M(__VA_ARGS__, EQUIRECT, equirect) \
+    M(__VA_ARGS__, RECTILINEAR, rectilinear) \
+    M(__VA_ARGS__, CYLINDRICAL, cylindrical) \
+    M(__VA_ARGS__, STEREOGRAPHIC, stereographic) \
+    M(__VA_ARGS__, FISHEYE, fisheye) \
+    M(__VA_ARGS__, CUBE_FACE, cube_face)
+#define INTERP_LIST(M, ...) \
+    M(__VA_ARGS__, NEAREST, nearest) \
+    M(__VA_ARGS__, BILINEAR, bilinear)
+#define CHANNEL_LIST(M, ...) \
+    M(__VA_ARGS__, 1) M(__VA_ARGS__, 3) M(__VA_ARGS__, 4)
+
+/* 入力側のサンプラーの定義 */
+OUTPUT_LIST(GEN_SAMPLERS, _)
+DEFINE_DUAL_FISHEYE_SAMPLER(nearest)
+DEFINE_DUAL_FISHEYE_SAMPLER(bilinear)
+
+#define FOR_EACH_INTERP(M, IE, in, OE, out) \
+    INTERP_LIST(CHANNEL_LIST_##M, IE, in, OE, out)
+#define CHANNEL_LIST_GEN(IE, in, OE, out, JE, interp) \
+    CHANNEL_LIST(GEN_KERNEL, IE, in, OE, out, JE, interp)
+#define CHANNEL_LIST_TBL(IE, in, OE, out, JE, interp) \
+    CHANNEL_LIST(TBL_ENTRY, IE, in, OE, out, JE, interp)
+#define CHANNEL_LIST_SPAN(IE, in, OE, out, JE, interp) \
+    CHANNEL_LIST(SPAN_ENTRY, IE, in, OE, out, JE, interp)
+#define CHANNEL_LIST_VIEWS(IE, in, OE, out, JE, interp) \
+    CHANNEL_LIST(VIEWS_ENTRY, IE, in, OE, out, JE, interp)
+
+/* カーネル本体の定義 */
+#define GEN_KERNEL(IE, in, OE, out, JE, interp, C) \
+    DEFINE_KERNEL(in, out, interp, C) DEFINE_SPAN_KERNEL(in, out, interp, C) \
+    DEFINE_VIEWS_KERNEL(in, out, interp, C)
+#define GEN_OUT(IE, in, OE, out) FOR_EACH_INTERP(GEN, IE, in, OE, out)
+#define GEN_IN(IE, in)           OUTPUT_LIST(GEN_OUT, IE, in)
+
+PROJECTION_LIST(GEN_IN)
+
+/* ビン分けのカーネルの定義（dual_fisheye は2つのレンズを混合するため対象外） */
+#define GEN_GATHER_WRAP(interp, C) \
+    DEFINE_GATHER(interp, C, 0) DEFINE_GATHER(interp, C, 1)
+#define GEN_GATHER(unused, JE, interp) CHANNEL_LIST(GEN_GATHER_WRAP, interp)
+
+OUTPUT_LIST(DEFINE_BIN_ROW, _)
+INTERP_LIST(GEN_GATHER, _)
+
+/* ディスパッチ表 [入力][出力][補間][チャンネル数] */
+#define TBL_ENTRY(IE, in, OE, out, JE, interp, C) \
+    [PROJ_##IE][PROJ_##OE][INTERP_##JE][C] = kernel_##in##_##out##_##interp##_##C,
+#define TBL_OUT(IE, in, OE, out) FOR_EACH_INTERP(TBL, IE, in, OE, out)
+#define TBL_IN(IE, in)           OUTPUT_LIST(TBL_OUT, IE, in)
+
+static const RenderKernel KERNELS[PROJ_COUNT][PROJ_COUNT][INTERP_COUNT][5] = {
+    PROJECTION_LIST(TBL_IN)
+};
+
+/* 行の一部のカーネルの表（並びは KERNELS と同じ） */
+#define SPAN_ENTRY(IE, in, OE, out, JE, interp, C) \
+    [PROJ_##IE][PROJ_##OE][INTERP_##JE][C] = span_##in##_##out##_##interp##_##C,
+#define SPAN_OUT(IE, in, OE, out) FOR_EACH_INTERP(SPAN, IE, in, OE, out)
+#define SPAN_IN(IE, in)           OUTPUT_LIST(SPAN_OUT, IE, in)
+
+static const ProjectionSpanKernel SPAN_KERNELS[PROJ_COUNT][PROJ_COUNT][INTERP_COUNT][5] = {
+    PROJECTION_LIST(SPAN_IN)
+};
+
+/* 複数ビューのカーネルの表 */
+#define VIEWS_ENTRY(IE, in, OE, out, JE, interp, C) \
+    [PROJ_##IE][PROJ_##OE][INTERP_##JE][C] = views_##in##_##out##_##interp##_##C,
+#define VIEWS_OUT(IE, in, OE, out) FOR_EACH_INTERP(VIEWS, IE, in, OE, out)
+#define VIEWS_IN(IE, in)           OUTPUT_LIST(VIEWS_OUT, IE, in)
+
+static const ViewsKernel VIEWS_KERNELS[PROJ_COUNT][PROJ_COUNT][INTERP_COUNT][5] = {
+    PROJECTION_LIST(VIEWS_IN)
+};
+
+/* ビン分けのカーネルの表 [入力] と [補間][チャンネル数][u の周期性] */
+#define BIN_ROW_ENTRY(unused, E, name) [PROJ_##E] = bin_row_##name,
+#define GATHER_ENTRY(JE, interp, C) \
+    [INTERP_##JE][C][0] = gather_##interp##_##C##_0, \
+    [INTERP_##JE][C][1] = gather_##interp##_##C##_1,
+#define GATHER_TBL(unused, JE, interp) CHANNEL_LIST(GATHER_ENTRY, JE, interp)
+
+static const BinRowKernel BIN_ROW_KERNELS[PROJ_COUNT] = {
+    OUTPUT_LIST(BIN_ROW_ENTRY, _)
+};
+
+static const GatherKernel GATHER_KERNELS[INTERP_COUNT][5][2] = {
+    INTERP_LIST(GATHER_TBL, _)
+};
+
+
+/* ===========================
+ * パラメータの設定
+ * =========================== */
+
+ProjectionParams projection_init(ProjectionType type, int width, int height,
+                                 double fov_deg) {
+    ProjectionParams p;
+    p.type = type;
+    p.width = width;
+    p.height = height;
+    p.fov_deg = fov_deg;
+    p.face = CUBE_POS_Z;
+    p.focal = 1.0;
+    p.fisheye = NULL;
+
+    double fov = DEG_TO_RAD(fov_deg);
+    switch (type) {
+    case PROJ_RECTILINEAR:
+        p.focal = ((double)width / 2.0) / tan(fov / 2.0);
+        break;
+    case PROJ_CYLINDRICAL:
+        p.focal = (double)width / fov;
+        break;
+    case PROJ_STEREOGRAPHIC:
+        p.focal = ((double)width / 2.0) / (2.0 * tan(fov / 4.0));
+        break;
+    case PROJ_FISHEYE:
+        p.focal = ((double)width / 2.0) / (fov / 2.0);
+        break;
+    default:
+        break;
+    }
+
+    return p;
+}
+
+ProjectionParams projection_init_dual_fisheye(int width, int height,
+                                              const DualFisheyeCalib *calib) {
+    ProjectionParams p = projection_init(PROJ_DUAL_FISHEYE, width, height,
+                                         2.0 * calib->lens[0].fov_deg);
+    p.fisheye = calib;
+    return p;
+}
+
+const char* projection_name(ProjectionType type) {
+    switch (type) {
+#define X(E, name) case PROJ_##E: return #name;
+    PROJECTION_LIST(X)
+#undef X
+    default:
+        return "unknown";
+    }
+}
+
+int projection_parse(const char *name, ProjectionType *type) {
+#define X(E, n) if (strcmp(name, #n) == 0) { *type = PROJ_##E; return 1; }
+    PROJECTION_LIST(X)
+#undef X
+    return 0;
+}
+
+
+/* ===========================
+ * 座標変換（汎用版）
+ * =========================== */
+
+int projection_to_world(const ProjectionParams *p, double u, double v,
+                        Vector3D *X) {
+    if (p->type == PROJ_DUAL_FISHEYE && !p->fisheye) return 0;
+    switch (p->type) {
+#define X(E, name) case PROJ_##E: return name##_to_world(p, u, v, X);
+    PROJECTION_LIST(X)
+#undef X
+    default:
+        return 0;
+    }
+}
+
+int projection_from_world(const ProjectionParams *p, Vector3D X,
+                          double *u, double *v) {
+    if (p->type == PROJ_DUAL_FISHEYE && !p->fisheye) return 0;
+    switch (p->type) {
+#define X_(E, name) case PROJ_##E: return name##_from_world(p, X, u, v);
+    PROJECTION_LIST(X_)
+#undef X_
+    default:
+        return 0;
+    }
+}
+
+int projection_sample(const Image *input, const ProjectionParams *in_p,
+                      Vector3D X, uint8_t *px, Interpolation interp) {
+    int C = input->channels;
+    if (in_p->type == PROJ_DUAL_FISHEYE && !in_p->fisheye) return 0;
+    switch (in_p->type) {
+#define X_(E, name) \
+    case PROJ_##E: \
+        return (interp == INTERP_NEAREST) \
+            ? name##_sample_nearest(input, in_p, X, px, C) \
+            : name##_sample_bilinear(input, in_p, X, px, C);
+    PROJECTION_LIST(X_)
+#undef X_
+    default:
+        return 0;
+    }
+}
+
+int projection_sample_at(const Image *input, const ProjectionParams *in_p,
+                         double u, double v, uint8_t *px, Interpolation interp) {
+    int C = input->channels;
+    int wrap_u;
+    switch (in_p->type) {
+#define X_(unused, E, name) case PROJ_##E: wrap_u = name##_WRAP_U; break;
+    OUTPUT_LIST(X_, _)
+#undef X_
+    default:
+        return 0;
+    }
+    if (!wrap_u && !IN_RANGE(input, u, v)) return 0;
+    if (interp == INTERP_NEAREST) {
+        sample_nearest(input, u, v, px, C, wrap_u);
+    } else {
+        sample_bilinear(input, u, v, px, C, wrap_u);
+    }
+    return 1;
+}
+
+
+/* ===========================
+ * 描画
+ * =========================== */
+
+int projection_render(Image *input, const ProjectionParams *in_p,
+                      Image *output, const ProjectionParams *out_p,
+                      Matrix3x3 R_T, Interpolation interp) {
+    int C = input->channels;
+    if (output->channels != C || output->width != out_p->width ||
+        output->height != out_p->height ||
+        input->width != in_p->width || input->height != in_p->height) {
+        fprintf(stderr, "エラー: 画像サイズまたはチャンネル数が投影パラメータと一致しません\n");
+        return 0;
+    }
+    if (in_p->type == PROJ_DUAL_FISHEYE && !in_p->fisheye) {
+        fprintf(stderr, "エラー: デュアル魚眼のキャリブレーションがありません\n");
+        return 0;
+    }
+    if (C < 1 || C > 4 || in_p->type >= PROJ_COUNT || out_p->type >= PROJ_COUNT ||
+        interp >= INTERP_COUNT) {
+        fprintf(stderr, "エラー: 対応していない組み合わせです\n");
+        return 0;
+    }
+
+    RenderKernel kernel = KERNELS[in_p->type][out_p->type][interp][C];
+    if (!kernel) {
+        fprintf(stderr, "エラー: 対応していない組み合わせです（%s → %s, %dチャンネル）\n",
+                projection_name(in_p->type), projection_name(out_p->type), C);
+        return 0;
+    }
+
+    kernel(input, in_p, output, out_p, &R_T);
+    return 1;
+}
+
+ProjectionSpanKernel projection_span_kernel(const Image *input, const ProjectionParams *in_p,
+                                            const ProjectionParams *out_p, Interpolation interp) {
+    int C = input->channels;
+    if (input->width != in_p->width || input->height != in_p->height) {
+        fprintf(stderr, "エラー: 画像サイズが投影パラメータと一致しません\n");
+        return NULL;
+    }
+    if (in_p->type == PROJ_DUAL_FISHEYE && !in_p->fisheye) {
+        fprintf(stderr, "エラー: デュアル魚眼のキャリブレーションがありません\n");
+        return NULL;
+    }
+    if (C < 1 || C > 4 || in_p->type >= PROJ_COUNT || out_p->type >= PROJ_COUNT ||
+        interp >= INTERP_COUNT || !SPAN_KERNELS[in_p->type][out_p->type][interp][C]) {
+        fprintf(stderr, "エラー: 対応していない組み合わせです（%s → %s, %dチャンネル）\n",
+                projection_name(in_p->type), projection_name(out_p->type), C);
+        return NULL;
+    }
+    return SPAN_KERNELS[in_p->type][out_p->type][interp][C];
+}
+
+/* projection_render_views*() の引数の確認 */
+static int check_views(const Image *input, const ProjectionParams *in_p,
+                       Image **outputs, const ProjectionParams *out_p,
+                       int K, Interpolation interp) {
+    int C = input->channels;
+    for (int k = 0; k < K; k++) {
+        if (outputs[k]->channels != C || outputs[k]->width != out_p->width ||
+            outputs[k]->height != out_p->height) {
+            fprintf(stderr, "エラー: 画像サイズまたはチャンネル数が投影パラメータと一致しません\n");
+            return 0;
+        }
+    }
+    if (input->width != in_p->width || input->height != in_p->height) {
+        fprintf(stderr, "エラー: 画像サイズが投影パラメータと一致しません\n");
+        return 0;
+    }
+    if (in_p->type == PROJ_DUAL_FISHEYE && !in_p->fisheye) {
+        fprintf(stderr, "エラー: デュアル魚眼のキャリブレーションがありません\n");
+        return 0;
+    }
+    if (C < 1 || C > 4 || in_p->type >= PROJ_COUNT || out_p->type >= PROJ_COUNT ||
+        interp >= INTERP_COUNT || !VIEWS_KERNELS[in_p->type][out_p->type][interp][C]) {
+        fprintf(stderr, "エラー: 対応していない組み合わせです（%s → %s, %dチャンネル）\n",
+                projection_name(in_p->type), projection_name(out_p->type), C);
+        return 0;
+    }
+    return 1;
+}
+
+int projection_render_views(Image *input, const ProjectionParams *in_p,
+                            Image **outputs, const ProjectionParams *out_p,
+                            const Matrix3x3 *R_T, int K, Interpolation interp) {
+    int C = input->channels;
+    if (!check_views(input, in_p, outputs, out_p, K, interp)) {
+        return 0;
+    }
+    if (K <= 0) {
+        return 1;
+    }
+
+    Vector3D *dirs = (Vector3D*)malloc((size_t)out_p->width * sizeof(Vector3D));
+    uint8_t *valid = (uint8_t*)malloc((size_t)out_p->width);
+    uint8_t **out = (uint8_t**)malloc((size_t)K * sizeof(uint8_t*));
+    if (!dirs || !valid || !out) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(dirs);
+        free(valid);
+        free(out);
+        return 0;
+    }
+    for (int k = 0; k < K; k++) {
+        out[k] = outputs[k]->data;
+    }
+
+    VIEWS_KERNELS[in_p->type][out_p->type][interp][C](input, in_p, out_p, R_T, out, K, dirs, valid);
+
+    free(dirs);
+    free(valid);
+    free(out);
+    return 1;
+}
+
+int projection_render_views_binned(Image *input, const ProjectionParams *in_p,
+                                   Image **outputs, const ProjectionParams *out_p,
+                                   const Matrix3x3 *R_T, int K, Interpolation interp,
+                                   int tile_size, long batch_samples,
+                                   ProjectionBinStats *stats) {
+    ProjectionBinStats st = {0, 0};
+    int C = input->channels;
+    if (!check_views(input, in_p, outputs, out_p, K, interp)) {
+        return 0;
+    }
+    if (tile_size <= 0 || batch_samples <= 0) {
+        fprintf(stderr, "エラー: タイルの大きさとバッチの画素数は正の値にしてください\n");
+        return 0;
+    }
+    if (K <= 0) {
+        if (stats) *stats = st;
+        return 1;
+    }
+
+    BinRowKernel bin_row = BIN_ROW_KERNELS[in_p->type];
+    if (!bin_row) {
+        /* dual_fisheye: 1つの方向が2つのレンズの混合になるため行順で描画 */
+        if (stats) *stats = st;
+        return projection_render_views(input, in_p, outputs, out_p, R_T, K, interp);
+    }
+    int wrap_u = 0;
+    switch (in_p->type) {
+#define X_(unused, E, name) case PROJ_##E: wrap_u = name##_WRAP_U; break;
+    OUTPUT_LIST(X_, _)
+#undef X_
+    default:
+        break;
+    }
+    GatherKernel gather = GATHER_KERNELS[interp][C][wrap_u];
+
+    /* 全ビューの rows 行ずつを1つのバッチにする */
+    int W = out_p->width;
+    int H = out_p->height;
+    long rows = batch_samples / ((long)K * W);
+    if (rows < 1) rows = 1;
+    if (rows > H) rows = H;
+    size_t capacity = (size_t)rows * K * W;
+    int tiles_u = (input->width + tile_size - 1) / tile_size;
+    int tiles_v = (input->height + tile_size - 1) / tile_size;
+    int n_tiles = tiles_u * tiles_v;
+
+    Vector3D *dirs = (Vector3D*)malloc((size_t)W * sizeof(Vector3D));
+    uint8_t *valid = (uint8_t*)malloc((size_t)W);
+    double *uv = (double*)malloc(2 * capacity * sizeof(double));
+    uint8_t **dst = (uint8_t**)malloc(capacity * sizeof(uint8_t*));
+    int *tile = (int*)malloc(capacity * sizeof(int));
+    int *order = (int*)malloc(capacity * sizeof(int));
+    int *count = (int*)malloc(((size_t)n_tiles + 1) * sizeof(int));
+    if (!dirs || !valid || !uv || !dst || !tile || !order || !count) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(dirs);
+        free(valid);
+        free(uv);
+        free(dst);
+        free(tile);
+        free(order);
+        free(count);
+        return 0;
+    }
+
+    for (int v0 = 0; v0 < H; v0 += (int)rows) {
+        int v1 = (v0 + rows < H) ? v0 + (int)rows : H;
+
+        /* 1. 出力画素の入力座標とタイルを求める（方向は行ごとに1回） */
+        int n = 0;
+        for (int v_out = v0; v_out < v1; v_out++) {
+            for (int u_out = 0; u_out < W; u_out++) {
+                valid[u_out] = (uint8_t)projection_to_world(out_p, (double)u_out,
+                                                            (double)v_out, &dirs[u_out]);
+            }
+            for (int k = 0; k < K; k++) {
+                uint8_t *row = outputs[k]->data + (size_t)v_out * W * C;
+                n += bin_row(input, in_p, R_T + k, dirs, valid, W, row, C,
+                             tile_size, tiles_u, tiles_v,
+                             uv + 2 * (size_t)n, dst + n, tile + n);
+            }
+        }
+
+        /* 2. タイルごとに数え上げてソート */
+        memset(count, 0, ((size_t)n_tiles + 1) * sizeof(int));
+        for (int i = 0; i < n; i++) {
+            count[tile[i] + 1]++;
+        }
+        for (int t = 0; t < n_tiles; t++) {
+            if (count[t + 1] > 0) st.tile_visits++;
+            count[t + 1] += count[t];
+        }
+        for (int i = 0; i < n; i++) {
+            order[count[tile[i]]++] = i;
+        }
+
+        /* 3. タイル順に補間 */
+        gather(input, uv, dst, order, n);
+        st.batches++;
+    }
+
+    free(dirs);
+    free(valid);
+    free(uv);
+    free(dst);
+    free(tile);
+    free(order);
+    free(count);
+
+    if (stats) *stats = st;
+    return 1;
+}
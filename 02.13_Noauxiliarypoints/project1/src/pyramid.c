@@ -0,0 +1,65 @@
+/* pyramid.c
+ * 全方位画像のピラミッドの実装
+ */
+
+#include "pyramid.h"
+#include <stdio.h>
+
+/* ピラミッドの最上位の最小サイズ（高さ） */
+#define PYRAMID_MIN_HEIGHT 16
+
+/* 2×2画素の平均で縮小（u は周期的） */
+static GrayImage* downsample(const GrayImage *src) {
+    int W = src->width / 2;
+    int H = src->height / 2;
+    GrayImage *dst = gray_image_create(W, H);
+    if (!dst) return NULL;
+
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            dst->data[(size_t)v * W + u] = 0.25 * (
+                gray_get(src, 2 * u, 2 * v) + gray_get(src, 2 * u + 1, 2 * v) +
+                gray_get(src, 2 * u, 2 * v + 1) + gray_get(src, 2 * u + 1, 2 * v + 1));
+        }
+    }
+    return dst;
+}
+
+int gray_pyramid_build(GrayImage *image, int levels, GrayPyramid *pyramid) {
+    if (levels < 1) levels = 1;
+    if (levels > PYRAMID_MAX_LEVELS) levels = PYRAMID_MAX_LEVELS;
+
+    pyramid->levels = 1;
+    pyramid->level[0] = image;
+    for (int l = 1; l < levels; l++) {
+        const GrayImage *prev = pyramid->level[l - 1];
+        if (prev->height / 2 < PYRAMID_MIN_HEIGHT) {
+            break;
+        }
+        pyramid->level[l] = downsample(prev);
+        if (!pyramid->level[l]) {
+            fprintf(stderr, "エラー: ピラミッドの作成失敗\n");
+            gray_pyramid_free(pyramid);
+            return 0;
+        }
+        pyramid->levels++;
+    }
+    return 1;
+}
+
+void gray_pyramid_free(GrayPyramid *pyramid) {
+    for (int l = 1; l < pyramid->levels; l++) {
+        gray_image_free(pyramid->level[l]);
+        pyramid->level[l] = NULL;
+    }
+    pyramid->levels = 0;
+}
+
+Region region_at_level(Region region, int level) {
+    Region r;
+    r.u_min = region.u_min >> level;
+    r.v_min = region.v_min >> level;
+    r.u_max = region.u_max >> level;
+    r.v_max = region.v_max >> level;
+    return r;
+}
@@ -0,0 +1,355 @@
+/* region_set.c
+ * 複数の比較領域の目的関数の実装
+ */
+
+#include "region_set.h"
+#include "yaw_window.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 領域のファイルの1行の最大長 */
+#define REGION_LINE_MAX 256
+
+RegionSet* region_set_create(const Region *regions, int count) {
+    if (count < 1 || count > REGION_SET_MAX_REGIONS) {
+        fprintf(stderr, "エラー: 比較領域の数が不正です（%d）\n", count);
+        return NULL;
+    }
+    RegionSet *set = (RegionSet*)malloc(sizeof(RegionSet));
+    Region *copy = (Region*)malloc((size_t)count * sizeof(Region));
+    if (!set || !copy) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(set);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, regions, (size_t)count * sizeof(Region));
+    set->count = count;
+    set->regions = copy;
+    return set;
+}
+
+RegionSet* region_set_load(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        fprintf(stderr, "エラー: 比較領域のファイルが開けません: %s\n", filename);
+        return NULL;
+    }
+
+    Region regions[REGION_SET_MAX_REGIONS];
+    int count = 0;
+    int line_no = 0;
+    char line[REGION_LINE_MAX];
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        Region r;
+        char rest;
+        int n = sscanf(line, "%d %d %d %d %c", &r.u_min, &r.v_min, &r.u_max, &r.v_max, &rest);
+        if (n == EOF) continue;     /* 空行・コメントだけの行 */
+        if (n != 4) {
+            fprintf(stderr, "エラー: %s の %d 行目が読めません（u_min v_min u_max v_max）\n",
+                    filename, line_no);
+            fclose(fp);
+            return NULL;
+        }
+        if (count == REGION_SET_MAX_REGIONS) {
+            fprintf(stderr, "エラー: 比較領域が %d 個を超えています: %s\n",
+                    REGION_SET_MAX_REGIONS, filename);
+            fclose(fp);
+            return NULL;
+        }
+        regions[count++] = r;
+    }
+    fclose(fp);
+
+    if (count == 0) {
+        fprintf(stderr, "エラー: 比較領域がありません: %s\n", filename);
+        return NULL;
+    }
+    return region_set_create(regions, count);
+}
+
+void region_set_free(RegionSet *set) {
+    if (set) {
+        free(set->regions);
+        free(set);
+    }
+}
+
+/* 領域 r が行 v で覆う [0, W) の区間（継ぎ目で最大2つ、終わりは含まない）
+ *
+ * 戻り値:
+ *   区間の数（行を覆わなければ 0）
+ */
+static int region_row_intervals(const Region *r, int v, int W, int start[2], int end[2]) {
+    if (v < r->v_min || v > r->v_max) return 0;
+    int b = r->u_max + 1;
+    if (b <= W) {
+        start[0] = r->u_min;
+        end[0] = b;
+        return 1;
+    }
+    start[0] = r->u_min;
+    end[0] = W;
+    start[1] = 0;
+    end[1] = b - W;
+    return 2;
+}
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* 配列の容量を必要なら倍にする */
+static int ensure_capacity(void **array, int *capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) return 1;
+    int cap = (*capacity > 0) ? *capacity : 64;
+    while (cap < needed) cap *= 2;
+    void *p = realloc(*array, (size_t)cap * elem_size);
+    if (!p) return 0;
+    *array = p;
+    *capacity = cap;
+    return 1;
+}
+
+RegionSetContext* region_set_context_create(Image *base, Image *ref, const RegionSet *set) {
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return NULL;
+    }
+    int W = ref->width;
+    int H = ref->height;
+
+    RegionSetContext *ctx = (RegionSetContext*)calloc(1, sizeof(RegionSetContext));
+    if (!ctx) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    ctx->width = W;
+    ctx->height = H;
+    ctx->region_count = set->count;
+    ctx->regions = (Region*)malloc((size_t)set->count * sizeof(Region));
+    ctx->region_pixels = (int*)calloc((size_t)set->count, sizeof(int));
+    if (!ctx->regions || !ctx->region_pixels) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        region_set_context_free(ctx);
+        return NULL;
+    }
+
+    /* 領域を 0 <= u_min < W, u_min <= u_max < u_min + W にそろえる */
+    int v_lo = H, v_hi = -1;
+    for (int i = 0; i < set->count; i++) {
+        Region r = set->regions[i];
+        if (r.u_max < r.u_min) r.u_max += W;
+        int shift = (int)floor((double)r.u_min / W) * W;
+        r.u_min -= shift;
+        r.u_max -= shift;
+        int w = r.u_max - r.u_min + 1;
+        if (w > W || r.v_min < 0 || r.v_max >= H || r.v_max < r.v_min) {
+            fprintf(stderr, "エラー: %d 番目の比較領域が不正です (%d, %d) - (%d, %d)\n",
+                    i, set->regions[i].u_min, set->regions[i].v_min,
+                    set->regions[i].u_max, set->regions[i].v_max);
+            region_set_context_free(ctx);
+            return NULL;
+        }
+        ctx->regions[i] = r;
+        ctx->region_pixels[i] = w * (r.v_max - r.v_min + 1);
+        ctx->total_pixels += ctx->region_pixels[i];
+        if (r.v_min < v_lo) v_lo = r.v_min;
+        if (r.v_max > v_hi) v_hi = r.v_max;
+    }
+
+    /* 行ごとに区間の端を並べ、同じ領域の組に入る区間に分ける */
+    int seg_cap = 0, mem_cap = 0, row_cap = 0;
+    size_t base_size = 0;
+    int member_total = 0;
+    int bounds[4 * REGION_SET_MAX_REGIONS + 2];
+    int starts[REGION_SET_MAX_REGIONS][2], ends[REGION_SET_MAX_REGIONS][2];
+    int parts[REGION_SET_MAX_REGIONS];
+    for (int v = v_lo; v <= v_hi; v++) {
+        int nb = 0;
+        for (int i = 0; i < ctx->region_count; i++) {
+            parts[i] = region_row_intervals(&ctx->regions[i], v, W, starts[i], ends[i]);
+            for (int p = 0; p < parts[i]; p++) {
+                bounds[nb++] = starts[i][p];
+                bounds[nb++] = ends[i][p];
+            }
+        }
+        if (nb == 0) continue;
+        qsort(bounds, (size_t)nb, sizeof(int), compare_int);
+
+        if (!ensure_capacity((void**)&ctx->row_v, &row_cap, ctx->rows + 1, sizeof(int))) {
+            goto fail;
+        }
+        int row = ctx->rows++;
+        ctx->row_v[row] = v;
+
+        for (int b = 0; b + 1 < nb; b++) {
+            int a = bounds[b], e = bounds[b + 1];
+            if (a == e) continue;
+            int first_member = member_total;
+            for (int i = 0; i < ctx->region_count; i++) {
+                for (int p = 0; p < parts[i]; p++) {
+                    if (starts[i][p] <= a && e <= ends[i][p]) {
+                        if (!ensure_capacity((void**)&ctx->members, &mem_cap,
+                                             member_total + 1, sizeof(int))) {
+                            goto fail;
+                        }
+                        ctx->members[member_total++] = i;
+                    }
+                }
+            }
+            if (member_total == first_member) continue;
+
+            if (!ensure_capacity((void**)&ctx->segments, &seg_cap,
+                                 ctx->segment_count + 1, sizeof(RegionSegment))) {
+                goto fail;
+            }
+            RegionSegment *s = &ctx->segments[ctx->segment_count++];
+            s->row = row;
+            s->u0 = a;
+            s->length = e - a;
+            s->member_start = first_member;
+            s->member_count = member_total - first_member;
+            s->base_offset = base_size;
+            base_size += (size_t)s->length;
+        }
+    }
+    ctx->unique_pixels = (long)base_size;
+
+    /* 区間の基準画像の輝度と、使う行の参照画像（u 方向に周期的に延長） */
+    ctx->ext_width = 2 * W + 1;
+    ctx->base_gray = (double*)malloc((base_size > 0 ? base_size : 1) * sizeof(double));
+    ctx->ref_ext = (double*)malloc((size_t)(ctx->rows > 0 ? ctx->rows : 1) *
+                                   ctx->ext_width * sizeof(double));
+    if (!ctx->base_gray || !ctx->ref_ext) goto fail;
+
+    for (int k = 0; k < ctx->segment_count; k++) {
+        const RegionSegment *s = &ctx->segments[k];
+        int v = ctx->row_v[s->row];
+        for (int j = 0; j < s->length; j++) {
+            ctx->base_gray[s->base_offset + j] = pixel_gray(base, s->u0 + j, v);
+        }
+    }
+    for (int row = 0; row < ctx->rows; row++) {
+        double *ext = ctx->ref_ext + (size_t)row * ctx->ext_width;
+        for (int x = 0; x < W; x++) {
+            ext[x] = pixel_gray(ref, x, ctx->row_v[row]);
+        }
+        for (int x = W; x < ctx->ext_width; x++) {
+            ext[x] = ext[x - W];
+        }
+    }
+    return ctx;
+
+fail:
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    region_set_context_free(ctx);
+    return NULL;
+}
+
+void region_set_context_free(RegionSetContext *ctx) {
+    if (ctx) {
+        free(ctx->regions);
+        free(ctx->region_pixels);
+        free(ctx->row_v);
+        free(ctx->segments);
+        free(ctx->members);
+        free(ctx->base_gray);
+        free(ctx->ref_ext);
+        free(ctx);
+    }
+}
+
+void region_set_terms(const RegionSetContext *ctx, double psi_deg,
+                      ObjectiveTerms *per_region, ObjectiveTerms *combined) {
+    int W = ctx->width;
+    const double du_dtheta = (double)W / (2.0 * M_PI);
+
+    /* u 方向のずれ s = -ψ W/360 = k + f（k は整数、0 <= f < 1、0 <= k < W） */
+    int k;
+    double f;
+    yaw_shift_split(psi_deg, W, &k, &f);
+    k = wrap_u(k, W);
+
+    double sum_sq[REGION_SET_MAX_REGIONS] = {0};
+    double sum_grad[REGION_SET_MAX_REGIONS] = {0};
+    double sum_hess[REGION_SET_MAX_REGIONS] = {0};
+
+    for (int n = 0; n < ctx->segment_count; n++) {
+        const RegionSegment *s = &ctx->segments[n];
+        int x0 = s->u0 + k;
+        if (x0 >= W) x0 -= W;
+        const double *a = ctx->ref_ext + (size_t)s->row * ctx->ext_width + x0;
+        const double *b = ctx->base_gray + s->base_offset;
+
+        double sq = 0.0, grad = 0.0, hess = 0.0;
+        for (int j = 0; j < s->length; j++) {
+            double slope = a[j + 1] - a[j];
+            double diff = a[j] + f * slope - b[j];
+            /* dSr/dψ = -∂S/∂θ（compute_objective_terms_gray() と同じ） */
+            double J = -slope * du_dtheta;
+            sq += diff * diff;
+            grad += diff * J;
+            hess += J * J;
+        }
+
+        const int *m = ctx->members + s->member_start;
+        for (int i = 0; i < s->member_count; i++) {
+            sum_sq[m[i]] += sq;
+            sum_grad[m[i]] += grad;
+            sum_hess[m[i]] += hess;
+        }
+    }
+
+    double all_sq = 0.0, all_grad = 0.0, all_hess = 0.0;
+    for (int r = 0; r < ctx->region_count; r++) {
+        all_sq += sum_sq[r];
+        all_grad += sum_grad[r];
+        all_hess += sum_hess[r];
+        if (per_region) {
+            double n = (double)ctx->region_pixels[r];
+            per_region[r].E = sum_sq[r] / (2.0 * n);
+            per_region[r].gradient = sum_grad[r] / n;
+            per_region[r].hessian = sum_hess[r] / n;
+            per_region[r].count = ctx->region_pixels[r];
+        }
+    }
+    if (combined) {
+        double n = (double)ctx->total_pixels;
+        combined->E = all_sq / (2.0 * n);
+        combined->gradient = all_grad / n;
+        combined->hessian = all_hess / n;
+        combined->count = (int)ctx->total_pixels;
+    }
+}
+
+double region_set_objective(const RegionSetContext *ctx, double psi_deg) {
+    ObjectiveTerms t;
+    region_set_terms(ctx, psi_deg, NULL, &t);
+    return t.E;
+}
+
+void region_set_sweep(const RegionSetContext *ctx, const double *psis, int K,
+                      ObjectiveTerms *curves, ObjectiveTerms *combined) {
+    ObjectiveTerms per_region[REGION_SET_MAX_REGIONS];
+    for (int k = 0; k < K; k++) {
+        region_set_terms(ctx, psis[k], curves ? per_region : NULL,
+                         combined ? &combined[k] : NULL);
+        if (curves) {
+            for (int r = 0; r < ctx->region_count; r++) {
+                curves[(size_t)r * K + k] = per_region[r];
+            }
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/* remap.c
+ * 注視画像生成用のリマップテーブルの実装
+ */
+
+#include "remap.h"
+#include "coord_transform.h"
+#include "rotation.h"
+#include "vector_math.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* キー比較の許容誤差（度） */
+#define REMAP_KEY_EPS 1e-9
+
+/* ===========================
+ * テーブルの作成・適用
+ * =========================== */
+
+RemapTable* remap_table_create(int in_W, int in_H, int out_W, int out_H,
+                               double pitch_deg, double roll_deg) {
+    RemapTable *table = (RemapTable*)malloc(sizeof(RemapTable));
+    if (!table) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+
+    table->in_width = in_W;
+    table->in_height = in_H;
+    table->out_width = out_W;
+    table->out_height = out_H;
+    table->pitch_deg = pitch_deg;
+    table->roll_deg = roll_deg;
+
+    size_t n = (size_t)out_W * (size_t)out_H;
+    table->u = (float*)malloc(n * sizeof(float));
+    table->v = (float*)malloc(n * sizeof(float));
+    if (!table->u || !table->v) {
+        fprintf(stderr, "エラー: リマップテーブルのメモリ確保失敗\n");
+        remap_table_free(table);
+        return NULL;
+    }
+
+    /* ヨー0の逆変換: X = R_pr^T X' */
+    Matrix3x3 R_pr_T = matrix_transpose(create_pitch_roll_matrix(pitch_deg, roll_deg));
+
+    for (int v_out = 0; v_out < out_H; v_out++) {
+        for (int u_out = 0; u_out < out_W; u_out++) {
+            Vector3D X_prime = image_to_world(u_out, v_out, out_W, out_H);
+            Vector3D X = matrix_vector_multiply(R_pr_T, X_prime);
+
+            double u_in, v_in;
+            world_to_image(X, in_W, in_H, &u_in, &v_in);
+
+            size_t i = (size_t)v_out * out_W + u_out;
+            table->u[i] = (float)u_in;
+            table->v[i] = (float)v_in;
+        }
+    }
+
+    return table;
+}
+
+int remap_table_matches(const RemapTable *table,
+                        int in_W, int in_H, int out_W, int out_H,
+                        double pitch_deg, double roll_deg) {
+    return table
+        && table->in_width == in_W && table->in_height == in_H
+        && table->out_width == out_W && table->out_height == out_H
+        && fabs(table->pitch_deg - pitch_deg) < REMAP_KEY_EPS
+        && fabs(table->roll_deg - roll_deg) < REMAP_KEY_EPS;
+}
+
+void remap_table_apply(const RemapTable *table, Image *input,
+                       double yaw_deg, Image *output) {
+    int W = table->in_width;
+    int out_W = table->out_width;
+    int out_H = table->out_height;
+
+    /* ヨーは u 方向の平行移動: Δu = yaw * W/(2π) */
+    double shift = yaw_deg / 360.0 * (double)W;
+
+    for (int v_out = 0; v_out < out_H; v_out++) {
+        for (int u_out = 0; u_out < out_W; u_out++) {
+            size_t i = (size_t)v_out * out_W + u_out;
+
+            /* 周期境界: [0, W) に収める */
+            double u_in = (double)table->u[i] + shift;
+            u_in -= (double)W * floor(u_in / (double)W);
+
+            uint8_t rgb[3];
+            get_pixel_bilinear(input, u_in, (double)table->v[i], rgb);
+            set_pixel(output, u_out, v_out, rgb);
+        }
+    }
+}
+
+void remap_table_free(RemapTable *table) {
+    if (table) {
+        free(table->u);
+        free(table->v);
+        free(table);
+    }
+}
+
+
+/* ===========================
+ * キャッシュ
+ * =========================== */
+
+RemapCache* remap_cache_create(void) {
+    RemapCache *cache = (RemapCache*)calloc(1, sizeof(RemapCache));
+    if (!cache) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+    }
+    return cache;
+}
+
+RemapTable* remap_cache_get(RemapCache *cache,
+                            int in_W, int in_H, int out_W, int out_H,
+                            double pitch_deg, double roll_deg) {
+    for (int i = 0; i < REMAP_CACHE_SIZE; i++) {
+        if (remap_table_matches(cache->tables[i], in_W, in_H, out_W, out_H,
+                                pitch_deg, roll_deg)) {
+            cache->hits++;
+            return cache->tables[i];
+        }
+    }
+
+    RemapTable *table = remap_table_create(in_W, in_H, out_W, out_H,
+                                           pitch_deg, roll_deg);
+    if (!table) {
+        return NULL;
+    }
+    cache->misses++;
+
+    /* 古いものから順に置き換える */
+    remap_table_free(cache->tables[cache->next]);
+    cache->tables[cache->next] = table;
+    cache->next = (cache->next + 1) % REMAP_CACHE_SIZE;
+
+    return table;
+}
+
+void remap_cache_free(RemapCache *cache) {
+    if (cache) {
+        for (int i = 0; i < REMAP_CACHE_SIZE; i++) {
+            remap_table_free(cache->tables[i]);
+        }
+        free(cache);
+    }
+}
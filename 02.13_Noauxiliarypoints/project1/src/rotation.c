@@ -4,6 +4,7 @@
 
 #include "rotation.h"
 #include "vector_math.h"
+#include "y_rotation.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -11,6 +12,10 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+/* 度数法とラジアンの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+#define RAD_TO_DEG(rad) ((rad) * 180.0 / M_PI)
+
 /* ===========================
  * 回転行列の計算
  * =========================== */
@@ -97,6 +102,88 @@ Matrix3x3 compute_rotation_matrix(Vector3D G) {
 }
 
 
+/* ===========================
+ * 回転の分解
+ * =========================== */
+
+/* ピッチ・ロール回転行列を生成
+ * 
+ * R_pr = R(Z)(roll) × R(X)(pitch)
+ */
+Matrix3x3 create_pitch_roll_matrix(double pitch_deg, double roll_deg) {
+    double a = DEG_TO_RAD(pitch_deg);
+    double g = DEG_TO_RAD(roll_deg);
+
+    Matrix3x3 Rx = matrix_identity();
+    Rx.m[1][1] = cos(a);  Rx.m[1][2] = -sin(a);
+    Rx.m[2][1] = sin(a);  Rx.m[2][2] = cos(a);
+
+    Matrix3x3 Rz = matrix_identity();
+    Rz.m[0][0] = cos(g);  Rz.m[0][1] = -sin(g);
+    Rz.m[1][0] = sin(g);  Rz.m[1][1] = cos(g);
+
+    return matrix_multiply(Rz, Rx);
+}
+
+/* 回転行列をヨーとピッチ・ロールに分解
+ * 
+ * R = R_pr × R(Y)(yaw)  →  R_pr = R × R(Y)(yaw)^T
+ * 
+ * R_pr = R(Z)(γ) R(X)(α) の成分:
+ *   第3行 = (0, sin(α), cos(α))
+ *   第1列 = (cos(γ), sin(γ), 0)
+ */
+void rotation_decompose_yaw(Matrix3x3 R, double *yaw_deg,
+                            double *pitch_deg, double *roll_deg) {
+    /* 光軸 ez（第3行）の経度がヨー */
+    double yaw = atan2(R.m[2][0], R.m[2][2]);
+    *yaw_deg = RAD_TO_DEG(yaw);
+
+    Matrix3x3 R_yaw_T = matrix_transpose(create_y_rotation_matrix(*yaw_deg));
+    Matrix3x3 R_pr = matrix_multiply(R, R_yaw_T);
+
+    *pitch_deg = RAD_TO_DEG(atan2(R_pr.m[2][1], R_pr.m[2][2]));
+    *roll_deg = RAD_TO_DEG(atan2(R_pr.m[1][0], R_pr.m[0][0]));
+}
+
+
+/* ===========================
+ * 軸・角度表現
+ * =========================== */
+
+Matrix3x3 create_axis_angle_matrix(Vector3D omega) {
+    double angle = vector_norm(omega);
+    double a, b;
+    if (angle < 1e-8) {
+        /* テイラー展開の先頭項 */
+        a = 1.0 - angle * angle / 6.0;
+        b = 0.5 - angle * angle / 24.0;
+    } else {
+        a = sin(angle) / angle;
+        b = (1.0 - cos(angle)) / (angle * angle);
+    }
+
+    /* K = [ω]× */
+    double K[3][3] = {
+        {0.0, -omega.z, omega.y},
+        {omega.z, 0.0, -omega.x},
+        {-omega.y, omega.x, 0.0}
+    };
+
+    Matrix3x3 R;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            double K2 = 0.0;
+            for (int k = 0; k < 3; k++) {
+                K2 += K[i][k] * K[k][j];
+            }
+            R.m[i][j] = (i == j ? 1.0 : 0.0) + a * K[i][j] + b * K2;
+        }
+    }
+    return R;
+}
+
+
 /* ===========================
  * 検証・デバッグ用
  * =========================== */
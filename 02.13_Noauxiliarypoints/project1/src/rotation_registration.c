@@ -0,0 +1,423 @@
+/* rotation_registration.c
+ * 3自由度の回転の位置合わせの実装
+ */
+
+#include "rotation_registration.h"
+#include "coord_transform.h"
+#include "rotation.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法とラジアンの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+#define RAD_TO_DEG(rad) ((rad) * 180.0 / M_PI)
+
+/* 粗いレベルで間引いた後に残す標本点の最少数 */
+#define SAMPLES_MIN_COUNT 1024
+
+/* 目的関数とその微分（ω について） */
+typedef struct {
+    double E;
+    double g[3];
+    double H[3][3];
+    int count;
+} RotationTerms;
+
+
+RegistrationOptions registration_default_options(void) {
+    RegistrationOptions opt;
+    opt.levels = 4;
+    opt.max_iterations = 20;
+    opt.tolerance_deg = 1e-3;
+    opt.lambda_init = 1e-3;
+    opt.lambda_max = 1e6;
+    return opt;
+}
+
+double rotation_objective(const GrayImage *base, const GrayImage *ref,
+                          Region region, Matrix3x3 R) {
+    int W = base->width;
+    int H = base->height;
+    double sum = 0.0;
+    int count = 0;
+
+    for (int v = region.v_min; v <= region.v_max; v++) {
+        for (int u = region.u_min; u <= region.u_max; u++) {
+            Vector3D X_prime = matrix_vector_multiply(R, image_to_world(u, v, W, H));
+            double u_ref, v_ref;
+            world_to_image(X_prime, W, H, &u_ref, &v_ref);
+
+            double diff = gray_get_bilinear(ref, u_ref, v_ref) - gray_get(base, u, v);
+            sum += diff * diff;
+            count++;
+        }
+    }
+    return (count > 0) ? sum / (2.0 * count) : 0.0;
+}
+
+/* 1点の寄与を加算（X' = R X と基準画像の輝度 Sb） */
+static void accumulate_point(const GrayImage *ref, Vector3D X_prime, double Sb,
+                             RotationTerms *t) {
+    int W = ref->width;
+    int H = ref->height;
+    const double du_dtheta = (double)W / (2.0 * M_PI);
+    const double dv_dphi = -(double)H / M_PI;
+
+    double u_ref, v_ref;
+    world_to_image(X_prime, W, H, &u_ref, &v_ref);
+
+    /* 差と ∂S/∂θ, ∂S/∂φ（同じ4画素の補間面の微分を角度に換算） */
+    double dS_du, dS_dv;
+    double diff = gray_get_bilinear_gradient(ref, u_ref, v_ref, &dS_du, &dS_dv) - Sb;
+    double dS_dtheta = dS_du * du_dtheta;
+    double dS_dphi = dS_dv * dv_dphi;
+
+    /* ∂θ/∂X', ∂φ/∂X'（球面の接平面上の勾配） */
+    double theta, phi;
+    world_to_angle(X_prime, &theta, &phi);
+    double sin_phi = sin(phi), cos_phi = cos(phi);
+    double sin_th = sin(theta), cos_th = cos(theta);
+    if (fabs(sin_phi) < 1e-8) {
+        sin_phi = (sin_phi >= 0 ? 1e-8 : -1e-8);
+    }
+
+    Vector3D grad;
+    grad.x = dS_dtheta * cos_th / sin_phi + dS_dphi * cos_phi * sin_th;
+    grad.y = dS_dphi * (-sin_phi);
+    grad.z = -dS_dtheta * sin_th / sin_phi + dS_dphi * cos_phi * cos_th;
+
+    /* J = X' × ∇S */
+    Vector3D J = vector_cross(X_prime, grad);
+    double Jv[3] = {J.x, J.y, J.z};
+
+    t->E += diff * diff;
+    for (int i = 0; i < 3; i++) {
+        t->g[i] += diff * Jv[i];
+        for (int j = i; j < 3; j++) {
+            t->H[i][j] += Jv[i] * Jv[j];
+        }
+    }
+    t->count++;
+}
+
+/* 点の数で割り、H の下三角を埋める */
+static void finish_terms(RotationTerms *t) {
+    if (t->count == 0) return;
+    double inv_n = 1.0 / t->count;
+    t->E *= 0.5 * inv_n;
+    for (int i = 0; i < 3; i++) {
+        t->g[i] *= inv_n;
+        for (int j = i; j < 3; j++) {
+            t->H[i][j] *= inv_n;
+            t->H[j][i] = t->H[i][j];
+        }
+    }
+}
+
+/* E, g, H を1回の走査で計算（比較領域の画素） */
+static void rotation_terms(const GrayImage *base, const GrayImage *ref,
+                           Region region, Matrix3x3 R, RotationTerms *t) {
+    int W = base->width;
+    int H = base->height;
+
+    memset(t, 0, sizeof(*t));
+    for (int v = region.v_min; v <= region.v_max; v++) {
+        for (int u = region.u_min; u <= region.u_max; u++) {
+            Vector3D X_prime = matrix_vector_multiply(R, image_to_world(u, v, W, H));
+            accumulate_point(ref, X_prime, gray_get(base, u, v), t);
+        }
+    }
+    finish_terms(t);
+}
+
+/* E, g, H を1回の走査で計算（球面上の標本点） */
+static void sample_terms(const SphereSamples *samples, const GrayImage *ref,
+                         Matrix3x3 R, RotationTerms *t) {
+    memset(t, 0, sizeof(*t));
+    for (int k = 0; k < samples->count; k++) {
+        Vector3D X_prime = matrix_vector_multiply(R, samples->X[k]);
+        accumulate_point(ref, X_prime, samples->Sb[k], t);
+    }
+    finish_terms(t);
+}
+
+/* ガウス・ニュートン法で評価する点の集合（比較領域の画素か標本点） */
+typedef struct {
+    const GrayImage *base;
+    const GrayImage *ref;
+    Region region;
+    const SphereSamples *samples;   /* NULL なら比較領域の画素 */
+} TermsSource;
+
+static void source_terms(const TermsSource *src, Matrix3x3 R, RotationTerms *t) {
+    if (src->samples) {
+        sample_terms(src->samples, src->ref, R, t);
+    } else {
+        rotation_terms(src->base, src->ref, src->region, R, t);
+    }
+}
+
+/* 3×3 の連立一次方程式 A x = b（部分ピボット付きガウス消去）
+ *
+ * 戻り値:
+ *   1: 成功, 0: 特異
+ */
+static int solve3(double A[3][3], const double b[3], double x[3]) {
+    double M[3][4];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) M[i][j] = A[i][j];
+        M[i][3] = b[i];
+    }
+
+    for (int c = 0; c < 3; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 3; r++) {
+            if (fabs(M[r][c]) > fabs(M[pivot][c])) pivot = r;
+        }
+        if (fabs(M[pivot][c]) < 1e-300) return 0;
+        if (pivot != c) {
+            for (int j = 0; j < 4; j++) {
+                double tmp = M[c][j];
+                M[c][j] = M[pivot][j];
+                M[pivot][j] = tmp;
+            }
+        }
+        for (int r = c + 1; r < 3; r++) {
+            double f = M[r][c] / M[c][c];
+            for (int j = c; j < 4; j++) M[r][j] -= f * M[c][j];
+        }
+    }
+
+    for (int i = 2; i >= 0; i--) {
+        double s = M[i][3];
+        for (int j = i + 1; j < 3; j++) s -= M[i][j] * x[j];
+        x[i] = s / M[i][i];
+    }
+    return 1;
+}
+
+/* 1つのレベルでのガウス・ニュートン法（レーベンバーグ・マーカート型の減衰付き）
+ *
+ * 戻り値:
+ *   1: 収束, 0: 反復上限または打ち切り
+ */
+static int gauss_newton_level(const TermsSource *src, const RegistrationOptions *opt,
+                              Matrix3x3 *R, RotationTerms *cur,
+                              int *iterations, int *passes) {
+    double lambda = opt->lambda_init;
+    double tol = DEG_TO_RAD(opt->tolerance_deg);
+
+    source_terms(src, *R, cur);
+    (*passes)++;
+    if (cur->count == 0) return 0;
+
+    for (int iter = 0; iter < opt->max_iterations; iter++) {
+        double A[3][3];
+        double rhs[3];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) A[i][j] = cur->H[i][j];
+            A[i][i] *= 1.0 + lambda;
+            rhs[i] = -cur->g[i];
+        }
+        double w[3];
+        if (!solve3(A, rhs, w)) return 0;
+
+        Vector3D omega = {w[0], w[1], w[2]};
+        double step = vector_norm(omega);
+        Matrix3x3 R_trial = matrix_multiply(create_axis_angle_matrix(omega), *R);
+
+        RotationTerms trial;
+        source_terms(src, R_trial, &trial);
+        (*passes)++;
+        (*iterations)++;
+
+        if (trial.E <= cur->E) {
+            *R = R_trial;
+            *cur = trial;
+            lambda *= 0.1;
+            if (step < tol) return 1;
+        } else {
+            /* 更新量が十分小さいのに減らない = 最小点の近く */
+            if (step < tol) return 1;
+            lambda *= 10.0;
+            if (lambda > opt->lambda_max) return 0;
+        }
+    }
+    return 0;
+}
+
+int register_rotation(GrayImage *base, GrayImage *ref, Region region,
+                      Matrix3x3 R_init, const RegistrationOptions *options,
+                      RegistrationResult *result) {
+    RegistrationOptions opt = options ? *options : registration_default_options();
+    memset(result, 0, sizeof(*result));
+
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return 0;
+    }
+
+    GrayPyramid pb, pr;
+    if (!gray_pyramid_build(base, opt.levels, &pb)) {
+        return 0;
+    }
+    if (!gray_pyramid_build(ref, opt.levels, &pr)) {
+        gray_pyramid_free(&pb);
+        return 0;
+    }
+    int levels = (pb.levels < pr.levels) ? pb.levels : pr.levels;
+
+    Matrix3x3 R = R_init;
+    RotationTerms terms;
+    int converged = 0;
+    for (int l = levels - 1; l >= 0; l--) {
+        clock_t start = clock();
+        int iters = 0;
+        TermsSource src = {pb.level[l], pr.level[l], region_at_level(region, l), NULL};
+        converged = gauss_newton_level(&src, &opt, &R, &terms, &iters, &result->passes);
+        result->level_iterations[l] = iters;
+        result->level_seconds[l] = (double)(clock() - start) / CLOCKS_PER_SEC;
+        result->iterations += iters;
+    }
+
+    gray_pyramid_free(&pb);
+    gray_pyramid_free(&pr);
+
+    result->R = R;
+    result->E = terms.E;
+    result->converged = converged;
+    result->levels = levels;
+    rotation_decompose_yaw(R, &result->yaw_deg, &result->pitch_deg, &result->roll_deg);
+    return 1;
+}
+
+double rotation_objective_samples(const SphereSamples *samples, const GrayImage *ref,
+                                  Matrix3x3 R) {
+    int W = ref->width;
+    int H = ref->height;
+    double sum = 0.0;
+
+    for (int k = 0; k < samples->count; k++) {
+        Vector3D X_prime = matrix_vector_multiply(R, samples->X[k]);
+        double u_ref, v_ref;
+        world_to_image(X_prime, W, H, &u_ref, &v_ref);
+
+        double diff = gray_get_bilinear(ref, u_ref, v_ref) - samples->Sb[k];
+        sum += diff * diff;
+    }
+    return (samples->count > 0) ? sum / (2.0 * samples->count) : 0.0;
+}
+
+int register_rotation_samples(GrayImage *base, GrayImage *ref, const SpherePoints *points,
+                              Matrix3x3 R_init, const RegistrationOptions *options,
+                              RegistrationResult *result) {
+    RegistrationOptions opt = options ? *options : registration_default_options();
+    memset(result, 0, sizeof(*result));
+
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return 0;
+    }
+    if (!points || points->count == 0) {
+        fprintf(stderr, "エラー: 標本点がありません\n");
+        return 0;
+    }
+
+    GrayPyramid pb, pr;
+    if (!gray_pyramid_build(base, opt.levels, &pb)) {
+        return 0;
+    }
+    if (!gray_pyramid_build(ref, opt.levels, &pr)) {
+        gray_pyramid_free(&pb);
+        return 0;
+    }
+    int levels = (pb.levels < pr.levels) ? pb.levels : pr.levels;
+
+    Matrix3x3 R = R_init;
+    RotationTerms terms;
+    memset(&terms, 0, sizeof(terms));
+    int converged = 0;
+    int ok = 1;
+    for (int l = levels - 1; l >= 0; l--) {
+        clock_t start = clock();
+
+        /* レベル l では画素数が 1/4^l なので点も 4^l 個に1つ
+         * （少なくとも SAMPLES_MIN_COUNT 点は残す） */
+        int stride = 1 << (2 * l);
+        while (stride > 1 && points->count / stride < SAMPLES_MIN_COUNT) stride >>= 1;
+        SphereSamples *samples = sphere_samples_create(pb.level[l], points, stride);
+        if (!samples) {
+            ok = 0;
+            break;
+        }
+
+        int iters = 0;
+        TermsSource src = {pb.level[l], pr.level[l], {0, 0, 0, 0}, samples};
+        converged = gauss_newton_level(&src, &opt, &R, &terms, &iters, &result->passes);
+        sphere_samples_free(samples);
+
+        result->level_iterations[l] = iters;
+        result->level_seconds[l] = (double)(clock() - start) / CLOCKS_PER_SEC;
+        result->iterations += iters;
+    }
+
+    gray_pyramid_free(&pb);
+    gray_pyramid_free(&pr);
+    if (!ok) return 0;
+
+    result->R = R;
+    result->E = terms.E;
+    result->converged = converged;
+    result->levels = levels;
+    rotation_decompose_yaw(R, &result->yaw_deg, &result->pitch_deg, &result->roll_deg);
+    return 1;
+}
+
+int register_rotation_grid(const GrayImage *base, const GrayImage *ref,
+                           Region region, double yaw0_deg, double pitch0_deg,
+                           double roll0_deg, double half_range_deg,
+                           double step_deg, RegistrationResult *result) {
+    memset(result, 0, sizeof(*result));
+    if (step_deg <= 0.0) {
+        fprintf(stderr, "エラー: 格子の刻みが不正です\n");
+        return 0;
+    }
+
+    clock_t start = clock();
+    int n = (int)floor(2.0 * half_range_deg / step_deg + 1e-9) + 1;
+    double best_E = -1.0;
+
+    for (int i = 0; i < n; i++) {
+        double yaw = yaw0_deg - half_range_deg + i * step_deg;
+        Matrix3x3 R_yaw = create_y_rotation_matrix(yaw);
+        for (int j = 0; j < n; j++) {
+            double pitch = pitch0_deg - half_range_deg + j * step_deg;
+            for (int k = 0; k < n; k++) {
+                double roll = roll0_deg - half_range_deg + k * step_deg;
+                Matrix3x3 R = matrix_multiply(create_pitch_roll_matrix(pitch, roll), R_yaw);
+                double E = rotation_objective(base, ref, region, R);
+                result->passes++;
+                if (best_E < 0.0 || E < best_E) {
+                    best_E = E;
+                    result->R = R;
+                    result->yaw_deg = yaw;
+                    result->pitch_deg = pitch;
+                    result->roll_deg = roll;
+                }
+            }
+        }
+    }
+
+    result->E = best_E;
+    result->iterations = result->passes;
+    result->levels = 1;
+    result->level_iterations[0] = result->passes;
+    result->level_seconds[0] = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return 1;
+}
@@ -0,0 +1,170 @@
+/* sphere_sampling.c
+ * 球面上の等面積の標本点の実装
+ */
+
+#include "sphere_sampling.h"
+#include "coord_transform.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 度数法とラジアンの変換 */
+#define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
+
+/* 点の集合の確保 */
+static SpherePoints* sphere_points_alloc(int n) {
+    SpherePoints *points = (SpherePoints*)calloc(1, sizeof(SpherePoints));
+    if (!points) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    points->count = n;
+    points->X = (Vector3D*)malloc((size_t)(n > 0 ? n : 1) * sizeof(Vector3D));
+    points->area = (double*)malloc((size_t)(n > 0 ? n : 1) * sizeof(double));
+    if (!points->X || !points->area) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        sphere_points_free(points);
+        return NULL;
+    }
+    return points;
+}
+
+/* 球冠の中心 c と直交する単位ベクトル e1, e2（e1 × e2 = c） */
+static void cap_frame(Vector3D c, Vector3D *e1, Vector3D *e2) {
+    /* c と平行に近くない座標軸から作る */
+    Vector3D a = (fabs(c.y) < 0.9) ? vector_create(0.0, 1.0, 0.0)
+                                   : vector_create(1.0, 0.0, 0.0);
+    *e1 = vector_normalize(vector_cross(a, c));
+    *e2 = vector_cross(c, *e1);
+}
+
+double sphere_cap_solid_angle(double cap_radius_deg) {
+    if (cap_radius_deg >= 180.0) return 4.0 * M_PI;
+    return 2.0 * M_PI * (1.0 - cos(DEG_TO_RAD(cap_radius_deg)));
+}
+
+int sphere_cap_equator_density_count(double cap_radius_deg, int W, int H) {
+    double pixel = (2.0 * M_PI / W) * (M_PI / H);
+    return (int)ceil(sphere_cap_solid_angle(cap_radius_deg) / pixel);
+}
+
+SpherePoints* sphere_points_fibonacci(int n, Vector3D center, double cap_radius_deg) {
+    if (n <= 0 || cap_radius_deg <= 0.0 || vector_norm(center) == 0.0) {
+        fprintf(stderr, "エラー: 標本点の設定が不正です（%d 点, 角半径 %.3f°）\n",
+                n, cap_radius_deg);
+        return NULL;
+    }
+    SpherePoints *points = sphere_points_alloc(n);
+    if (!points) return NULL;
+
+    Vector3D c = vector_normalize(center);
+    Vector3D e1, e2;
+    cap_frame(c, &e1, &e2);
+
+    double h = 1.0 - ((cap_radius_deg >= 180.0) ? -1.0 : cos(DEG_TO_RAD(cap_radius_deg)));
+    double golden = M_PI * (3.0 - sqrt(5.0));
+    double area = 2.0 * M_PI * h / n;
+
+    for (int i = 0; i < n; i++) {
+        double z = 1.0 - h * (i + 0.5) / n;
+        double r = sqrt(fmax(0.0, 1.0 - z * z));
+        double a = golden * i;
+        double ca = r * cos(a), sa = r * sin(a);
+        points->X[i].x = z * c.x + ca * e1.x + sa * e2.x;
+        points->X[i].y = z * c.y + ca * e1.y + sa * e2.y;
+        points->X[i].z = z * c.z + ca * e1.z + sa * e2.z;
+        points->area[i] = area;
+    }
+    return points;
+}
+
+SpherePoints* sphere_points_equirect(int W, int H, Vector3D center, double cap_radius_deg) {
+    if (W <= 0 || H <= 0 || cap_radius_deg <= 0.0 || vector_norm(center) == 0.0) {
+        fprintf(stderr, "エラー: 標本点の設定が不正です（%d × %d, 角半径 %.3f°）\n",
+                W, H, cap_radius_deg);
+        return NULL;
+    }
+    Vector3D c = vector_normalize(center);
+    double cos_alpha = (cap_radius_deg >= 180.0) ? -2.0 : cos(DEG_TO_RAD(cap_radius_deg));
+    double pixel = (2.0 * M_PI / W) * (M_PI / H);
+
+    /* 1回目で数え、2回目で詰める */
+    int n = 0;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            if (vector_dot(image_to_world(u, v, W, H), c) >= cos_alpha) n++;
+        }
+    }
+    SpherePoints *points = sphere_points_alloc(n);
+    if (!points) return NULL;
+
+    int k = 0;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            Vector3D X = image_to_world(u, v, W, H);
+            if (vector_dot(X, c) < cos_alpha) continue;
+            points->X[k] = X;
+            points->area[k] = pixel * sqrt(X.x * X.x + X.z * X.z);
+            k++;
+        }
+    }
+    return points;
+}
+
+void sphere_points_free(SpherePoints *points) {
+    if (points) {
+        free(points->X);
+        free(points->area);
+        free(points);
+    }
+}
+
+double sphere_points_effective_count(const SpherePoints *points) {
+    double sum = 0.0, sum2 = 0.0;
+    for (int i = 0; i < points->count; i++) {
+        sum += points->area[i];
+        sum2 += points->area[i] * points->area[i];
+    }
+    return (sum2 > 0.0) ? sum * sum / sum2 : 0.0;
+}
+
+SphereSamples* sphere_samples_create(const GrayImage *base, const SpherePoints *points,
+                                     int stride) {
+    if (stride < 1) stride = 1;
+    int n = (points->count + stride - 1) / stride;
+
+    SphereSamples *samples = (SphereSamples*)calloc(1, sizeof(SphereSamples));
+    if (!samples) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    samples->count = n;
+    samples->X = (Vector3D*)malloc((size_t)(n > 0 ? n : 1) * sizeof(Vector3D));
+    samples->Sb = (double*)malloc((size_t)(n > 0 ? n : 1) * sizeof(double));
+    if (!samples->X || !samples->Sb) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        sphere_samples_free(samples);
+        return NULL;
+    }
+
+    for (int k = 0; k < n; k++) {
+        Vector3D X = points->X[(size_t)k * stride];
+        double u, v;
+        world_to_image(X, base->width, base->height, &u, &v);
+        samples->X[k] = X;
+        samples->Sb[k] = gray_get_bilinear(base, u, v);
+    }
+    return samples;
+}
+
+void sphere_samples_free(SphereSamples *samples) {
+    if (samples) {
+        free(samples->X);
+        free(samples->Sb);
+        free(samples);
+    }
+}
@@ -0,0 +1,280 @@
+/* sweep.c
+ * 角度の掃引の並列実行の実装
+ */
+
+#include "sweep.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* スレッドで共有する作業の情報 */
+typedef struct {
+    const RegionContext *ctx;
+    Image *ref;
+    const double *psis;
+    int nblocks;            /* 1つの角度の行ブロック数 */
+    int split_rows;
+    int items;              /* 作業の総数 */
+    int next;               /* 次に取り出す作業 */
+    pthread_mutex_t lock;
+    ObjectiveTerms *partial;    /* [角度][行ブロック] の部分和 */
+} SweepJob;
+
+/* 最小値だけの探索で共有する情報 */
+typedef struct {
+    Image *base;
+    Image *ref;
+    Region region;
+    const double *psis;
+    const int *order;           /* 角度を調べる順序 */
+    const int *row_order;       /* 行を足す順序 */
+    int n;
+    int next;                   /* 次に取り出す order の位置 */
+    pthread_mutex_t lock;
+    SweepMinimum best;          /* ここまでの最小値（lock で保護） */
+} ArgminJob;
+
+
+SweepOptions sweep_default_options(void) {
+    SweepOptions opt;
+    opt.threads = 0;
+    opt.split_rows = 0;
+    return opt;
+}
+
+int sweep_thread_count(const SweepOptions *options) {
+    if (options && options->threads > 0) {
+        return options->threads;
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+/* 1つの角度の1つの行ブロックの値 */
+static void compute_block(const SweepJob *job, int angle, int block) {
+    int row0 = block * SWEEP_ROW_BLOCK;
+    int row1 = row0 + SWEEP_ROW_BLOCK - 1;
+
+    compute_objective_terms_ctx_rows(job->ctx, job->ref, job->psis[angle], row0, row1,
+                                     &job->partial[(size_t)angle * job->nblocks + block]);
+}
+
+/* 作業を1つずつ取り出して計算 */
+static void* sweep_worker(void *arg) {
+    SweepJob *job = (SweepJob*)arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int item = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (item >= job->items) break;
+
+        if (job->split_rows) {
+            compute_block(job, item / job->nblocks, item % job->nblocks);
+        } else {
+            for (int b = 0; b < job->nblocks; b++) {
+                compute_block(job, item, b);
+            }
+        }
+    }
+    return NULL;
+}
+
+/* スレッドを起動して worker を実行（作れなかった分は呼び出し元で実行） */
+static void run_workers(void *(*worker)(void*), void *job, int threads) {
+    if (threads <= 1) {
+        worker(job);
+        return;
+    }
+    pthread_t *tids = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    int started = 0;
+    if (tids) {
+        for (; started < threads; started++) {
+            if (pthread_create(&tids[started], NULL, worker, job) != 0) {
+                break;
+            }
+        }
+    }
+    if (started < threads) {
+        worker(job);
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    free(tids);
+}
+
+/* 行ブロックの部分和を上の行から順に足す */
+static void reduce_blocks(const ObjectiveTerms *partial, int nblocks,
+                          ObjectiveTerms *terms) {
+    double sum_sq = 0.0;
+    double sum_grad = 0.0;
+    double sum_hess = 0.0;
+    int count = 0;
+    for (int b = 0; b < nblocks; b++) {
+        const ObjectiveTerms *p = &partial[b];
+        sum_sq += 2.0 * p->E * p->count;
+        sum_grad += p->gradient * p->count;
+        sum_hess += p->hessian * p->count;
+        count += p->count;
+    }
+
+    terms->count = count;
+    if (count == 0) {
+        terms->E = terms->gradient = terms->hessian = 0.0;
+        return;
+    }
+    terms->E = sum_sq / (2.0 * count);
+    terms->gradient = sum_grad / (double)count;
+    terms->hessian = sum_hess / (double)count;
+}
+
+int sweep_objective_terms(Image *base, Image *ref, Region region,
+                          const double *psis, int n, const SweepOptions *options,
+                          ObjectiveTerms *terms) {
+    if (n <= 0) return 1;
+    if (region.v_max < region.v_min || region.u_max < region.u_min) {
+        fprintf(stderr, "エラー: 比較領域が不正です\n");
+        return 0;
+    }
+
+    RegionContext *ctx = region_context_create(base, region);
+    if (!ctx) {
+        return 0;
+    }
+    int ok = sweep_objective_terms_ctx(ctx, ref, psis, n, options, terms);
+    region_context_free(ctx);
+    return ok;
+}
+
+int sweep_objective_terms_ctx(const RegionContext *ctx, Image *ref,
+                              const double *psis, int n, const SweepOptions *options,
+                              ObjectiveTerms *terms) {
+    SweepOptions opt = options ? *options : sweep_default_options();
+    if (n <= 0) return 1;
+
+    SweepJob job;
+    job.ctx = ctx;
+    job.ref = ref;
+    job.psis = psis;
+    job.nblocks = (ctx->rows - 1) / SWEEP_ROW_BLOCK + 1;
+    job.split_rows = opt.split_rows;
+    job.items = opt.split_rows ? n * job.nblocks : n;
+    job.next = 0;
+    job.partial = (ObjectiveTerms*)malloc((size_t)n * job.nblocks * sizeof(ObjectiveTerms));
+    if (!job.partial) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 0;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+
+    int threads = sweep_thread_count(&opt);
+    if (threads > job.items) threads = job.items;
+    run_workers(sweep_worker, &job, threads);
+    pthread_mutex_destroy(&job.lock);
+
+    for (int i = 0; i < n; i++) {
+        reduce_blocks(&job.partial[(size_t)i * job.nblocks], job.nblocks, &terms[i]);
+    }
+    free(job.partial);
+    return 1;
+}
+
+/* 角度を1つずつ取り出し、その時点の最小値を上限に計算 */
+static void* argmin_worker(void *arg) {
+    ArgminJob *job = (ArgminJob*)arg;
+    const Region *r = &job->region;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int pos = job->next++;
+        double bound = (job->best.index >= 0) ? job->best.E : HUGE_VAL;
+        pthread_mutex_unlock(&job->lock);
+        if (pos >= job->n) break;
+
+        int i = job->order[pos];
+        int rows_done = 0;
+        double E = compute_objective_function_yaw_bounded(
+            job->base, job->ref, job->psis[i], r->u_min, r->v_min, r->u_max,
+            r->v_max, job->row_order, bound, &rows_done);
+        int complete = (rows_done == r->v_max - r->v_min + 1);
+
+        pthread_mutex_lock(&job->lock);
+        job->best.rows += rows_done;
+        if (complete) {
+            job->best.completed++;
+            if (job->best.index < 0 || E < job->best.E ||
+                (E == job->best.E && i < job->best.index)) {
+                job->best.index = i;
+                job->best.E = E;
+            }
+        } else {
+            job->best.pruned++;
+        }
+        pthread_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+int sweep_objective_argmin(Image *base, Image *ref, Region region,
+                           const double *psis, int n, const SweepOptions *options,
+                           SweepMinimum *minimum) {
+    SweepOptions opt = options ? *options : sweep_default_options();
+    minimum->index = -1;
+    minimum->E = 0.0;
+    minimum->completed = minimum->pruned = 0;
+    minimum->rows = 0;
+    if (n <= 0) return 1;
+    if (region.v_max < region.v_min || region.u_max < region.u_min) {
+        fprintf(stderr, "エラー: 比較領域が不正です\n");
+        return 0;
+    }
+
+    int *row_order = objective_row_order(base, region.u_min, region.v_min,
+                                         region.u_max, region.v_max);
+    int *order = (int*)malloc((size_t)n * sizeof(int));
+    char *visited = (char*)calloc((size_t)n, 1);
+    if (!row_order || !order || !visited) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(row_order);
+        free(order);
+        free(visited);
+        return 0;
+    }
+
+    /* 間隔 stride, stride/2, ..., 1 の順に未調査の角度を並べる */
+    int stride = 1;
+    while (stride * 2 <= n) stride *= 2;
+    int m = 0;
+    for (; stride >= 1; stride /= 2) {
+        for (int i = 0; i < n; i += stride) {
+            if (!visited[i]) {
+                visited[i] = 1;
+                order[m++] = i;
+            }
+        }
+    }
+    free(visited);
+
+    ArgminJob job;
+    job.base = base;
+    job.ref = ref;
+    job.region = region;
+    job.psis = psis;
+    job.order = order;
+    job.row_order = row_order;
+    job.n = n;
+    job.next = 0;
+    job.best = *minimum;
+    pthread_mutex_init(&job.lock, NULL);
+
+    int threads = sweep_thread_count(&opt);
+    if (threads > n) threads = n;
+    run_workers(argmin_worker, &job, threads);
+    pthread_mutex_destroy(&job.lock);
+
+    *minimum = job.best;
+    free(order);
+    free(row_order);
+    return 1;
+}
@@ -0,0 +1,453 @@
+/* tracking.c
+ * 全方位動画のフレーム列の回転の追跡の実装
+ */
+
+#include "tracking.h"
+#include "rotation.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* リストの1行の最大長 */
+#define LIST_LINE_MAX 4096
+
+/* 経過時間（秒、スレッドごとではなく実時間） */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ===========================
+ * フレームの入力
+ * =========================== */
+
+static FrameSource* frame_source_alloc(FrameSourceType type, FILE *fp, int close_fp) {
+    FrameSource *source = (FrameSource*)calloc(1, sizeof(FrameSource));
+    if (!source) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        if (close_fp) fclose(fp);
+        return NULL;
+    }
+    source->type = type;
+    source->fp = fp;
+    source->close_fp = close_fp;
+    return source;
+}
+
+FrameSource* frame_source_open_list(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        fprintf(stderr, "エラー: フレームのリストが開けません: %s\n", filename);
+        return NULL;
+    }
+    return frame_source_alloc(FRAME_SOURCE_LIST, fp, 1);
+}
+
+FrameSource* frame_source_open_raw(const char *filename, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "エラー: フレームのサイズが不正です（%d × %d）\n", width, height);
+        return NULL;
+    }
+    int use_stdin = (strcmp(filename, "-") == 0);
+    FILE *fp = use_stdin ? stdin : fopen(filename, "rb");
+    if (!fp) {
+        fprintf(stderr, "エラー: フレームのファイルが開けません: %s\n", filename);
+        return NULL;
+    }
+    FrameSource *source = frame_source_alloc(FRAME_SOURCE_RAW, fp, !use_stdin);
+    if (source) {
+        source->width = width;
+        source->height = height;
+    }
+    return source;
+}
+
+/* リストの次のパス（コメントと前後の空白を除く）、なければ 0 */
+static int next_list_path(FILE *fp, char *path) {
+    char line[LIST_LINE_MAX];
+    while (fgets(line, sizeof(line), fp)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        char *end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t')) {
+            end--;
+        }
+        *end = '\0';
+        if (*start) {
+            memmove(path, start, (size_t)(end - start) + 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+Image* frame_source_next(FrameSource *source) {
+    Image *frame = NULL;
+    if (source->error) return NULL;
+    if (source->type == FRAME_SOURCE_LIST) {
+        char path[LIST_LINE_MAX];
+        if (!next_list_path(source->fp, path)) return NULL;
+        frame = image_load(path);
+        if (!frame) {
+            fprintf(stderr, "エラー: フレーム %d が読めません: %s\n", source->frames, path);
+            source->error = 1;
+            return NULL;
+        }
+    } else {
+        frame = image_create(source->width, source->height, 3);
+        if (!frame) {
+            source->error = 1;
+            return NULL;
+        }
+        size_t bytes = (size_t)source->width * source->height * 3;
+        size_t got = fread(frame->data, 1, bytes, source->fp);
+        if (got != bytes) {
+            if (got > 0) {
+                fprintf(stderr, "エラー: フレーム %d が途中で終わっています（%zu / %zu バイト）\n",
+                        source->frames, got, bytes);
+                source->error = 1;
+            } else if (ferror(source->fp)) {
+                fprintf(stderr, "エラー: フレーム %d の読み込みに失敗しました\n", source->frames);
+                source->error = 1;
+            }
+            image_free(frame);
+            return NULL;
+        }
+    }
+    source->frames++;
+    return frame;
+}
+
+void frame_source_close(FrameSource *source) {
+    if (source) {
+        if (source->close_fp) fclose(source->fp);
+        free(source);
+    }
+}
+
+/* ===========================
+ * フレームの先読み
+ * =========================== */
+
+/* デコード用のスレッド: 待ち行列に空きがある間は次のフレームを読む */
+static void* pipeline_worker(void *arg) {
+    FramePipeline *p = (FramePipeline*)arg;
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->size == p->depth && !p->stop) {
+            pthread_cond_wait(&p->not_full, &p->lock);
+        }
+        int stop = p->stop;
+        pthread_mutex_unlock(&p->lock);
+        if (stop) break;
+
+        /* デコードはロックの外で行う */
+        double start = now_seconds();
+        Image *frame = frame_source_next(p->source);
+        double seconds = now_seconds() - start;
+
+        pthread_mutex_lock(&p->lock);
+        p->decode_seconds += seconds;
+        if (frame) {
+            p->queue[(p->head + p->size) % p->depth] = frame;
+            p->size++;
+        } else {
+            p->finished = 1;
+            p->error = p->source->error;
+        }
+        pthread_cond_signal(&p->not_empty);
+        pthread_mutex_unlock(&p->lock);
+        if (!frame) break;
+    }
+    return NULL;
+}
+
+FramePipeline* frame_pipeline_start(FrameSource *source, int depth) {
+    FramePipeline *p = (FramePipeline*)calloc(1, sizeof(FramePipeline));
+    if (!p) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    p->source = source;
+    p->depth = (depth < 0) ? 0 : (depth > FRAME_PIPELINE_MAX_DEPTH) ? FRAME_PIPELINE_MAX_DEPTH : depth;
+    if (p->depth == 0) return p;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->not_empty, NULL);
+    pthread_cond_init(&p->not_full, NULL);
+    if (pthread_create(&p->thread, NULL, pipeline_worker, p) != 0) {
+        /* スレッドが作れなければ先読みせずに読む */
+        pthread_mutex_destroy(&p->lock);
+        pthread_cond_destroy(&p->not_empty);
+        pthread_cond_destroy(&p->not_full);
+        p->depth = 0;
+        return p;
+    }
+    p->started = 1;
+    return p;
+}
+
+Image* frame_pipeline_next(FramePipeline *p) {
+    if (!p->started) {
+        double start = now_seconds();
+        Image *frame = frame_source_next(p->source);
+        p->decode_seconds += now_seconds() - start;
+        if (!frame) p->error = p->source->error;
+        return frame;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    while (p->size == 0 && !p->finished) {
+        pthread_cond_wait(&p->not_empty, &p->lock);
+    }
+    Image *frame = NULL;
+    if (p->size > 0) {
+        frame = p->queue[p->head];
+        p->head = (p->head + 1) % p->depth;
+        p->size--;
+        pthread_cond_signal(&p->not_full);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return frame;
+}
+
+void frame_pipeline_stop(FramePipeline *p) {
+    if (!p) return;
+    if (p->started) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = 1;
+        pthread_cond_signal(&p->not_full);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->thread, NULL);
+
+        for (int i = 0; i < p->size; i++) {
+            image_free(p->queue[(p->head + i) % p->depth]);
+        }
+        pthread_mutex_destroy(&p->lock);
+        pthread_cond_destroy(&p->not_empty);
+        pthread_cond_destroy(&p->not_full);
+    }
+    free(p);
+}
+
+/* ===========================
+ * 追跡
+ * =========================== */
+
+TrackerOptions tracker_default_options(Region region) {
+    TrackerOptions opt;
+    opt.model = TRACK_YAW;
+    opt.reference = TRACK_KEYFRAME;
+    opt.region = region;
+    opt.predict = 1;
+    opt.acquire_levels = 4;
+    opt.keyframe_interval = 30;
+    opt.keyframe_max_deg = 10.0;
+    opt.yaw = yaw_estimator_default_options();
+    opt.rotation = registration_default_options();
+    /* 初期値が近いので粗いレベルは少なくてよい */
+    opt.rotation.levels = 2;
+    return opt;
+}
+
+Tracker* tracker_create(const TrackerOptions *options) {
+    Tracker *t = (Tracker*)calloc(1, sizeof(Tracker));
+    if (!t) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    t->opt = *options;
+    t->R_key = t->R_prev = t->R_prev2 = matrix_identity();
+    return t;
+}
+
+/* 基準のフレームを替える（frame の所有権を移す） */
+static int set_key(Tracker *t, Image *frame, Matrix3x3 R, double yaw_deg, int index) {
+    yaw_template_free(t->key_template);
+    gray_image_free(t->key_gray);
+    image_free(t->key);
+    t->key_template = NULL;
+    t->key_gray = NULL;
+    t->key = frame;
+    t->R_key = R;
+    t->yaw_key = yaw_deg;
+    t->key_frame = index;
+
+    if (t->opt.model == TRACK_YAW) {
+        t->key_template = yaw_template_create(frame, t->opt.region);
+        return t->key_template != NULL;
+    }
+    t->key_gray = gray_image_from_image(frame);
+    return t->key_gray != NULL;
+}
+
+/* 捕捉: 基準のフレームに対するヨー角を初期値なしで求める
+ * （ピラミッドの最上位での全周探索 + 各レベルのガウス・ニュートン法） */
+static int acquire_yaw(Tracker *t, GrayImage *key_gray, GrayImage *gray, YawEstimate *est) {
+    YawPyramidEstimate pe;
+    int ok = estimate_y_rotation_pyramid(key_gray, gray, t->opt.region, t->opt.acquire_levels,
+                                         &t->opt.yaw, &pe);
+    *est = pe.estimate;
+    return ok;
+}
+
+/* 回転行列の回転角（度数法） */
+static double rotation_angle_deg(Matrix3x3 R) {
+    double c = 0.5 * (R.m[0][0] + R.m[1][1] + R.m[2][2] - 1.0);
+    if (c > 1.0) c = 1.0;
+    if (c < -1.0) c = -1.0;
+    return acos(c) * 180.0 / M_PI;
+}
+
+int tracker_add_frame(Tracker *t, Image *frame, TrackPose *pose) {
+    memset(pose, 0, sizeof(*pose));
+    pose->frame = t->frames;
+    double start = now_seconds();
+
+    /* 最初のフレームは回転なしの基準 */
+    if (t->frames == 0) {
+        if (!set_key(t, frame, matrix_identity(), 0.0, 0)) return 0;
+        pose->R = matrix_identity();
+        pose->converged = 1;
+        pose->keyframe = 1;
+        t->frames = 1;
+        pose->seconds = now_seconds() - start;
+        return 1;
+    }
+
+    if (frame->width != t->key->width || frame->height != t->key->height) {
+        fprintf(stderr, "エラー: フレーム %d のサイズ %d × %d が最初のフレームと異なります\n",
+                t->frames, frame->width, frame->height);
+        image_free(frame);
+        return 0;
+    }
+
+    /* 等速の予測（2フレーム目は直前の回転） */
+    int predict = t->opt.predict && t->frames >= 2;
+    /* 動きの分からない2フレーム目と、直前のフレームで収束しなかった場合は捕捉から */
+    int acquire = t->opt.acquire_levels > 0 && (t->frames == 1 || t->lost);
+    Matrix3x3 R;
+    double yaw = 0.0;
+    int ok, converged;
+
+    if (t->opt.model == TRACK_YAW) {
+        double yaw_pred = predict ? 2.0 * t->yaw_prev - t->yaw_prev2 : t->yaw_prev;
+        pose->predicted_yaw_deg = yaw_pred;
+
+        YawEstimate est;
+        memset(&est, 0, sizeof(est));
+        if (acquire) {
+            GrayImage *key_gray = gray_image_from_image(t->key);
+            GrayImage *gray = gray_image_from_image(frame);
+            ok = key_gray && gray && acquire_yaw(t, key_gray, gray, &est);
+            gray_image_free(key_gray);
+            gray_image_free(gray);
+        } else {
+            ok = estimate_y_rotation_ic(t->key_template, frame, yaw_pred - t->yaw_key,
+                                        &t->opt.yaw, &est);
+        }
+        yaw = ok ? t->yaw_key + est.psi_deg : yaw_pred;
+        R = create_y_rotation_matrix(yaw);
+        pose->E = est.E;
+        pose->passes = est.passes;
+        converged = ok && est.status == YAW_CONVERGED;
+
+        t->yaw_prev2 = t->yaw_prev;
+        t->yaw_prev = yaw;
+    } else {
+        Matrix3x3 R_pred = predict
+            ? matrix_multiply(matrix_multiply(t->R_prev, matrix_transpose(t->R_prev2)), t->R_prev)
+            : t->R_prev;
+        double pitch_pred, roll_pred;
+        rotation_decompose_yaw(R_pred, &pose->predicted_yaw_deg, &pitch_pred, &roll_pred);
+
+        GrayImage *gray = gray_image_from_image(frame);
+        if (!gray) {
+            image_free(frame);
+            return 0;
+        }
+        /* 相対回転の初期値（捕捉ではヨーの全周探索の結果） */
+        Matrix3x3 R_init = matrix_multiply(R_pred, matrix_transpose(t->R_key));
+        YawEstimate est;
+        if (acquire && acquire_yaw(t, t->key_gray, gray, &est)) {
+            R_init = create_y_rotation_matrix(est.psi_deg);
+        }
+        RegistrationResult reg;
+        ok = register_rotation(t->key_gray, gray, t->opt.region, R_init,
+                               &t->opt.rotation, &reg);
+        gray_image_free(gray);
+        R = ok ? matrix_multiply(reg.R, t->R_key) : R_pred;
+        pose->E = reg.E;
+        pose->passes = reg.passes;
+        converged = ok && reg.converged;
+    }
+
+    pose->R = R;
+    rotation_decompose_yaw(R, &pose->yaw_deg, &pose->pitch_deg, &pose->roll_deg);
+    if (t->opt.model == TRACK_YAW) {
+        /* ヨーだけのモデルでは ±180° で折り返さない */
+        pose->yaw_deg = yaw;
+    }
+    pose->converged = converged;
+    pose->acquired = acquire;
+    t->lost = !converged;
+    t->R_prev2 = t->R_prev;
+    t->R_prev = R;
+
+    /* 基準のフレームを替えるか
+     * 収束しなかったフレームの回転は予測のままなので基準にしない。
+     * 直前の良い基準のフレームを残し、次のフレームはそれに対して捕捉する */
+    int index = t->frames++;
+    int rekey = 0;
+    if (converged) {
+        rekey = (t->opt.reference == TRACK_PREVIOUS);
+        if (t->opt.keyframe_interval > 0 && index - t->key_frame >= t->opt.keyframe_interval) {
+            rekey = 1;
+        }
+        if (rotation_angle_deg(matrix_multiply(R, matrix_transpose(t->R_key))) > t->opt.keyframe_max_deg) {
+            rekey = 1;
+        }
+    }
+    if (rekey) {
+        pose->keyframe = 1;
+        if (!set_key(t, frame, R, yaw, index)) return 0;
+    } else {
+        image_free(frame);
+    }
+
+    pose->seconds = now_seconds() - start;
+    return 1;
+}
+
+void tracker_free(Tracker *t) {
+    if (t) {
+        yaw_template_free(t->key_template);
+        gray_image_free(t->key_gray);
+        image_free(t->key);
+        free(t);
+    }
+}
+
+/* ===========================
+ * 軌跡のファイル
+ * =========================== */
+
+void trajectory_write_header(FILE *fp) {
+    fprintf(fp, "frame,yaw_deg,pitch_deg,roll_deg,predicted_yaw_deg,E,passes,converged,acquired,keyframe,seconds\n");
+}
+
+void trajectory_write_pose(FILE *fp, const TrackPose *pose) {
+    fprintf(fp, "%d,%.6f,%.6f,%.6f,%.6f,%.8f,%d,%d,%d,%d,%.6f\n",
+            pose->frame, pose->yaw_deg, pose->pitch_deg, pose->roll_deg,
+            pose->predicted_yaw_deg, pose->E, pose->passes, pose->converged,
+            pose->acquired, pose->keyframe, pose->seconds);
+}
@@ -5,8 +5,10 @@
 #include "y_rotation.h"
 #include "coord_transform.h"
 #include "vector_math.h"
+#include "yaw_window.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -15,32 +17,15 @@
 /* 度数法からラジアンへの変換 */
 #define DEG_TO_RAD(deg) ((deg) * M_PI / 180.0)
 
-static inline double gray_at(Image *img, double u, double v) {
-  uint8_t rgb[3];
-  get_pixel_bilinear(img, u, v, rgb);
-  return (rgb[0] + rgb[1] + rgb[2]) / 3.0;
-}
-
-/* 参照画像上での ∂S/∂θ, ∂S/∂φ を計算（画像差分→角度差で割る） */
-static void ref_image_derivative_theta_phi(Image *ref, double u, double v,
-                                           double *dS_dtheta, double *dS_dphi) {
-  int W = ref->width;
-  int H = ref->height;
-
-  const double dtheta = 2.0 * M_PI / (double)W;
-  const double dphi = M_PI / (double)H;
-
-  /* θ方向（u方向差分、横は周期） */
-  double S_u_plus = gray_at(ref, u + 1.0, v);
-  double S_u_minus = gray_at(ref, u - 1.0, v);
-  *dS_dtheta = (S_u_plus - S_u_minus) / (2.0 * dtheta);
-
-  /* φ方向（v方向差分）
-     あなたのphi定義は phi = (H - v)*pi/H なので、dv/dphi = -H/pi = -1/dphi */
-  double S_v_plus = gray_at(ref, u, v + 1.0);
-  double S_v_minus = gray_at(ref, u, v - 1.0);
-  double dS_dv = (S_v_plus - S_v_minus) / 2.0;
-  *dS_dphi = dS_dv * (-1.0 / dphi);
+/* 同じ行の2画素 a, b の u 方向の線形補間の輝度
+ * （get_gray_bilinear() の dv = 0 の場合と同じく切り捨てなし）
+ */
+static inline double lerp_gray(const uint8_t *a, const uint8_t *b, double f) {
+  double sum = 0.0;
+  for (int c = 0; c < 3; c++) {
+    sum += (1.0 - f) * a[c] + f * b[c];
+  }
+  return sum / 3.0;
 }
 
 /* ∂θ/∂X, ∂φ/∂X など（資料の式） */
@@ -159,14 +144,117 @@ Image *rotate_image_y_axis(Image *input, double psi_deg) {
 }
 
 /* ===========================
- * 目的関数の計算
+ * 画素ごとの計算（目的関数・微分で共通）
  * =========================== */
 
-double compute_objective_function(Image *base, Image *ref, double psi_deg,
-                                  int u_min, int v_min, int u_max, int v_max) {
+/* 基準画像の画素 (u, v) を回転して参照画像と比較
+ *
+ * 出力:
+ *   X, X_prime   - 回転前後の世界座標
+ *   u_ref, v_ref - 参照画像上の座標
+ *
+ * 戻り値:
+ *   diff = Sr(X') - Sb(X)
+ */
+static inline double pixel_difference(Image *base, Image *ref, Matrix3x3 R,
+                                      int u, int v, Vector3D *X,
+                                      Vector3D *X_prime, double *u_ref,
+                                      double *v_ref) {
   int W = base->width;
   int H = base->height;
 
+  /* 基準画像の点を世界座標に変換し、Y軸回りに回転 */
+  *X = image_to_world(u, v, W, H);
+  *X_prime = matrix_vector_multiply(R, *X);
+
+  /* 参照画像の座標に変換 */
+  world_to_image(*X_prime, W, H, u_ref, v_ref);
+
+  /* 両画像の輝度を取得（参照画像は補間面の値、切り捨てなし） */
+  double gray_base = pixel_gray(base, u, v);
+  double gray_ref = get_gray_bilinear(ref, *u_ref, *v_ref);
+
+  return gray_ref - gray_base;
+}
+
+/* pixel_difference() に参照画像の ∂S/∂θ, ∂S/∂φ を加えたもの
+ *
+ * Sr と偏微分を get_gray_bilinear_gradient() で同じ4画素から求める。
+ * 偏微分は目的関数が実際に使う補間面の微分（画素の中心差分ではない）。
+ *
+ * 出力:
+ *   X, X_prime - 回転前後の世界座標
+ *   dS_dtheta, dS_dphi - 参照画像の X' での ∂S/∂θ, ∂S/∂φ
+ *
+ * 戻り値:
+ *   diff = Sr(X') - Sb(X)
+ */
+static inline double pixel_difference_gradient(Image *base, Image *ref,
+                                               Matrix3x3 R, int u, int v,
+                                               Vector3D *X, Vector3D *X_prime,
+                                               double *dS_dtheta,
+                                               double *dS_dphi) {
+  int W = base->width;
+  int H = base->height;
+
+  *X = image_to_world(u, v, W, H);
+  *X_prime = matrix_vector_multiply(R, *X);
+
+  double u_ref, v_ref;
+  world_to_image(*X_prime, W, H, &u_ref, &v_ref);
+
+  double gray_base = pixel_gray(base, u, v);
+
+  double dS_du, dS_dv;
+  double gray_ref = get_gray_bilinear_gradient(ref, u_ref, v_ref, &dS_du, &dS_dv);
+
+  /* du/dθ = W/2π, dv/dφ = -H/π（phi = (H - v)π/H） */
+  *dS_dtheta = dS_du * ((double)W / (2.0 * M_PI));
+  *dS_dphi = dS_dv * (-(double)H / M_PI);
+
+  return gray_ref - gray_base;
+}
+
+/* 画素ごとの dSr/dψ（式15の連鎖律）
+ *
+ * 入力:
+ *   dS_dtheta, dS_dphi - 参照画像の X' での ∂S/∂θ, ∂S/∂φ
+ */
+static inline double pixel_jacobian(Vector3D X, Vector3D X_prime,
+                                    double dS_dtheta, double dS_dphi,
+                                    double cos_psi, double sin_psi) {
+  /* ===== dX'/dψ, dY'/dψ, dZ'/dψ （式11, 12, 13） =====
+     X' =  X cosψ - Z sinψ
+     Y' =  Y
+     Z' =  X sinψ + Z cosψ
+  */
+  double dX_dpsi = -X.x * sin_psi - X.z * cos_psi;
+  double dY_dpsi = 0.0;
+  double dZ_dpsi = X.x * cos_psi - X.z * sin_psi;
+
+  /* ===== ∂θ/∂X', ∂φ/∂X' など ===== */
+  double theta_p, phi_p;
+  world_to_angle(X_prime, &theta_p, &phi_p);
+
+  double dth_dX, dth_dY, dth_dZ;
+  double dph_dX, dph_dY, dph_dZ;
+  dtheta_dphi_dXYZ(theta_p, phi_p, &dth_dX, &dth_dY, &dth_dZ, &dph_dX,
+                   &dph_dY, &dph_dZ);
+
+  /* ===== 連鎖律で ∂S/∂X', ∂S/∂Y', ∂S/∂Z' ===== */
+  double dSr_dX = dS_dtheta * dth_dX + dS_dphi * dph_dX;
+  double dSr_dY = dS_dtheta * dth_dY + dS_dphi * dph_dY;
+  double dSr_dZ = dS_dtheta * dth_dZ + dS_dphi * dph_dZ;
+
+  return dSr_dX * dX_dpsi + dSr_dY * dY_dpsi + dSr_dZ * dZ_dpsi;
+}
+
+/* ===========================
+ * 目的関数の計算
+ * =========================== */
+
+double compute_objective_function(Image *base, Image *ref, double psi_deg,
+                                  int u_min, int v_min, int u_max, int v_max) {
   /* 回転行列を計算 */
   Matrix3x3 R = create_y_rotation_matrix(psi_deg);
 
@@ -176,27 +264,12 @@ double compute_objective_function(Image *base, Image *ref, double psi_deg,
   /* 比較領域内の全画素について */
   for (int v = v_min; v <= v_max; v++) {
     for (int u = u_min; u <= u_max; u++) {
-      /* 基準画像の点を世界座標に変換 */
-      Vector3D X = image_to_world(u, v, W, H);
-
-      /* Y軸回りに回転 */
-      Vector3D X_prime = matrix_vector_multiply(R, X);
-
-      /* 参照画像の座標に変換 */
+      Vector3D X, X_prime;
       double u_ref, v_ref;
-      world_to_image(X_prime, W, H, &u_ref, &v_ref);
-
-      /* 両画像の画素値を取得 */
-      uint8_t rgb_base[3], rgb_ref[3];
-      get_pixel(base, u, v, rgb_base);
-      get_pixel_bilinear(ref, u_ref, v_ref, rgb_ref);
-
-      /* グレースケール変換（簡易版） */
-      double gray_base = (rgb_base[0] + rgb_base[1] + rgb_base[2]) / 3.0;
-      double gray_ref = (rgb_ref[0] + rgb_ref[1] + rgb_ref[2]) / 3.0;
+      double diff = pixel_difference(base, ref, R, u, v, &X, &X_prime,
+                                     &u_ref, &v_ref);
 
       /* 差の2乗を加算 */
-      double diff = gray_ref - gray_base;
       sum += diff * diff;
       count++;
     }
@@ -206,6 +279,26 @@ double compute_objective_function(Image *base, Image *ref, double psi_deg,
   return sum / (2.0 * count);
 }
 
+int compute_objective_batch(Image *base, Image *ref, const double *psis, int K,
+                            int u_min, int v_min, int u_max, int v_max,
+                            double *E) {
+  int n = (u_max - u_min + 1) * (v_max - v_min + 1);
+  if (K <= 0 || n <= 0) {
+    for (int k = 0; k < K; k++) E[k] = 0.0;
+    return 1;
+  }
+
+  /* 基準画像の比較領域を1回だけ読み込む（世界座標と輝度） */
+  Region region = {u_min, v_min, u_max, v_max};
+  RegionContext *ctx = region_context_create(base, region);
+  if (!ctx) {
+    return 0;
+  }
+  compute_objective_batch_ctx(ctx, ref, psis, K, E);
+  region_context_free(ctx);
+  return 1;
+}
+
 /* ===========================
  * 微分の計算
  * =========================== */
@@ -213,81 +306,597 @@ double compute_objective_function(Image *base, Image *ref, double psi_deg,
 double compute_analytical_derivative(Image *base, Image *ref, double psi_deg,
                                      int u_min, int v_min, int u_max,
                                      int v_max) {
-  int W = base->width;
-  int H = base->height;
+  ObjectiveTerms terms;
+  compute_objective_terms(base, ref, psi_deg, u_min, v_min, u_max, v_max,
+                          &terms);
+  return terms.gradient;
+}
 
-  /* 回転角度と三角関数 */
+void compute_objective_terms(Image *base, Image *ref, double psi_deg,
+                             int u_min, int v_min, int u_max, int v_max,
+                             ObjectiveTerms *terms) {
+  /* 回転角度と三角関数（画素ごとではなく1回だけ） */
   double psi = DEG_TO_RAD(psi_deg);
   double cos_psi = cos(psi);
   double sin_psi = sin(psi);
 
-  /* 回転行列 */
   Matrix3x3 R = create_y_rotation_matrix(psi_deg);
 
-  double sum = 0.0;
+  double sum_sq = 0.0;
+  double sum_grad = 0.0;
+  double sum_hess = 0.0;
   int count = 0;
 
   for (int v = v_min; v <= v_max; v++) {
     for (int u = u_min; u <= u_max; u++) {
+      /* 差と参照画像の微分 ∂S/∂θ, ∂S/∂φ（同じ4画素の補間面から） */
+      Vector3D X, X_prime;
+      double dS_dtheta, dS_dphi;
+      double diff = pixel_difference_gradient(base, ref, R, u, v, &X, &X_prime,
+                                              &dS_dtheta, &dS_dphi);
 
-      /* 基準画像の点（球面上） */
+      /* dSr/dψ */
+      double J = pixel_jacobian(X, X_prime, dS_dtheta, dS_dphi, cos_psi,
+                                sin_psi);
+
+      sum_sq += diff * diff;
+      sum_grad += diff * J;
+      sum_hess += J * J;
+      count++;
+    }
+  }
+
+  terms->count = count;
+  if (count == 0) {
+    terms->E = terms->gradient = terms->hessian = 0.0;
+    return;
+  }
+  terms->E = sum_sq / (2.0 * count);
+  terms->gradient = sum_grad / (double)count;
+  terms->hessian = sum_hess / (double)count;
+}
+
+/* ===========================
+ * 基準画像の比較領域（事前計算）
+ * =========================== */
+
+RegionContext *region_context_create(Image *base, Region region) {
+  if (!base) {
+    fprintf(stderr, "エラー: 基準画像がNULL\n");
+    return NULL;
+  }
+  if (region.u_max < region.u_min || region.v_max < region.v_min) {
+    fprintf(stderr, "エラー: 比較領域が不正です\n");
+    return NULL;
+  }
+
+  int W = base->width;
+  int H = base->height;
+  int w = region.u_max - region.u_min + 1;
+  int rows = region.v_max - region.v_min + 1;
+  int n = w * rows;
+
+  RegionContext *ctx = (RegionContext *)calloc(1, sizeof(RegionContext));
+  if (!ctx) {
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    return NULL;
+  }
+  ctx->width = W;
+  ctx->height = H;
+  ctx->region = region;
+  ctx->region_width = w;
+  ctx->rows = rows;
+  ctx->count = n;
+  ctx->X = (double *)malloc((size_t)n * sizeof(double));
+  ctx->Y = (double *)malloc((size_t)n * sizeof(double));
+  ctx->Z = (double *)malloc((size_t)n * sizeof(double));
+  ctx->Sb = (double *)malloc((size_t)n * sizeof(double));
+  if (!ctx->X || !ctx->Y || !ctx->Z || !ctx->Sb) {
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    region_context_free(ctx);
+    return NULL;
+  }
+
+  int i = 0;
+  for (int v = region.v_min; v <= region.v_max; v++) {
+    for (int u = region.u_min; u <= region.u_max; u++) {
       Vector3D X = image_to_world(u, v, W, H);
+      uint8_t rgb[3];
+      get_pixel(base, u, v, rgb);
 
-      /* 回転後の点 */
-      Vector3D X_prime = matrix_vector_multiply(R, X);
+      ctx->X[i] = X.x;
+      ctx->Y[i] = X.y;
+      ctx->Z[i] = X.z;
+      ctx->Sb[i] = (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+      i++;
+    }
+  }
+  return ctx;
+}
 
-      /* 回転後点を参照画像の(u,v)へ */
-      double u_ref, v_ref;
-      world_to_image(X_prime, W, H, &u_ref, &v_ref);
+void region_context_free(RegionContext *ctx) {
+  if (ctx) {
+    free(ctx->X);
+    free(ctx->Y);
+    free(ctx->Z);
+    free(ctx->Sb);
+    free(ctx);
+  }
+}
 
-      /* 画素値 */
-      uint8_t rgb_base[3], rgb_ref[3];
-      get_pixel(base, u, v, rgb_base);
-      get_pixel_bilinear(ref, u_ref, v_ref, rgb_ref);
+double compute_objective_function_ctx(const RegionContext *ctx, Image *ref,
+                                      double psi_deg) {
+  int W = ctx->width;
+  int H = ctx->height;
+  Matrix3x3 R = create_y_rotation_matrix(psi_deg);
 
-      double gray_base = (rgb_base[0] + rgb_base[1] + rgb_base[2]) / 3.0;
-      double gray_ref = (rgb_ref[0] + rgb_ref[1] + rgb_ref[2]) / 3.0;
+  double sum = 0.0;
+  for (int i = 0; i < ctx->count; i++) {
+    Vector3D X = {ctx->X[i], ctx->Y[i], ctx->Z[i]};
+    Vector3D X_prime = matrix_vector_multiply(R, X);
 
-      /* diff = Sr - Sb */
-      double diff = gray_ref - gray_base;
+    double u_ref, v_ref;
+    world_to_image(X_prime, W, H, &u_ref, &v_ref);
 
-      /* ===== dX'/dψ, dY'/dψ, dZ'/dψ （式11, 12, 13） =====
-         X' =  X cosψ - Z sinψ
-         Y' =  Y
-         Z' =  X sinψ + Z cosψ
-      */
-      double dX_dpsi = -X.x * sin_psi - X.z * cos_psi;
-      double dY_dpsi = 0.0;
-      double dZ_dpsi = X.x * cos_psi - X.z * sin_psi;
+    double diff = get_gray_bilinear(ref, u_ref, v_ref) - ctx->Sb[i];
+    sum += diff * diff;
+  }
 
-      /* ===== 参照画像の微分：∂S/∂θ, ∂S/∂φ ===== */
-      double dS_dtheta, dS_dphi;
-      ref_image_derivative_theta_phi(ref, u_ref, v_ref, &dS_dtheta, &dS_dphi);
+  /* 式(14): E(ψ) = (1/2N) Σ (Sr - Sb)² */
+  return sum / (2.0 * ctx->count);
+}
+
+int compute_objective_batch_ctx(const RegionContext *ctx, Image *ref,
+                                const double *psis, int K, double *E) {
+  int W = ctx->width;
+  int H = ctx->height;
+  int n = ctx->count;
+
+  /* 角度を OBJECTIVE_BATCH_ANGLES 個ずつ */
+  for (int k0 = 0; k0 < K; k0 += OBJECTIVE_BATCH_ANGLES) {
+    int nk = K - k0;
+    if (nk > OBJECTIVE_BATCH_ANGLES) nk = OBJECTIVE_BATCH_ANGLES;
+
+    Matrix3x3 R[OBJECTIVE_BATCH_ANGLES];
+    double sum[OBJECTIVE_BATCH_ANGLES];
+    for (int k = 0; k < nk; k++) {
+      R[k] = create_y_rotation_matrix(psis[k0 + k]);
+      sum[k] = 0.0;
+    }
+
+    for (int i = 0; i < n; i++) {
+      Vector3D Xi = {ctx->X[i], ctx->Y[i], ctx->Z[i]};
+      double Sb = ctx->Sb[i];
+      for (int k = 0; k < nk; k++) {
+        Vector3D X_prime = matrix_vector_multiply(R[k], Xi);
+
+        double u_ref, v_ref;
+        world_to_image(X_prime, W, H, &u_ref, &v_ref);
+
+        double diff = get_gray_bilinear(ref, u_ref, v_ref) - Sb;
+        sum[k] += diff * diff;
+      }
+    }
+
+    /* 式(14): E(ψ) = (1/2N) Σ (Sr - Sb)² */
+    for (int k = 0; k < nk; k++) {
+      E[k0 + k] = (n > 0) ? sum[k] / (2.0 * n) : 0.0;
+    }
+  }
+  return 1;
+}
+
+double compute_analytical_derivative_ctx(const RegionContext *ctx, Image *ref,
+                                         double psi_deg) {
+  ObjectiveTerms terms;
+  compute_objective_terms_ctx(ctx, ref, psi_deg, &terms);
+  return terms.gradient;
+}
+
+void compute_objective_terms_ctx(const RegionContext *ctx, Image *ref,
+                                 double psi_deg, ObjectiveTerms *terms) {
+  compute_objective_terms_ctx_rows(ctx, ref, psi_deg, 0, ctx->rows - 1, terms);
+}
+
+void compute_objective_terms_ctx_rows(const RegionContext *ctx, Image *ref,
+                                      double psi_deg, int row0, int row1,
+                                      ObjectiveTerms *terms) {
+  int W = ctx->width;
+  int H = ctx->height;
+  /* du/dθ = W/2π, dv/dφ = -H/π（phi = (H - v)π/H） */
+  const double du_dtheta = (double)W / (2.0 * M_PI);
+  const double dv_dphi = -(double)H / M_PI;
+
+  double psi = DEG_TO_RAD(psi_deg);
+  double cos_psi = cos(psi);
+  double sin_psi = sin(psi);
+  Matrix3x3 R = create_y_rotation_matrix(psi_deg);
+
+  if (row0 < 0) row0 = 0;
+  if (row1 > ctx->rows - 1) row1 = ctx->rows - 1;
+  int i0 = row0 * ctx->region_width;
+  int i1 = (row1 + 1) * ctx->region_width;
+
+  double sum_sq = 0.0;
+  double sum_grad = 0.0;
+  double sum_hess = 0.0;
+  int count = 0;
+
+  for (int i = i0; i < i1; i++) {
+    Vector3D X = {ctx->X[i], ctx->Y[i], ctx->Z[i]};
+    Vector3D X_prime = matrix_vector_multiply(R, X);
 
-      /* ===== ∂θ/∂X', ∂φ/∂X' など ===== */
-      double theta_p, phi_p;
-      world_to_angle(X_prime, &theta_p, &phi_p);
+    double u_ref, v_ref;
+    world_to_image(X_prime, W, H, &u_ref, &v_ref);
 
-      double dth_dX, dth_dY, dth_dZ;
-      double dph_dX, dph_dY, dph_dZ;
-      dtheta_dphi_dXYZ(theta_p, phi_p, &dth_dX, &dth_dY, &dth_dZ, &dph_dX,
-                       &dph_dY, &dph_dZ);
+    /* 差と ∂S/∂θ, ∂S/∂φ を同じ4画素の補間面から */
+    double dS_du, dS_dv;
+    double gray_ref = get_gray_bilinear_gradient(ref, u_ref, v_ref, &dS_du, &dS_dv);
+    double diff = gray_ref - ctx->Sb[i];
 
-      /* ===== 連鎖律で ∂S/∂X', ∂S/∂Y', ∂S/∂Z' ===== */
-      double dSr_dX = dS_dtheta * dth_dX + dS_dphi * dph_dX;
-      double dSr_dY = dS_dtheta * dth_dY + dS_dphi * dph_dY;
-      double dSr_dZ = dS_dtheta * dth_dZ + dS_dphi * dph_dZ;
+    double J = pixel_jacobian(X, X_prime, dS_du * du_dtheta, dS_dv * dv_dphi,
+                              cos_psi, sin_psi);
+
+    sum_sq += diff * diff;
+    sum_grad += diff * J;
+    sum_hess += J * J;
+    count++;
+  }
 
-      /* ===== 式: dE/dψ = (1/N) Σ (Sr-Sb)*(...) ===== */
-      double chain_rule =
-          dSr_dX * dX_dpsi + dSr_dY * dY_dpsi + dSr_dZ * dZ_dpsi;
+  terms->count = count;
+  if (count == 0) {
+    terms->E = terms->gradient = terms->hessian = 0.0;
+    return;
+  }
+  terms->E = sum_sq / (2.0 * count);
+  terms->gradient = sum_grad / (double)count;
+  terms->hessian = sum_hess / (double)count;
+}
 
-      sum += diff * chain_rule;
+/* ===========================
+ * Y軸回り専用の閉じた形（球面座標を経由しない）
+ * =========================== */
+
+/* 1行分の E, g, H の和（want_grad = 0 なら E だけ） */
+static void yaw_row_sums(Image *base, Image *ref, int v, int u_min, int u_max,
+                         int k, double f, int want_grad, double *sum_sq,
+                         double *sum_grad, double *sum_hess) {
+  static const uint8_t zero[3] = {0, 0, 0};
+  int W = ref->width;
+  int H = ref->height;
+  int channels_b = base->channels;
+  int channels_r = ref->channels;
+  /* 行が画像の外なら get_pixel() と同じく 0 */
+  int inside = (v >= 0 && v < H);
+  const uint8_t *row_b = inside ? base->data + (size_t)v * W * channels_b : NULL;
+  const uint8_t *row_r = inside ? ref->data + (size_t)v * W * channels_r : NULL;
+  const double du_dtheta = (double)W / (2.0 * M_PI);
+
+  int u0 = wrap_u(u_min + k, W);
+  for (int u = u_min; u <= u_max; u++) {
+    int u1 = (u0 + 1 == W) ? 0 : u0 + 1;
+
+    const uint8_t *pb = inside ? row_b + (size_t)wrap_u(u, W) * channels_b : zero;
+    const uint8_t *p0 = inside ? row_r + (size_t)u0 * channels_r : zero;
+    const uint8_t *p1 = inside ? row_r + (size_t)u1 * channels_r : zero;
+
+    double Sb = (pb[0] + pb[1] + pb[2]) / 3.0;
+    double diff = lerp_gray(p0, p1, f) - Sb;
+    *sum_sq += diff * diff;
+
+    if (want_grad) {
+      /* dSr/dψ = -∂S/∂θ（∂S/∂u は補間に使った2画素の線形補間の傾き） */
+      double dS_du = ((p1[0] - p0[0]) + (p1[1] - p0[1]) + (p1[2] - p0[2])) / 3.0;
+      double J = -dS_du * du_dtheta;
+      *sum_grad += diff * J;
+      *sum_hess += J * J;
+    }
+
+    u0 = u1;
+  }
+}
+
+double compute_objective_function_yaw(Image *base, Image *ref, double psi_deg,
+                                      int u_min, int v_min, int u_max,
+                                      int v_max) {
+  int k;
+  double f;
+  yaw_shift_split(psi_deg, ref->width, &k, &f);
+
+  double sum = 0.0;
+  double unused_grad = 0.0, unused_hess = 0.0;
+  for (int v = v_min; v <= v_max; v++) {
+    yaw_row_sums(base, ref, v, u_min, u_max, k, f, 0, &sum, &unused_grad,
+                 &unused_hess);
+  }
+
+  int count = (u_max - u_min + 1) * (v_max - v_min + 1);
+  return sum / (2.0 * count);
+}
+
+void compute_objective_terms_yaw(Image *base, Image *ref, double psi_deg,
+                                 int u_min, int v_min, int u_max, int v_max,
+                                 ObjectiveTerms *terms) {
+  int k;
+  double f;
+  yaw_shift_split(psi_deg, ref->width, &k, &f);
+
+  double sum_sq = 0.0;
+  double sum_grad = 0.0;
+  double sum_hess = 0.0;
+  for (int v = v_min; v <= v_max; v++) {
+    yaw_row_sums(base, ref, v, u_min, u_max, k, f, 1, &sum_sq, &sum_grad,
+                 &sum_hess);
+  }
+
+  int count = (u_max - u_min + 1) * (v_max - v_min + 1);
+  terms->count = count;
+  if (count <= 0) {
+    terms->count = 0;
+    terms->E = terms->gradient = terms->hessian = 0.0;
+    return;
+  }
+  terms->E = sum_sq / (2.0 * count);
+  terms->gradient = sum_grad / (double)count;
+  terms->hessian = sum_hess / (double)count;
+}
+
+/* 比較領域の行ごとの基準画像の輝度の分散 */
+static double row_variance(Image *base, int v, int u_min, int u_max) {
+  double sum = 0.0, sum_sq = 0.0;
+  int n = u_max - u_min + 1;
+  for (int u = u_min; u <= u_max; u++) {
+    uint8_t rgb[3];
+    get_pixel(base, u, v, rgb);
+    double s = (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+    sum += s;
+    sum_sq += s * s;
+  }
+  double mean = sum / n;
+  return sum_sq / n - mean * mean;
+}
+
+/* 行の順序の並べ替え用 */
+typedef struct {
+  double variance;
+  int v;
+} RowRank;
+
+static int compare_row_rank(const void *a, const void *b) {
+  const RowRank *ra = (const RowRank *)a;
+  const RowRank *rb = (const RowRank *)b;
+  if (ra->variance > rb->variance) return -1;
+  if (ra->variance < rb->variance) return 1;
+  return ra->v - rb->v;
+}
+
+int *objective_row_order(Image *base, int u_min, int v_min, int u_max,
+                         int v_max) {
+  int rows = v_max - v_min + 1;
+  if (rows <= 0 || u_max < u_min) {
+    fprintf(stderr, "エラー: 比較領域が不正です\n");
+    return NULL;
+  }
+  RowRank *rank = (RowRank *)malloc((size_t)rows * sizeof(RowRank));
+  int *order = (int *)malloc((size_t)rows * sizeof(int));
+  if (!rank || !order) {
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    free(rank);
+    free(order);
+    return NULL;
+  }
+
+  for (int i = 0; i < rows; i++) {
+    rank[i].v = v_min + i;
+    rank[i].variance = row_variance(base, v_min + i, u_min, u_max);
+  }
+  qsort(rank, rows, sizeof(RowRank), compare_row_rank);
+  for (int i = 0; i < rows; i++) {
+    order[i] = rank[i].v;
+  }
+
+  free(rank);
+  return order;
+}
+
+double compute_objective_function_yaw_bounded(Image *base, Image *ref,
+                                              double psi_deg, int u_min,
+                                              int v_min, int u_max, int v_max,
+                                              const int *row_order,
+                                              double bound, int *rows_done) {
+  int k;
+  double f;
+  yaw_shift_split(psi_deg, ref->width, &k, &f);
+
+  int rows = v_max - v_min + 1;
+  int count = (u_max - u_min + 1) * rows;
+
+  double sum = 0.0;
+  double unused_grad = 0.0, unused_hess = 0.0;
+  int i = 0;
+  while (i < rows) {
+    int v = row_order ? row_order[i] : v_min + i;
+    yaw_row_sums(base, ref, v, u_min, u_max, k, f, 0, &sum, &unused_grad,
+                 &unused_hess);
+    i++;
+    /* 最後の E と同じ割り算で比べる（残りの行を足しても E は減らない） */
+    if (i < rows && sum / (2.0 * count) > bound) {
+      break;
+    }
+  }
+
+  if (rows_done) {
+    *rows_done = i;
+  }
+  return sum / (2.0 * count);
+}
+
+/* ===========================
+ * グレースケール画像（ピラミッド用）
+ * =========================== */
+
+void compute_objective_terms_gray(const GrayImage *base, const GrayImage *ref,
+                                  double psi_deg, int u_min, int v_min,
+                                  int u_max, int v_max, ObjectiveTerms *terms) {
+  int W = base->width;
+  int H = base->height;
+  const double du_dtheta = (double)W / (2.0 * M_PI);
+
+  int k;
+  double f;
+  yaw_shift_split(psi_deg, W, &k, &f);
+
+  double sum_sq = 0.0;
+  double sum_grad = 0.0;
+  double sum_hess = 0.0;
+  int count = 0;
+
+  for (int v = v_min; v <= v_max; v++) {
+    if (v < 0 || v >= H) {
+      continue;
+    }
+    const double *row_b = base->data + (size_t)v * W;
+    const double *row_r = ref->data + (size_t)v * W;
+
+    int u0 = wrap_u(u_min + k, W);
+    for (int u = u_min; u <= u_max; u++) {
+      int u1 = (u0 + 1 == W) ? 0 : u0 + 1;
+
+      double Sr = (1.0 - f) * row_r[u0] + f * row_r[u1];
+      double diff = Sr - row_b[wrap_u(u, W)];
+
+      /* Y軸回りでは θ' = θ - ψ, φ' = φ なので式15の連鎖律は
+       * dSr/dψ = -∂S/∂θ になる（∂S/∂u は線形補間の傾き） */
+      double J = -(row_r[u1] - row_r[u0]) * du_dtheta;
+
+      sum_sq += diff * diff;
+      sum_grad += diff * J;
+      sum_hess += J * J;
       count++;
+
+      u0 = u1;
+    }
+  }
+
+  terms->count = count;
+  if (count == 0) {
+    terms->E = terms->gradient = terms->hessian = 0.0;
+    return;
+  }
+  terms->E = sum_sq / (2.0 * count);
+  terms->gradient = sum_grad / (double)count;
+  terms->hessian = sum_hess / (double)count;
+}
+
+/* ===========================
+ * 逆合成法
+ * =========================== */
+
+YawTemplate *yaw_template_create(Image *base, Region region) {
+  if (!base) {
+    fprintf(stderr, "エラー: 基準画像がNULL\n");
+    return NULL;
+  }
+  if (region.u_max < region.u_min || region.v_max < region.v_min) {
+    fprintf(stderr, "エラー: 比較領域が不正です\n");
+    return NULL;
+  }
+
+  int W = base->width;
+  int H = base->height;
+  int n = (region.u_max - region.u_min + 1) * (region.v_max - region.v_min + 1);
+
+  YawTemplate *t = (YawTemplate *)calloc(1, sizeof(YawTemplate));
+  if (!t) {
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    return NULL;
+  }
+  t->width = W;
+  t->height = H;
+  t->region = region;
+  t->X = (Vector3D *)malloc((size_t)n * sizeof(Vector3D));
+  t->Sb = (double *)malloc((size_t)n * sizeof(double));
+  t->SD = (double *)malloc((size_t)n * sizeof(double));
+  if (!t->X || !t->Sb || !t->SD) {
+    fprintf(stderr, "エラー: メモリ確保失敗\n");
+    yaw_template_free(t);
+    return NULL;
+  }
+
+  /* du/dθ = W/2π, dv/dφ = -H/π（phi = (H - v)π/H） */
+  const double du_dtheta = (double)W / (2.0 * M_PI);
+  const double dv_dphi = -(double)H / M_PI;
+
+  double sum_hess = 0.0;
+  int i = 0;
+  for (int v = region.v_min; v <= region.v_max; v++) {
+    for (int u = region.u_min; u <= region.u_max; u++) {
+      Vector3D X = image_to_world(u, v, W, H);
+
+      uint8_t rgb[3];
+      get_pixel(base, u, v, rgb);
+
+      /* 画素の中心での ∂S/∂θ, ∂S/∂φ（中心差分、u は周期的、画像外の行は0）
+       * 比較領域の画素ごとに1回だけなので勾配画像は作らない */
+      double dS_dtheta =
+          0.5 * (pixel_gray(base, u + 1, v) - pixel_gray(base, u - 1, v)) * du_dtheta;
+      double dS_dphi =
+          0.5 * (pixel_gray(base, u, v + 1) - pixel_gray(base, u, v - 1)) * dv_dphi;
+
+      /* ψ = 0（X' = X）での dSb/dψ */
+      double sd = pixel_jacobian(X, X, dS_dtheta, dS_dphi, 1.0, 0.0);
+
+      t->X[i] = X;
+      t->Sb[i] = (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+      t->SD[i] = sd;
+      sum_hess += sd * sd;
+      i++;
     }
   }
+  t->count = i;
+  t->hessian = sum_hess / (double)i;
+  return t;
+}
+
+void yaw_template_free(YawTemplate *tmpl) {
+  if (tmpl) {
+    free(tmpl->X);
+    free(tmpl->Sb);
+    free(tmpl->SD);
+    free(tmpl);
+  }
+}
+
+void compute_objective_terms_ic(const YawTemplate *tmpl, Image *ref,
+                                double psi_deg, ObjectiveTerms *terms) {
+  int W = tmpl->width;
+  int H = tmpl->height;
+
+  Matrix3x3 R = create_y_rotation_matrix(psi_deg);
 
-  return sum / (double)count;
+  double sum_sq = 0.0;
+  double sum_grad = 0.0;
+
+  for (int i = 0; i < tmpl->count; i++) {
+    Vector3D X_prime = matrix_vector_multiply(R, tmpl->X[i]);
+
+    double u_ref, v_ref;
+    world_to_image(X_prime, W, H, &u_ref, &v_ref);
+
+    double diff = get_gray_bilinear(ref, u_ref, v_ref) - tmpl->Sb[i];
+
+    sum_sq += diff * diff;
+    sum_grad += tmpl->SD[i] * diff;
+  }
+
+  terms->count = tmpl->count;
+  if (tmpl->count == 0) {
+    terms->E = terms->gradient = terms->hessian = 0.0;
+    return;
+  }
+  terms->E = sum_sq / (2.0 * tmpl->count);
+  terms->gradient = sum_grad / (double)tmpl->count;
+  terms->hessian = tmpl->hessian;
 }
 
 double compute_numerical_derivative(Image *base, Image *ref, double psi_deg,
@@ -0,0 +1,489 @@
+/* yaw_estimator.c
+ * ヨー角の推定の実装
+ */
+
+#include "yaw_estimator.h"
+#include "yaw_search.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ラジアンから度数法への変換 */
+#define RAD_TO_DEG(rad) ((rad) * 180.0 / M_PI)
+
+/* 黄金分割比 (3 - √5) / 2 */
+#define GOLDEN_SECTION 0.3819660112501051
+
+YawEstimatorOptions yaw_estimator_default_options(void) {
+    YawEstimatorOptions opt;
+    opt.max_iterations = 20;
+    opt.tolerance_deg = 5e-3;
+    opt.lambda_init = 1e-3;
+    opt.lambda_max = 1e6;
+    opt.use_brent_fallback = 1;
+    opt.brent_half_range_deg = 2.0;
+    opt.brent_tolerance_deg = 1e-3;
+    return opt;
+}
+
+const char* yaw_status_name(YawStatus status) {
+    switch (status) {
+    case YAW_CONVERGED:      return "収束";
+    case YAW_BRENT_FALLBACK: return "ブレント法";
+    case YAW_MAX_ITERATIONS: return "反復上限";
+    case YAW_FAILED:         return "失敗";
+    default:                 return "不明";
+    }
+}
+
+/* ブレント法で最小化する目的関数 E(ψ)（ψ は度数法） */
+typedef double (*ObjectiveFn)(void *ctx, double psi_deg);
+
+/* 事前計算した比較領域と参照画像の組
+ * （compute_objective_function_ctx, compute_objective_terms_ctx）
+ */
+typedef struct {
+    const RegionContext *region;
+    Image *ref;
+} RegionPair;
+
+static double region_pair_objective(void *ctx, double psi_deg) {
+    const RegionPair *p = (const RegionPair*)ctx;
+    return compute_objective_function_ctx(p->region, p->ref, psi_deg);
+}
+
+/* ガウス・ニュートン法で使う E, g, H（ψ は度数法） */
+typedef void (*TermsFn)(void *ctx, double psi_deg, ObjectiveTerms *terms);
+
+static void region_pair_terms(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    const RegionPair *p = (const RegionPair*)ctx;
+    compute_objective_terms_ctx(p->region, p->ref, psi_deg, terms);
+}
+
+/* 逆合成法の E, g, H（compute_objective_terms_ic、H は定数） */
+typedef struct {
+    const YawTemplate *tmpl;
+    Image *ref;
+} TemplatePair;
+
+static void template_terms(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    const TemplatePair *p = (const TemplatePair*)ctx;
+    compute_objective_terms_ic(p->tmpl, p->ref, psi_deg, terms);
+}
+
+static double template_objective(void *ctx, double psi_deg) {
+    ObjectiveTerms terms;
+    template_terms(ctx, psi_deg, &terms);
+    return terms.E;
+}
+
+/* ピラミッドの1つのレベルでの E, g, H（compute_objective_terms_gray） */
+typedef struct {
+    const GrayImage *base;
+    const GrayImage *ref;
+    Region region;
+} GrayLevelPair;
+
+static void gray_level_terms(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    const GrayLevelPair *p = (const GrayLevelPair*)ctx;
+    compute_objective_terms_gray(p->base, p->ref, psi_deg,
+                                 p->region.u_min, p->region.v_min,
+                                 p->region.u_max, p->region.v_max, terms);
+}
+
+static double gray_level_objective(void *ctx, double psi_deg) {
+    ObjectiveTerms terms;
+    gray_level_terms(ctx, psi_deg, &terms);
+    return terms.E;
+}
+
+/* ZNCC の E, g, H（zncc_objective_terms、H は区間内の厳密な2階微分） */
+static void zncc_terms(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    zncc_objective_terms((const ZnccContext*)ctx, psi_deg, terms);
+}
+
+static double zncc_objective_fn(void *ctx, double psi_deg) {
+    return zncc_objective((const ZnccContext*)ctx, psi_deg);
+}
+
+/* 相互情報量の E, g, H（mi_objective_terms、H はフィッシャー情報量型の近似） */
+static void mi_terms(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    mi_objective_terms((MiContext*)ctx, psi_deg, terms);
+}
+
+static double mi_objective_fn(void *ctx, double psi_deg) {
+    return mi_objective((MiContext*)ctx, psi_deg);
+}
+
+/* 複数の比較領域の全体の E, g, H（region_set_terms） */
+static void region_set_terms_fn(void *ctx, double psi_deg, ObjectiveTerms *terms) {
+    region_set_terms((const RegionSetContext*)ctx, psi_deg, NULL, terms);
+}
+
+static double region_set_objective_fn(void *ctx, double psi_deg) {
+    return region_set_objective((const RegionSetContext*)ctx, psi_deg);
+}
+
+/* ブレント法で [a, b] の最小値を求める（放物線補間と黄金分割の併用）
+ *
+ * 出力:
+ *   psi_min - 最小点（度数法）
+ *
+ * 戻り値:
+ *   最小値
+ */
+static double brent_minimize(ObjectiveFn f, void *ctx,
+                             double a, double b, double tol, int max_iter,
+                             double *psi_min, int *passes) {
+    double x = a + GOLDEN_SECTION * (b - a);
+    double w = x, v = x;
+    double fx = f(ctx, x);
+    (*passes)++;
+    double fw = fx, fv = fx;
+    double d = 0.0, e = 0.0;
+
+    for (int iter = 0; iter < max_iter; iter++) {
+        double m = 0.5 * (a + b);
+        double tol1 = tol + 1e-10 * fabs(x);
+        double tol2 = 2.0 * tol1;
+        if (fabs(x - m) <= tol2 - 0.5 * (b - a)) {
+            break;
+        }
+
+        int golden = 1;
+        if (fabs(e) > tol1) {
+            /* 放物線補間を試す */
+            double p = (x - w) * (x - w) * (fx - fv) - (x - v) * (x - v) * (fx - fw);
+            double q = 2.0 * ((x - w) * (fx - fv) - (x - v) * (fx - fw));
+            if (q > 0.0) {
+                p = -p;
+            }
+            q = fabs(q);
+            double e_prev = e;
+            e = d;
+            if (fabs(p) < fabs(0.5 * q * e_prev) && p > q * (a - x) && p < q * (b - x)) {
+                d = p / q;
+                double u = x + d;
+                if (u - a < tol2 || b - u < tol2) {
+                    d = (x < m) ? tol1 : -tol1;
+                }
+                golden = 0;
+            }
+        }
+        if (golden) {
+            e = (x < m) ? b - x : a - x;
+            d = GOLDEN_SECTION * e;
+        }
+
+        double u = (fabs(d) >= tol1) ? x + d : x + (d > 0.0 ? tol1 : -tol1);
+        double fu = f(ctx, u);
+        (*passes)++;
+
+        if (fu <= fx) {
+            if (u < x) b = x; else a = x;
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        } else {
+            if (u < x) a = u; else b = u;
+            if (fu <= fw || w == x) {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            } else if (fu <= fv || v == x || v == w) {
+                v = u; fv = fu;
+            }
+        }
+    }
+
+    *psi_min = x;
+    return fx;
+}
+
+/* ガウス・ニュートン法の後処理（状態の設定と、必要ならブレント法）
+ *
+ * 戻り値:
+ *   1: 角度が求まった, 0: 失敗
+ */
+static int finish_estimate(const YawEstimatorOptions *opt, int gn_ok,
+                           double init_deg, ObjectiveFn f, void *ctx,
+                           YawEstimate *result) {
+    if (gn_ok) {
+        result->status = YAW_CONVERGED;
+        return 1;
+    }
+
+    if (!opt->use_brent_fallback) {
+        result->status = (result->iterations >= opt->max_iterations)
+                       ? YAW_MAX_ITERATIONS : YAW_FAILED;
+        return result->status == YAW_MAX_ITERATIONS;
+    }
+
+    /* 勾配が当てにならないので目的関数だけで探索 */
+    double psi_brent;
+    double E_brent = brent_minimize(f, ctx,
+                                    init_deg - opt->brent_half_range_deg,
+                                    init_deg + opt->brent_half_range_deg,
+                                    opt->brent_tolerance_deg, 100,
+                                    &psi_brent, &result->passes);
+    if (E_brent < result->E) {
+        result->psi_deg = psi_brent;
+        result->E = E_brent;
+        result->gradient = 0.0;
+    }
+    result->status = YAW_BRENT_FALLBACK;
+    return 1;
+}
+
+/* ガウス・ニュートン法（レーベンバーグ・マーカート型の減衰付き）
+ *
+ * terms(ctx, ψ) で E, g, H を1回の走査で求め、Δψ = -g / (H (1 + λ)) で更新する。
+ * 収束の判定は減衰なしのガウス・ニュートン法の更新量 |g / H| で行う
+ * （λ が大きいと Δψ は最小点から遠くても小さくなるので、Δψ では判定しない）。
+ * 減衰した Δψ が収束の閾値より小さくなっても E が減らない場合は
+ * 収束とせず 0 を返し、呼び出し側でブレント法に切り替える。
+ *
+ * 戻り値:
+ *   1: 収束, 0: 反復上限・λ の上限・H <= 0, -1: 比較領域に画素がない
+ */
+static int gauss_newton(TermsFn terms, void *ctx, double init_deg,
+                        const YawEstimatorOptions *opt, YawEstimate *result) {
+    ObjectiveTerms cur;
+    terms(ctx, init_deg, &cur);
+    result->passes++;
+    if (cur.count == 0) {
+        fprintf(stderr, "エラー: 比較領域に画素がありません\n");
+        return -1;
+    }
+
+    double psi = init_deg;
+    double lambda = opt->lambda_init;
+    int gn_ok = 0;
+
+    while (result->iterations < opt->max_iterations) {
+        if (cur.hessian <= 0.0) {
+            break;
+        }
+
+        /* 減衰なしの更新量 -g / H と Δψ = -g / (H (1 + λ))（度数法） */
+        double newton_deg = RAD_TO_DEG(-cur.gradient / cur.hessian);
+        double step_deg = newton_deg / (1.0 + lambda);
+
+        ObjectiveTerms trial;
+        terms(ctx, psi + step_deg, &trial);
+        result->passes++;
+        result->iterations++;
+
+        if (trial.E <= cur.E) {
+            psi += step_deg;
+            cur = trial;
+            lambda *= 0.1;
+            if (fabs(newton_deg) < opt->tolerance_deg) {
+                gn_ok = 1;
+                break;
+            }
+        } else {
+            /* 減衰なしの更新量が十分小さいのに減らない = 最小点の近く
+             * （双線形補間の目的関数は画素の境界で滑らかでないため、
+             *   最小点の近くではこれで止める）
+             */
+            if (fabs(newton_deg) < opt->tolerance_deg) {
+                gn_ok = 1;
+                break;
+            }
+            /* 減衰で Δψ だけが小さくなっても減らない = 勾配が当てにならない
+             * （ブレント法に任せる） */
+            if (fabs(step_deg) < opt->tolerance_deg) {
+                break;
+            }
+            /* 減らなければ減衰を強めて同じ点からやり直す */
+            lambda *= 10.0;
+            if (lambda > opt->lambda_max) {
+                break;
+            }
+        }
+    }
+
+    result->psi_deg = psi;
+    result->E = cur.E;
+    result->gradient = cur.gradient;
+    return gn_ok;
+}
+
+static void reset_estimate(double init_deg, YawEstimate *result) {
+    result->psi_deg = init_deg;
+    result->E = 0.0;
+    result->gradient = 0.0;
+    result->iterations = 0;
+    result->passes = 0;
+    result->status = YAW_FAILED;
+}
+
+int estimate_y_rotation(Image *base, Image *ref, Region region,
+                        double init_deg, const YawEstimatorOptions *options,
+                        YawEstimate *result) {
+    /* 基準画像の比較領域の世界座標と輝度は1回だけ求める */
+    RegionContext *ctx = region_context_create(base, region);
+    if (!ctx) {
+        reset_estimate(init_deg, result);
+        return 0;
+    }
+    int ok = estimate_y_rotation_ctx(ctx, ref, init_deg, options, result);
+    region_context_free(ctx);
+    return ok;
+}
+
+int estimate_y_rotation_ctx(const RegionContext *ctx, Image *ref, double init_deg,
+                            const YawEstimatorOptions *options, YawEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    reset_estimate(init_deg, result);
+
+    RegionPair pair = {ctx, ref};
+    int gn_ok = gauss_newton(region_pair_terms, &pair, init_deg, &opt, result);
+    if (gn_ok < 0) {
+        return 0;
+    }
+    return finish_estimate(&opt, gn_ok, init_deg, region_pair_objective, &pair, result);
+}
+
+int estimate_y_rotation_ic(const YawTemplate *tmpl, Image *ref, double init_deg,
+                           const YawEstimatorOptions *options, YawEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    reset_estimate(init_deg, result);
+
+    if (ref->width != tmpl->width || ref->height != tmpl->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return 0;
+    }
+
+    TemplatePair tp = {tmpl, ref};
+    int gn_ok = gauss_newton(template_terms, &tp, init_deg, &opt, result);
+    if (gn_ok < 0) {
+        return 0;
+    }
+    return finish_estimate(&opt, gn_ok, init_deg, template_objective, &tp, result);
+}
+
+int estimate_y_rotation_zncc(const ZnccContext *ctx, double init_deg,
+                             const YawEstimatorOptions *options, YawEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    reset_estimate(init_deg, result);
+
+    /* zncc_objective() と zncc_objective_terms() は ctx を変更しない */
+    void *zctx = (void*)ctx;
+    int gn_ok = gauss_newton(zncc_terms, zctx, init_deg, &opt, result);
+    if (gn_ok < 0) {
+        return 0;
+    }
+    return finish_estimate(&opt, gn_ok, init_deg, zncc_objective_fn, zctx, result);
+}
+
+int estimate_y_rotation_mi(MiContext *ctx, double init_deg,
+                           const YawEstimatorOptions *options, YawEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    reset_estimate(init_deg, result);
+
+    int gn_ok = gauss_newton(mi_terms, ctx, init_deg, &opt, result);
+    if (gn_ok < 0) {
+        return 0;
+    }
+    return finish_estimate(&opt, gn_ok, init_deg, mi_objective_fn, ctx, result);
+}
+
+int estimate_y_rotation_regions(const RegionSetContext *ctx, double init_deg,
+                                const YawEstimatorOptions *options, YawEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    reset_estimate(init_deg, result);
+
+    /* region_set_terms() と region_set_objective() は ctx を変更しない */
+    void *rctx = (void*)ctx;
+    int gn_ok = gauss_newton(region_set_terms_fn, rctx, init_deg, &opt, result);
+    if (gn_ok < 0) {
+        return 0;
+    }
+    return finish_estimate(&opt, gn_ok, init_deg, region_set_objective_fn, rctx, result);
+}
+
+int estimate_y_rotation_pyramid(GrayImage *base, GrayImage *ref, Region region,
+                                int levels, const YawEstimatorOptions *options,
+                                YawPyramidEstimate *result) {
+    YawEstimatorOptions opt = options ? *options : yaw_estimator_default_options();
+    memset(result, 0, sizeof(*result));
+    reset_estimate(0.0, &result->estimate);
+
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return 0;
+    }
+
+    clock_t start = clock();
+    GrayPyramid pb, pr;
+    if (!gray_pyramid_build(base, levels, &pb)) {
+        return 0;
+    }
+    if (!gray_pyramid_build(ref, levels, &pr)) {
+        gray_pyramid_free(&pb);
+        return 0;
+    }
+    int top = ((pb.levels < pr.levels) ? pb.levels : pr.levels) - 1;
+    result->levels = top + 1;
+    result->build_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* 1. 最上位レベルで全周探索 */
+    start = clock();
+    Region r_top = region_at_level(region, top);
+    YawCurve curve;
+    if (!yaw_search_fft(pb.level[top], pr.level[top], r_top.u_min, r_top.v_min,
+                        r_top.u_max, r_top.v_max, &curve)) {
+        gray_pyramid_free(&pb);
+        gray_pyramid_free(&pr);
+        return 0;
+    }
+    double psi = curve.best_psi_deg;
+    yaw_curve_free(&curve);
+    result->search_psi_deg = psi;
+    result->search_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* 2. 粗いレベルから順にガウス・ニュートン法 */
+    int ok = 1;
+    for (int l = top; l >= 0; l--) {
+        start = clock();
+        GrayLevelPair gp = {pb.level[l], pr.level[l], region_at_level(region, l)};
+        YawEstimatorOptions level_opt = opt;
+        level_opt.tolerance_deg = opt.tolerance_deg * (double)(1 << l);
+
+        YawEstimate est;
+        reset_estimate(psi, &est);
+        int gn_ok = gauss_newton(gray_level_terms, &gp, psi, &level_opt, &est);
+        if (gn_ok < 0) {
+            ok = 0;
+            break;
+        }
+        if (l == 0) {
+            ok = finish_estimate(&level_opt, gn_ok, psi, gray_level_objective, &gp, &est);
+        } else {
+            est.status = gn_ok ? YAW_CONVERGED : YAW_MAX_ITERATIONS;
+        }
+        psi = est.psi_deg;
+
+        result->level_psi_deg[l] = psi;
+        result->level_passes[l] = est.passes;
+        result->level_seconds[l] = (double)(clock() - start) / CLOCKS_PER_SEC;
+        result->estimate.iterations += est.iterations;
+        result->estimate.passes += est.passes;
+        if (l == 0) {
+            result->estimate.psi_deg = est.psi_deg;
+            result->estimate.E = est.E;
+            result->estimate.gradient = est.gradient;
+            result->estimate.status = est.status;
+        }
+    }
+
+    gray_pyramid_free(&pb);
+    gray_pyramid_free(&pr);
+    return ok;
+}
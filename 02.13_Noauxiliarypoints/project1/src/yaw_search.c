@@ -0,0 +1,140 @@
+/* yaw_search.c
+ * FFTによるヨー角の全探索の実装
+ */
+
+#include "yaw_search.h"
+#include "fft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+double yaw_shift_to_deg(int shift, int width) {
+    if (shift > width / 2) {
+        shift -= width;
+    }
+    return 360.0 * shift / width;
+}
+
+int yaw_search_fft(const GrayImage *base, const GrayImage *ref,
+                   int u_min, int v_min, int u_max, int v_max,
+                   YawCurve *curve) {
+    memset(curve, 0, sizeof(*curve));
+
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return 0;
+    }
+    int W = base->width;
+    int w = u_max - u_min + 1;     /* 領域の幅 */
+    if (w <= 0 || w > W || v_max < v_min) {
+        fprintf(stderr, "エラー: 比較領域が不正です\n");
+        return 0;
+    }
+
+    /* シフト s の参照画素 u - s は u_min - (W-1) 〜 u_max の範囲なので
+     * その区間を長さ L = W + w - 1 の列 r_ext として取り出すと、
+     *   C(s) = Σ_j b[j] r_ext[j + (W-1-s)]
+     * という循環のない相関になる
+     */
+    int L = W + w - 1;
+    int n = fft_size_pow2(L);
+    int offset = u_min - (W - 1);
+
+    double *b = (double*)calloc(n, sizeof(double));
+    double *r_ext = (double*)calloc(n, sizeof(double));
+    double *q_ext = (double*)calloc(L + 1, sizeof(double));  /* Σ_v r_ext² の累積和用 */
+    Complex *work = (Complex*)malloc(n * sizeof(Complex));
+    Complex *B = (Complex*)malloc(n * sizeof(Complex));
+    Complex *R = (Complex*)malloc(n * sizeof(Complex));
+    Complex *acc = (Complex*)calloc(n, sizeof(Complex));
+    curve->E = (double*)malloc(W * sizeof(double));
+    if (!b || !r_ext || !q_ext || !work || !B || !R || !acc || !curve->E) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        free(b); free(r_ext); free(q_ext); free(work); free(B); free(R); free(acc);
+        yaw_curve_free(curve);
+        return 0;
+    }
+
+    double sum_b2 = 0.0;
+    for (int v = v_min; v <= v_max; v++) {
+        for (int j = 0; j < w; j++) {
+            b[j] = gray_get(base, u_min + j, v);
+            sum_b2 += b[j] * b[j];
+        }
+        for (int m = 0; m < L; m++) {
+            r_ext[m] = gray_get(ref, offset + m, v);
+            q_ext[m + 1] += r_ext[m] * r_ext[m];
+        }
+
+        /* 相関のスペクトル conj(B) R を全行で足し合わせる */
+        fft_real_pair(r_ext, b, n, work, R, B);
+        for (int k = 0; k < n; k++) {
+            acc[k].re += B[k].re * R[k].re + B[k].im * R[k].im;
+            acc[k].im += B[k].re * R[k].im - B[k].im * R[k].re;
+        }
+    }
+    fft_complex(acc, n, 1);
+
+    /* 累積和 */
+    for (int m = 0; m < L; m++) {
+        q_ext[m + 1] += q_ext[m];
+    }
+
+    /* 2N E(s) = Σ b² + Q(s) - 2 C(s) */
+    long N = (long)w * (v_max - v_min + 1);
+    int best = 0;
+    for (int s = 0; s < W; s++) {
+        int k = W - 1 - s;
+        double C = acc[k].re;
+        double Q = q_ext[k + w] - q_ext[k];
+        double E = (sum_b2 + Q - 2.0 * C) / (2.0 * N);
+        curve->E[s] = (E > 0.0) ? E : 0.0;   /* 丸め誤差で負にならないように */
+        if (curve->E[s] < curve->E[best]) {
+            best = s;
+        }
+    }
+
+    /* 前後3点の放物線でサブピクセル補正 */
+    double E_minus = curve->E[(best - 1 + W) % W];
+    double E_zero = curve->E[best];
+    double E_plus = curve->E[(best + 1) % W];
+    double denom = E_minus - 2.0 * E_zero + E_plus;
+    double delta = (denom > 0.0) ? 0.5 * (E_minus - E_plus) / denom : 0.0;
+
+    curve->width = W;
+    curve->best_shift = best;
+    curve->best_E = E_zero;
+    curve->best_psi_deg = yaw_shift_to_deg(best, W) + 360.0 * delta / W;
+
+    free(b);
+    free(r_ext);
+    free(q_ext);
+    free(work);
+    free(B);
+    free(R);
+    free(acc);
+    return 1;
+}
+
+int yaw_curve_save_csv(const YawCurve *curve, const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        fprintf(stderr, "エラー: 出力ファイルが開けません: %s\n", filename);
+        return 0;
+    }
+
+    int W = curve->width;
+    fprintf(fp, "angle_deg,objective_function\n");
+    for (int i = 0; i < W; i++) {
+        int s = (W / 2 + 1 + i) % W;   /* -180° の次から 180° まで */
+        fprintf(fp, "%.6f,%.6f\n", yaw_shift_to_deg(s, W), curve->E[s]);
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+void yaw_curve_free(YawCurve *curve) {
+    free(curve->E);
+    curve->E = NULL;
+}
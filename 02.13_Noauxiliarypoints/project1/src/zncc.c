@@ -0,0 +1,179 @@
+/* zncc.c
+ * 零平均正規化相互相関（ZNCC）による目的関数の実装
+ */
+
+#include "zncc.h"
+#include "yaw_window.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+ZnccContext* zncc_context_create(Image *base, Image *ref, Region region) {
+    if (base->width != ref->width || base->height != ref->height) {
+        fprintf(stderr, "エラー: 基準画像と参照画像のサイズが異なります\n");
+        return NULL;
+    }
+    int W = ref->width;
+    int w = region.u_max - region.u_min + 1;
+    int rows = region.v_max - region.v_min + 1;
+    if (w <= 0 || rows <= 0 || w > W || region.v_min < 0 || region.v_max >= ref->height) {
+        fprintf(stderr, "エラー: ZNCC の比較領域が不正です\n");
+        return NULL;
+    }
+
+    ZnccContext *ctx = (ZnccContext*)calloc(1, sizeof(ZnccContext));
+    if (!ctx) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return NULL;
+    }
+    ctx->width = W;
+    ctx->height = ref->height;
+    ctx->region = region;
+    ctx->region_width = w;
+    ctx->rows = rows;
+    ctx->count = w * rows;
+    ctx->ext_width = W + w + 1;
+
+    int L = ctx->ext_width;
+    ctx->base_zm = (double*)malloc((size_t)ctx->count * sizeof(double));
+    ctx->ref_ext = (double*)malloc((size_t)rows * L * sizeof(double));
+    ctx->sum_S = (double*)calloc((size_t)L + 1, sizeof(double));
+    ctx->sum_S2 = (double*)calloc((size_t)L + 1, sizeof(double));
+    ctx->sum_SS = (double*)calloc((size_t)L + 1, sizeof(double));
+    if (!ctx->base_zm || !ctx->ref_ext || !ctx->sum_S || !ctx->sum_S2 || !ctx->sum_SS) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        zncc_context_free(ctx);
+        return NULL;
+    }
+
+    /* 基準画像の Sb - mb と Σ (Sb - mb)² */
+    double mean = 0.0;
+    for (int r = 0; r < rows; r++) {
+        for (int j = 0; j < w; j++) {
+            double Sb = pixel_gray(base, region.u_min + j, region.v_min + r);
+            ctx->base_zm[(size_t)r * w + j] = Sb;
+            mean += Sb;
+        }
+    }
+    mean /= ctx->count;
+    double var = 0.0;
+    for (int i = 0; i < ctx->count; i++) {
+        ctx->base_zm[i] -= mean;
+        var += ctx->base_zm[i] * ctx->base_zm[i];
+    }
+    ctx->base_var = var;
+
+    /* 参照画像の行を周期的に延長し、列ごとの和の累積を作る */
+    for (int r = 0; r < rows; r++) {
+        double *ext = ctx->ref_ext + (size_t)r * L;
+        for (int x = 0; x < L; x++) {
+            ext[x] = pixel_gray(ref, x, region.v_min + r);
+        }
+    }
+    for (int x = 0; x < L; x++) {
+        double col_S = 0.0, col_S2 = 0.0, col_SS = 0.0;
+        for (int r = 0; r < rows; r++) {
+            const double *ext = ctx->ref_ext + (size_t)r * L;
+            col_S += ext[x];
+            col_S2 += ext[x] * ext[x];
+            if (x + 1 < L) col_SS += ext[x] * ext[x + 1];
+        }
+        ctx->sum_S[x + 1] = ctx->sum_S[x] + col_S;
+        ctx->sum_S2[x + 1] = ctx->sum_S2[x] + col_S2;
+        ctx->sum_SS[x + 1] = ctx->sum_SS[x] + col_SS;
+    }
+
+    return ctx;
+}
+
+void zncc_context_free(ZnccContext *ctx) {
+    if (ctx) {
+        free(ctx->base_zm);
+        free(ctx->ref_ext);
+        free(ctx->sum_S);
+        free(ctx->sum_S2);
+        free(ctx->sum_SS);
+        free(ctx);
+    }
+}
+
+/* 角度 ψ での ρ と s での1階・2階の微分（want_deriv = 0 なら ρ だけ） */
+static double zncc_rho(const ZnccContext *ctx, double psi_deg, int want_deriv,
+                       double *rho_s, double *rho_ss) {
+    int x0;
+    double f;
+    yaw_window(psi_deg, ctx->width, ctx->region.u_min, &x0, &f);
+
+    /* 相互相関の項（角度ごとに走査するのはここだけ） */
+    int w = ctx->region_width;
+    int L = ctx->ext_width;
+    double cA = 0.0, cB = 0.0;
+    for (int r = 0; r < ctx->rows; r++) {
+        const double *b = ctx->base_zm + (size_t)r * w;
+        const double *a = ctx->ref_ext + (size_t)r * L + x0;
+        for (int j = 0; j < w; j++) {
+            cA += b[j] * a[j];
+            cB += b[j] * a[j + 1];
+        }
+    }
+
+    /* 窓 A = 列 [x0, x0 + w)、B = 列 [x0 + 1, x0 + w + 1) の和（積分画像） */
+    double N = (double)ctx->count;
+    double SA = ctx->sum_S[x0 + w] - ctx->sum_S[x0];
+    double SB = ctx->sum_S[x0 + w + 1] - ctx->sum_S[x0 + 1];
+    double QA = ctx->sum_S2[x0 + w] - ctx->sum_S2[x0];
+    double QB = ctx->sum_S2[x0 + w + 1] - ctx->sum_S2[x0 + 1];
+    double X = ctx->sum_SS[x0 + w] - ctx->sum_SS[x0];
+
+    double g = 1.0 - f;
+    double sum_r = g * SA + f * SB;
+    double sum_r2 = g * g * QA + 2.0 * f * g * X + f * f * QB;
+    double V = sum_r2 - sum_r * sum_r / N;
+    double C = g * cA + f * cB;
+
+    if (rho_s) *rho_s = 0.0;
+    if (rho_ss) *rho_ss = 0.0;
+    if (V <= 0.0 || ctx->base_var <= 0.0) {
+        return 0.0;
+    }
+    double D = sqrt(ctx->base_var * V);
+    double rho = C / D;
+    if (!want_deriv) {
+        return rho;
+    }
+
+    double C_s = cB - cA;
+    double sum_r_s = SB - SA;
+    double sum_r2_s = -2.0 * g * QA + 2.0 * (1.0 - 2.0 * f) * X + 2.0 * f * QB;
+    double sum_r2_ss = 2.0 * QA - 4.0 * X + 2.0 * QB;
+    double V_s = sum_r2_s - 2.0 * sum_r * sum_r_s / N;
+    double V_ss = sum_r2_ss - 2.0 * sum_r_s * sum_r_s / N;
+
+    double d1 = C_s / D - rho * V_s / (2.0 * V);
+    double d2 = -C_s * V_s / (2.0 * V * D) - d1 * V_s / (2.0 * V)
+              - rho * (V_ss / (2.0 * V) - V_s * V_s / (2.0 * V * V));
+    *rho_s = d1;
+    *rho_ss = d2;
+    return rho;
+}
+
+double zncc_objective(const ZnccContext *ctx, double psi_deg) {
+    return 1.0 - zncc_rho(ctx, psi_deg, 0, NULL, NULL);
+}
+
+void zncc_objective_terms(const ZnccContext *ctx, double psi_deg,
+                          ObjectiveTerms *terms) {
+    double rho_s, rho_ss;
+    double rho = zncc_rho(ctx, psi_deg, 1, &rho_s, &rho_ss);
+
+    /* ds/dψ = -W/2π（ラジアン当たり）、E = 1 - ρ */
+    double ds_dpsi = -(double)ctx->width / (2.0 * M_PI);
+    terms->E = 1.0 - rho;
+    terms->gradient = -rho_s * ds_dpsi;
+    terms->hessian = -rho_ss * ds_dpsi * ds_dpsi;
+    terms->count = ctx->count;
+}
@@ -0,0 +1,245 @@
+/* test_projection.c
+ * projection.cの動作確認
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "projection.h"
+#include "foveated.h"
+#include "rotation.h"
+#include "coord_transform.h"
+#include "y_rotation.h"
+#include "vector_math.h"
+#include "image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int main(void) {
+    printf("===== 投影モデルのテスト =====\n\n");
+
+    /* ===== テスト1: 往復変換 ===== */
+    printf("【テスト1】往復変換 (u, v) → X → (u, v)\n");
+    double test_points[3][2] = {{400.0, 300.0}, {250.5, 410.25}, {520.0, 180.0}};
+
+    /* dual_fisheye はキャリブレーションが必要なのでテスト5で確認 */
+    for (int t = 0; t < PROJ_DUAL_FISHEYE; t++) {
+        ProjectionParams p = projection_init((ProjectionType)t, 800, 600, 120.0);
+        if (t == PROJ_CUBE_FACE || t == PROJ_EQUIRECT) {
+            p = projection_init((ProjectionType)t, 600, 600, 90.0);
+        }
+
+        double max_err = 0.0;
+        int valid = 0;
+        for (int i = 0; i < 3; i++) {
+            Vector3D X;
+            double u, v;
+            if (!projection_to_world(&p, test_points[i][0], test_points[i][1], &X)) {
+                continue;
+            }
+            if (!projection_from_world(&p, X, &u, &v)) {
+                continue;
+            }
+            valid++;
+            max_err = fmax(max_err, fabs(u - test_points[i][0]));
+            max_err = fmax(max_err, fabs(v - test_points[i][1]));
+        }
+        printf("  %-14s 有効 %d/3, 最大誤差 %.2e (0に近いはず)\n",
+               projection_name((ProjectionType)t), valid, max_err);
+    }
+
+    /* ===== テスト2: 画像中心は光軸方向 ===== */
+    printf("\n【テスト2】画像中心 → 光軸 (0, 0, 1)\n");
+    for (int t = PROJ_RECTILINEAR; t < PROJ_DUAL_FISHEYE; t++) {
+        ProjectionParams p = projection_init((ProjectionType)t, 800, 600, 100.0);
+        Vector3D X;
+        projection_to_world(&p, 400.0, 300.0, &X);
+        printf("  %-14s (%.6f, %.6f, %.6f)\n",
+               projection_name((ProjectionType)t), X.x, X.y, X.z);
+    }
+
+    /* ===== テスト3: equirect → equirect は従来の生成と一致 ===== */
+    printf("\n【テスト3】equirect → equirect の描画と従来方法の比較\n");
+    int W = 360;
+    int H = 180;
+    Image *input = image_create(W, H, 3);
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            uint8_t rgb[3];
+            rgb[0] = (uint8_t)(127.5 + 127.0 * sin(2.0 * M_PI * 2.0 * u / W));
+            rgb[1] = (uint8_t)(127.5 + 127.0 * cos(2.0 * M_PI * v / H));
+            rgb[2] = 128;
+            set_pixel(input, u, v, rgb);
+        }
+    }
+
+    Matrix3x3 R = compute_rotation_matrix(image_to_world(90, 70, W, H));
+    Matrix3x3 R_T = matrix_transpose(R);
+
+    ProjectionParams eq = projection_init(PROJ_EQUIRECT, W, H, 360.0);
+    Image *out = image_create(W, H, 3);
+    projection_render(input, &eq, out, &eq, R_T, INTERP_BILINEAR);
+
+    long total = 0;
+    int over = 0;
+    for (int v = 1; v < H - 1; v++) {
+        for (int u = 0; u < W; u++) {
+            Vector3D X = matrix_vector_multiply(R_T, image_to_world(u, v, W, H));
+            double u_in, v_in;
+            world_to_image(X, W, H, &u_in, &v_in);
+            uint8_t rgb[3], got[3];
+            get_pixel_bilinear(input, u_in, v_in, rgb);
+            get_pixel(out, u, v, got);
+            for (int c = 0; c < 3; c++) {
+                int d = abs((int)rgb[c] - (int)got[c]);
+                total += d;
+                if (d > 2) over++;
+            }
+        }
+    }
+    printf("  平均画素差: %.4f, 差>2の画素: %d (極付近の数画素のみのはず)\n",
+           (double)total / (W * (H - 2) * 3), over);
+
+    /* ===== テスト4: 1チャンネル・最近傍でも描画できる ===== */
+    printf("\n【テスト4】1チャンネル画像の描画\n");
+    Image *gray = image_create(W, H, 1);
+    Image *view = image_create(200, 200, 1);
+    ProjectionParams rect = projection_init(PROJ_RECTILINEAR, 200, 200, 90.0);
+    int ok = projection_render(gray, &eq, view, &rect, R_T, INTERP_NEAREST);
+    printf("  結果: %s\n", ok ? "成功" : "失敗");
+
+    /* ===== テスト5: デュアル魚眼から直接サンプリング ===== */
+    printf("\n【テスト5】デュアル魚眼フレームからの直接描画\n");
+    DualFisheyeCalib calib;
+    dual_fisheye_default(W, H, 190.0, &calib);
+    ProjectionParams df = projection_init_dual_fisheye(W, H, &calib);
+
+    /* 全方位画像からデュアル魚眼フレームを合成 */
+    Image *frame = image_create(W, H, 3);
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            Vector3D X;
+            if (!projection_to_world(&df, u, v, &X)) continue;
+            double u_in, v_in;
+            world_to_image(X, W, H, &u_in, &v_in);
+            uint8_t rgb[3];
+            get_pixel_bilinear(input, u_in, v_in, rgb);
+            set_pixel(frame, u, v, rgb);
+        }
+    }
+
+    /* 魚眼フレーム → 注視画像 と 全方位画像 → 注視画像 を比較 */
+    Image *from_fisheye = image_create(W, H, 3);
+    projection_render(frame, &df, from_fisheye, &eq, R_T, INTERP_BILINEAR);
+
+    total = 0;
+    for (int i = 0; i < W * H * 3; i++) {
+        total += abs((int)from_fisheye->data[i] - (int)out->data[i]);
+    }
+    printf("  平均画素差: %.4f (補間2回分の小さな差のはず)\n",
+           (double)total / (W * H * 3));
+
+    /* ===== テスト6: 中心窩描画 ===== */
+    printf("\n【テスト6】中心窩描画（半径 20°）と全密度の描画の比較\n");
+    ProjectionParams fov_outs[2] = {
+        projection_init(PROJ_RECTILINEAR, 400, 300, 120.0),
+        projection_init(PROJ_EQUIRECT, W, H, 360.0)
+    };
+    FoveationParams fov = foveation_default(20.0);
+    double z_inner = cos(20.0 * M_PI / 180.0);
+    for (int k = 0; k < 2; k++) {
+        const ProjectionParams *op = &fov_outs[k];
+        Image *full = image_create(op->width, op->height, 3);
+        Image *fovea = image_create(op->width, op->height, 3);
+        FoveationPlan *plan = foveation_plan_create(op, &fov);
+        FoveationStats stats;
+        projection_render(input, &eq, full, op, R_T, INTERP_BILINEAR);
+        int fov_ok = plan && foveated_render_plan(input, &eq, fovea, op, R_T, plan, &stats);
+
+        /* 画素ごとのレベル分け（ブロックごとの分類と一致するはず）と
+         * レベル0の画素の一致 */
+        long inner = 0, differ = 0, level_err = 0;
+        for (int v = 0; fov_ok && v < op->height; v++) {
+            for (int u = 0; u < op->width; u++) {
+                Vector3D X;
+                int valid = projection_to_world(op, u, v, &X);
+                int level0 = valid && X.z >= z_inner;
+                if (level0 != (plan->level[(size_t)v * op->width + u] == 0)) level_err++;
+                if (!level0) continue;
+                inner++;
+                size_t i = ((size_t)v * op->width + u) * 3;
+                for (int c = 0; c < 3; c++) {
+                    if (full->data[i + c] != fovea->data[i + c]) {
+                        differ++;
+                        break;
+                    }
+                }
+            }
+        }
+        printf("  %-12s 中心部 %ld 画素: 不一致 %ld, レベル分けの誤り %ld (どちらも0のはず), "
+               "サンプリング %.1f%% 削減, 投影 %ld 回\n",
+               projection_name(op->type), inner, differ, level_err,
+               fov_ok ? 100.0 * stats.saved_ratio : 0.0, plan ? plan->projections : 0L);
+        foveation_plan_free(plan);
+        image_free(fovea);
+        image_free(full);
+    }
+
+    /* ===== テスト7: 入力タイル順の一括描画 ===== */
+    printf("\n【テスト7】入力タイル順の一括描画と個別の描画の比較\n");
+    ProjectionParams rect_in = projection_init(PROJ_RECTILINEAR, W, H, 120.0);
+    struct {
+        const char *name;
+        Image *img;
+        const ProjectionParams *p;
+        Interpolation interp;
+    } bin_cases[3] = {
+        {"equirect", input, &eq, INTERP_BILINEAR},
+        {"rectilinear", out, &rect_in, INTERP_NEAREST},
+        {"dual_fisheye", frame, &df, INTERP_BILINEAR}
+    };
+    ProjectionParams bin_out = projection_init(PROJ_RECTILINEAR, 120, 90, 100.0);
+    Matrix3x3 bin_R[3] = {
+        R_T,
+        matrix_multiply(create_y_rotation_matrix(15.0), R_T),
+        create_pitch_roll_matrix(30.0, 10.0)
+    };
+    for (int i = 0; i < 3; i++) {
+        Image *separate[3], *binned[3];
+        for (int k = 0; k < 3; k++) {
+            separate[k] = image_create(bin_out.width, bin_out.height, 3);
+            binned[k] = image_create(bin_out.width, bin_out.height, 3);
+            projection_render(bin_cases[i].img, bin_cases[i].p, separate[k], &bin_out,
+                              bin_R[k], bin_cases[i].interp);
+        }
+        /* 小さなタイルとバッチで複数のバッチに分かれるようにする */
+        ProjectionBinStats bin_stats = {0, 0};
+        int bin_ok = projection_render_views_binned(bin_cases[i].img, bin_cases[i].p, binned,
+                                                    &bin_out, bin_R, 3, bin_cases[i].interp,
+                                                    16, 4000, &bin_stats);
+        long differ = 0;
+        for (int k = 0; k < 3; k++) {
+            for (int j = 0; j < bin_out.width * bin_out.height * 3; j++) {
+                if (separate[k]->data[j] != binned[k]->data[j]) differ++;
+            }
+            image_free(separate[k]);
+            image_free(binned[k]);
+        }
+        printf("  %-12s %s: 不一致 %ld (0のはず), バッチ %d, タイル %ld\n",
+               bin_cases[i].name, bin_ok ? "成功" : "失敗", differ,
+               bin_stats.batches, bin_stats.tile_visits);
+    }
+
+    image_free(from_fisheye);
+    image_free(frame);
+    image_free(view);
+    image_free(gray);
+    image_free(out);
+    image_free(input);
+
+    printf("\n===== テスト完了 =====\n");
+
+    return 0;
+}
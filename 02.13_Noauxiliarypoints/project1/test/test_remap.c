@@ -0,0 +1,143 @@
+/* test_remap.c
+ * remap.cの動作確認
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "remap.h"
+#include "rotation.h"
+#include "y_rotation.h"
+#include "coord_transform.h"
+#include "vector_math.h"
+#include "image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* テスト用の全方位画像（滑らかな模様） */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            uint8_t rgb[3];
+            rgb[0] = (uint8_t)(127.5 + 127.0 * sin(2.0 * M_PI * 3.0 * u / W));
+            rgb[1] = (uint8_t)(127.5 + 127.0 * cos(2.0 * M_PI * 2.0 * v / H));
+            rgb[2] = (uint8_t)(127.5 + 127.0 * sin(2.0 * M_PI * (u + 2.0 * v) / W));
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+/* 従来の方法（画素ごとに X = R^T X'）で注視画像を生成 */
+static Image* render_direct(Image *input, Matrix3x3 R) {
+    int W = input->width;
+    int H = input->height;
+    Matrix3x3 R_T = matrix_transpose(R);
+    Image *output = image_create_like(input);
+
+    for (int v_out = 0; v_out < H; v_out++) {
+        for (int u_out = 0; u_out < W; u_out++) {
+            Vector3D X_prime = image_to_world(u_out, v_out, W, H);
+            Vector3D X = matrix_vector_multiply(R_T, X_prime);
+            double u_in, v_in;
+            world_to_image(X, W, H, &u_in, &v_in);
+            uint8_t rgb[3];
+            get_pixel_bilinear(input, u_in, v_in, rgb);
+            set_pixel(output, u_out, v_out, rgb);
+        }
+    }
+    return output;
+}
+
+/* 2画像の画素差（平均値と、差が2を超える画素の数）
+ * 極の画素は経度が不定なので数画素の不一致は許容する
+ */
+static int count_abs_diff(Image *a, Image *b, double *mean_diff) {
+    int over = 0;
+    long total = 0;
+    int n = a->width * a->height * a->channels;
+    for (int i = 0; i < n; i++) {
+        int d = abs((int)a->data[i] - (int)b->data[i]);
+        total += d;
+        if (d > 2) over++;
+    }
+    *mean_diff = (double)total / n;
+    return over;
+}
+
+int main(void) {
+    printf("===== リマップテーブルのテスト =====\n\n");
+
+    int W = 720;
+    int H = 360;
+    Image *input = create_test_image(W, H);
+
+    /* ===== テスト1: 回転の分解 ===== */
+    printf("【テスト1】回転の分解 R = R_pr × R(Y)(yaw)\n");
+    Vector3D G = image_to_world(100, 120, W, H);
+    Matrix3x3 R = compute_rotation_matrix(G);
+
+    double yaw, pitch, roll;
+    rotation_decompose_yaw(R, &yaw, &pitch, &roll);
+    printf("yaw = %.6f°, pitch = %.6f°, roll = %.6f°\n", yaw, pitch, roll);
+
+    Matrix3x3 R_back = matrix_multiply(create_pitch_roll_matrix(pitch, roll),
+                                       create_y_rotation_matrix(yaw));
+    double err = 0.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            err = fmax(err, fabs(R.m[i][j] - R_back.m[i][j]));
+        }
+    }
+    printf("再構成誤差: %.2e (0に近いはず)\n", err);
+    printf("注視点の回転ではロール≈0になるはず\n\n");
+
+    /* ===== テスト2: 従来方法との比較 ===== */
+    printf("【テスト2】従来方法（画素ごとの回転）との比較\n");
+    RemapTable *table = remap_table_create(W, H, W, H, pitch, roll);
+    Image *out_table = image_create_like(input);
+    remap_table_apply(table, input, yaw, out_table);
+
+    Image *out_direct = render_direct(input, R);
+    double mean_diff;
+    int over = count_abs_diff(out_table, out_direct, &mean_diff);
+    printf("平均画素差: %.4f, 差>2の画素: %d (極付近の数画素のみのはず)\n\n",
+           mean_diff, over);
+
+    /* ===== テスト3: 同じ水平線上の注視点でテーブルを再利用 ===== */
+    printf("【テスト3】同じ水平線上の注視点でのキャッシュ再利用\n");
+    RemapCache *cache = remap_cache_create();
+    int u_list[4] = {100, 250, 400, 650};
+    int worst_over = 0;
+    double worst_mean = 0.0;
+    for (int i = 0; i < 4; i++) {
+        Matrix3x3 Ri = compute_rotation_matrix(image_to_world(u_list[i], 120, W, H));
+        double yi, pi, ri;
+        rotation_decompose_yaw(Ri, &yi, &pi, &ri);
+
+        RemapTable *t = remap_cache_get(cache, W, H, W, H, pi, ri);
+        remap_table_apply(t, input, yi, out_table);
+
+        image_free(out_direct);
+        out_direct = render_direct(input, Ri);
+        over = count_abs_diff(out_table, out_direct, &mean_diff);
+        if (over > worst_over) worst_over = over;
+        if (mean_diff > worst_mean) worst_mean = mean_diff;
+    }
+    printf("キャッシュ: ヒット %d 回, 作成 %d 回 (期待値: ヒット3, 作成1)\n",
+           cache->hits, cache->misses);
+    printf("平均画素差(最大): %.4f, 差>2の画素(最大): %d\n", worst_mean, worst_over);
+
+    remap_cache_free(cache);
+    remap_table_free(table);
+    image_free(out_table);
+    image_free(out_direct);
+    image_free(input);
+
+    printf("\n===== テスト完了 =====\n");
+
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <math.h>
 #include "rotation.h"
+#include "y_rotation.h"
 #include "coord_transform.h"
 #include "vector_math.h"
 
@@ -83,6 +84,26 @@ int main(void) {
     rotation_matrix_info(R_pole);
     rotation_matrix_verify(R_pole);
 
+    /* ===== テスト5: 回転ベクトル（軸・角度表現） ===== */
+    printf("\n\n=====================================\n\n");
+    printf("【テスト5】回転ベクトルからの回転行列\n\n");
+
+    /* ω = -ψ ey は R(Y)(ψ) と一致する */
+    double psi_deg = 25.0;
+    Vector3D omega = vector_create(0.0, -psi_deg * M_PI / 180.0, 0.0);
+    Matrix3x3 R_axis = create_axis_angle_matrix(omega);
+    Matrix3x3 R_y = create_y_rotation_matrix(psi_deg);
+    double max_diff = 0.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            max_diff = fmax(max_diff, fabs(R_axis.m[i][j] - R_y.m[i][j]));
+        }
+    }
+    printf("ω = (0, -25°, 0) と R(Y)(25°) の最大差: %.2e (0に近いはず)\n", max_diff);
+
+    Matrix3x3 R_general = create_axis_angle_matrix(vector_create(0.3, -0.2, 0.5));
+    rotation_matrix_verify(R_general);
+
     printf("\n===== テスト完了 =====\n");
 
     return 0;
@@ -0,0 +1,495 @@
+/* test_yaw_search.c
+ * fft.c と yaw_search.c の動作確認
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fft.h"
+#include "yaw_search.h"
+#include "yaw_estimator.h"
+#include "y_rotation.h"
+#include "image_utils.h"
+#include "objective_cache.h"
+#include "sweep.h"
+#include "pixel_selection.h"
+#include "rotation_registration.h"
+#include "rotation.h"
+#include "tracking.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int main(void) {
+    printf("===== ヨー角の全探索のテスト =====\n\n");
+
+    /* ===== テスト1: FFTと直接計算したDFTの比較 ===== */
+    printf("【テスト1】FFT と DFT の比較（n = 16）\n");
+    int n = 16;
+    double a[16], b[16];
+    for (int i = 0; i < n; i++) {
+        a[i] = sin(0.7 * i) + 0.1 * i;
+        b[i] = cos(1.3 * i) - 0.05 * i * i;
+    }
+    Complex work[16], A[16], B[16];
+    fft_real_pair(a, b, n, work, A, B);
+
+    double max_err = 0.0;
+    for (int k = 0; k < n; k++) {
+        double re_a = 0.0, im_a = 0.0, re_b = 0.0, im_b = 0.0;
+        for (int i = 0; i < n; i++) {
+            double angle = -2.0 * M_PI * k * i / n;
+            re_a += a[i] * cos(angle);
+            im_a += a[i] * sin(angle);
+            re_b += b[i] * cos(angle);
+            im_b += b[i] * sin(angle);
+        }
+        max_err = fmax(max_err, fabs(A[k].re - re_a) + fabs(A[k].im - im_a));
+        max_err = fmax(max_err, fabs(B[k].re - re_b) + fabs(B[k].im - im_b));
+    }
+    fft_complex(A, n, 1);
+    for (int i = 0; i < n; i++) {
+        max_err = fmax(max_err, fabs(A[i].re - a[i]) + fabs(A[i].im));
+    }
+    printf("  最大誤差: %.2e (0に近いはず)\n", max_err);
+
+    /* ===== テスト2: 目的関数が直接計算と一致 ===== */
+    printf("\n【テスト2】整数シフトでの目的関数と compute_objective_function() の比較\n");
+    int W = 720;
+    int H = 360;
+    Image *base = image_create(W, H, 3);
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            uint8_t rgb[3];
+            double t = 2.0 * M_PI * u / W;
+            rgb[0] = (uint8_t)(127.5 + 120.0 * sin(3.0 * t + 0.02 * v));
+            rgb[1] = (uint8_t)(127.5 + 100.0 * cos(7.0 * t) * sin(0.05 * v));
+            rgb[2] = (uint8_t)(127.5 + 60.0 * sin(11.0 * t + 1.0));
+            set_pixel(base, u, v, rgb);
+        }
+    }
+    Image *ref = rotate_image_y_axis(base, 12.5);
+
+    int u_min = 300, v_min = 150, u_max = 419, v_max = 209;
+    GrayImage *gray_base = gray_image_from_image(base);
+    GrayImage *gray_ref = gray_image_from_image(ref);
+    YawCurve curve;
+    yaw_search_fft(gray_base, gray_ref, u_min, v_min, u_max, v_max, &curve);
+
+    int shifts[4] = {0, 10, 25, W - 40};
+    for (int i = 0; i < 4; i++) {
+        double psi = yaw_shift_to_deg(shifts[i], W);
+        double E_direct = compute_objective_function(base, ref, psi,
+                                                     u_min, v_min, u_max, v_max);
+        printf("  ψ = %7.2f°: FFT %.4f, 直接 %.4f (一致するはず)\n",
+               psi, curve.E[shifts[i]], E_direct);
+    }
+
+    /* ===== テスト3: 回転角度の推定 ===== */
+    printf("\n【テスト3】回転角度の推定（正解 12.5°）\n");
+    printf("  最小のシフト: %d (%.2f°)\n",
+           curve.best_shift, yaw_shift_to_deg(curve.best_shift, W));
+    printf("  サブピクセル補正後: %.4f°\n", curve.best_psi_deg);
+
+    /* ===== テスト4: ガウス・ニュートン法 ===== */
+    printf("\n【テスト4】ガウス・ニュートン法による推定（正解 12.5°）\n");
+    Region region = {u_min, v_min, u_max, v_max};
+    double inits[2] = {11.0, 14.5};
+    for (int i = 0; i < 2; i++) {
+        YawEstimate est;
+        estimate_y_rotation(base, ref, region, inits[i], NULL, &est);
+        printf("  初期値 %.1f° → %.4f° (%s, 反復 %d 回, 走査 %d 回)\n",
+               inits[i], est.psi_deg, yaw_status_name(est.status),
+               est.iterations, est.passes);
+    }
+
+    /* フォールバック: ガウス・ニュートン法を使わずブレント法のみ */
+    YawEstimatorOptions opt = yaw_estimator_default_options();
+    opt.max_iterations = 0;
+    YawEstimate est;
+    estimate_y_rotation(base, ref, region, 11.0, &opt, &est);
+    printf("  ブレント法のみ: %.4f° (%s, 走査 %d 回)\n",
+           est.psi_deg, yaw_status_name(est.status), est.passes);
+
+    /* ===== テスト5: 補間面の微分による理論微分 ===== */
+    printf("\n【テスト5】理論微分と中心差分（Δψ = 0.1°, 0.001°）の比較\n");
+    /* 10°, 12.5°, 14° は画素の境界（W = 720 で整数のずれ）なので、
+     * 補間面の傾きが変わらない 0.05° 先で比べる */
+    double psis[3] = {10.05, 12.55, 14.05};
+    for (int i = 0; i < 3; i++) {
+        ObjectiveTerms t;
+        compute_objective_terms(base, ref, psis[i], u_min, v_min, u_max, v_max, &t);
+        double hs[2] = {0.1, 0.001};
+        double central[2];
+        for (int j = 0; j < 2; j++) {
+            central[j] =
+                (compute_objective_function(base, ref, psis[i] + hs[j], u_min, v_min, u_max, v_max) -
+                 compute_objective_function(base, ref, psis[i] - hs[j], u_min, v_min, u_max, v_max)) /
+                (2.0 * hs[j] * M_PI / 180.0);
+        }
+        printf("  ψ = %5.2f°: E %.4f (compute_objective_function %.4f), dE/dψ %10.3f, 中心差分 %10.3f / %10.3f\n",
+               psis[i], t.E,
+               compute_objective_function(base, ref, psis[i], u_min, v_min, u_max, v_max),
+               t.gradient, central[0], central[1]);
+    }
+    printf("  (E は同じ補間面、Δψ = 0.001° の中心差分は理論微分と一致するはず)\n");
+
+    /* ===== テスト6: 逆合成法 ===== */
+    printf("\n【テスト6】逆合成法による推定（正解 12.5°）\n");
+    YawTemplate *tmpl = yaw_template_create(base, region);
+    ObjectiveTerms t_ic;
+    compute_objective_terms_ic(tmpl, ref, 14.0, &t_ic);
+    printf("  ψ = 14.00° の E: %.4f (compute_objective_function: %.4f)\n", t_ic.E,
+           compute_objective_function(base, ref, 14.0, u_min, v_min, u_max, v_max));
+    for (int i = 0; i < 2; i++) {
+        YawEstimate est_ic;
+        estimate_y_rotation_ic(tmpl, ref, inits[i], NULL, &est_ic);
+        printf("  初期値 %.1f° → %.4f° (%s, 反復 %d 回, 走査 %d 回)\n",
+               inits[i], est_ic.psi_deg, yaw_status_name(est_ic.status),
+               est_ic.iterations, est_ic.passes);
+    }
+    yaw_template_free(tmpl);
+
+    /* ===== テスト7: 目的関数のキャッシュ ===== */
+    printf("\n【テスト7】目的関数のキャッシュ（0.5° 刻みの掃引と数値微分）\n");
+    ObjectiveCache *cache = objective_cache_create(0);
+    ObjectivePair pair = {1, base, ref, region, NULL};
+    for (double psi = 10.0; psi <= 15.0 + 1e-9; psi += 0.5) {
+        cached_objective(cache, &pair, psi);
+    }
+    long sweep_misses = cache->misses;
+    double d_cached = cached_forward_derivative(cache, &pair, 12.0, 0.5);
+    double d_direct = compute_numerical_derivative(base, ref, 12.0, 0.5,
+                                                   u_min, v_min, u_max, v_max);
+    double d_central = cached_central_derivative(cache, &pair, 12.0, 0.5);
+    printf("  掃引: 走査 %ld 回（11 角度）\n", sweep_misses);
+    printf("  前進差分: キャッシュ %.6f, compute_numerical_derivative %.6f\n",
+           d_cached, d_direct);
+    printf("  中心差分: %.6f\n", d_central);
+    printf("  微分での追加の走査: %ld 回（0 のはず）, 命中 %ld 回\n",
+           cache->misses - sweep_misses, cache->hits);
+    objective_cache_free(cache);
+
+    /* ===== テスト8: 並列の掃引がスレッド数によらず一致 ===== */
+    printf("\n【テスト8】並列の掃引（スレッド数によらずビット単位で一致）\n");
+    double sweep_psis[24];
+    for (int i = 0; i < 24; i++) sweep_psis[i] = 10.0 + 0.25 * i;
+    ObjectiveTerms serial[24], parallel[24];
+    SweepOptions sopt = {1, 0};
+    sweep_objective_terms(base, ref, region, sweep_psis, 24, &sopt, serial);
+    SweepOptions variants[3] = {{4, 0}, {3, 1}, {7, 1}};
+    for (int k = 0; k < 3; k++) {
+        sweep_objective_terms(base, ref, region, sweep_psis, 24, &variants[k], parallel);
+        int same = 1;
+        for (int i = 0; i < 24; i++) {
+            same &= memcmp(&serial[i].E, &parallel[i].E, sizeof(double)) == 0 &&
+                    memcmp(&serial[i].gradient, &parallel[i].gradient, sizeof(double)) == 0 &&
+                    memcmp(&serial[i].hessian, &parallel[i].hessian, sizeof(double)) == 0;
+        }
+        printf("  スレッド %d, %s: %s\n", variants[k].threads,
+               variants[k].split_rows ? "角度 × 行" : "角度  ", same ? "一致" : "不一致");
+    }
+    ObjectiveTerms whole;
+    compute_objective_terms(base, ref, sweep_psis[10], u_min, v_min, u_max, v_max, &whole);
+    printf("  ψ = %.2f°: E %.10f (行ブロックの和) / %.10f (一括)\n",
+           sweep_psis[10], serial[10].E, whole.E);
+
+    /* ===== テスト9: 画素の間引き ===== */
+    printf("\n【テスト9】画素を間引いた逆合成法（20%%、正解 12.5°）\n");
+    YawTemplate *full = yaw_template_create(base, region);
+    PixelSelectMode modes[3] = {PIXEL_SELECT_TOP_K, PIXEL_SELECT_STRATIFIED, PIXEL_SELECT_RANDOM};
+    double hess_share[3] = {0.0, 0.0, 0.0};
+    int select_ok = 1;
+    for (int k = 0; k < 3; k++) {
+        PixelSelectOptions popt = pixel_select_default_options();
+        popt.mode = modes[k];
+        popt.fraction = 0.2;
+        YawTemplate *sub = yaw_template_select(full, &popt);
+        YawEstimate est_sub;
+        estimate_y_rotation_ic(sub, ref, 14.5, NULL, &est_sub);
+        /* 選んだ画素のヘッセ行列への寄与 Σ SD² の割合 */
+        hess_share[k] = (sub->hessian * sub->count) / (full->hessian * full->count);
+        printf("  %s: %d / %d 画素 → %.4f° (%s, 走査 %d 回, Σ SD² の %.1f%%)\n",
+               pixel_select_mode_name(modes[k]), sub->count, full->count,
+               est_sub.psi_deg, yaw_status_name(est_sub.status), est_sub.passes,
+               100.0 * hess_share[k]);
+        if (sub->count != 1440 || est_sub.status != YAW_CONVERGED ||
+            fabs(est_sub.psi_deg - 12.5) > 0.05) {
+            select_ok = 0;
+        }
+        yaw_template_free(sub);
+    }
+    /* 層別上位はセルの Σ|SD| で個数を配るので、画素数で配る層別無作為の
+     * 2倍以上の Σ SD² を残し、上位k は超えない */
+    if (hess_share[1] < 2.0 * hess_share[2] || hess_share[1] > hess_share[0]) select_ok = 0;
+    printf("  確認: 全て収束して誤差 0.05° 以内、Σ SD² は 上位k ≥ 層別上位 ≥ 2 × 層別無作為 (%s)\n",
+           select_ok ? "OK" : "NG");
+    yaw_template_free(full);
+
+    /* ===== テスト10: 粗密探索（初期値なしで大きな回転） ===== */
+    printf("\n【テスト10】ピラミッドによる粗密探索（初期値なし）\n");
+    double big_angles[2] = {12.5, -137.0};
+    for (int k = 0; k < 2; k++) {
+        Image *ref_big = (k == 0) ? ref : rotate_image_y_axis(base, big_angles[k]);
+        GrayImage *gray_big = (k == 0) ? gray_ref : gray_image_from_image(ref_big);
+        YawPyramidEstimate pyr;
+        estimate_y_rotation_pyramid(gray_base, gray_big, region, 3, NULL, &pyr);
+        printf("  正解 %7.2f°: 全周探索 %8.4f° → %8.4f° (%s, %d レベル, 走査 %d 回)\n",
+               big_angles[k], pyr.search_psi_deg, pyr.estimate.psi_deg,
+               yaw_status_name(pyr.estimate.status), pyr.levels, pyr.estimate.passes);
+        if (k != 0) {
+            gray_image_free(gray_big);
+            image_free(ref_big);
+        }
+    }
+
+    /* ===== テスト11: Y軸回り専用の閉じた形 ===== */
+    printf("\n【テスト11】閉じた形と一般の経路の比較\n");
+    double yaw_psis[4] = {-3.7, 10.0, 12.5, 200.25};
+    for (int i = 0; i < 4; i++) {
+        ObjectiveTerms t_gen, t_yaw;
+        compute_objective_terms(base, ref, yaw_psis[i], u_min, v_min, u_max, v_max, &t_gen);
+        compute_objective_terms_yaw(base, ref, yaw_psis[i], u_min, v_min, u_max, v_max, &t_yaw);
+        printf("  ψ = %7.2f°: E %.4f / %.4f, dE/dψ %10.3f / %10.3f\n",
+               yaw_psis[i], t_gen.E, t_yaw.E, t_gen.gradient, t_yaw.gradient);
+    }
+    printf("  E (compute_objective_function_yaw, 12.5°): %.4f\n",
+           compute_objective_function_yaw(base, ref, 12.5, u_min, v_min, u_max, v_max));
+    printf("  (E は一致、dE/dψ の差は画素の境界の ψ で左右どちらの傾きを取るかの差のみ)\n");
+
+    /* ===== テスト12: 打ち切り付きの最小値探索 ===== */
+    printf("\n【テスト12】打ち切り付きの最小値探索（41 角度、5°〜15°）\n");
+    double argmin_psis[41];
+    int brute_best = 0;
+    double brute_E[41];
+    for (int i = 0; i < 41; i++) {
+        argmin_psis[i] = 5.0 + 0.25 * i;
+        brute_E[i] = compute_objective_function_yaw(base, ref, argmin_psis[i],
+                                                    u_min, v_min, u_max, v_max);
+        if (brute_E[i] < brute_E[brute_best]) brute_best = i;
+    }
+    printf("  全て計算: ψ = %.2f°, E = %.6f\n", argmin_psis[brute_best], brute_E[brute_best]);
+    SweepOptions argmin_opts[2] = {{1, 0}, {4, 0}};
+    for (int k = 0; k < 2; k++) {
+        SweepMinimum minimum;
+        sweep_objective_argmin(base, ref, region, argmin_psis, 41, &argmin_opts[k], &minimum);
+        printf("  %d スレッド: ψ = %.2f°, E = %.6f (%s), 完了 %d, 打ち切り %d\n",
+               argmin_opts[k].threads, argmin_psis[minimum.index], minimum.E,
+               (minimum.index == brute_best && minimum.E == brute_E[brute_best])
+                   ? "一致" : "不一致",
+               minimum.completed, minimum.pruned);
+    }
+
+    /* ===== テスト13: ZNCC（露出の違い） ===== */
+    printf("\n【テスト13】ZNCC（参照画像の輝度 × 0.6 + 40、正解 12.5°）\n");
+    Image *exposed = image_create_like(ref);
+    size_t n_bytes = (size_t)ref->width * ref->height * ref->channels;
+    for (size_t i = 0; i < n_bytes; i++) {
+        exposed->data[i] = (uint8_t)(0.6 * ref->data[i] + 40.0);
+    }
+    ZnccContext *zncc = zncc_context_create(base, exposed, region);
+    YawEstimate est_ssd, est_zncc;
+    estimate_y_rotation(base, exposed, region, 14.5, NULL, &est_ssd);
+    estimate_y_rotation_zncc(zncc, 14.5, NULL, &est_zncc);
+    printf("  差の2乗: %.4f° (%s), ZNCC: %.4f° (%s, ρ = %.4f)\n",
+           est_ssd.psi_deg, yaw_status_name(est_ssd.status),
+           est_zncc.psi_deg, yaw_status_name(est_zncc.status), 1.0 - est_zncc.E);
+    ObjectiveTerms zt, zp, zm;
+    double zh = 1e-4;
+    zncc_objective_terms(zncc, 12.23, &zt);
+    zncc_objective_terms(zncc, 12.23 + zh, &zp);
+    zncc_objective_terms(zncc, 12.23 - zh, &zm);
+    printf("  dE/dψ (12.23°): 理論 %.5f, 中心差分 %.5f\n", zt.gradient,
+           (zp.E - zm.E) / (2.0 * zh * M_PI / 180.0));
+    zncc_context_free(zncc);
+
+    /* ===== テスト14: 相互情報量（単調でない輝度の変換） ===== */
+    printf("\n【テスト14】相互情報量（参照画像の輝度 |2S - 255|、正解 12.5°）\n");
+    for (size_t i = 0; i < n_bytes; i += 3) {
+        int S = (ref->data[i] + ref->data[i + 1] + ref->data[i + 2]) / 3;
+        exposed->data[i] = exposed->data[i + 1] = exposed->data[i + 2] = (uint8_t)abs(2 * S - 255);
+    }
+    MiContext *mi = mi_context_create(base, exposed, region, NULL);
+    int mi_best = 0;
+    double mi_E[41];
+    for (int i = 0; i < 41; i++) {
+        mi_E[i] = mi_objective(mi, argmin_psis[i]);
+        if (mi_E[i] < mi_E[mi_best]) mi_best = i;
+    }
+    YawEstimate est_mi;
+    estimate_y_rotation_mi(mi, argmin_psis[mi_best], NULL, &est_mi);
+    printf("  掃引の最小 %.2f° → %.4f° (%s, 走査 %d 回, MI = %.4f)\n",
+           argmin_psis[mi_best], est_mi.psi_deg, yaw_status_name(est_mi.status),
+           est_mi.passes, -est_mi.E);
+    ObjectiveTerms mt, mp, mm;
+    mi_objective_terms(mi, 12.23, &mt);
+    mi_objective_terms(mi, 12.23 + zh, &mp);
+    mi_objective_terms(mi, 12.23 - zh, &mm);
+    printf("  dE/dψ (12.23°): 理論 %.5f, 中心差分 %.5f\n", mt.gradient,
+           (mp.E - mm.E) / (2.0 * zh * M_PI / 180.0));
+    mi_context_free(mi);
+    image_free(exposed);
+
+    /* ===== テスト15: 球面上の等面積の標本点 ===== */
+    printf("\n【テスト15】フィボナッチ格子（赤道の球冠 40°）での位置合わせ（正解 12.5°）\n");
+    Vector3D cap_center = {0.0, 0.0, 1.0};
+    int n_fib = sphere_cap_equator_density_count(40.0, W, H);
+    SpherePoints *fib = sphere_points_fibonacci(n_fib, cap_center, 40.0);
+    double norm_err = 0.0, min_dot = 1.0;
+    for (int i = 0; i < fib->count; i++) {
+        norm_err = fmax(norm_err, fabs(vector_norm(fib->X[i]) - 1.0));
+        min_dot = fmin(min_dot, vector_dot(fib->X[i], cap_center));
+    }
+    printf("  %d 点, |X| - 1 の最大 %.2e, 中心からの最大角 %.3f°（40° 以下のはず）\n",
+           fib->count, norm_err, acos(min_dot) * 180.0 / M_PI);
+    RegistrationResult fib_result;
+    register_rotation_samples(gray_base, gray_ref, fib, create_y_rotation_matrix(11.0),
+                              NULL, &fib_result);
+    printf("  推定: ヨー %.4f°, ピッチ %.4f°, ロール %.4f° (%s, 走査 %d 回)\n",
+           fib_result.yaw_deg, fib_result.pitch_deg, fib_result.roll_deg,
+           fib_result.converged ? "収束" : "未収束", fib_result.passes);
+    sphere_points_free(fib);
+
+    /* ===== テスト16: 複数の比較領域 ===== */
+    printf("\n【テスト16】複数の比較領域（重なり・継ぎ目をまたぐ領域、正解 12.5°）\n");
+    const char *region_file = "test_regions.txt";
+    FILE *fp_regions = fopen(region_file, "w");
+    if (fp_regions) {
+        fprintf(fp_regions, "# u_min v_min u_max v_max\n");
+        fprintf(fp_regions, "300 150 419 209\n");
+        fprintf(fp_regions, "380 180 479 239   # 1つ目と重なる\n\n");
+        fprintf(fp_regions, "680 100 39 139    # 継ぎ目をまたぐ\n");
+        fclose(fp_regions);
+    }
+    RegionSet *set = region_set_load(region_file);
+    remove(region_file);
+    RegionSetContext *rs = set ? region_set_context_create(base, ref, set) : NULL;
+    if (rs) {
+        ObjectiveTerms per_region[3], all;
+        region_set_terms(rs, 12.3, per_region, &all);
+        double max_diff = 0.0;
+        for (int r = 0; r < set->count; r++) {
+            Region q = rs->regions[r];
+            ObjectiveTerms single;
+            compute_objective_terms_gray(gray_base, gray_ref, 12.3, q.u_min, q.v_min,
+                                         q.u_max, q.v_max, &single);
+            max_diff = fmax(max_diff, fabs(per_region[r].E - single.E));
+            max_diff = fmax(max_diff, fabs(per_region[r].gradient - single.gradient));
+        }
+        printf("  %d 領域, 区間 %d 個, 走査 %ld 画素（領域の画素数の和 %ld）\n",
+               set->count, rs->segment_count, rs->unique_pixels, rs->total_pixels);
+        printf("  領域ごとの E, dE/dψ と compute_objective_terms_gray() の差の最大: %.2e\n",
+               max_diff);
+        YawEstimate est_rs;
+        estimate_y_rotation_regions(rs, 12.0, NULL, &est_rs);
+        printf("  全体の推定: %.4f° (%s, 走査 %d 回)\n", est_rs.psi_deg,
+               yaw_status_name(est_rs.status), est_rs.passes);
+    }
+    region_set_context_free(rs);
+    region_set_free(set);
+
+    /* ===== テスト17: 基準画像の比較領域の事前計算 ===== */
+    printf("\n【テスト17】RegionContext 版と元の関数の比較（ψ = 12.3°）\n");
+    RegionContext *region_ctx = region_context_create(base, region);
+    if (region_ctx) {
+        ObjectiveTerms t_ctx, t_plain;
+        compute_objective_terms_ctx(region_ctx, ref, 12.3, &t_ctx);
+        compute_objective_terms(base, ref, 12.3, u_min, v_min, u_max, v_max, &t_plain);
+        double E_ctx = compute_objective_function_ctx(region_ctx, ref, 12.3);
+        double E_plain = compute_objective_function(base, ref, 12.3, u_min, v_min, u_max, v_max);
+        int same = (E_ctx == E_plain && t_ctx.E == t_plain.E &&
+                    t_ctx.gradient == t_plain.gradient && t_ctx.hessian == t_plain.hessian);
+        printf("  E %.10f / %.10f, dE/dψ %.6f / %.6f (%s)\n", E_ctx, E_plain,
+               t_ctx.gradient, t_plain.gradient, same ? "ビット単位で一致" : "不一致");
+        region_context_free(region_ctx);
+    }
+
+    /* ===== テスト18: フレーム列の回転の追跡 ===== */
+    printf("\n【テスト18】フレーム列の追跡（1フレーム 1.5° の等速、生の RGB を先読み）\n");
+    const char *frame_file = "test_frames.rgb";
+    FILE *fp_frames = fopen(frame_file, "wb");
+    int n_frames = 8;
+    for (int k = 0; fp_frames && k < n_frames; k++) {
+        Image *f = rotate_image_y_axis(base, 1.5 * k);
+        fwrite(f->data, 1, (size_t)W * H * 3, fp_frames);
+        image_free(f);
+    }
+    if (fp_frames) fclose(fp_frames);
+    for (int predict = 1; predict >= 0; predict--) {
+        TrackerOptions track_opt = tracker_default_options(region);
+        track_opt.predict = predict;
+        FrameSource *src = frame_source_open_raw(frame_file, W, H);
+        FramePipeline *pipe = src ? frame_pipeline_start(src, 2) : NULL;
+        Tracker *tracker = tracker_create(&track_opt);
+        double track_err = 0.0;
+        int track_passes = 0, tracked = 0;
+        Image *f;
+        while (pipe && tracker && (f = frame_pipeline_next(pipe)) != NULL) {
+            TrackPose pose;
+            if (!tracker_add_frame(tracker, f, &pose)) break;
+            track_err = fmax(track_err, fabs(pose.yaw_deg - 1.5 * pose.frame));
+            track_passes += pose.passes;
+            tracked++;
+        }
+        printf("  %s: %d フレーム, ヨーの誤差の最大 %.4f°, 走査 平均 %.2f 回/フレーム\n",
+               predict ? "等速の予測" : "直前の回転", tracked, track_err,
+               tracked > 1 ? (double)track_passes / (tracked - 1) : 0.0);
+        tracker_free(tracker);
+        frame_pipeline_stop(pipe);
+        frame_source_close(src);
+    }
+
+    /* フレーム 4 を雑音に替え、最後に途中で終わるフレームを付ける */
+    fp_frames = fopen(frame_file, "wb");
+    srand(1);
+    for (int k = 0; fp_frames && k < n_frames; k++) {
+        Image *f = rotate_image_y_axis(base, 1.5 * k);
+        if (k == 4) {
+            for (size_t i = 0; i < (size_t)W * H * 3; i++) f->data[i] = (uint8_t)(rand() & 0xff);
+        }
+        fwrite(f->data, 1, (size_t)W * H * 3, fp_frames);
+        if (k == n_frames - 1) fwrite(f->data, 1, (size_t)W * H, fp_frames);
+        image_free(f);
+    }
+    if (fp_frames) fclose(fp_frames);
+    {
+        TrackerOptions track_opt = tracker_default_options(region);
+        FrameSource *src = frame_source_open_raw(frame_file, W, H);
+        FramePipeline *pipe = src ? frame_pipeline_start(src, 2) : NULL;
+        Tracker *tracker = tracker_create(&track_opt);
+        double track_err = 0.0;
+        int tracked = 0, lost_frame = -1, key_after = -1;
+        Image *f = NULL;
+        while (pipe && tracker && (f = frame_pipeline_next(pipe)) != NULL) {
+            TrackPose pose;
+            if (!tracker_add_frame(tracker, f, &pose)) break;
+            if (!pose.converged) {
+                lost_frame = pose.frame;
+                key_after = tracker->key_frame;
+            } else {
+                track_err = fmax(track_err, fabs(pose.yaw_deg - 1.5 * pose.frame));
+            }
+            tracked++;
+        }
+        printf("  雑音のフレーム: 未収束 %d（4 のはず）, その後の基準 %d（4 でないはず）, "
+               "他のヨーの誤差の最大 %.4f°\n", lost_frame, key_after, track_err);
+        printf("  途中で終わるフレーム: %d フレームで停止, デコードの失敗 %s\n", tracked,
+               (f == NULL && pipe && pipe->error) ? "あり（正しい）" : "なし（誤り）");
+        tracker_free(tracker);
+        frame_pipeline_stop(pipe);
+        frame_source_close(src);
+    }
+    remove(frame_file);
+
+    yaw_curve_free(&curve);
+    gray_image_free(gray_base);
+    gray_image_free(gray_ref);
+    image_free(ref);
+    image_free(base);
+
+    printf("\n===== テスト完了 =====\n");
+
+    return 0;
+}
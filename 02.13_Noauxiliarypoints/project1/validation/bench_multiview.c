@@ -0,0 +1,394 @@
+/* bench_multiview.c
+ * 複数ビューの一括描画のベンチマーク
+ *
+ * 目的:
+ *   K 個のビュー（K = 1, 2, 4, 8, 16, 32）について
+ *   1. projection_render() をビューごとに呼ぶ場合
+ *   2. multiview_render() で出力の行順に一括描画する場合（MULTIVIEW_ROWS）
+ *   3. multiview_render() で入力タイル順に一括描画する場合（MULTIVIEW_TILES）
+ *   の時間と読んだ入力タイルの数を比較し、結果が一致することを確認する
+ *
+ *   さらに3つの順序で入力画像を読む順番を LRU のキャッシュのモデルに通し、
+ *   キャッシュミスの数を比較する（この環境ではハードウェアのカウンタを
+ *   読めないため、ソフトウェアで数える）。読む順番は各描画と同じ手順
+ *   （タイル順はバッチの大きさとタイルの一辺も同じ）で求める。
+ *
+ * 使い方:
+ *   ./bench_multiview [全方位画像]
+ *
+ * 画像を省略した場合は 4096 × 2048 の合成画像を使う。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/multiview.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ビューの設定 */
+#define VIEW_WIDTH 640
+#define VIEW_HEIGHT 480
+#define VIEW_FOV 90.0
+#define MAX_VIEWS 32
+#define REPEAT 3
+
+/* キャッシュのモデル（この環境の L1d と L2 の大きさ、64 バイトの行、LRU） */
+#define LINE_BYTES 64
+#define L1_BYTES (48 * 1024)
+#define L1_WAYS 12
+#define L2_BYTES (2 * 1024 * 1024)
+#define L2_WAYS 16
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            uint8_t *px = img->data + ((size_t)v * W + u) * 3;
+            px[0] = (uint8_t)(127.5 + 127.0 * sin(2.0 * M_PI * 8.0 * u / W));
+            px[1] = (uint8_t)(127.5 + 127.0 * cos(2.0 * M_PI * 5.0 * v / H));
+            px[2] = (uint8_t)((u ^ v) & 0xff);
+        }
+    }
+    return img;
+}
+
+/* ===========================
+ * キャッシュのモデル
+ * =========================== */
+
+/* セットアソシアティブの LRU キャッシュ */
+typedef struct {
+    int sets;
+    int ways;
+    uint64_t *tag;           /* sets × ways（空きは UINT64_MAX） */
+    uint64_t *stamp;         /* 最後に使った時刻 */
+    uint64_t clock;
+    long accesses;
+    long misses;
+} CacheModel;
+
+static int cache_init(CacheModel *cache, int bytes, int ways) {
+    cache->ways = ways;
+    cache->sets = bytes / LINE_BYTES / ways;
+    size_t n = (size_t)cache->sets * ways;
+    cache->tag = (uint64_t*)malloc(n * sizeof(uint64_t));
+    cache->stamp = (uint64_t*)calloc(n, sizeof(uint64_t));
+    if (!cache->tag || !cache->stamp) {
+        free(cache->tag);
+        free(cache->stamp);
+        return 0;
+    }
+    memset(cache->tag, 0xff, n * sizeof(uint64_t));
+    cache->clock = 0;
+    cache->accesses = 0;
+    cache->misses = 0;
+    return 1;
+}
+
+static void cache_free(CacheModel *cache) {
+    free(cache->tag);
+    free(cache->stamp);
+}
+
+static void cache_access(CacheModel *cache, uint64_t line) {
+    uint64_t *tag = cache->tag + (size_t)(line % cache->sets) * cache->ways;
+    uint64_t *stamp = cache->stamp + (size_t)(line % cache->sets) * cache->ways;
+    int victim = 0;
+    cache->clock++;
+    cache->accesses++;
+    for (int w = 0; w < cache->ways; w++) {
+        if (tag[w] == line) {
+            stamp[w] = cache->clock;
+            return;
+        }
+        if (stamp[w] < stamp[victim]) victim = w;
+    }
+    cache->misses++;
+    tag[victim] = line;
+    stamp[victim] = cache->clock;
+}
+
+/* 双線形補間の4画素が載るキャッシュの行を読む（sample_bilinear() と同じ添字） */
+static void read_bilinear(CacheModel *l1, CacheModel *l2, const Image *in,
+                          double u, double v, int wrap) {
+    int W = in->width;
+    int H = in->height;
+    int C = in->channels;
+    int u0 = (int)floor(u);
+    int v0 = (int)floor(v);
+    int u1 = u0 + 1;
+    int v1 = v0 + 1;
+    v0 = v0 < 0 ? 0 : (v0 >= H ? H - 1 : v0);
+    v1 = v1 < 0 ? 0 : (v1 >= H ? H - 1 : v1);
+    if (wrap) {
+        u0 = ((u0 % W) + W) % W;
+        u1 = ((u1 % W) + W) % W;
+    } else {
+        u0 = u0 < 0 ? 0 : (u0 >= W ? W - 1 : u0);
+        u1 = u1 < 0 ? 0 : (u1 >= W ? W - 1 : u1);
+    }
+    int us[2] = {u0, u1};
+    int vs[2] = {v0, v1};
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            size_t first = ((size_t)vs[j] * W + us[i]) * C;
+            uint64_t a = first / LINE_BYTES;
+            uint64_t b = (first + C - 1) / LINE_BYTES;
+            cache_access(l1, a);
+            cache_access(l2, a);
+            if (b != a) {
+                cache_access(l1, b);
+                cache_access(l2, b);
+            }
+        }
+    }
+}
+
+/* 出力画素 (u_out, v_out) を入力の座標に写す（範囲外は 0） */
+static int map_to_input(const Image *in, const ProjectionParams *in_p,
+                        const ProjectionParams *out_p, const Matrix3x3 *M,
+                        int u_out, int v_out, double *u, double *v) {
+    Vector3D Xp, X;
+    if (!projection_to_world(out_p, (double)u_out, (double)v_out, &Xp)) return 0;
+    X.x = M->m[0][0] * Xp.x + M->m[0][1] * Xp.y + M->m[0][2] * Xp.z;
+    X.y = M->m[1][0] * Xp.x + M->m[1][1] * Xp.y + M->m[1][2] * Xp.z;
+    X.z = M->m[2][0] * Xp.x + M->m[2][1] * Xp.y + M->m[2][2] * Xp.z;
+    if (!projection_from_world(in_p, X, u, v)) return 0;
+    if (in_p->type == PROJ_EQUIRECT) return 1;
+    return *u >= 0.0 && *u <= in->width - 1 && *v >= 0.0 && *v <= in->height - 1;
+}
+
+/* 3つの順序でのキャッシュミス（[順序] = 個別, 行順, タイル順） */
+typedef struct {
+    long l1_misses[3];
+    long l2_misses[3];
+    long samples;
+} CacheResult;
+
+static int simulate_cache(const Image *in, const ProjectionParams *in_p,
+                          const ProjectionParams *out_p, const ViewSpec *views,
+                          int K, CacheResult *result) {
+    int W = out_p->width;
+    int H = out_p->height;
+    int wrap = (in_p->type == PROJ_EQUIRECT);
+    memset(result, 0, sizeof(*result));
+
+    /* タイル順のバッチ（projection_render_views_binned() と同じ大きさ） */
+    long rows = MULTIVIEW_BATCH_SAMPLES / ((long)K * W);
+    if (rows < 1) rows = 1;
+    if (rows > H) rows = H;
+    size_t capacity = (size_t)rows * K * W;
+    int tiles_u = (in->width + MULTIVIEW_TILE_SIZE - 1) / MULTIVIEW_TILE_SIZE;
+    int tiles_v = (in->height + MULTIVIEW_TILE_SIZE - 1) / MULTIVIEW_TILE_SIZE;
+    int n_tiles = tiles_u * tiles_v;
+    double *uv = (double*)malloc(2 * capacity * sizeof(double));
+    int *tile = (int*)malloc(capacity * sizeof(int));
+    int *order = (int*)malloc(capacity * sizeof(int));
+    int *count = (int*)malloc(((size_t)n_tiles + 1) * sizeof(int));
+    if (!uv || !tile || !order || !count) {
+        free(uv);
+        free(tile);
+        free(order);
+        free(count);
+        return 0;
+    }
+
+    for (int mode = 0; mode < 3; mode++) {
+        CacheModel l1, l2;
+        if (!cache_init(&l1, L1_BYTES, L1_WAYS) || !cache_init(&l2, L2_BYTES, L2_WAYS)) {
+            exit(1);
+        }
+        double u, v;
+        if (mode == 0) {
+            /* 個別: ビューごとに出力のラスタ順 */
+            for (int k = 0; k < K; k++) {
+                for (int v_out = 0; v_out < H; v_out++) {
+                    for (int u_out = 0; u_out < W; u_out++) {
+                        if (map_to_input(in, in_p, out_p, &views[k].R_T, u_out, v_out, &u, &v)) {
+                            read_bilinear(&l1, &l2, in, u, v, wrap);
+                            result->samples++;
+                        }
+                    }
+                }
+            }
+        } else if (mode == 1) {
+            /* 行順: 全ビューの同じ行を続けて */
+            for (int v_out = 0; v_out < H; v_out++) {
+                for (int k = 0; k < K; k++) {
+                    for (int u_out = 0; u_out < W; u_out++) {
+                        if (map_to_input(in, in_p, out_p, &views[k].R_T, u_out, v_out, &u, &v)) {
+                            read_bilinear(&l1, &l2, in, u, v, wrap);
+                        }
+                    }
+                }
+            }
+        } else {
+            /* タイル順: バッチ内をタイルごとに数え上げソート */
+            for (int v0 = 0; v0 < H; v0 += (int)rows) {
+                int v1 = (v0 + rows < H) ? v0 + (int)rows : H;
+                int n = 0;
+                for (int v_out = v0; v_out < v1; v_out++) {
+                    for (int k = 0; k < K; k++) {
+                        for (int u_out = 0; u_out < W; u_out++) {
+                            if (!map_to_input(in, in_p, out_p, &views[k].R_T,
+                                              u_out, v_out, &u, &v)) continue;
+                            int tu = (int)floor(u) / MULTIVIEW_TILE_SIZE;
+                            int tv = (int)floor(v) / MULTIVIEW_TILE_SIZE;
+                            tu = tu < 0 ? 0 : (tu >= tiles_u ? tiles_u - 1 : tu);
+                            tv = tv < 0 ? 0 : (tv >= tiles_v ? tiles_v - 1 : tv);
+                            uv[2 * n] = u;
+                            uv[2 * n + 1] = v;
+                            tile[n] = tv * tiles_u + tu;
+                            n++;
+                        }
+                    }
+                }
+                memset(count, 0, ((size_t)n_tiles + 1) * sizeof(int));
+                for (int i = 0; i < n; i++) count[tile[i] + 1]++;
+                for (int t = 0; t < n_tiles; t++) count[t + 1] += count[t];
+                for (int i = 0; i < n; i++) order[count[tile[i]]++] = i;
+                for (int j = 0; j < n; j++) {
+                    read_bilinear(&l1, &l2, in, uv[2 * order[j]], uv[2 * order[j] + 1], wrap);
+                }
+            }
+        }
+        result->l1_misses[mode] = l1.misses;
+        result->l2_misses[mode] = l2.misses;
+        cache_free(&l1);
+        cache_free(&l2);
+    }
+
+    free(uv);
+    free(tile);
+    free(order);
+    free(count);
+    return 1;
+}
+
+
+/* K = 1〜MAX_VIEWS で個別描画と一括描画を比較
+ *
+ * spread = 1 で注視点を水平方向に一周させ、小さくすると
+ * 画像中心付近に集める（ビュー同士が重なる）。
+ */
+static void run_scenario(const char *title, Image *input, const ProjectionParams *in_p,
+                         const ProjectionParams *out_p, double spread) {
+    int W = input->width;
+    int H = input->height;
+    printf("【%s】\n", title);
+
+    ViewSpec separate[MAX_VIEWS];
+    ViewSpec rows[MAX_VIEWS];
+    ViewSpec tiles[MAX_VIEWS];
+    for (int k = 0; k < MAX_VIEWS; k++) {
+        double s = fmod(k * 0.37, 1.0) - 0.5;
+        int u_g = (int)(W / 2 + spread * s * W) % W;
+        int v_g = H / 2 + (int)(spread * H / 6 * sin(k * 1.3));
+        if (!view_spec_init(&separate[k], out_p, u_g, v_g, W, H, input->channels) ||
+            !view_spec_init(&rows[k], out_p, u_g, v_g, W, H, input->channels) ||
+            !view_spec_init(&tiles[k], out_p, u_g, v_g, W, H, input->channels)) {
+            exit(1);
+        }
+    }
+
+    printf("時間 [ms]（速度比は個別描画に対する比）\n");
+    printf("%4s %10s %10s %8s %10s %8s %10s %8s\n",
+           "K", "個別", "行順", "速度比", "タイル順", "速度比", "タイル数", "最大差");
+    for (int K = 1; K <= MAX_VIEWS; K *= 2) {
+        /* 交互に REPEAT 回ずつ測って最小値を使う（先に測る側が不利にならないように） */
+        double t_separate = 1e30, t_rows = 1e30, t_tiles = 1e30;
+        MultiViewStats st;
+        for (int r = 0; r < REPEAT; r++) {
+            double t0 = now_ms();
+            for (int k = 0; k < K; k++) {
+                projection_render(input, in_p, separate[k].output, &separate[k].out_p,
+                                  separate[k].R_T, INTERP_BILINEAR);
+            }
+            double t1 = now_ms();
+            multiview_render(input, in_p, rows, K, INTERP_BILINEAR, MULTIVIEW_ROWS, NULL);
+            double t2 = now_ms();
+            multiview_render(input, in_p, tiles, K, INTERP_BILINEAR, MULTIVIEW_TILES, &st);
+            double t3 = now_ms();
+            if (t1 - t0 < t_separate) t_separate = t1 - t0;
+            if (t2 - t1 < t_rows) t_rows = t2 - t1;
+            if (t3 - t2 < t_tiles) t_tiles = t3 - t2;
+        }
+
+        int max_diff = 0;
+        for (int k = 0; k < K; k++) {
+            size_t n = (size_t)VIEW_WIDTH * VIEW_HEIGHT * input->channels;
+            for (size_t i = 0; i < n; i++) {
+                int d1 = abs((int)separate[k].output->data[i] - (int)rows[k].output->data[i]);
+                int d2 = abs((int)separate[k].output->data[i] - (int)tiles[k].output->data[i]);
+                if (d1 > max_diff) max_diff = d1;
+                if (d2 > max_diff) max_diff = d2;
+            }
+        }
+
+        printf("%4d %10.1f %10.1f %8.2f %10.1f %8.2f %10ld %8d\n",
+               K, t_separate, t_rows, t_separate / t_rows, t_tiles, t_separate / t_tiles,
+               st.tile_visits, max_diff);
+    }
+
+    printf("\nキャッシュのモデルのミス数（L1 %d KiB, L2 %d KiB, %d バイトの行, LRU）\n",
+           L1_BYTES / 1024, L2_BYTES / 1024, LINE_BYTES);
+    printf("%4s %10s | %10s %10s %10s | %10s %10s %10s\n", "K", "画素数",
+           "L1 個別", "L1 行順", "L1 タイル", "L2 個別", "L2 行順", "L2 タイル");
+    for (int K = 1; K <= MAX_VIEWS; K *= 2) {
+        CacheResult cr;
+        if (!simulate_cache(input, in_p, out_p, separate, K, &cr)) {
+            fprintf(stderr, "エラー: メモリ確保失敗\n");
+            exit(1);
+        }
+        printf("%4d %10ld | %10ld %10ld %10ld | %10ld %10ld %10ld\n", K, cr.samples,
+               cr.l1_misses[0], cr.l1_misses[1], cr.l1_misses[2],
+               cr.l2_misses[0], cr.l2_misses[1], cr.l2_misses[2]);
+    }
+    printf("\n");
+
+    for (int k = 0; k < MAX_VIEWS; k++) {
+        view_spec_free(&separate[k]);
+        view_spec_free(&rows[k]);
+        view_spec_free(&tiles[k]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 複数ビューの一括描画ベンチマーク =====\n\n");
+
+    Image *input = (argc >= 2) ? image_load(argv[1]) : create_test_image(4096, 2048);
+    if (!input) {
+        fprintf(stderr, "エラー: 入力画像の準備に失敗しました\n");
+        return 1;
+    }
+    int W = input->width;
+    int H = input->height;
+    ProjectionParams in_p = projection_init(PROJ_EQUIRECT, W, H, 360.0);
+    ProjectionParams out_p = projection_init(PROJ_RECTILINEAR, VIEW_WIDTH, VIEW_HEIGHT, VIEW_FOV);
+
+    printf("入力: %d × %d, ビュー: %d × %d (rectilinear, 画角 %.0f°)\n",
+           W, H, VIEW_WIDTH, VIEW_HEIGHT, VIEW_FOV);
+    printf("\n");
+    run_scenario("注視点を全周に分散", input, &in_p, &out_p, 1.0);
+    run_scenario("注視点を ±20° に集中（ビューが重なる）", input, &in_p, &out_p, 20.0 / 180.0);
+
+    image_free(input);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
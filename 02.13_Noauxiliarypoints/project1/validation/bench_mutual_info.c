@@ -0,0 +1,251 @@
+/* bench_mutual_info.c
+ * 相互情報量の目的関数のベンチマーク
+ *
+ * 目的:
+ *   1. 同時ヒストグラムを作る速さ（画素/秒）を、階級の数（32, 64）と
+ *      部分ヒストグラムの数（1, 2, 4, 8）、微分の有無ごとに比較する
+ *   2. 1角度の目的関数の時間を差の2乗・ZNCC と比較する
+ *   3. 理論微分 mi_objective_terms() と中心差分（Δψ = 1e-4°）の差
+ *   4. 参照画像の輝度を変換した場合（露出、反転、折り返し）の最小点と
+ *      推定値を、差の2乗・ZNCC・相互情報量で比較する
+ *
+ * 使い方:
+ *   ./bench_mutual_info [基準画像 参照画像 [中心角度(度)]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像（12.5° 回転）を使う。
+ * 推定の初期値はそれぞれの目的関数の 0.1° 刻みの最小点（掃引してから
+ * ガウス・ニュートン法で詰める）。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/y_rotation.h"
+#include "../include/yaw_estimator.h"
+#include "../include/zncc.h"
+#include "../include/mutual_info.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 角度範囲（中心 ± 10°、0.1° 刻み = 201 角度） */
+#define ANGLE_HALF_RANGE 10.0
+#define ANGLE_STEP 0.1
+
+/* 輝度の変換 */
+typedef enum {
+    TRANSFORM_NONE,
+    TRANSFORM_EXPOSURE,     /* 0.6 x + 40 */
+    TRANSFORM_INVERT,       /* 255 - x */
+    TRANSFORM_FOLD,         /* |2x - 255|（単調でない） */
+    TRANSFORM_COUNT
+} Transform;
+
+static const char *transform_names[TRANSFORM_COUNT] = {
+    "元の参照画像", "露出 0.6x + 40", "反転 255 - x", "折り返し |2x - 255|"
+};
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.4 * sin(13.0 * t + 5.0 * p) + 0.3 * cos(29.0 * t - 11.0 * p)
+                     + 0.3 * sin(41.0 * t) * cos(17.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+/* 輝度を変換した画像 */
+static Image* transform_image(Image *src, Transform t) {
+    Image *img = image_create_like(src);
+    if (!img) return NULL;
+    size_t n = (size_t)src->width * src->height * src->channels;
+    for (size_t i = 0; i < n; i++) {
+        double x = src->data[i];
+        double y = x;
+        switch (t) {
+        case TRANSFORM_EXPOSURE: y = 0.6 * x + 40.0; break;
+        case TRANSFORM_INVERT:   y = 255.0 - x; break;
+        case TRANSFORM_FOLD:     y = fabs(2.0 * x - 255.0); break;
+        default: break;
+        }
+        img->data[i] = (uint8_t)(y > 255.0 ? 255.0 : y);
+    }
+    return img;
+}
+
+static int argmin(const double *E, int K) {
+    int best = 0;
+    for (int k = 1; k < K; k++) {
+        if (E[k] < E[best]) best = k;
+    }
+    return best;
+}
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 相互情報量の目的関数のベンチマーク =====\n\n");
+
+    Image *base, *ref;
+    double center = 12.5;
+    Region region;
+    if (argc >= 3) {
+        base = image_load(argv[1]);
+        ref = image_load(argv[2]);
+        if (argc >= 4) center = atof(argv[3]);
+        /* validate_y_rotation と同じ比較領域 */
+        region.u_min = 2850; region.v_min = 1425;
+        region.u_max = 3229; region.v_max = 1614;
+    } else {
+        base = create_test_image(2048, 1024);
+        ref = base ? rotate_image_y_axis(base, center) : NULL;
+        region.u_min = 1024 - 128; region.v_min = 512 - 64;
+        region.u_max = 1024 + 127; region.v_max = 512 + 63;
+    }
+    if (!base || !ref) {
+        fprintf(stderr, "エラー: 画像の準備に失敗しました\n");
+        return 1;
+    }
+
+    int K = (int)floor(2.0 * ANGLE_HALF_RANGE / ANGLE_STEP + 1e-9) + 1;
+    double *psis = (double*)malloc((size_t)K * sizeof(double));
+    double *E_ssd = (double*)malloc((size_t)K * sizeof(double));
+    double *E_zncc = (double*)malloc((size_t)K * sizeof(double));
+    double *E_mi = (double*)malloc((size_t)K * sizeof(double));
+    double *joint = (double*)malloc((size_t)MI_MAX_BINS * MI_MAX_BINS * sizeof(double));
+    double *joint_d = (double*)malloc((size_t)MI_MAX_BINS * MI_MAX_BINS * sizeof(double));
+    if (!psis || !E_ssd || !E_zncc || !E_mi || !joint || !joint_d) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 1;
+    }
+    for (int k = 0; k < K; k++) {
+        psis[k] = center - ANGLE_HALF_RANGE + k * ANGLE_STEP;
+    }
+    int u_min = region.u_min, v_min = region.v_min;
+    int u_max = region.u_max, v_max = region.v_max;
+    int N = (u_max - u_min + 1) * (v_max - v_min + 1);
+
+    printf("\n画像: %d × %d, 比較領域: (%d, %d) - (%d, %d), %d 画素, 角度 %d 個\n\n",
+           base->width, base->height, u_min, v_min, u_max, v_max, N, K);
+
+    /* 1. 同時ヒストグラムを作る速さ */
+    printf("【同時ヒストグラムを作る速さ（%d 角度）】\n", K);
+    printf("  %6s %16s %14s %14s\n", "階級", "部分ヒストグラム", "値(M画素/秒)", "微分も(M画素/秒)");
+    static const int bin_counts[2] = {32, 64};
+    static const int sub_counts[4] = {1, 2, 4, 8};
+    for (int bi = 0; bi < 2; bi++) {
+        for (int si = 0; si < 4; si++) {
+            MiOptions opt = {bin_counts[bi], sub_counts[si]};
+            MiContext *ctx = mi_context_create(base, ref, region, &opt);
+            if (!ctx) return 1;
+            clock_t start = clock();
+            for (int k = 0; k < K; k++) mi_joint_histogram(ctx, psis[k], joint, NULL);
+            double plain = seconds_since(start);
+            start = clock();
+            for (int k = 0; k < K; k++) mi_joint_histogram(ctx, psis[k], joint, joint_d);
+            double with_grad = seconds_since(start);
+            printf("  %6d %16d %14.1f %14.1f\n", bin_counts[bi], sub_counts[si],
+                   (double)N * K / plain * 1e-6, (double)N * K / with_grad * 1e-6);
+            mi_context_free(ctx);
+        }
+    }
+    printf("\n");
+
+    /* 2. 1角度の時間 */
+    MiContext *mi = mi_context_create(base, ref, region, NULL);
+    ZnccContext *zncc = zncc_context_create(base, ref, region);
+    if (!mi || !zncc) return 1;
+    clock_t start = clock();
+    for (int k = 0; k < K; k++) {
+        E_ssd[k] = compute_objective_function_yaw(base, ref, psis[k], u_min, v_min, u_max, v_max);
+    }
+    double ssd_ms = 1000.0 * seconds_since(start) / K;
+    start = clock();
+    for (int k = 0; k < K; k++) E_zncc[k] = zncc_objective(zncc, psis[k]);
+    double zncc_ms = 1000.0 * seconds_since(start) / K;
+    start = clock();
+    for (int k = 0; k < K; k++) E_mi[k] = mi_objective(mi, psis[k]);
+    double mi_ms = 1000.0 * seconds_since(start) / K;
+    ObjectiveTerms terms;
+    start = clock();
+    for (int k = 0; k < K; k++) mi_objective_terms(mi, psis[k], &terms);
+    double mi_terms_ms = 1000.0 * seconds_since(start) / K;
+    printf("【1角度の時間（標準の設定: 32 階級、部分ヒストグラム 1 個）】\n");
+    printf("  差の2乗 compute_objective_function_yaw: %.3f ms\n", ssd_ms);
+    printf("  ZNCC zncc_objective:                    %.3f ms\n", zncc_ms);
+    printf("  相互情報量 mi_objective:                %.3f ms\n", mi_ms);
+    printf("  相互情報量 mi_objective_terms:          %.3f ms\n\n", mi_terms_ms);
+
+    /* 3. 理論微分と中心差分 */
+    printf("【理論微分と中心差分（Δψ = 1e-4°）】\n");
+    const double h = 1e-4;
+    double h_rad = h * M_PI / 180.0;
+    double test_psis[4] = {center - 3.33, center - 0.27, center + 0.01, center + 0.41};
+    for (int i = 0; i < 4; i++) {
+        ObjectiveTerms plus, minus;
+        mi_objective_terms(mi, test_psis[i], &terms);
+        mi_objective_terms(mi, test_psis[i] + h, &plus);
+        mi_objective_terms(mi, test_psis[i] - h, &minus);
+        printf("  ψ = %7.2f°: dE/dψ %10.5f / %10.5f, H %9.2f（d²E/dψ² の中心差分 %9.2f）\n",
+               test_psis[i], terms.gradient, (plus.E - minus.E) / (2.0 * h_rad),
+               terms.hessian, (plus.gradient - minus.gradient) / (2.0 * h_rad));
+    }
+    printf("\n");
+    mi_context_free(mi);
+    zncc_context_free(zncc);
+
+    /* 4. 輝度を変換した参照画像 */
+    printf("【輝度の変換への強さ（最小 / 推定）】\n");
+    for (int t = 0; t < TRANSFORM_COUNT; t++) {
+        Image *r = transform_image(ref, (Transform)t);
+        MiContext *mi_t = r ? mi_context_create(base, r, region, NULL) : NULL;
+        ZnccContext *zncc_t = r ? zncc_context_create(base, r, region) : NULL;
+        if (!mi_t || !zncc_t) return 1;
+        for (int k = 0; k < K; k++) {
+            E_ssd[k] = compute_objective_function_yaw(base, r, psis[k], u_min, v_min, u_max, v_max);
+            E_zncc[k] = zncc_objective(zncc_t, psis[k]);
+            E_mi[k] = mi_objective(mi_t, psis[k]);
+        }
+        YawEstimate est_ssd, est_zncc, est_mi;
+        estimate_y_rotation(base, r, region, psis[argmin(E_ssd, K)], NULL, &est_ssd);
+        estimate_y_rotation_zncc(zncc_t, psis[argmin(E_zncc, K)], NULL, &est_zncc);
+        estimate_y_rotation_mi(mi_t, psis[argmin(E_mi, K)], NULL, &est_mi);
+        printf("  %s:\n", transform_names[t]);
+        printf("    差の2乗:   %7.2f° / %8.4f° (%s)\n", psis[argmin(E_ssd, K)],
+               est_ssd.psi_deg, yaw_status_name(est_ssd.status));
+        printf("    ZNCC:      %7.2f° / %8.4f° (%s)\n", psis[argmin(E_zncc, K)],
+               est_zncc.psi_deg, yaw_status_name(est_zncc.status));
+        printf("    相互情報量: %7.2f° / %8.4f° (%s, 走査 %d 回, MI = %.4f)\n",
+               psis[argmin(E_mi, K)], est_mi.psi_deg, yaw_status_name(est_mi.status),
+               est_mi.passes, -est_mi.E);
+        mi_context_free(mi_t);
+        zncc_context_free(zncc_t);
+        image_free(r);
+    }
+
+    free(psis);
+    free(E_ssd);
+    free(E_zncc);
+    free(E_mi);
+    free(joint);
+    free(joint_d);
+    image_free(base);
+    image_free(ref);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
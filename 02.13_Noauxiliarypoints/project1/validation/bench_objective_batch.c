@@ -0,0 +1,120 @@
+/* bench_objective_batch.c
+ * 複数の角度の目的関数をまとめて計算する場合のベンチマーク
+ *
+ * 目的:
+ *   K 個の角度の E(ψ) を
+ *   1. compute_objective_function() を K 回呼ぶ
+ *   2. compute_objective_batch() で基準画像を1回だけ読み込む
+ *   の2通りで求め、値が一致することと時間を比較する
+ *
+ * 使い方:
+ *   ./bench_objective_batch [基準画像 参照画像 [中心角度(度)]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像（12.5° 回転）を使う。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/y_rotation.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 角度範囲（中心 ± 10°、0.1° 刻み = 201 角度） */
+#define ANGLE_HALF_RANGE 10.0
+#define ANGLE_STEP 0.1
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.4 * sin(13.0 * t + 5.0 * p) + 0.3 * cos(29.0 * t - 11.0 * p)
+                     + 0.3 * sin(41.0 * t) * cos(17.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 複数角度の目的関数のベンチマーク =====\n\n");
+
+    Image *base, *ref;
+    double center = 12.5;
+    int u_min, v_min, u_max, v_max;
+    if (argc >= 3) {
+        base = image_load(argv[1]);
+        ref = image_load(argv[2]);
+        if (argc >= 4) center = atof(argv[3]);
+        /* validate_y_rotation と同じ比較領域 */
+        u_min = 2850; v_min = 1425; u_max = 3229; v_max = 1614;
+    } else {
+        base = create_test_image(2048, 1024);
+        ref = base ? rotate_image_y_axis(base, center) : NULL;
+        u_min = 1024 - 128; v_min = 512 - 64; u_max = 1024 + 127; v_max = 512 + 63;
+    }
+    if (!base || !ref) {
+        fprintf(stderr, "エラー: 画像の準備に失敗しました\n");
+        return 1;
+    }
+
+    int K = (int)floor(2.0 * ANGLE_HALF_RANGE / ANGLE_STEP + 1e-9) + 1;
+    double *psis = (double*)malloc((size_t)K * sizeof(double));
+    double *E_single = (double*)malloc((size_t)K * sizeof(double));
+    double *E_batch = (double*)malloc((size_t)K * sizeof(double));
+    if (!psis || !E_single || !E_batch) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 1;
+    }
+    for (int k = 0; k < K; k++) {
+        psis[k] = center - ANGLE_HALF_RANGE + k * ANGLE_STEP;
+    }
+
+    printf("\n画像: %d × %d, 比較領域: (%d, %d) - (%d, %d), 角度 %d 個\n\n",
+           base->width, base->height, u_min, v_min, u_max, v_max, K);
+
+    /* 1. 角度ごとに呼ぶ */
+    clock_t start = clock();
+    for (int k = 0; k < K; k++) {
+        E_single[k] = compute_objective_function(base, ref, psis[k],
+                                                 u_min, v_min, u_max, v_max);
+    }
+    double single_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* 2. まとめて計算 */
+    start = clock();
+    compute_objective_batch(base, ref, psis, K, u_min, v_min, u_max, v_max, E_batch);
+    double batch_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    int same = memcmp(E_single, E_batch, (size_t)K * sizeof(double)) == 0;
+    int best = 0;
+    for (int k = 1; k < K; k++) {
+        if (E_batch[k] < E_batch[best]) best = k;
+    }
+
+    printf("  角度ごと (compute_objective_function × %d): %.3f 秒\n", K, single_seconds);
+    printf("  まとめて (compute_objective_batch):          %.3f 秒\n", batch_seconds);
+    printf("  速度比: %.2f 倍\n", single_seconds / batch_seconds);
+    printf("  値: %s\n", same ? "ビット単位で一致" : "不一致");
+    printf("  最小: ψ = %.2f°, E = %.6f\n", psis[best], E_batch[best]);
+
+    free(psis);
+    free(E_single);
+    free(E_batch);
+    image_free(base);
+    image_free(ref);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
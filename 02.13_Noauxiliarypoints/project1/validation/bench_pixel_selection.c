@@ -0,0 +1,199 @@
+/* bench_pixel_selection.c
+ * 目的関数に使う画素の間引きのベンチマーク
+ *
+ * 目的:
+ *   比較領域の画素を yaw_template_select() で間引いたとき、
+ *   1. 1回の走査（compute_objective_terms_ic）の時間
+ *   2. estimate_y_rotation_ic() で推定した角度
+ *   3. 目的関数の曲線 E(ψ)（中心 ± 2°）の最小点と形（最小 0、最大 1 に
+ *      正規化した曲線の最大の差）
+ *   が全画素の場合からどれだけ変わるかを、選び方と割合ごとに比較する
+ *
+ * 使い方:
+ *   ./bench_pixel_selection [基準画像 参照画像 [期待角度(度)]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像（12.5° 回転）を使う。
+ * 推定の初期値は 期待角度 + 0.3°。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/y_rotation.h"
+#include "../include/yaw_estimator.h"
+#include "../include/pixel_selection.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 曲線の角度範囲（中心 ± 2°、0.1° 刻み） */
+#define CURVE_HALF_RANGE 2.0
+#define CURVE_STEP 0.1
+#define CURVE_POINTS 41
+
+/* 時間を測るときの走査の回数 */
+#define TIMING_PASSES 20
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.4 * sin(13.0 * t + 5.0 * p) + 0.3 * cos(29.0 * t - 11.0 * p)
+                     + 0.3 * sin(41.0 * t) * cos(17.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+/* 曲線 E(ψ) */
+static void compute_curve(const YawTemplate *tmpl, Image *ref, double center,
+                          double *E) {
+    ObjectiveTerms terms;
+    for (int k = 0; k < CURVE_POINTS; k++) {
+        double psi = center - CURVE_HALF_RANGE + k * CURVE_STEP;
+        compute_objective_terms_ic(tmpl, ref, psi, &terms);
+        E[k] = terms.E;
+    }
+}
+
+static int curve_argmin(const double *E) {
+    int best = 0;
+    for (int k = 1; k < CURVE_POINTS; k++) {
+        if (E[k] < E[best]) best = k;
+    }
+    return best;
+}
+
+/* 曲線を最小 0、最大 1 に正規化（画素の選び方で E の大きさ自体が変わるので
+ * 形だけを比べる） */
+static void normalize_curve(double *E) {
+    double lo = E[0], hi = E[0];
+    for (int k = 1; k < CURVE_POINTS; k++) {
+        if (E[k] < lo) lo = E[k];
+        if (E[k] > hi) hi = E[k];
+    }
+    double range = (hi > lo) ? hi - lo : 1.0;
+    for (int k = 0; k < CURVE_POINTS; k++) {
+        E[k] = (E[k] - lo) / range;
+    }
+}
+
+/* 1回の走査の時間（ミリ秒） */
+static double time_pass(const YawTemplate *tmpl, Image *ref, double psi) {
+    ObjectiveTerms terms;
+    clock_t start = clock();
+    for (int i = 0; i < TIMING_PASSES; i++) {
+        compute_objective_terms_ic(tmpl, ref, psi, &terms);
+    }
+    return 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC / TIMING_PASSES;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 画素の間引きのベンチマーク =====\n\n");
+
+    Image *base, *ref;
+    double expected = 12.5;
+    Region region;
+    if (argc >= 3) {
+        base = image_load(argv[1]);
+        ref = image_load(argv[2]);
+        if (argc >= 4) expected = atof(argv[3]);
+        /* validate_y_rotation と同じ比較領域 */
+        region.u_min = 2850; region.v_min = 1425;
+        region.u_max = 3229; region.v_max = 1614;
+    } else {
+        base = create_test_image(2048, 1024);
+        ref = base ? rotate_image_y_axis(base, expected) : NULL;
+        region.u_min = 1024 - 128; region.v_min = 512 - 64;
+        region.u_max = 1024 + 127; region.v_max = 512 + 63;
+    }
+    if (!base || !ref) {
+        fprintf(stderr, "エラー: 画像の準備に失敗しました\n");
+        return 1;
+    }
+
+    YawTemplate *full = yaw_template_create(base, region);
+    if (!full) {
+        image_free(base);
+        image_free(ref);
+        return 1;
+    }
+    double init = expected + 0.3;
+
+    printf("\n画像: %d × %d, 比較領域: (%d, %d) - (%d, %d), %d 画素\n",
+           base->width, base->height, region.u_min, region.v_min,
+           region.u_max, region.v_max, full->count);
+    printf("推定の初期値: %.2f°, 曲線: %.1f° ± %.1f°（%.1f° 刻み）\n\n",
+           init, expected, CURVE_HALF_RANGE, CURVE_STEP);
+
+    /* 全画素の基準値 */
+    double E_full[CURVE_POINTS];
+    compute_curve(full, ref, expected, E_full);
+    normalize_curve(E_full);
+    double full_ms = time_pass(full, ref, expected);
+    YawEstimate full_est;
+    estimate_y_rotation_ic(full, ref, init, NULL, &full_est);
+
+    printf("  全画素: 走査 %.2f ms, 推定 %.4f°（%d 回）, 曲線の最小 %.1f°\n\n",
+           full_ms, full_est.psi_deg, full_est.passes,
+           expected - CURVE_HALF_RANGE + curve_argmin(E_full) * CURVE_STEP);
+
+    printf("  %-10s %6s %7s %9s %10s %9s %9s %10s\n",
+           "選び方", "割合", "画素数", "走査(ms)", "推定(°)", "差(°)", "曲線最小", "形の差");
+
+    static const PixelSelectMode modes[] = {
+        PIXEL_SELECT_TOP_K, PIXEL_SELECT_STRATIFIED, PIXEL_SELECT_RANDOM
+    };
+    static const double fractions[] = {0.5, 0.25, 0.1, 0.05, 0.02, 0.01};
+    int nmodes = (int)(sizeof(modes) / sizeof(modes[0]));
+    int nfractions = (int)(sizeof(fractions) / sizeof(fractions[0]));
+
+    for (int mi = 0; mi < nmodes; mi++) {
+        for (int fi = 0; fi < nfractions; fi++) {
+            PixelSelectOptions opt = pixel_select_default_options();
+            opt.mode = modes[mi];
+            opt.fraction = fractions[fi];
+            YawTemplate *sub = yaw_template_select(full, &opt);
+            if (!sub) continue;
+
+            double ms = time_pass(sub, ref, expected);
+            YawEstimate est;
+            estimate_y_rotation_ic(sub, ref, init, NULL, &est);
+
+            /* 曲線の形の差（正規化した曲線の最大の差） */
+            double E_sub[CURVE_POINTS];
+            compute_curve(sub, ref, expected, E_sub);
+            int sub_best = curve_argmin(E_sub);
+            normalize_curve(E_sub);
+            double max_diff = 0.0;
+            for (int k = 0; k < CURVE_POINTS; k++) {
+                double d = fabs(E_sub[k] - E_full[k]);
+                if (d > max_diff) max_diff = d;
+            }
+
+            printf("  %-10s %5.0f%% %7d %9.3f %10.4f %+9.4f %8.1f° %9.1f%%\n",
+                   pixel_select_mode_name(modes[mi]), 100.0 * fractions[fi],
+                   sub->count, ms, est.psi_deg, est.psi_deg - full_est.psi_deg,
+                   expected - CURVE_HALF_RANGE + sub_best * CURVE_STEP,
+                   100.0 * max_diff);
+            yaw_template_free(sub);
+        }
+    }
+
+    yaw_template_free(full);
+    image_free(base);
+    image_free(ref);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+/* bench_registration.c
+ * 3自由度の回転の位置合わせのベンチマーク
+ *
+ * 目的:
+ *   既知の回転（ヨー・ピッチ・ロール）で参照画像を合成し、
+ *   1. ピラミッド + ガウス・ニュートン法（register_rotation）
+ *   2. 3次元格子の全探索（register_rotation_grid）
+ *   の精度と時間を比較する
+ *
+ * 使い方:
+ *   ./bench_registration [全方位画像 [ヨー ピッチ ロール]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像を使う。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/rotation_registration.h"
+#include "../include/projection.h"
+#include "../include/rotation.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 格子探索の設定（± 範囲と刻み、度数法） */
+#define GRID_HALF_RANGE 3.0
+#define GRID_STEP 0.5
+
+/* 合成の全方位画像（周期の異なる縞の重ね合わせ） */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.35 * sin(13.0 * t + 5.0 * p) + 0.25 * cos(29.0 * t - 11.0 * p)
+                     + 0.2 * sin(7.0 * t) * cos(17.0 * p) + 0.2 * sin(41.0 * t + 23.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+static void print_result(const char *name, const RegistrationResult *r,
+                         double yaw, double pitch, double roll, double seconds) {
+    printf("  %s\n", name);
+    printf("    推定: ヨー %.4f°, ピッチ %.4f°, ロール %.4f° (E = %.4f)\n",
+           r->yaw_deg, r->pitch_deg, r->roll_deg, r->E);
+    printf("    誤差: %.4f°, %.4f°, %.4f°\n",
+           r->yaw_deg - yaw, r->pitch_deg - pitch, r->roll_deg - roll);
+    printf("    走査 %d 回, %.3f 秒\n", r->passes, seconds);
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 3自由度の回転の位置合わせベンチマーク =====\n\n");
+
+    Image *input = (argc >= 2) ? image_load(argv[1]) : create_test_image(2048, 1024);
+    if (!input) {
+        fprintf(stderr, "エラー: 入力画像の準備に失敗しました\n");
+        return 1;
+    }
+    double yaw = (argc >= 5) ? atof(argv[2]) : 2.0;
+    double pitch = (argc >= 5) ? atof(argv[3]) : 1.0;
+    double roll = (argc >= 5) ? atof(argv[4]) : -0.5;
+
+    int W = input->width;
+    int H = input->height;
+
+    /* 参照画像: Sr(R X) = Sb(X) となるように描画（出力 X' → 入力 R^T X'） */
+    Matrix3x3 R_true = matrix_multiply(create_pitch_roll_matrix(pitch, roll),
+                                       create_y_rotation_matrix(yaw));
+    ProjectionParams eq = projection_init(PROJ_EQUIRECT, W, H, 360.0);
+    Image *ref_image = image_create(W, H, input->channels);
+    projection_render(input, &eq, ref_image, &eq, matrix_transpose(R_true), INTERP_BILINEAR);
+
+    GrayImage *base = gray_image_from_image(input);
+    GrayImage *ref = gray_image_from_image(ref_image);
+
+    /* 比較領域: 画像中心の W/8 × H/8 */
+    Region region = {W / 2 - W / 16, H / 2 - H / 16, W / 2 + W / 16 - 1, H / 2 + H / 16 - 1};
+
+    printf("画像: %d × %d, 比較領域: (%d, %d) - (%d, %d)\n",
+           W, H, region.u_min, region.v_min, region.u_max, region.v_max);
+    printf("正解: ヨー %.4f°, ピッチ %.4f°, ロール %.4f°\n\n", yaw, pitch, roll);
+
+    /* ピラミッド + ガウス・ニュートン法 */
+    printf("【ピラミッド + ガウス・ニュートン法】\n");
+    RegistrationResult gn;
+    clock_t start = clock();
+    register_rotation(base, ref, region, matrix_identity(), NULL, &gn);
+    double gn_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    print_result(gn.converged ? "収束" : "未収束", &gn, yaw, pitch, roll, gn_seconds);
+    for (int l = gn.levels - 1; l >= 0; l--) {
+        printf("    レベル%d: 反復 %d 回, %.3f 秒\n",
+               l, gn.level_iterations[l], gn.level_seconds[l]);
+    }
+
+    /* 3次元格子の全探索 */
+    printf("\n【3次元格子の全探索】(±%.1f°, 刻み %.2f°)\n", GRID_HALF_RANGE, GRID_STEP);
+    RegistrationResult grid;
+    start = clock();
+    register_rotation_grid(base, ref, region, 0.0, 0.0, 0.0,
+                           GRID_HALF_RANGE, GRID_STEP, &grid);
+    double grid_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    print_result("格子点の最小", &grid, yaw, pitch, roll, grid_seconds);
+
+    printf("\n  時間の比: 格子探索 / ガウス・ニュートン法 = %.1f 倍\n",
+           grid_seconds / gn_seconds);
+
+    gray_image_free(base);
+    gray_image_free(ref);
+    image_free(ref_image);
+    image_free(input);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
@@ -0,0 +1,136 @@
+/* bench_sphere_sampling.c
+ * 球面上の等面積の標本点のベンチマーク
+ *
+ * 目的:
+ *   既知の回転（ヨー・ピッチ・ロール）で参照画像を合成し、球面全体と球冠
+ *   （赤道・極）のそれぞれで
+ *   1. 正距円筒画像の画素（球冠に入る全画素）
+ *   2. フィボナッチ格子（赤道の画素と同じ密度）
+ *   の点の数、立体角で重みを付けた実効的な点の数、register_rotation_samples() の
+ *   精度と時間を比較する
+ *
+ * 使い方:
+ *   ./bench_sphere_sampling [全方位画像 [ヨー ピッチ ロール]]
+ *
+ * 画像を省略した場合は 1024 × 512 の合成画像を使う。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/rotation_registration.h"
+#include "../include/sphere_sampling.h"
+#include "../include/projection.h"
+#include "../include/rotation.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 球冠の設定 */
+typedef struct {
+    const char *name;
+    Vector3D center;
+    double radius_deg;
+} Cap;
+
+static const Cap caps[] = {
+    {"球面全体",            {0.0, 0.0, 1.0}, 180.0},
+    {"赤道の球冠（30°）",   {0.0, 0.0, 1.0}, 30.0},
+    {"極の球冠（30°）",     {0.0, 1.0, 0.0}, 30.0},
+};
+
+/* 合成の全方位画像（bench_registration と同じ縞の重ね合わせ） */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.35 * sin(13.0 * t + 5.0 * p) + 0.25 * cos(29.0 * t - 11.0 * p)
+                     + 0.2 * sin(7.0 * t) * cos(17.0 * p) + 0.2 * sin(41.0 * t + 23.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+/* 点の集合で位置合わせして1行表示 */
+static double run(const char *name, GrayImage *base, GrayImage *ref,
+                  const SpherePoints *points, double yaw, double pitch, double roll) {
+    RegistrationResult r;
+    clock_t start = clock();
+    int ok = register_rotation_samples(base, ref, points, matrix_identity(), NULL, &r);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (!ok) {
+        printf("    %-18s 失敗\n", name);
+        return seconds;
+    }
+    printf("    %-18s %9d %11.0f   誤差 %8.4f° %8.4f° %8.4f°  走査 %2d 回 %7.3f 秒%s\n",
+           name, points->count, sphere_points_effective_count(points),
+           r.yaw_deg - yaw, r.pitch_deg - pitch, r.roll_deg - roll,
+           r.passes, seconds, r.converged ? "" : "（未収束）");
+    return seconds;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== 球面上の等面積の標本点のベンチマーク =====\n\n");
+
+    Image *input = (argc >= 2) ? image_load(argv[1]) : create_test_image(1024, 512);
+    if (!input) {
+        fprintf(stderr, "エラー: 入力画像の準備に失敗しました\n");
+        return 1;
+    }
+    double yaw = (argc >= 5) ? atof(argv[2]) : 2.0;
+    double pitch = (argc >= 5) ? atof(argv[3]) : 1.0;
+    double roll = (argc >= 5) ? atof(argv[4]) : -0.5;
+
+    int W = input->width;
+    int H = input->height;
+
+    /* 参照画像: Sr(R X) = Sb(X) となるように描画（出力 X' → 入力 R^T X'） */
+    Matrix3x3 R_true = matrix_multiply(create_pitch_roll_matrix(pitch, roll),
+                                       create_y_rotation_matrix(yaw));
+    ProjectionParams eq = projection_init(PROJ_EQUIRECT, W, H, 360.0);
+    Image *ref_image = image_create(W, H, input->channels);
+    if (!ref_image) return 1;
+    projection_render(input, &eq, ref_image, &eq, matrix_transpose(R_true), INTERP_BILINEAR);
+
+    GrayImage *base = gray_image_from_image(input);
+    GrayImage *ref = gray_image_from_image(ref_image);
+    if (!base || !ref) return 1;
+
+    printf("画像: %d × %d\n", W, H);
+    printf("正解: ヨー %.4f°, ピッチ %.4f°, ロール %.4f°\n\n", yaw, pitch, roll);
+
+    for (size_t c = 0; c < sizeof(caps) / sizeof(caps[0]); c++) {
+        const Cap *cap = &caps[c];
+        SpherePoints *pixels = sphere_points_equirect(W, H, cap->center, cap->radius_deg);
+        int n = sphere_cap_equator_density_count(cap->radius_deg, W, H);
+        SpherePoints *fib = sphere_points_fibonacci(n, cap->center, cap->radius_deg);
+        if (!pixels || !fib) return 1;
+
+        printf("【%s】立体角 %.4f sr\n", cap->name, sphere_cap_solid_angle(cap->radius_deg));
+        printf("    %-18s %9s %11s\n", "", "点の数", "実効的な数");
+        double t_pixels = run("正距円筒の画素", base, ref, pixels, yaw, pitch, roll);
+        double t_fib = run("フィボナッチ格子", base, ref, fib, yaw, pitch, roll);
+        printf("    点の数の比 %.2f 倍, 時間の比 %.2f 倍\n\n",
+               (double)pixels->count / fib->count, t_pixels / t_fib);
+
+        sphere_points_free(pixels);
+        sphere_points_free(fib);
+    }
+
+    gray_image_free(base);
+    gray_image_free(ref);
+    image_free(ref_image);
+    image_free(input);
+
+    printf("===== ベンチマーク完了 =====\n");
+    return 0;
+}
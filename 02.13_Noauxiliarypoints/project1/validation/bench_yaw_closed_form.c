@@ -0,0 +1,170 @@
+/* bench_yaw_closed_form.c
+ * Y軸回り専用の閉じた形の目的関数・微分のベンチマーク
+ *
+ * 目的:
+ *   380 × 190 画素の比較領域で、K 個の角度の
+ *   1. 目的関数 E(ψ): compute_objective_function() と
+ *      compute_objective_function_yaw()
+ *   2. E, dE/dψ, H: compute_objective_terms() と
+ *      compute_objective_terms_yaw()
+ *   の時間と値の差を比較する
+ *
+ * 使い方:
+ *   ./bench_yaw_closed_form [基準画像 参照画像 [中心角度(度)]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像（12.5° 回転）を使う。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/y_rotation.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 角度範囲（中心 ± 10°、0.1° 刻み = 201 角度） */
+#define ANGLE_HALF_RANGE 10.0
+#define ANGLE_STEP 0.1
+
+/* 比較領域の大きさ */
+#define REGION_WIDTH 380
+#define REGION_HEIGHT 190
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.4 * sin(13.0 * t + 5.0 * p) + 0.3 * cos(29.0 * t - 11.0 * p)
+                     + 0.3 * sin(41.0 * t) * cos(17.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+static int argmin(const double *E, int K) {
+    int best = 0;
+    for (int k = 1; k < K; k++) {
+        if (E[k] < E[best]) best = k;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== Y軸回り専用の閉じた形のベンチマーク =====\n\n");
+
+    Image *base, *ref;
+    double center = 12.5;
+    int u_min, v_min;
+    if (argc >= 3) {
+        base = image_load(argv[1]);
+        ref = image_load(argv[2]);
+        if (argc >= 4) center = atof(argv[3]);
+        /* validate_y_rotation と同じ比較領域 */
+        u_min = 2850; v_min = 1425;
+    } else {
+        base = create_test_image(2048, 1024);
+        ref = base ? rotate_image_y_axis(base, center) : NULL;
+        u_min = 1024 - REGION_WIDTH / 2; v_min = 512 - REGION_HEIGHT / 2;
+    }
+    if (!base || !ref) {
+        fprintf(stderr, "エラー: 画像の準備に失敗しました\n");
+        return 1;
+    }
+    int u_max = u_min + REGION_WIDTH - 1;
+    int v_max = v_min + REGION_HEIGHT - 1;
+
+    int K = (int)floor(2.0 * ANGLE_HALF_RANGE / ANGLE_STEP + 1e-9) + 1;
+    double *psis = (double*)malloc((size_t)K * sizeof(double));
+    double *E_generic = (double*)malloc((size_t)K * sizeof(double));
+    double *E_yaw = (double*)malloc((size_t)K * sizeof(double));
+    ObjectiveTerms *t_generic = (ObjectiveTerms*)malloc((size_t)K * sizeof(ObjectiveTerms));
+    ObjectiveTerms *t_yaw = (ObjectiveTerms*)malloc((size_t)K * sizeof(ObjectiveTerms));
+    if (!psis || !E_generic || !E_yaw || !t_generic || !t_yaw) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 1;
+    }
+    for (int k = 0; k < K; k++) {
+        psis[k] = center - ANGLE_HALF_RANGE + k * ANGLE_STEP;
+    }
+
+    printf("\n画像: %d × %d, 比較領域: (%d, %d) - (%d, %d), 角度 %d 個\n\n",
+           base->width, base->height, u_min, v_min, u_max, v_max, K);
+
+    /* 1. 目的関数 */
+    clock_t start = clock();
+    for (int k = 0; k < K; k++) {
+        E_generic[k] = compute_objective_function(base, ref, psis[k],
+                                                  u_min, v_min, u_max, v_max);
+    }
+    double generic_E_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        E_yaw[k] = compute_objective_function_yaw(base, ref, psis[k],
+                                                  u_min, v_min, u_max, v_max);
+    }
+    double yaw_E_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* 2. E, dE/dψ, H */
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        compute_objective_terms(base, ref, psis[k], u_min, v_min, u_max, v_max,
+                                &t_generic[k]);
+    }
+    double generic_t_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        compute_objective_terms_yaw(base, ref, psis[k], u_min, v_min, u_max, v_max,
+                                    &t_yaw[k]);
+    }
+    double yaw_t_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* 値の差（E は相対、微分は一般の経路の最大の |dE/dψ| に対して） */
+    double max_E_rel = 0.0, max_g_abs = 0.0, max_g_diff = 0.0;
+    for (int k = 0; k < K; k++) {
+        double d = fabs(E_yaw[k] - E_generic[k]) / fmax(E_generic[k], 1e-12);
+        if (d > max_E_rel) max_E_rel = d;
+        if (fabs(t_generic[k].gradient) > max_g_abs) max_g_abs = fabs(t_generic[k].gradient);
+        d = fabs(t_yaw[k].gradient - t_generic[k].gradient);
+        if (d > max_g_diff) max_g_diff = d;
+    }
+    int best_generic = argmin(E_generic, K);
+    int best_yaw = argmin(E_yaw, K);
+
+    printf("  目的関数 E(ψ) × %d\n", K);
+    printf("    一般 (compute_objective_function):         %.3f 秒\n", generic_E_seconds);
+    printf("    閉じた形 (compute_objective_function_yaw): %.3f 秒\n", yaw_E_seconds);
+    printf("    速度比: %.1f 倍\n", generic_E_seconds / yaw_E_seconds);
+    printf("  E, dE/dψ, H × %d\n", K);
+    printf("    一般 (compute_objective_terms):            %.3f 秒\n", generic_t_seconds);
+    printf("    閉じた形 (compute_objective_terms_yaw):    %.3f 秒\n", yaw_t_seconds);
+    printf("    速度比: %.1f 倍\n", generic_t_seconds / yaw_t_seconds);
+    printf("  値の差\n");
+    printf("    E の最大の相対差:     %.2e\n", max_E_rel);
+    printf("    dE/dψ の最大の差:     %.2e（最大の |dE/dψ| %.2f に対して）\n",
+           max_g_diff, max_g_abs);
+    printf("    最小: 一般 %.2f°, 閉じた形 %.2f°\n", psis[best_generic], psis[best_yaw]);
+
+    free(psis);
+    free(E_generic);
+    free(E_yaw);
+    free(t_generic);
+    free(t_yaw);
+    image_free(base);
+    image_free(ref);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+/* bench_zncc.c
+ * ZNCC の目的関数のベンチマーク
+ *
+ * 目的:
+ *   1. K 個の角度の目的関数の時間を比較する
+ *      - 差の2乗: compute_objective_function(), compute_objective_function_yaw()
+ *      - ZNCC: 角度ごとに平均と分散を求める素朴な実装と、積分画像を使う
+ *        zncc_objective()（値が一致することも確かめる）
+ *   2. 理論微分 zncc_objective_terms() と中心差分（Δψ = 1e-4°）の差
+ *   3. 参照画像の露出を変えた場合（輝度 × EXPOSURE_GAIN + EXPOSURE_OFFSET）の
+ *      最小点と推定値を、差の2乗と ZNCC で比較する
+ *
+ * 使い方:
+ *   ./bench_zncc [基準画像 参照画像 [中心角度(度)]]
+ *
+ * 画像を省略した場合は 2048 × 1024 の合成画像（12.5° 回転）を使う。
+ * 推定の初期値は 中心角度 + 0.3°。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../include/y_rotation.h"
+#include "../include/yaw_estimator.h"
+#include "../include/zncc.h"
+#include "../include/image_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 角度範囲（中心 ± 10°、0.1° 刻み = 201 角度） */
+#define ANGLE_HALF_RANGE 10.0
+#define ANGLE_STEP 0.1
+
+/* 露出の変更 */
+#define EXPOSURE_GAIN 0.6
+#define EXPOSURE_OFFSET 40.0
+
+/* 合成の全方位画像 */
+static Image* create_test_image(int W, int H) {
+    Image *img = image_create(W, H, 3);
+    if (!img) return NULL;
+    for (int v = 0; v < H; v++) {
+        for (int u = 0; u < W; u++) {
+            double t = 2.0 * M_PI * u / W;
+            double p = M_PI * v / H;
+            double s = 0.4 * sin(13.0 * t + 5.0 * p) + 0.3 * cos(29.0 * t - 11.0 * p)
+                     + 0.3 * sin(41.0 * t) * cos(17.0 * p);
+            uint8_t val = (uint8_t)(127.5 + 120.0 * s);
+            uint8_t rgb[3] = {val, val, val};
+            set_pixel(img, u, v, rgb);
+        }
+    }
+    return img;
+}
+
+/* 露出を変えた画像 */
+static Image* change_exposure(Image *src) {
+    Image *img = image_create_like(src);
+    if (!img) return NULL;
+    size_t n = (size_t)src->width * src->height * src->channels;
+    for (size_t i = 0; i < n; i++) {
+        double val = EXPOSURE_GAIN * src->data[i] + EXPOSURE_OFFSET;
+        img->data[i] = (uint8_t)(val > 255.0 ? 255.0 : val);
+    }
+    return img;
+}
+
+static double gray_at(Image *img, int u, int v) {
+    uint8_t rgb[3];
+    get_pixel(img, u, v, rgb);
+    return (rgb[0] + rgb[1] + rgb[2]) / 3.0;
+}
+
+/* 素朴な ZNCC（角度ごとに参照画像の平均と分散も求める、1 - ρ） */
+static double zncc_naive(Image *base, Image *ref, double psi_deg, Region r) {
+    int W = ref->width;
+    double shift = -psi_deg * W / 360.0;
+    int k = (int)floor(shift);
+    double f = shift - k;
+    int N = (r.u_max - r.u_min + 1) * (r.v_max - r.v_min + 1);
+
+    double mb = 0.0, mr = 0.0;
+    for (int v = r.v_min; v <= r.v_max; v++) {
+        for (int u = r.u_min; u <= r.u_max; u++) {
+            mb += gray_at(base, u, v);
+            mr += (1.0 - f) * gray_at(ref, u + k, v) + f * gray_at(ref, u + k + 1, v);
+        }
+    }
+    mb /= N;
+    mr /= N;
+
+    double C = 0.0, Vb = 0.0, Vr = 0.0;
+    for (int v = r.v_min; v <= r.v_max; v++) {
+        for (int u = r.u_min; u <= r.u_max; u++) {
+            double b = gray_at(base, u, v) - mb;
+            double s = (1.0 - f) * gray_at(ref, u + k, v) + f * gray_at(ref, u + k + 1, v) - mr;
+            C += b * s;
+            Vb += b * b;
+            Vr += s * s;
+        }
+    }
+    return (Vb > 0.0 && Vr > 0.0) ? 1.0 - C / sqrt(Vb * Vr) : 1.0;
+}
+
+static int argmin(const double *E, int K) {
+    int best = 0;
+    for (int k = 1; k < K; k++) {
+        if (E[k] < E[best]) best = k;
+    }
+    return best;
+}
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== ZNCC の目的関数のベンチマーク =====\n\n");
+
+    Image *base, *ref;
+    double center = 12.5;
+    Region region;
+    if (argc >= 3) {
+        base = image_load(argv[1]);
+        ref = image_load(argv[2]);
+        if (argc >= 4) center = atof(argv[3]);
+        /* validate_y_rotation と同じ比較領域 */
+        region.u_min = 2850; region.v_min = 1425;
+        region.u_max = 3229; region.v_max = 1614;
+    } else {
+        base = create_test_image(2048, 1024);
+        ref = base ? rotate_image_y_axis(base, center) : NULL;
+        region.u_min = 1024 - 128; region.v_min = 512 - 64;
+        region.u_max = 1024 + 127; region.v_max = 512 + 63;
+    }
+    Image *exposed = ref ? change_exposure(ref) : NULL;
+    if (!base || !ref || !exposed) {
+        fprintf(stderr, "エラー: 画像の準備に失敗しました\n");
+        return 1;
+    }
+
+    int K = (int)floor(2.0 * ANGLE_HALF_RANGE / ANGLE_STEP + 1e-9) + 1;
+    double *psis = (double*)malloc((size_t)K * sizeof(double));
+    double *E = (double*)malloc((size_t)K * sizeof(double));
+    double *E_zncc = (double*)malloc((size_t)K * sizeof(double));
+    if (!psis || !E || !E_zncc) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        return 1;
+    }
+    for (int k = 0; k < K; k++) {
+        psis[k] = center - ANGLE_HALF_RANGE + k * ANGLE_STEP;
+    }
+    int u_min = region.u_min, v_min = region.v_min;
+    int u_max = region.u_max, v_max = region.v_max;
+
+    printf("\n画像: %d × %d, 比較領域: (%d, %d) - (%d, %d), 角度 %d 個\n",
+           base->width, base->height, u_min, v_min, u_max, v_max, K);
+    printf("露出の変更: 輝度 × %.2f + %.0f\n\n", EXPOSURE_GAIN, EXPOSURE_OFFSET);
+
+    /* 1. 時間 */
+    printf("【時間（%d 角度）】\n", K);
+    clock_t start = clock();
+    for (int k = 0; k < K; k++) {
+        E[k] = compute_objective_function(base, ref, psis[k], u_min, v_min, u_max, v_max);
+    }
+    printf("  差の2乗 compute_objective_function:     %8.3f 秒\n", seconds_since(start));
+
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        E[k] = compute_objective_function_yaw(base, ref, psis[k], u_min, v_min, u_max, v_max);
+    }
+    double ssd_yaw_seconds = seconds_since(start);
+    printf("  差の2乗 compute_objective_function_yaw: %8.3f 秒\n", ssd_yaw_seconds);
+
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        E_zncc[k] = zncc_naive(base, ref, psis[k], region);
+    }
+    printf("  ZNCC 素朴な実装:                        %8.3f 秒\n", seconds_since(start));
+
+    start = clock();
+    ZnccContext *ctx = zncc_context_create(base, ref, region);
+    double create_seconds = seconds_since(start);
+    if (!ctx) return 1;
+    double max_diff = 0.0;
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        double z = zncc_objective(ctx, psis[k]);
+        if (fabs(z - E_zncc[k]) > max_diff) max_diff = fabs(z - E_zncc[k]);
+        E_zncc[k] = z;
+    }
+    double zncc_seconds = seconds_since(start);
+    printf("  ZNCC 積分画像 zncc_objective:           %8.3f 秒（事前計算 %.3f 秒）\n",
+           zncc_seconds, create_seconds);
+    printf("  ZNCC / 差の2乗（閉じた形）: %.2f 倍、素朴な実装との差: 最大 %.2e\n",
+           zncc_seconds / ssd_yaw_seconds, max_diff);
+
+    ObjectiveTerms terms;
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        compute_objective_terms_yaw(base, ref, psis[k], u_min, v_min, u_max, v_max, &terms);
+    }
+    double terms_ssd = seconds_since(start);
+    start = clock();
+    for (int k = 0; k < K; k++) {
+        zncc_objective_terms(ctx, psis[k], &terms);
+    }
+    double terms_zncc = seconds_since(start);
+    printf("  E, g, H: compute_objective_terms_yaw %.3f 秒, zncc_objective_terms %.3f 秒\n\n",
+           terms_ssd, terms_zncc);
+
+    /* 2. 理論微分と中心差分 */
+    printf("【理論微分と中心差分（Δψ = 1e-4°）】\n");
+    const double h = 1e-4;
+    double test_psis[4] = {center - 3.33, center - 0.27, center + 0.41, center + 5.17};
+    for (int i = 0; i < 4; i++) {
+        zncc_objective_terms(ctx, test_psis[i], &terms);
+        ObjectiveTerms plus, minus;
+        zncc_objective_terms(ctx, test_psis[i] + h, &plus);
+        zncc_objective_terms(ctx, test_psis[i] - h, &minus);
+        double h_rad = h * M_PI / 180.0;
+        double fd_grad = (plus.E - minus.E) / (2.0 * h_rad);
+        double fd_hess = (plus.gradient - minus.gradient) / (2.0 * h_rad);
+        printf("  ψ = %7.2f°: dE/dψ %10.5f / %10.5f, d²E/dψ² %10.3f / %10.3f\n",
+               test_psis[i], terms.gradient, fd_grad, terms.hessian, fd_hess);
+    }
+    printf("\n");
+
+    /* 3. 露出を変えた参照画像 */
+    printf("【露出の違いへの強さ】\n");
+    ZnccContext *ctx_exposed = zncc_context_create(base, exposed, region);
+    if (!ctx_exposed) return 1;
+    double init = center + 0.3;
+    for (int pass = 0; pass < 2; pass++) {
+        Image *r = (pass == 0) ? ref : exposed;
+        const ZnccContext *zc = (pass == 0) ? ctx : ctx_exposed;
+        for (int k = 0; k < K; k++) {
+            E[k] = compute_objective_function_yaw(base, r, psis[k], u_min, v_min, u_max, v_max);
+            E_zncc[k] = zncc_objective(zc, psis[k]);
+        }
+        YawEstimate est_ssd, est_zncc;
+        estimate_y_rotation(base, r, region, init, NULL, &est_ssd);
+        estimate_y_rotation_zncc(zc, init, NULL, &est_zncc);
+        printf("  %s:\n", (pass == 0) ? "元の参照画像" : "露出を変えた参照画像");
+        printf("    差の2乗: 最小 %.2f°, 推定 %.4f° (%s, 走査 %d 回)\n",
+               psis[argmin(E, K)], est_ssd.psi_deg, yaw_status_name(est_ssd.status),
+               est_ssd.passes);
+        printf("    ZNCC:    最小 %.2f°, 推定 %.4f° (%s, 走査 %d 回), ρ = %.4f\n",
+               psis[argmin(E_zncc, K)], est_zncc.psi_deg, yaw_status_name(est_zncc.status),
+               est_zncc.passes, 1.0 - est_zncc.E);
+    }
+
+    zncc_context_free(ctx);
+    zncc_context_free(ctx_exposed);
+    free(psis);
+    free(E);
+    free(E_zncc);
+    image_free(exposed);
+    image_free(base);
+    image_free(ref);
+
+    printf("\n===== ベンチマーク完了 =====\n");
+    return 0;
+}
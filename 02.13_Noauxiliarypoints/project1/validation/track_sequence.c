@@ -0,0 +1,219 @@
+/* track_sequence.c
+ * 全方位動画のフレーム列の回転の追跡
+ *
+ * 目的:
+ *   フレーム列の各フレームの回転を直前のフレームまたはキーフレームに対して
+ *   等速の予測から推定し（tracking.h）、最初のフレームに対する回転の軌跡を
+ *   CSV に書く。フレームのデコードは推定と並行に行い、処理速度（FPS）を表示する。
+ *
+ * 使い方:
+ *   ./track_sequence [オプション] <フレームのリスト | 生のフレーム（- で標準入力）>
+ *
+ *   フレームのリストは1行に1つの画像ファイルのパス（# から行末はコメント）。
+ *   --raw W H を指定した場合は W × H の RGB（1画素3バイト）の連続として読む。
+ *   例: ffmpeg -i video.mp4 -f rawvideo -pix_fmt rgb24 - | ./track_sequence --raw 3840 1920 -
+ *
+ * 例:
+ *   ./track_sequence frames.txt
+ *   ./track_sequence --model rotation --previous -o results/trajectory.csv frames.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/tracking.h"
+#include "../include/image_utils.h"
+
+/* 標準の比較領域（画像の中央、資料の領域 2850〜3229 × 1425〜1614 と同じ割合） */
+#define REGION_U_MIN_RATIO (2850.0 / 6080.0)
+#define REGION_U_MAX_RATIO (3229.0 / 6080.0)
+#define REGION_V_MIN_RATIO (1425.0 / 3040.0)
+#define REGION_V_MAX_RATIO (1614.0 / 3040.0)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "使い方: %s [オプション] <フレームのリスト | 生のフレーム（- で標準入力）>\n", prog);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "オプション:\n");
+    fprintf(stderr, "  --raw W H          W × H の RGB の連続として読む\n");
+    fprintf(stderr, "  --model yaw|rotation  ヨー角だけ（逆合成法、既定）/ ヨー・ピッチ・ロール\n");
+    fprintf(stderr, "  --previous         直前のフレームに対して推定（既定はキーフレーム）\n");
+    fprintf(stderr, "  --keyframe-interval N  キーフレームを替えるフレーム数（既定 30、0 で替えない）\n");
+    fprintf(stderr, "  --keyframe-max D   キーフレームからの回転が D 度を超えたら替える（既定 10）\n");
+    fprintf(stderr, "  --no-predict       等速の予測を使わず直前の回転を初期値にする\n");
+    fprintf(stderr, "  --acquire-levels N 捕捉（全周探索）のピラミッドのレベル数（既定 4、0 で捕捉しない）\n");
+    fprintf(stderr, "  --prefetch N       先読みするフレーム数（既定 4、0 で先読みしない）\n");
+    fprintf(stderr, "  --region u0 v0 u1 v1  比較領域（既定は画像の中央）\n");
+    fprintf(stderr, "  -o FILE            軌跡の出力先（既定 results/trajectory.csv）\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "例:\n");
+    fprintf(stderr, "  %s frames.txt\n", prog);
+    fprintf(stderr, "  ffmpeg -i video.mp4 -f rawvideo -pix_fmt rgb24 - | %s --raw 3840 1920 -\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    printf("===== フレーム列の回転の追跡 =====\n\n");
+
+    const char *input = NULL;
+    const char *output = "results/trajectory.csv";
+    int raw = 0, raw_width = 0, raw_height = 0;
+    int prefetch = 4;
+    int has_region = 0;
+    Region region = {0, 0, 0, 0};
+    TrackerOptions opt = tracker_default_options(region);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--raw") == 0 && i + 2 < argc) {
+            raw = 1;
+            raw_width = atoi(argv[++i]);
+            raw_height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            const char *m = argv[++i];
+            if (strcmp(m, "yaw") == 0) {
+                opt.model = TRACK_YAW;
+            } else if (strcmp(m, "rotation") == 0) {
+                opt.model = TRACK_ROTATION;
+            } else {
+                fprintf(stderr, "エラー: 不明なモデル: %s\n", m);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--previous") == 0) {
+            opt.reference = TRACK_PREVIOUS;
+        } else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+            opt.keyframe_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--keyframe-max") == 0 && i + 1 < argc) {
+            opt.keyframe_max_deg = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--no-predict") == 0) {
+            opt.predict = 0;
+        } else if (strcmp(argv[i], "--acquire-levels") == 0 && i + 1 < argc) {
+            opt.acquire_levels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) {
+            prefetch = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--region") == 0 && i + 4 < argc) {
+            region.u_min = atoi(argv[++i]);
+            region.v_min = atoi(argv[++i]);
+            region.u_max = atoi(argv[++i]);
+            region.v_max = atoi(argv[++i]);
+            has_region = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (!input) {
+            input = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!input) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FrameSource *source = raw ? frame_source_open_raw(input, raw_width, raw_height)
+                              : frame_source_open_list(input);
+    if (!source) return 1;
+    FramePipeline *pipeline = frame_pipeline_start(source, prefetch);
+    if (!pipeline) {
+        frame_source_close(source);
+        return 1;
+    }
+
+    FILE *fp = fopen(output, "w");
+    if (!fp) {
+        fprintf(stderr, "エラー: 出力ファイルが開けません: %s\n", output);
+        frame_pipeline_stop(pipeline);
+        frame_source_close(source);
+        return 1;
+    }
+    trajectory_write_header(fp);
+
+    double start = now_seconds();
+    Tracker *tracker = NULL;
+    int frames = 0, keyframes = 0, acquisitions = 0, failures = 0;
+    long passes = 0;
+    double estimate_seconds = 0.0;
+    int status = 0;
+
+    Image *frame;
+    while ((frame = frame_pipeline_next(pipeline)) != NULL) {
+        if (!tracker) {
+            /* 比較領域は最初のフレームのサイズから決める */
+            if (!has_region) {
+                region.u_min = (int)(REGION_U_MIN_RATIO * frame->width);
+                region.u_max = (int)(REGION_U_MAX_RATIO * frame->width);
+                region.v_min = (int)(REGION_V_MIN_RATIO * frame->height);
+                region.v_max = (int)(REGION_V_MAX_RATIO * frame->height);
+            }
+            opt.region = region;
+            printf("フレームのサイズ: %d × %d\n", frame->width, frame->height);
+            printf("比較領域: u = %d〜%d, v = %d〜%d\n",
+                   region.u_min, region.u_max, region.v_min, region.v_max);
+            printf("モデル: %s, 基準: %s, 予測: %s, 先読み: %d フレーム\n\n",
+                   opt.model == TRACK_YAW ? "ヨー角（逆合成法）" : "ヨー・ピッチ・ロール",
+                   opt.reference == TRACK_PREVIOUS ? "直前のフレーム" : "キーフレーム",
+                   opt.predict ? "等速" : "直前の回転", pipeline->depth);
+            tracker = tracker_create(&opt);
+            if (!tracker) {
+                image_free(frame);
+                status = 1;
+                break;
+            }
+        }
+
+        TrackPose pose;
+        if (!tracker_add_frame(tracker, frame, &pose)) {
+            status = 1;
+            break;
+        }
+        trajectory_write_pose(fp, &pose);
+        frames++;
+        keyframes += pose.keyframe;
+        acquisitions += pose.acquired;
+        failures += !pose.converged;
+        passes += pose.passes;
+        estimate_seconds += pose.seconds;
+
+        printf("  フレーム %4d: ヨー %9.4f° ピッチ %8.4f° ロール %8.4f°  予測 %9.4f°  走査 %2d 回%s%s%s\n",
+               pose.frame, pose.yaw_deg, pose.pitch_deg, pose.roll_deg,
+               pose.predicted_yaw_deg, pose.passes,
+               pose.acquired ? "  [捕捉]" : "", pose.keyframe ? "  [キー]" : "",
+               pose.converged ? "" : "  （未収束）");
+    }
+    double total_seconds = now_seconds() - start;
+    /* 取り出しが NULL で終わった場合だけデコード用のスレッドは止まっている */
+    int decode_error = (frame == NULL) && pipeline->error;
+    if (decode_error) {
+        fprintf(stderr, "エラー: フレーム %d のデコードに失敗したので止めました\n", frames);
+        status = 1;
+    }
+
+    fclose(fp);
+    tracker_free(tracker);
+    double decode_seconds = pipeline->decode_seconds;
+    frame_pipeline_stop(pipeline);
+    frame_source_close(source);
+
+    if (frames == 0) {
+        if (!decode_error) fprintf(stderr, "エラー: フレームがありません\n");
+        return 1;
+    }
+
+    printf("\n【結果】\n");
+    printf("  フレーム数: %d（キーフレーム %d, 捕捉 %d, 未収束 %d）\n",
+           frames, keyframes, acquisitions, failures);
+    printf("  走査回数: 平均 %.2f 回/フレーム\n", frames > 1 ? (double)passes / (frames - 1) : 0.0);
+    printf("  デコード: %.3f 秒, 推定: %.3f 秒, 全体: %.3f 秒\n",
+           decode_seconds, estimate_seconds, total_seconds);
+    printf("  処理速度: %.2f FPS（推定だけなら %.2f FPS）\n",
+           frames / total_seconds, estimate_seconds > 0.0 ? frames / estimate_seconds : 0.0);
+    printf("  軌跡: %s\n", output);
+
+    printf("\n===== 追跡完了 =====\n");
+    return status;
+}
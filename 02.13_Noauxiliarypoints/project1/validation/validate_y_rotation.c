@@ -4,9 +4,18 @@
  * 目的:
  *   1. 目的関数E(ψ)が期待角度で最小値をとることを確認
  *   2. 理論微分と数値微分が一致することを確認
+ *   3. FFTによる全周探索（全ての整数シフト）で同じ最小値が得られることを確認
+ *   4. ガウス・ニュートン法で少ない走査回数で収束することを確認
+ *   5. 逆合成法（定数のヘッセ行列）でも同じ角度に収束することを確認
+ *   6. --regions を指定した場合は、ファイルの全ての比較領域の曲線と
+ *      全体の推定を1回の走査ずつで求める（region_set.h）
  * 
  * 使い方:
- *   ./validate_y_rotation <基準画像> <参照画像> [期待角度(度)]
+ *   ./validate_y_rotation [--threads N] [--split-rows] [--regions ファイル]
+ *                         <基準画像> <参照画像> [期待角度(度)]
+ * 
+ *   角度の掃引はスレッド数によらず同じ結果になる（sweep.h）。
+ *   比較領域のファイルの形式は region_set.h（例: validation/regions.txt）。
  * 
  * 例:
  *   ./validate_y_rotation images/base/base.jpg images/reference/reference_18_5deg.jpg 18.5
@@ -16,8 +25,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <math.h>
 #include "../include/y_rotation.h"
 #include "../include/image_utils.h"
+#include "../include/yaw_search.h"
+#include "../include/yaw_estimator.h"
+#include "../include/objective_cache.h"
+#include "../include/sweep.h"
+#include "../include/region_set.h"
 
 /* 比較領域の設定（資料より） */
 #define REGION_U_MIN 2850
@@ -25,6 +41,10 @@
 #define REGION_U_MAX 3229
 #define REGION_V_MAX 1614
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 
 static int infer_angle_from_filename(const char *path, double *angle_deg) {
     const char *filename = strrchr(path, '/');
@@ -83,27 +103,55 @@ static int infer_angle_from_filename(const char *path, double *angle_deg) {
 #define ANGLE_HALF_RANGE 10.0
 #define ANGLE_STEP 0.1
 
+/* 補間面の微分と比べる細かい中心差分の刻み（画素の境界をほぼまたがない幅） */
+#define FINE_STEP 1e-4
+
+/* 粗密探索のピラミッドのレベル数 */
+#define PYRAMID_LEVELS 4
+
 int main(int argc, char *argv[]) {
     printf("===== Y軸回りの回転検証実験 =====\n\n");
     
+    /* オプション（--threads N, --split-rows, --regions ファイル）と位置引数を分ける */
+    SweepOptions sweep_opt = sweep_default_options();
+    const char *regions_filename = NULL;
+    const char *args[3] = {NULL, NULL, NULL};
+    int nargs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            sweep_opt.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--split-rows") == 0) {
+            sweep_opt.split_rows = 1;
+        } else if (strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+            regions_filename = argv[++i];
+        } else if (nargs < 3) {
+            args[nargs++] = argv[i];
+        }
+    }
+
     /* コマンドライン引数のチェック */
-    if (argc < 3) {
-        fprintf(stderr, "使い方: %s <基準画像> <参照画像> [期待角度(度)]\n", argv[0]);
+    if (nargs < 2) {
+        fprintf(stderr, "使い方: %s [オプション] <基準画像> <参照画像> [期待角度(度)]\n", argv[0]);
         fprintf(stderr, "\n");
         fprintf(stderr, "引数:\n");
         fprintf(stderr, "  基準画像: 注視点が中心にある画像（I_b）\n");
         fprintf(stderr, "  参照画像: 任意角度で回転させた画像（I_r）\n");
         fprintf(stderr, "\n");
+        fprintf(stderr, "オプション:\n");
+        fprintf(stderr, "  --threads N   掃引のスレッド数（省略時は CPU のコア数）\n");
+        fprintf(stderr, "  --split-rows  角度をさらに比較領域の行単位に分けて並列化\n");
+        fprintf(stderr, "  --regions F   ファイル F の全ての比較領域でも掃引・推定する\n");
+        fprintf(stderr, "\n");
         fprintf(stderr, "例:\n");
         fprintf(stderr, "  %s images/base/base.jpg images/reference/reference_18_5deg.jpg 18.5\n", argv[0]);
         return 1;
     }
     
-    const char *base_filename = argv[1];
-    const char *ref_filename = argv[2];
+    const char *base_filename = args[0];
+    const char *ref_filename = args[1];
     double expected_angle_deg = 5.0;
-    if (argc >= 4) {
-        expected_angle_deg = atof(argv[3]);
+    if (nargs >= 3) {
+        expected_angle_deg = atof(args[2]);
     } else {
         double inferred_angle = 0.0;
         if (infer_angle_from_filename(ref_filename, &inferred_angle)) {
@@ -179,59 +227,335 @@ int main(int argc, char *argv[]) {
     
     /* CSVヘッダー */
     fprintf(fp_obj, "angle_deg,objective_function\n");
-    fprintf(fp_der, "angle_deg,analytical_derivative,numerical_derivative\n");
+    fprintf(fp_der, "angle_deg,analytical_derivative,numerical_derivative,central_derivative,"
+                    "central_derivative_fine\n");
     
     /* 角度を変化させて計算 */
     int total_points = (int)((angle_max - angle_min) / ANGLE_STEP) + 1;
-    int progress_step = total_points / 10;
-    if (progress_step <= 0) {
-        progress_step = 1;
-    }
     
     printf("  計算点数: %d点\n", total_points);
+    printf("  スレッド数: %d（%s）\n", sweep_thread_count(&sweep_opt),
+           sweep_opt.split_rows ? "角度 × 行" : "角度");
     printf("  処理中");
     fflush(stdout);
-    
-    for (double psi = angle_min; psi <= angle_max + 1e-9; psi += ANGLE_STEP) {
-        int point_num = (int)((psi - angle_min) / ANGLE_STEP);
-        
-        if (point_num % progress_step == 0) {
-            printf(".");
-            fflush(stdout);
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    clock_t sweep_start = clock();
+
+    /* 1. 各角度で目的関数・理論微分・ヘッセ行列を1回の走査で計算し
+     *    （compute_objective_terms_ctx、基準画像の比較領域の世界座標と輝度は
+     *    最初に1回だけ計算）、E をキャッシュに登録する。
+     *    角度はスレッドで並列に計算する
+     * 2. 数値微分（前進差分・中心差分）はキャッシュの E から求める。
+     *    E(ψ ± Δψ) は隣の角度の E なので、新たに走査するのは
+     *    範囲の外側の2点 ψmin - Δψ, ψmax + Δψ だけ
+     * 3. 理論微分は補間面（区分的な双線形関数）の微分なので、Δψ = 0.1°
+     *    （約 1.7 画素）の中心差分とは模様の細かい画像では一致しない。
+     *    同じ補間面の E の Δψ = FINE_STEP の中心差分も書き、理論微分と比べる。
+     *    これは確認用に角度ごとに2回走査するので、時間を測り終えてから
+     *    別に計算し、走査回数にも別に数える
+     */
+    Region region_main = {REGION_U_MIN, REGION_V_MIN, REGION_U_MAX, REGION_V_MAX};
+    RegionContext *region_ctx = region_context_create(base, region_main);
+    ObjectivePair pair = {0, base, ref, region_main, region_ctx};
+    ObjectiveCache *cache = objective_cache_create((size_t)total_points + 2);
+    int capacity = total_points + 1;
+    double *psis = (double*)malloc((size_t)capacity * sizeof(double));
+    ObjectiveTerms *terms = (ObjectiveTerms*)malloc((size_t)capacity * sizeof(ObjectiveTerms));
+    /* 前進差分・中心差分・細かい中心差分（角度ごとに3つ） */
+    double *numerical = (double*)malloc((size_t)capacity * 3 * sizeof(double));
+    if (!region_ctx || !cache || !psis || !terms || !numerical) {
+        fprintf(stderr, "エラー: メモリ確保失敗\n");
+        region_context_free(region_ctx);
+        objective_cache_free(cache);
+        free(psis);
+        free(terms);
+        free(numerical);
+        fclose(fp_obj);
+        fclose(fp_der);
+        image_free(base);
+        image_free(ref);
+        return 1;
+    }
+
+    /* 角度の列（以前の逐次の掃引と同じ足し算で作る） */
+    int n = 0;
+    for (double psi = angle_min; psi <= angle_max + 1e-9 && n < capacity; psi += ANGLE_STEP) {
+        psis[n++] = psi;
+    }
+
+    sweep_objective_terms_ctx(region_ctx, ref, psis, n, &sweep_opt, terms);
+    for (int i = 0; i < n; i++) {
+        objective_cache_store(cache, &pair, psis[i], terms[i].E);
+    }
+
+    double sweep_best_psi = psis[0];
+    double sweep_best_E = terms[0].E;
+    for (int i = 0; i < n; i++) {
+        double psi = psis[i];
+        double E = cached_objective(cache, &pair, psi);
+        if (E < sweep_best_E) {
+            sweep_best_E = E;
+            sweep_best_psi = psi;
         }
-        
-        /* 目的関数を計算 */
-        double E = compute_objective_function(
-            base, ref, psi,
-            REGION_U_MIN, REGION_V_MIN,
-            REGION_U_MAX, REGION_V_MAX
-        );
-        
-        /* 理論微分を計算 */
-        double dE_analytical = compute_analytical_derivative(
-            base, ref, psi,
-            REGION_U_MIN, REGION_V_MIN,
-            REGION_U_MAX, REGION_V_MAX
-        );
-        
-        /* 数値微分を計算 */
-        double dE_numerical = compute_numerical_derivative(
-            base, ref, psi, ANGLE_STEP,
-            REGION_U_MIN, REGION_V_MIN,
-            REGION_U_MAX, REGION_V_MAX
-        );
-        
-        /* CSVに書き込み */
-        fprintf(fp_obj, "%.2f,%.6f\n", psi, E);
-        fprintf(fp_der, "%.2f,%.6f,%.6f\n", psi, dE_analytical, dE_numerical);
+
+        /* 数値微分（ラジアン当たり） */
+        numerical[3 * i] = cached_forward_derivative(cache, &pair, psi, ANGLE_STEP);
+        numerical[3 * i + 1] = cached_central_derivative(cache, &pair, psi, ANGLE_STEP);
     }
     
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double sweep_cpu_seconds = (double)(clock() - sweep_start) / CLOCKS_PER_SEC;
+
+    /* 確認用の細かい中心差分（時間の外、角度ごとに2回走査） */
+    for (int i = 0; i < n; i++) {
+        numerical[3 * i + 2] =
+            (compute_objective_function_yaw(base, ref, psis[i] + FINE_STEP, REGION_U_MIN,
+                                            REGION_V_MIN, REGION_U_MAX, REGION_V_MAX) -
+             compute_objective_function_yaw(base, ref, psis[i] - FINE_STEP, REGION_U_MIN,
+                                            REGION_V_MIN, REGION_U_MAX, REGION_V_MAX)) /
+            (2.0 * FINE_STEP * M_PI / 180.0);
+    }
+    long fine_passes = 2L * n;
+
+    /* CSV は角度の順に書き、理論微分との差が 1% 以内の角度を数える */
+    int agree_coarse = 0, agree_fine = 0;
+    for (int i = 0; i < n; i++) {
+        double g = terms[i].gradient;
+        double dE_central = numerical[3 * i + 1];
+        double dE_fine = numerical[3 * i + 2];
+        agree_coarse += fabs(g - dE_central) <= 0.01 * fabs(dE_central);
+        agree_fine += fabs(g - dE_fine) <= 0.01 * fabs(dE_fine);
+
+        fprintf(fp_obj, "%.2f,%.6f\n", psis[i], terms[i].E);
+        fprintf(fp_der, "%.2f,%.6f,%.6f,%.6f,%.6f\n", psis[i], g, numerical[3 * i],
+                dE_central, dE_fine);
+    }
     printf(" 完了！\n");
+    printf("  計算時間: 経過 %.2f 秒, CPU %.2f 秒\n",
+           (wall_end.tv_sec - wall_start.tv_sec) + 1e-9 * (wall_end.tv_nsec - wall_start.tv_nsec),
+           sweep_cpu_seconds);
+    printf("  最小: %.2f° (期待角度との差 %.2f°), E = %.6f\n",
+           sweep_best_psi, sweep_best_psi - expected_angle_deg, sweep_best_E);
+    printf("  領域の走査 %ld 回 = 掃引 %d + 範囲外 %ld + 確認用の細かい中心差分 %ld（時間の外）、"
+           "キャッシュ命中 %ld 回\n",
+           n + cache->misses + fine_passes, n, cache->misses, fine_passes, cache->hits);
+    printf("  理論微分と中心差分の差が 1%% 以内: Δψ = %.1f° で %d / %d 角度, "
+           "Δψ = %g° で %d / %d 角度\n",
+           ANGLE_STEP, agree_coarse, n, FINE_STEP, agree_fine, n);
+    free(terms);
+    free(numerical);
+    objective_cache_free(cache);
+
+    /* 最小の角度だけが必要な場合は打ち切り付きの探索で十分 */
+    printf("\n【最小値だけの探索（打ち切り付き）】\n");
+    int region_rows = REGION_V_MAX - REGION_V_MIN + 1;
+    double E_check = 0.0;
+    clock_t full_start = clock();
+    int full_best = 0;
+    for (int i = 0; i < n; i++) {
+        double E = compute_objective_function_yaw(base, ref, psis[i], REGION_U_MIN,
+                                                  REGION_V_MIN, REGION_U_MAX, REGION_V_MAX);
+        if (i == 0 || E < E_check) {
+            E_check = E;
+            full_best = i;
+        }
+    }
+    double full_seconds = (double)(clock() - full_start) / CLOCKS_PER_SEC;
+    printf("  打ち切りなし（compute_objective_function_yaw × %d）: %.2f°, %.3f 秒\n",
+           n, psis[full_best], full_seconds);
+
+    SweepMinimum minimum;
+    clock_t bb_start = clock();
+    if (sweep_objective_argmin(base, ref, pair.region, psis, n, &sweep_opt, &minimum)) {
+        printf("  打ち切り付き（sweep_objective_argmin）: %.2f°, %.3f 秒\n",
+               psis[minimum.index], (double)(clock() - bb_start) / CLOCKS_PER_SEC);
+        printf("    最後まで計算 %d 角度, 打ち切り %d 角度, 行 %.1f%%\n",
+               minimum.completed, minimum.pruned,
+               100.0 * minimum.rows / ((double)n * region_rows));
+    }
+
+    /* 角度範囲を全周（-180° 〜 180°、同じ刻み）に広げた場合 */
+    int n_circle = (int)floor(360.0 / ANGLE_STEP + 1e-9);
+    double *psis_circle = (double*)malloc((size_t)n_circle * sizeof(double));
+    if (psis_circle) {
+        for (int i = 0; i < n_circle; i++) {
+            psis_circle[i] = -180.0 + i * ANGLE_STEP;
+        }
+        bb_start = clock();
+        if (sweep_objective_argmin(base, ref, pair.region, psis_circle, n_circle,
+                                   &sweep_opt, &minimum)) {
+            printf("  全周 %d 角度（打ち切り付き）: %.2f°, %.3f 秒\n",
+                   n_circle, psis_circle[minimum.index],
+                   (double)(clock() - bb_start) / CLOCKS_PER_SEC);
+            printf("    最後まで計算 %d 角度, 打ち切り %d 角度, 行 %.1f%%\n",
+                   minimum.completed, minimum.pruned,
+                   100.0 * minimum.rows / ((double)n_circle * region_rows));
+        }
+        free(psis_circle);
+    }
     
     /* ファイルを閉じる */
     fclose(fp_obj);
     fclose(fp_der);
 
+    /* FFTによる全周探索 */
+    printf("\n【FFTによる全周探索】\n");
+    clock_t fft_start = clock();
+    GrayImage *gray_base = gray_image_from_image(base);
+    GrayImage *gray_ref = gray_image_from_image(ref);
+    YawCurve curve;
+    double fft_init_deg = expected_angle_deg;
+    if (gray_base && gray_ref &&
+        yaw_search_fft(gray_base, gray_ref,
+                       REGION_U_MIN, REGION_V_MIN, REGION_U_MAX, REGION_V_MAX,
+                       &curve)) {
+        printf("  計算時間: %.3f 秒（%d 角度、グレースケール変換を含む）\n",
+               (double)(clock() - fft_start) / CLOCKS_PER_SEC, curve.width);
+        printf("  最小のシフト: %d 画素 (%.4f°), E = %.6f\n",
+               curve.best_shift, yaw_shift_to_deg(curve.best_shift, curve.width),
+               curve.best_E);
+        printf("  サブピクセル補正後: %.4f° (期待角度との差 %.4f°)\n",
+               curve.best_psi_deg, curve.best_psi_deg - expected_angle_deg);
+        yaw_curve_save_csv(&curve, "results/objective_fft.csv");
+        fft_init_deg = yaw_shift_to_deg(curve.best_shift, curve.width);
+        yaw_curve_free(&curve);
+    } else {
+        fprintf(stderr, "  警告: FFTによる探索に失敗\n");
+    }
+
+    /* ガウス・ニュートン法による推定
+     * 実画像では目的関数の谷の幅が数画素程度なので、初期値は
+     * FFTによる全周探索の結果を使うのが基本
+     */
+    printf("\n【ガウス・ニュートン法による推定】\n");
+    Region region_gn = {REGION_U_MIN, REGION_V_MIN, REGION_U_MAX, REGION_V_MAX};
+    double inits[2] = {fft_init_deg, expected_angle_deg + 0.3};
+    const char *init_names[2] = {"FFTの整数シフト", "期待角度 + 0.3°"};
+    for (int i = 0; i < 2; i++) {
+        YawEstimate est;
+        clock_t gn_start = clock();
+        estimate_y_rotation_ctx(region_ctx, ref, inits[i], NULL, &est);
+        printf("  初期値 %.4f° (%s)\n", inits[i], init_names[i]);
+        printf("    結果: %.4f° (期待角度との差 %.4f°), E = %.6f\n",
+               est.psi_deg, est.psi_deg - expected_angle_deg, est.E);
+        printf("    状態: %s, 反復 %d 回, 走査 %d 回, %.2f 秒\n",
+               yaw_status_name(est.status), est.iterations, est.passes,
+               (double)(clock() - gn_start) / CLOCKS_PER_SEC);
+    }
+
+    region_context_free(region_ctx);
+
+    /* 逆合成法: 基準画像側の事前計算は1回だけで、各反復は参照画像の補間のみ */
+    printf("\n【逆合成法による推定】\n");
+    clock_t tmpl_start = clock();
+    YawTemplate *tmpl = yaw_template_create(base, region_gn);
+    if (tmpl) {
+        printf("  事前計算: %.3f 秒 (H = %.2f)\n",
+               (double)(clock() - tmpl_start) / CLOCKS_PER_SEC, tmpl->hessian);
+        for (int i = 0; i < 2; i++) {
+            YawEstimate est;
+            clock_t ic_start = clock();
+            estimate_y_rotation_ic(tmpl, ref, inits[i], NULL, &est);
+            printf("  初期値 %.4f° (%s)\n", inits[i], init_names[i]);
+            printf("    結果: %.4f° (期待角度との差 %.4f°), E = %.6f\n",
+                   est.psi_deg, est.psi_deg - expected_angle_deg, est.E);
+            printf("    状態: %s, 反復 %d 回, 走査 %d 回, %.3f 秒\n",
+                   yaw_status_name(est.status), est.iterations, est.passes,
+                   (double)(clock() - ic_start) / CLOCKS_PER_SEC);
+        }
+        yaw_template_free(tmpl);
+    } else {
+        fprintf(stderr, "  警告: 逆合成法の事前計算に失敗\n");
+    }
+
+    /* 粗密探索: 初期値も角度範囲も使わずに、最上位レベルの全周探索から求める */
+    printf("\n【ピラミッドによる粗密探索】\n");
+    YawPyramidEstimate pyr;
+    if (gray_base && gray_ref &&
+        estimate_y_rotation_pyramid(gray_base, gray_ref, region_gn, PYRAMID_LEVELS,
+                                    NULL, &pyr)) {
+        double total = pyr.build_seconds + pyr.search_seconds;
+        printf("  ピラミッド作成: %.3f 秒（%d レベル）\n", pyr.build_seconds, pyr.levels);
+        printf("  レベル%d 全周探索: %.4f°, %.3f 秒\n",
+               pyr.levels - 1, pyr.search_psi_deg, pyr.search_seconds);
+        for (int l = pyr.levels - 1; l >= 0; l--) {
+            printf("  レベル%d: %.4f°, 走査 %d 回, %.3f 秒\n",
+                   l, pyr.level_psi_deg[l], pyr.level_passes[l], pyr.level_seconds[l]);
+            total += pyr.level_seconds[l];
+        }
+        printf("  結果: %.4f° (期待角度との差 %.4f°), 状態: %s, 合計 %.3f 秒\n",
+               pyr.estimate.psi_deg, pyr.estimate.psi_deg - expected_angle_deg,
+               yaw_status_name(pyr.estimate.status), total);
+        printf("  掃引（±%.0f°, %.1f° 刻み）: %.2f° (差 %.2f°), CPU %.2f 秒\n",
+               ANGLE_HALF_RANGE, ANGLE_STEP, sweep_best_psi,
+               sweep_best_psi - expected_angle_deg, sweep_cpu_seconds);
+    } else {
+        fprintf(stderr, "  警告: 粗密探索に失敗\n");
+    }
+    gray_image_free(gray_base);
+    gray_image_free(gray_ref);
+
+    /* 複数の比較領域: 角度ごとに全ての領域を1回の走査で求める */
+    if (regions_filename) {
+        printf("\n【複数の比較領域】%s\n", regions_filename);
+        RegionSet *set = region_set_load(regions_filename);
+        clock_t rs_start = clock();
+        RegionSetContext *rs = set ? region_set_context_create(base, ref, set) : NULL;
+        ObjectiveTerms *curves = rs ? (ObjectiveTerms*)malloc((size_t)set->count * n * sizeof(ObjectiveTerms)) : NULL;
+        ObjectiveTerms *combined = rs ? (ObjectiveTerms*)malloc((size_t)n * sizeof(ObjectiveTerms)) : NULL;
+        FILE *fp_regions = fopen("results/objective_regions.csv", "w");
+        if (rs && curves && combined && fp_regions) {
+            double prep_seconds = (double)(clock() - rs_start) / CLOCKS_PER_SEC;
+            rs_start = clock();
+            region_set_sweep(rs, psis, n, curves, combined);
+            double rs_seconds = (double)(clock() - rs_start) / CLOCKS_PER_SEC;
+            printf("  %d 領域, 1角度の走査 %ld 画素（領域の画素数の和 %ld）\n",
+                   set->count, rs->unique_pixels, rs->total_pixels);
+            printf("  事前計算 %.3f 秒, 掃引 %d 角度 %.2f 秒\n", prep_seconds, n, rs_seconds);
+
+            fprintf(fp_regions, "angle_deg");
+            for (int r = 0; r < set->count; r++) fprintf(fp_regions, ",region%d", r);
+            fprintf(fp_regions, ",combined\n");
+            for (int k = 0; k < n; k++) {
+                fprintf(fp_regions, "%.2f", psis[k]);
+                for (int r = 0; r < set->count; r++) {
+                    fprintf(fp_regions, ",%.6f", curves[(size_t)r * n + k].E);
+                }
+                fprintf(fp_regions, ",%.6f\n", combined[k].E);
+            }
+
+            int best_all = 0;
+            for (int r = 0; r < set->count; r++) {
+                const ObjectiveTerms *c = curves + (size_t)r * n;
+                int best = 0;
+                for (int k = 1; k < n; k++) {
+                    if (c[k].E < c[best].E) best = k;
+                }
+                Region q = set->regions[r];
+                printf("  領域%d (%d, %d) - (%d, %d): 最小 %.2f°, E = %.4f\n",
+                       r, q.u_min, q.v_min, q.u_max, q.v_max, psis[best], c[best].E);
+            }
+            for (int k = 1; k < n; k++) {
+                if (combined[k].E < combined[best_all].E) best_all = k;
+            }
+            YawEstimate est;
+            estimate_y_rotation_regions(rs, psis[best_all], NULL, &est);
+            printf("  全体: 最小 %.2f° → %.4f° (期待角度との差 %.4f°), 状態: %s, 走査 %d 回\n",
+                   psis[best_all], est.psi_deg, est.psi_deg - expected_angle_deg,
+                   yaw_status_name(est.status), est.passes);
+            printf("  曲線: results/objective_regions.csv\n");
+        } else {
+            fprintf(stderr, "  警告: 複数の比較領域の計算に失敗\n");
+        }
+        if (fp_regions) fclose(fp_regions);
+        free(curves);
+        free(combined);
+        region_set_context_free(rs);
+        region_set_free(set);
+    }
+    free(psis);
+
     /* グラフ描画用に期待角度を保存 */
     FILE *fp_expected = fopen("results/expected_angle.txt", "w");
     if (fp_expected) {
@@ -248,6 +572,7 @@ int main(int argc, char *argv[]) {
     printf("\n【結果保存】\n");
     printf("  目的関数: results/objective_function.csv\n");
     printf("  微分値: results/derivatives.csv\n");
+    printf("  全周の目的関数: results/objective_fft.csv\n");
     
     printf("\n===== 計算完了 =====\n");
     printf("次のステップ: Pythonでグラフを描画してください\n");